@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshbuilder.h
+// ============
+// write the interleaved vertices of the generated primitive meshes into
+// memory that is already sized for them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  MeshBuilder
+ *
+ *  This class contains the code for building the torus and
+ *  sphere meshes.  Every vertex is a position, a normal and
+ *  a texture coordinate.  The number of vertices of a mesh
+ *  is known before it is built, so the caller can size the
+ *  destination once, for example a mapped vertex buffer,
+ *  and the vertices are written straight into it without
+ *  any allocations.  It does not depend on OpenGL, so the
+ *  builders can be benchmarked on their own.
+ ***********************************************************/
+class MeshBuilder
+{
+public:
+	// position, normal and texture coordinate of a vertex
+	static const int FLOATS_PER_VERTEX = 8;
+
+	// number of vertices written by WriteTorus()
+	static int GetTorusVertexCount();
+	// write the triangles of a torus with a main radius of 1
+	// and the passed in tube radius - pVertices must have
+	// room for GetTorusVertexCount() vertices
+	static void WriteTorus(float tubeRadius, float* pVertices);
+
+	// number of vertices written by WriteSphere()
+	static int GetSphereVertexCount();
+	// write the vertices of the unit sphere - pVertices must
+	// have room for GetSphereVertexCount() vertices
+	static void WriteSphere(float* pVertices);
+	// triangle indices into the sphere vertices
+	static int GetSphereIndexCount();
+	static const unsigned int* GetSphereIndices();
+};
@@ -0,0 +1,285 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcache.cpp
+// ============
+// keep generated meshes in versioned binary files that later launches map
+// into memory instead of generating the meshes again
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshCache.h"
+#include "MeshBuilder.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char g_Magic[4] = { 'S', 'M', 'S', 'H' };
+	const char* g_Extension = ".mesh";
+	const char* g_TemporaryExtension = ".tmp";
+	// the vertices start at this alignment in the file
+	const uint32_t g_BlobAlignment = 16;
+
+	// float count and byte offset of one vertex attribute
+	struct VERTEX_ATTRIBUTE
+	{
+		uint32_t components;
+		uint32_t offset;
+	};
+
+	// position, normal and texture coordinate, the layout
+	// that ShapeMeshes sets for its vertex arrays
+	const int g_AttributeCount = 3;
+	const VERTEX_ATTRIBUTE g_Attributes[g_AttributeCount] = {
+		{ 3, 0 },
+		{ 3, 3 * sizeof(float) },
+		{ 2, 6 * sizeof(float) }
+	};
+	const uint32_t g_VertexStride = MeshBuilder::FLOATS_PER_VERTEX * sizeof(float);
+
+	// the start of every cache file
+	struct FILE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		// vertex format descriptor
+		uint32_t vertexStride;
+		uint32_t attributeCount;
+		VERTEX_ATTRIBUTE attributes[g_AttributeCount];
+		// the vertex and index blobs
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t vertexOffset;
+		uint32_t indexOffset;
+		// bounding box of the vertex positions
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	// where the vertices start in a file
+	uint32_t GetVertexOffset()
+	{
+		return(((sizeof(FILE_HEADER) + g_BlobAlignment - 1) / g_BlobAlignment) * g_BlobAlignment);
+	}
+
+	// size of the file holding the passed in counts
+	size_t GetFileSize(uint32_t vertexCount, uint32_t indexCount)
+	{
+		return(GetVertexOffset() + (size_t)vertexCount * g_VertexStride + (size_t)indexCount * sizeof(uint32_t));
+	}
+}
+
+/***********************************************************
+ *  MeshCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshCache::MeshCache()
+{
+	m_directory = "mesh_cache";
+	m_createdVertexCount = 0;
+	m_createdIndexCount = 0;
+}
+
+/***********************************************************
+ *  SetDirectory()
+ *
+ *  This method is used to set the folder of the cache files.
+ *  It is created when the first file is written.
+ ***********************************************************/
+void MeshCache::SetDirectory(const std::string& directory)
+{
+	m_directory = directory;
+}
+
+/***********************************************************
+ *  GetPath()
+ *
+ *  This method is used to get the path of the cache file of
+ *  the named mesh.
+ ***********************************************************/
+std::string MeshCache::GetPath(const char* name) const
+{
+	return(m_directory + "/" + name + g_Extension);
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used to map the cache file of the named
+ *  mesh.  It returns false when there is no file, or when
+ *  the file was written by another version, with another
+ *  vertex format or with other counts, or is cut short.
+ ***********************************************************/
+bool MeshCache::Open(const char* name, uint32_t vertexCount, uint32_t indexCount, MESH_DATA& mesh)
+{
+	Close();
+
+	std::string path = GetPath(name);
+	if (m_file.OpenForReading(path.c_str()) == false)
+	{
+		return false;
+	}
+
+	FILE_HEADER header;
+	bool bValid = (m_file.GetSize() >= sizeof(header));
+	if (bValid == true)
+	{
+		memcpy(&header, m_file.GetData(), sizeof(header));
+		bValid = (memcmp(header.magic, g_Magic, sizeof(g_Magic)) == 0) &&
+			(header.version == VERSION) &&
+			(header.vertexStride == g_VertexStride) &&
+			(header.attributeCount == g_AttributeCount) &&
+			(memcmp(header.attributes, g_Attributes, sizeof(g_Attributes)) == 0) &&
+			(header.vertexCount == vertexCount) &&
+			(header.indexCount == indexCount) &&
+			(header.vertexOffset == GetVertexOffset()) &&
+			(header.indexOffset == header.vertexOffset + vertexCount * g_VertexStride) &&
+			(m_file.GetSize() == GetFileSize(vertexCount, indexCount));
+	}
+	if (bValid == false)
+	{
+		std::cout << "Ignoring outdated mesh cache file:" << path << std::endl;
+		m_file.Close();
+		return false;
+	}
+
+	// the file is mapped read only, the pointers are not
+	// const only so created files can share the structure
+	unsigned char* pData = (unsigned char*)m_file.GetData();
+	mesh.pVertices = (float*)(pData + header.vertexOffset);
+	mesh.vertexCount = header.vertexCount;
+	mesh.pIndices = (uint32_t*)(pData + header.indexOffset);
+	mesh.indexCount = header.indexCount;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		mesh.boundsMin[axis] = header.boundsMin[axis];
+		mesh.boundsMax[axis] = header.boundsMax[axis];
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create a cache file sized for the
+ *  passed in counts and map it for writing.  The file is
+ *  written under a temporary name until Finish().
+ ***********************************************************/
+bool MeshCache::Create(const char* name, uint32_t vertexCount, uint32_t indexCount, MESH_DATA& mesh)
+{
+	Close();
+
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+
+	m_createdPath = GetPath(name);
+	m_temporaryPath = m_createdPath + g_TemporaryExtension;
+	if (m_file.CreateForWriting(m_temporaryPath.c_str(), GetFileSize(vertexCount, indexCount)) == false)
+	{
+		std::cout << "Could not create mesh cache file:" << m_temporaryPath << std::endl;
+		m_createdPath.clear();
+		m_temporaryPath.clear();
+		return false;
+	}
+
+	m_createdVertexCount = vertexCount;
+	m_createdIndexCount = indexCount;
+
+	unsigned char* pData = m_file.GetWritableData();
+	uint32_t vertexOffset = GetVertexOffset();
+	mesh.pVertices = (float*)(pData + vertexOffset);
+	mesh.vertexCount = vertexCount;
+	mesh.pIndices = (uint32_t*)(pData + vertexOffset + vertexCount * g_VertexStride);
+	mesh.indexCount = indexCount;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		mesh.boundsMin[axis] = 0.0f;
+		mesh.boundsMax[axis] = 0.0f;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used to complete a created file once the
+ *  mesh has been written into it.  The header is written
+ *  last, together with the bounds of the vertices, then
+ *  the file is unmapped and renamed to its final name.
+ ***********************************************************/
+bool MeshCache::Finish()
+{
+	unsigned char* pData = m_file.GetWritableData();
+	if (NULL == pData)
+	{
+		return false;
+	}
+
+	FILE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, g_Magic, sizeof(g_Magic));
+	header.version = VERSION;
+	header.vertexStride = g_VertexStride;
+	header.attributeCount = g_AttributeCount;
+	memcpy(header.attributes, g_Attributes, sizeof(g_Attributes));
+	header.vertexCount = m_createdVertexCount;
+	header.indexCount = m_createdIndexCount;
+	header.vertexOffset = GetVertexOffset();
+	header.indexOffset = header.vertexOffset + header.vertexCount * g_VertexStride;
+
+	const float* pVertices = (const float*)(pData + header.vertexOffset);
+	for (uint32_t vertex = 0; vertex < header.vertexCount; vertex++)
+	{
+		const float* pPosition = pVertices + vertex * MeshBuilder::FLOATS_PER_VERTEX;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if ((vertex == 0) || (pPosition[axis] < header.boundsMin[axis]))
+			{
+				header.boundsMin[axis] = pPosition[axis];
+			}
+			if ((vertex == 0) || (pPosition[axis] > header.boundsMax[axis]))
+			{
+				header.boundsMax[axis] = pPosition[axis];
+			}
+		}
+	}
+	memcpy(pData, &header, sizeof(header));
+	m_file.Close();
+
+	std::error_code error;
+	std::filesystem::rename(m_temporaryPath, m_createdPath, error);
+	if (error)
+	{
+		std::cout << "Could not store mesh cache file:" << m_createdPath << std::endl;
+		std::filesystem::remove(m_temporaryPath, error);
+	}
+
+	m_createdPath.clear();
+	m_temporaryPath.clear();
+	return(!error);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to unmap the current file.  A file
+ *  that was created but not finished is deleted.
+ ***********************************************************/
+void MeshCache::Close()
+{
+	m_file.Close();
+
+	if (m_temporaryPath.empty() == false)
+	{
+		std::error_code error;
+		std::filesystem::remove(m_temporaryPath, error);
+		m_createdPath.clear();
+		m_temporaryPath.clear();
+	}
+}
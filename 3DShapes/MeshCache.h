@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcache.h
+// ============
+// keep generated meshes in versioned binary files that later launches map
+// into memory instead of generating the meshes again
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+
+/***********************************************************
+ *  MeshCache
+ *
+ *  This class contains the code for the mesh cache files.
+ *  Each file holds one mesh: a header with the version, the
+ *  vertex format, the counts and the bounds of the mesh,
+ *  followed by the vertices and the indices exactly as they
+ *  are sent to the GPU.  A file is only used when its
+ *  version, vertex format and counts match, so VERSION must
+ *  change whenever MeshBuilder builds a mesh differently.
+ *
+ *  A new file is mapped and the mesh is generated straight
+ *  into it.  It gets its final name once it is complete, so
+ *  an interrupted launch never leaves a broken cache behind.
+ ***********************************************************/
+class MeshCache
+{
+public:
+	// version of the file layout and of the cached meshes
+	static const uint32_t VERSION = 1;
+
+	// a mesh in the mapped cache file - the pointers stay
+	// valid until Close() or Finish() is called
+	struct MESH_DATA
+	{
+		float* pVertices;
+		uint32_t vertexCount;
+		uint32_t* pIndices;
+		uint32_t indexCount;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	// constructor
+	MeshCache();
+
+	// folder the cache files are kept in
+	void SetDirectory(const std::string& directory);
+
+	// map the cache file of the named mesh for reading - the
+	// pointers in mesh must not be written through
+	bool Open(const char* name, uint32_t vertexCount, uint32_t indexCount, MESH_DATA& mesh);
+	// create and map a new cache file for the named mesh, so
+	// the vertices and indices can be written into it
+	bool Create(const char* name, uint32_t vertexCount, uint32_t indexCount, MESH_DATA& mesh);
+	// store the bounds and the header of a created file and
+	// give it its final name
+	bool Finish();
+	// unmap the current file, dropping a created file that
+	// was not finished
+	void Close();
+
+private:
+	std::string m_directory;
+	MappedFile m_file;
+	// final and temporary paths and the counts of a file
+	// being created
+	std::string m_createdPath;
+	std::string m_temporaryPath;
+	uint32_t m_createdVertexCount;
+	uint32_t m_createdIndexCount;
+
+	// path of the cache file of the named mesh
+	std::string GetPath(const char* name) const;
+};
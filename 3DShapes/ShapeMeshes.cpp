@@ -8,7 +8,10 @@
 //	Created for CS-330-Computational Graphics and Visualization, Nov. 7th, 2022
 ///////////////////////////////////////////////////////////////////////////////
 
-#include "shapemeshes.h"
+#include "ShapeMeshes.h"
+#include "MeshBuilder.h"
+#include "Profiler.h"
+#include "RenderStats.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
@@ -16,12 +19,21 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
 #include <vector>
 
 namespace
 {
+	// the C math headers already define these on Linux
+#ifndef M_PI
 	const double M_PI = 3.14159265358979323846f;
+#endif
+#ifndef M_PI_2
 	const double M_PI_2 = 1.571428571428571;
+#endif
 	const GLuint g_FloatsPerVertex = 3;	// Number of coordinates per vertex
 	const GLuint g_FloatsPerNormal = 3;	// Number of values per vertex color
 	const GLuint g_FloatsPerUV = 2;		// Number of texture coordinate values
@@ -30,6 +42,48 @@ namespace
 ShapeMeshes::ShapeMeshes()
 {
 	m_bMemoryLayoutDone = false;
+	m_boundMeshType = box;
+	for (int i = 0; i < meshTypeCount; i++)
+	{
+		m_meshTriangles[i].minCorner = glm::vec3(0.0f);
+		m_meshTriangles[i].maxCorner = glm::vec3(0.0f);
+	}
+}
+
+///////////////////////////////////////////////////
+//	GetMeshTypeName()
+//
+//	Get the name of a primitive type, used when the
+//  render statistics are exported.
+// 
+///////////////////////////////////////////////////
+const char* ShapeMeshes::GetMeshTypeName(MeshType type)
+{
+	switch (type)
+	{
+	case box:
+		return "box";
+	case cone:
+		return "cone";
+	case cylinder:
+		return "cylinder";
+	case plane:
+		return "plane";
+	case prism:
+		return "prism";
+	case pyramid3:
+		return "pyramid3";
+	case pyramid4:
+		return "pyramid4";
+	case sphere:
+		return "sphere";
+	case taperedCylinder:
+		return "tapered_cylinder";
+	case torus:
+		return "torus";
+	default:
+		return "unknown";
+	}
 }
 
 //**************************************************************************
@@ -112,6 +166,10 @@ void ShapeMeshes::LoadBoxMesh()
 	m_BoxMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 	m_BoxMesh.nIndices = sizeof(indices) / sizeof(indices[0]);
 
+	// keep the triangles of the filled mesh for picking
+	m_meshTriangles[box].Clear();
+	AddMeshTriangles(m_meshTriangles[box], verts, m_BoxMesh.nVertices, GL_TRIANGLES, 0, m_BoxMesh.nIndices, indices);
+
 	glGenVertexArrays(1, &m_BoxMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_BoxMesh.vao);
 
@@ -298,6 +356,11 @@ void ShapeMeshes::LoadConeMesh()
 	m_ConeMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 	m_ConeMesh.nIndices = 0;
 
+	// keep the triangles of the filled mesh for picking
+	m_meshTriangles[cone].Clear();
+	AddMeshTriangles(m_meshTriangles[cone], verts, m_ConeMesh.nVertices, GL_TRIANGLE_FAN, 0, 36);
+	AddMeshTriangles(m_meshTriangles[cone], verts, m_ConeMesh.nVertices, GL_TRIANGLE_STRIP, 36, 108);
+
 	// Create VAO
 	glGenVertexArrays(1, &m_ConeMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_ConeMesh.vao);
@@ -558,6 +621,12 @@ void ShapeMeshes::LoadCylinderMesh()
 	m_CylinderMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 	m_CylinderMesh.nIndices = 0;
 
+	// keep the triangles of the filled mesh for picking
+	m_meshTriangles[cylinder].Clear();
+	AddMeshTriangles(m_meshTriangles[cylinder], verts, m_CylinderMesh.nVertices, GL_TRIANGLE_FAN, 0, 36);
+	AddMeshTriangles(m_meshTriangles[cylinder], verts, m_CylinderMesh.nVertices, GL_TRIANGLE_FAN, 36, 36);
+	AddMeshTriangles(m_meshTriangles[cylinder], verts, m_CylinderMesh.nVertices, GL_TRIANGLE_STRIP, 72, 146);
+
 	// Create VAO
 	glGenVertexArrays(1, &m_CylinderMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_CylinderMesh.vao);
@@ -605,6 +674,10 @@ void ShapeMeshes::LoadPlaneMesh()
 	m_PlaneMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 	m_PlaneMesh.nIndices = sizeof(indices) / sizeof(indices[0]);
 
+	// keep the triangles of the filled mesh for picking
+	m_meshTriangles[plane].Clear();
+	AddMeshTriangles(m_meshTriangles[plane], verts, m_PlaneMesh.nVertices, GL_TRIANGLES, 0, m_PlaneMesh.nIndices, indices);
+
 	// Generate the VAO for the mesh
 	glGenVertexArrays(1, &m_PlaneMesh.vao);
 	glBindVertexArray(m_PlaneMesh.vao);	// activate the VAO
@@ -687,6 +760,10 @@ void ShapeMeshes::LoadPrismMesh()
 
 	m_PrismMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 
+	// keep the triangles of the filled mesh for picking
+	m_meshTriangles[prism].Clear();
+	AddMeshTriangles(m_meshTriangles[prism], verts, m_PrismMesh.nVertices, GL_TRIANGLE_STRIP, 0, m_PrismMesh.nVertices);
+
 	glGenVertexArrays(1, &m_PrismMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_PrismMesh.vao);
 
@@ -742,6 +819,10 @@ void ShapeMeshes::LoadPyramid3Mesh()
 	// Calculate total defined vertices
 	m_Pyramid3Mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 
+	// keep the triangles of the filled mesh for picking
+	m_meshTriangles[pyramid3].Clear();
+	AddMeshTriangles(m_meshTriangles[pyramid3], verts, m_Pyramid3Mesh.nVertices, GL_TRIANGLE_STRIP, 0, m_Pyramid3Mesh.nVertices);
+
 	glGenVertexArrays(1, &m_Pyramid3Mesh.vao);				// Creates 1 VAO
 	glGenBuffers(1, m_Pyramid3Mesh.vbos);					// Creates 1 VBO
 	glBindVertexArray(m_Pyramid3Mesh.vao);					// Activates the VAO
@@ -805,6 +886,10 @@ void ShapeMeshes::LoadPyramid4Mesh()
 	// Calculate total defined vertices
 	m_Pyramid4Mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 
+	// keep the triangles of the filled mesh for picking
+	m_meshTriangles[pyramid4].Clear();
+	AddMeshTriangles(m_meshTriangles[pyramid4], verts, m_Pyramid4Mesh.nVertices, GL_TRIANGLE_STRIP, 0, m_Pyramid4Mesh.nVertices);
+
 	glGenVertexArrays(1, &m_Pyramid4Mesh.vao);				// Creates 1 VAO
 	glGenBuffers(1, m_Pyramid4Mesh.vbos);					// Creates 1 VBO
 	glBindVertexArray(m_Pyramid4Mesh.vao);					// Activates the VAO
@@ -831,860 +916,9 @@ void ShapeMeshes::LoadPyramid4Mesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadSphereMesh()
 {
-	GLfloat verts[] = {
-		// vertex data					// texture coords			// index
-		// top center point
-		0.0f, 1.0f, 0.0f,				0.5f, 1.0f,					//0
-		// ring 1
-		0.0f, 0.9808f, 0.1951f,			0.5f, 0.9375f,				//1
-		0.0747f, 0.9808f, 0.1802f,		0.51219375f, 0.9375f,		//2
-		0.1379f, 0.9808f, 0.1379f,		0.5243875f, 0.9375f,		//3
-		0.1802f, 0.9808f, 0.0747f,		0.53658125f, 0.9375f,		//4
-		0.1951f, 0.9808, 0.0f,			0.548775f, 0.9375f,			//5
-		0.1802f, 0.9808f, -0.0747f,		0.56096875f, 0.9375f,		//6
-		0.1379f, 0.9808f, -0.1379f,		0.5731625f, 0.9375f,		//7
-		0.0747f, 0.9808f, -0.1802f,		0.58535625f, 0.9375f,		//8
-		0.0f, 0.9808f, -0.1951f,		0.59755f, 0.9375f,			//9 - seam
-		0.0f, 0.9808f, -0.1951f,		0.40245f, 0.9375f,			//10 - seam
-		-0.0747f, 0.9808f, -0.1802f,	0.41464375f, 0.9375f,		//11
-		-0.1379f, 0.9808f, -0.1379f,	0.4268375f, 0.9375f,		//12
-		-0.1802f, 0.9808f, -0.0747f,	0.43903125f, 0.9375f,		//13
-		-0.1951f, 0.9808, 0.0f,			0.451225f, 0.9375f,			//14
-		-0.1802f, 0.9808f, 0.0747f,		0.46341875f, 0.9375f,		//15
-		-0.1379f, 0.9808f, 0.1379f,		0.4756125f, 0.9375f,		//16
-		-0.0747f, 0.9808f, 0.1802f,		0.48780625f, 0.9375f,		//17
-		// ring 2
-		0.0f, 0.9239f, 0.3827f,			0.5f, 0.875f,				//18
-		0.1464f, 0.9239f, 0.3536f,		0.52391875f, 0.875f,		//19
-		0.2706f, 0.9239f, 0.2706f,		0.5478375f, 0.875f,			//20
-		0.3536f, 0.9239f, 0.1464f,		0.57175625f, 0.875f,		//21
-		0.3827f, 0.9239f, 0.0f,			0.5956755f, 0.875f,			//22
-		0.3536f, 0.9239f, -0.1464f,		0.61959425f, 0.875f,		//23
-		0.2706f, 0.9239f, -0.2706f,		0.643513f, 0.875f,			//24
-		0.1464f, 0.9239f, -0.3536f,		0.66743175f, 0.875f,		//25
-		0.0f, 0.9239f, -0.3827f,		0.6913505f, 0.875f,			//26 - seam
-		0.0f, 0.9239f, -0.3827f,		0.3086495f, 0.875f,			//27 - seam
-		-0.1464f, 0.9239f, -0.3536f,	0.33256825f, 0.875f,		//28
-		-0.2706f, 0.9239f, -0.2706f,	0.356487f, 0.875f,			//29
-		-0.3536f, 0.9239f, -0.1464f,	0.38040575f, 0.875f,		//30
-		-0.3827f, 0.9239f, 0.0f,		0.4043245f, 0.875f,			//31
-		-0.3536f, 0.9239f, 0.1464f,		0.42824325f, 0.875f,		//32
-		-0.2706f, 0.9239f, 0.2706f,		0.452162f, 0.875f,			//33
-		-0.1464f, 0.9239f, 0.3536f,		0.47608075f, 0.875f,		//34
-		// ring 3
-		0.0f, 0.8315f, 0.5556f,			0.5f, 0.8125f,				//35
-		0.2126f, 0.8315f, 0.5133f,		0.534725f, 0.8125f,			//36
-		0.3928f, 0.8315f, 0.3928f,		0.56945f, 0.8125f,			//37
-		0.5133f, 0.8315f, 0.2126f,		0.604175f, 0.8125f,			//38
-		0.5556f, 0.8315f, 0.0f,			0.6389f, 0.8125f,			//39
-		0.5133f, 0.8315f, -0.2126f,		0.673625f, 0.8125f,			//40
-		0.3928f, 0.8315f, -0.3928f,		0.70835f, 0.8125f,			//41
-		0.2126f, 0.8315f, -0.5133f,		0.743075f, 0.8125f,			//42
-		0.0f, 0.8315f, -0.5556f,		0.7778f, 0.8125f,			//43 - seam
-		0.0f, 0.8315f, -0.5556f,		0.2222f, 0.8125f,			//44 - seam
-		-0.2126f, 0.8315f, -0.5133f,	0.256925f, 0.8125f,			//45
-		-0.3928f, 0.8315f, -0.3928f,	0.29165f, 0.8125f,			//46
-		-0.5133f, 0.8315f, -0.2126f,	0.326375f, 0.8125f,			//47
-		-0.5556f, 0.8315f, 0.0f,		0.3611f, 0.8125f,			//48
-		-0.5133f, 0.8315f, 0.2126f,		0.395825f, 0.8125f,			//49
-		-0.3928f, 0.8315f, 0.3928f,		0.43055f, 0.8125f,			//50
-		-0.2126f, 0.8315f, 0.5133f,		0.465275f, 0.8125f,			//51
-		// ring 4
-		0.0f, 0.7071f, 0.7071f,			0.5f, 0.75f,				//52
-		0.2706f, 0.7071f, 0.6533f,		0.54419375f, 0.75f,			//53
-		0.5f, 0.7071f, 0.5f,			0.5883875f, 0.75f,			//54
-		0.6533f, 0.7071f, 0.2706f,		0.63258125f, 0.75f,			//55
-		0.7071f, 0.7071f, 0.0f,			0.676775f, 0.75f,			//56
-		0.6533f, 0.7071f, -0.2706f,		0.72096875f, 0.75f,			//57
-		0.5f, 0.7071f, -0.5f,			0.7651625f, 0.75f,			//58
-		0.2706f, 0.7071f, -0.6533f,		0.80935625f, 0.75f,			//59
-		0.0f, 0.7071f, -0.7071f,		0.85355f, 0.75f,			//60 - seam
-		0.0f, 0.7071f, -0.7071f,		0.14645f, 0.75f,			//61 - seam
-		-0.2706f, 0.7071f, -0.6533f,	0.19064375f, 0.75f,			//62
-		-0.5f, 0.7071f, -0.5f,			0.2348375f, 0.75f,			//63
-		-0.6533f, 0.7071f, -0.2706f,	0.27903135f, 0.75f,			//64
-		-0.7071f, 0.7071f, 0.0f,		0.323225f, 0.75f,			//65
-		-0.6533f, 0.7071f, 0.2706f,		0.36741875f, 0.75f,			//66
-		-0.5f, 0.7071f, 0.5f,			0.4116125f, 0.75f,			//67
-		-0.2706f, 0.7071f, 0.6533f,		0.45580625f, 0.75f,			//68
-		// ring 5
-		0.0f, 0.5556f, 0.8315f,			0.5f, 0.6875f,				//69
-		0.3182f, 0.5556f, 0.7682f,		0.55196875f, 0.6875f,		//70
-		0.5879f, 0.5556f, 0.5879f,		0.6039375f, 0.6875f,		//71
-		0.7682f, 0.5556f, 0.3182f,		0.65590625f, 0.6875f,		//72
-		0.8315f, 0.5556f, 0.0f,			0.707875f, 0.6875f,			//73
-		0.7682f, 0.5556f, -0.3182f,		0.75984375f, 0.6875f,		//74
-		0.5879f, 0.5556f, -0.5879f,		0.8118125f, 0.6875f,		//75
-		0.3182f, 0.5556f, -0.7682f,		0.86378125f, 0.6875f,		//76
-		0.0f, 0.5556f, -0.8315f,		0.91575f, 0.6875f,			//77 - seam
-		0.0f, 0.5556f, -0.8315f,		0.08425f, 0.6875f,			//78 - seam
-		-0.3182f, 0.5556f, -0.7682f,	0.13621875f, 0.6875f,		//79
-		-0.5879f, 0.5556f, -0.5879f,	0.1881875f, 0.6875f,		//80
-		-0.7682f, 0.5556f, -0.3182f,	0.24015625f, 0.6875f,		//81
-		-0.8315f, 0.5556f, 0.0f,		0.292125f, 0.6875f,			//82
-		-0.7682f, 0.5556f, 0.3182f,		0.34409375f, 0.6875f,		//83
-		-0.5879f, 0.5556f, 0.5879f,		0.3960625f, 0.6875f,		//84
-		-0.3182f, 0.5556f, 0.7682f,		0.44803125f, 0.6875f,		//85
-		//ring 6
-		0.0f, 0.3827f, 0.9239f,			0.5f, 0.625f,				//86
-		0.3536f, 0.3827f, 0.8536f,		0.55774375f, 0.625f,		//87
-		0.6533f, 0.3827f, 0.6533f,		0.6154875f, 0.625f,			//88
-		0.8536f, 0.3827f, 0.3536f,		0.67323125f, 0.625f,		//89
-		0.9239f, 0.3827f, 0.0f,			0.730975f, 0.625f,			//90
-		0.8536f, 0.3827f, -0.3536f,		0.78871875f, 0.625f,		//91
-		0.6533f, 0.3827f, -0.6533f,		0.8464625f, 0.625f,			//92
-		0.3536f, 0.3827f, -0.8536f,		0.90420625f, 0.625f,		//93
-		0.0f, 0.3827f, -0.9239f,		0.96195f, 0.625f,			//94 - seam
-		0.0f, 0.3827f, -0.9239f,		0.03805f, 0.625f,			//95 - seam
-		-0.3536f, 0.3827f, -0.8536f,	0.09579375f, 0.625f,		//96
-		-0.6533f, 0.3827f, -0.6533f,	0.1535375f, 0.625f,			//97
-		-0.8536f, 0.3827f, -0.3536f,	0.21128125f, 0.625f,		//98
-		-0.9239f, 0.3827f, 0.0f,		0.269025f, 0.625f,			//99
-		-0.8536f, 0.3827f, 0.3536f,		0.32676875f, 0.625f,		//100
-		-0.6533f, 0.3827f, 0.6533f,		0.3845125f, 0.625f,			//101
-		-0.3536f, 0.3827f, 0.8536f,		0.44225625f, 0.625f,		//102
-		// ring 7
-		0.0f, 0.1951f, 0.9808f,			0.5f, 0.5625f,				//103
-		0.3753f, 0.1915f, 0.9061f,		0.5613f, 0.5625f,			//104
-		0.6935f, 0.1915f, 0.6935f,		0.6226f, 0.5625f,			//105
-		0.9061f, 0.1915f, 0.3753f,		0.6839f, 0.5625f,			//106
-		0.9808f, 0.1915f, 0.0f,			0.7452f, 0.5625f,			//107
-		0.9061f, 0.1915f, -0.3753f,		0.8065f, 0.5625f,			//108
-		0.6935f, 0.1915f, -0.6935f,		0.8678f, 0.5625f,			//109
-		0.3753f, 0.1915f, -0.9061f,		0.9291f, 0.5625f,			//110
-		0.0f, 0.1915f, -0.9808f,		0.9904f, 0.5625f,			//111 - seam
-		0.0f, 0.1915f, -0.9808f,		0.0096f, 0.5625f,			//112 - seam
-		-0.3753f, 0.1915f, -0.9061f,	0.0709f, 0.5625f,			//113
-		-0.6935f, 0.1915f, -0.6935f,	0.1322f, 0.5625f,			//114
-		-0.9061f, 0.1915f, -0.3753f,	0.1935f, 0.5625f,			//115
-		-0.9808f, 0.1915f, 0.0f,		0.2548f, 0.5625f,			//116
-		-0.9061f, 0.1915f, 0.3753f,		0.3161f, 0.5625f,			//117
-		-0.6935f, 0.1915f, 0.6935f,		0.3774f, 0.5625f,			//118
-		-0.3753f, 0.1915f, 0.9061f,		0.4387f, 0.5625f,			//119
-		// ring 8
-		0.0f, 0.0f, 1.0f,				0.5f, 0.5f,					//120
-		0.3827f, 0.0f, 0.9239f,			0.5625f, 0.5f,				//121
-		0.7071f, 0.0f, 0.7071f,			0.625f, 0.5f,				//122
-		0.9239f, 0.0f, 0.3827f,			0.6875f, 0.5f,				//123
-		1.0f, 0.0f, 0.0f,				0.75f, 0.5f,				//124
-		0.9239f, 0.0f, -0.3827f,		0.8125f, 0.5f,				//125
-		0.7071f, 0.0f, -0.7071f,		0.875f, 0.5f,				//126
-		0.3827f, 0.0f, -0.9239f,		0.9375f, 0.5f,				//127
-		0.0f, 0.0f, -1.0f,				1.0f, 0.5f,					//128 - seam
-		0.0f, 0.0f, -1.0f, 				0.0f, 0.5f,					//129 - seam
-		-0.3827f, 0.0f, -0.9239f,		0.0625f, 0.5f,				//130
-		-0.7071f, 0.0f, -0.7071f,		0.125f, 0.5f,				//131
-		-0.9239f, 0.0f, -0.3827f,		0.1875f, 0.5f,				//132
-		-1.0f, 0.0f, 0.0f,				0.25f, 0.5f,				//133
-		-0.9239f, 0.0f, 0.3827f,		0.3125f, 0.5f,				//134
-		-0.7071, 0.0, 0.7071f,			0.375f, 0.5f,				//135
-		-0.3827f, 0.0f, 0.9239f,		0.4375f, 0.5f,				//136
-		// ring 9
-		0.0f, -0.1915f, 0.9808f,		0.5f, 0.4375f,				//137
-		0.3753f, -0.1915f, 0.9061f,		0.5613f, 0.4375f,			//138
-		0.6935f, -0.1915f, 0.6935f,		0.6226f, 0.4375f,			//139
-		0.9061f, -0.1915f, 0.3753f,		0.6839f, 0.4375f,			//140
-		0.9808f, -0.1915f, 0.0f,		0.7452f, 0.4375f,			//141
-		0.9061f, -0.1915f, -0.3753f,	0.8065f, 0.4375f,			//142
-		0.6935f, -0.1915f, -0.6935f,	0.8678f, 0.4375f,			//143
-		0.3753f, -0.1915f, -0.9061f,	0.9261f, 0.4375f,			//144
-		0.0f, -0.1915f, -0.9808f,		0.9904f, 0.4375f,			//145 - seam
-		0.0f, -0.1915f, -0.9808f,		0.0096f, 0.4375f,			//146 - seam
-		-0.3753f, -0.1915f, -0.9061f,	0.0709f, 0.4375f,			//147
-		-0.6935f, -0.1915f, -0.6935f,	0.1322f, 0.4375f,			//148
-		-0.9061f, -0.1915f, -0.3753f,	0.1935f, 0.4375f,			//149
-		-0.9808f, -0.1915f, 0.0f,		0.2548f, 0.4375f,			//150
-		-0.9061f, -0.1915f, 0.3753f,	0.3161f, 0.4375f,			//151
-		-0.6935f, -0.1915f, 0.6935f,	0.3774f, 0.4375f,			//152
-		-0.3753f, -0.1915f, 0.9061f,	0.4387f, 0.4375f,			//153
-		// ring 10
-		0.0f, -0.3827f, 0.9239f,		0.5f, 0.375f,				//154
-		0.3536f, -0.3827f, 0.8536f,		0.55774375f, 0.375f,		//155
-		0.6533f, -0.3827f, 0.6533f,		0.6154875f, 0.375f,			//156
-		0.8536f, -0.3827f, 0.3536f,		0.67323125f, 0.375f,		//157
-		0.9239f, -0.3827f, 0.0f,		0.730975f, 0.375f,			//158
-		0.8536f, -0.3827f, -0.3536f,	0.78871875f, 0.375f,		//159
-		0.6533f, -0.3827f, -0.6533f,	0.8464625f, 0.375f,			//160
-		0.3536f, -0.3827f, -0.8536f,	0.90420625f, 0.375f,		//161
-		0.0f, -0.3827f, -0.9239f,		0.96195f, 0.375f,			//162 - seam
-		0.0f, -0.3827f, -0.9239f,		0.03805f, 0.375f,			//163 - seam
-		-0.3536f, -0.3827f, -0.8536f,	0.09579375f, 0.375f,		//164
-		-0.6533f, -0.3827f, -0.6533f,	0.1535375f, 0.375f,			//165
-		-0.8536f, -0.3827f, -0.3536f,	0.21128125f, 0.375f,		//166
-		-0.9239f, -0.3827f, 0.0f,		0.269025f, 0.375f,			//167
-		-0.8536f, -0.3827f, 0.3536f,	0.32676875f, 0.375f,		//168
-		-0.6533f, -0.3827f, 0.6533f,	0.3845125f, 0.375f,			//169
-		-0.3536f, -0.3827f, 0.8536f,	0.44225625f, 0.375f,		//170
-		// ring 11
-		0.0f, -0.5556f, 0.8315f,		0.5f, 0.3125f,				//171
-		0.3182f, -0.5556f, 0.7682f,		0.55196875f, 0.3125f,		//172
-		0.5879f, -0.5556f, 0.5879f,		0.6039375f, 0.3125f,		//173
-		0.7682f, -0.5556f, 0.3182f,		0.65590625f, 0.3125f,		//174
-		0.8315f, -0.5556f, 0.0f,		0.707875f, 0.3125f,			//175
-		0.7682f, -0.5556f, -0.3182f,	0.75984375f, 0.3125f,		//176
-		0.5879f, -0.5556f, -0.5879f,	0.8118125f, 0.3125f,		//177
-		0.3182f, -0.5556f, -0.7682f,	0.86378125f, 0.3125f,		//178
-		0.0f, -0.5556f, -0.8315f,		0.91575f, 0.3125f,			//179 - seam
-		0.0f, -0.5556f, -0.8315f,		0.08425f, 0.3125f,			//180 - seam
-		-0.3182f, -0.5556f, -0.7682f,	0.13621875f, 0.3125f,		//181
-		-0.5879f, -0.5556f, -0.5879f,	0.1881875f, 0.3125f,		//182
-		-0.7682f, -0.5556f, -0.3182f,	0.24015625f, 0.3125f,		//183
-		-0.8315f, -0.5556f, 0.0f,		0.292125f, 0.3125f,			//184
-		-0.7682f, -0.5556f, 0.3182f,	0.34409375f, 0.3125f,		//185
-		-0.5879f, -0.5556f, 0.5879f,	0.3960625f, 0.3125f,		//186
-		-0.3182f, -0.5556f, 0.7682f,	0.44803125f, 0.3125f,		//187
-		// ring 12
-		0.0f, -0.7071f, 0.7071f,		0.5f, 0.25f,				//188
-		0.2706f, -0.7071f, 0.6533f,		0.54419375f, 0.25f,			//189
-		0.5f, -0.7071f, 0.5f,			0.5883875f, 0.25f,			//190
-		0.6533f, -0.7071f, 0.2706f,		0.63258125f, 0.25f,			//191
-		0.7071f, -0.7071f, 0.0f,		0.676775f, 0.25f,			//192
-		0.6533f, -0.7071f, -0.2706f,	0.72096875f, 0.25f,			//193
-		0.5f, -0.7071f, -0.5f,			0.7651625f, 0.25f,			//194
-		0.2706f, -0.7071f, -0.6533f,	0.80935625f, 0.25f,			//195
-		0.0f, -0.7071f, -0.7071f,		0.85355f, 0.25f,			//196 - seam
-		0.0f, -0.7071f, -0.7071f,		0.14645f, 0.25f,			//197 - seam
-		-0.2706f, -0.7071f, -0.6533f,	0.19064375f, 0.25f,			//198
-		-0.5f, -0.7071f, -0.5f,			0.2348375f, 0.25f,			//199
-		-0.6533f, -0.7071f, -0.2706f,	0.27903135f, 0.25f,			//200
-		-0.7071f, -0.7071f, 0.0f,		0.323225f, 0.25f,			//201
-		-0.6533f, -0.7071f, 0.2706f,	0.36741875f, 0.25f,			//202
-		-0.5f, -0.7071f, 0.5f,			0.4116125f, 0.25f,			//203
-		-0.2706f, -0.7071f, 0.6533f,	0.45580625f, 0.25f,			//204
-		// ring 13
-		0.0f, -0.8315f, 0.5556f,		0.5f, 0.1875f,				//205
-		0.2126f, -0.8315f, 0.5133f,		0.534725f, 0.1875f,			//206
-		0.3928f, -0.8315f, 0.3928f,		0.56945f, 0.1875f,			//207
-		0.5133f, -0.8315f, 0.2126f,		0.604175f, 0.1875f,			//208
-		0.5556f, -0.8315f, 0.0f,		0.6389f, 0.1875f,			//209
-		0.5133f, -0.8315f, -0.2126f,	0.673625f, 0.1875f,			//210
-		0.3928f, -0.8315f, -0.3928f,	0.70835f, 0.1875f,			//211
-		0.2126f, -0.8315f, -0.5133f,	0.743075f, 0.1875f,			//212
-		0.0f, -0.8315f, -0.5556f,		0.7778f, 0.1875f,			//213 - seam
-		0.0f, -0.8315f, -0.5556f,		0.2222f, 0.1875f,			//214 - seam
-		-0.2126f, -0.8315f, -0.5133f,	0.256925f, 0.1875f,			//215
-		-0.3928f, -0.8315f, -0.3928f,	0.29165f, 0.1875f,			//216
-		-0.5133f, -0.8315f, -0.2126f,	0.326375f, 0.1875f,			//217
-		-0.5556f, -0.8315f, 0.0f,		0.3611f, 0.1875f,			//218
-		-0.5133f, -0.8315f, 0.2126f,	0.395825f, 0.1875f,			//219
-		-0.3928f, -0.8315f, 0.3928f,	0.43055f, 0.1875f,			//220
-		-0.2126f, -0.8315f, 0.5133f,	0.465275f, 0.1875f,			//221
-		// ring 14
-		0.0f, -0.9239f, 0.3827f,		0.5f, 0.125f,				//222
-		0.1464f, -0.9239f, 0.3536f,		0.52391875f, 0.125f,		//223
-		0.2706f, -0.9239f, 0.2706f,		0.5478375f, 0.125f,			//224
-		0.3536f, -0.9239f, 0.1464f,		0.57175625f, 0.125f,		//225
-		0.3827f, -0.9239f, 0.0f,		0.5956755f, 0.125f,			//226
-		0.3536f, -0.9239f, -0.1464f,	0.61959425f, 0.125f,		//227
-		0.2706f, -0.9239f, -0.2706f,	0.643513f, 0.125f,			//228
-		0.1464f, -0.9239f, -0.3536f,	0.66743175f, 0.125f,		//229
-		0.0f, -0.9239f, -0.3827f,		0.6913505f, 0.125f,			//230 - seam
-		0.0f, -0.9239f, -0.3827f,		0.3086495f, 0.125f,			//231 - seam
-		-0.1464f, -0.9239f, -0.3536f,	0.33256825f, 0.125f,		//232
-		-0.2706f, -0.9239f, -0.2706f,	0.356487f, 0.125f,			//233
-		-0.3536f, -0.9239f, -0.1464f,	0.38040575f, 0.125f,		//234
-		-0.3827f, -0.9239f, 0.0f,		0.4043245f, 0.125f,			//235
-		-0.3536f, -0.9239f, 0.1464f,	0.42824325f, 0.125f,		//236
-		-0.2706f, -0.9239f, 0.2706f,	0.452162f, 0.125f,			//237
-		-0.1464f, -0.9239f, 0.3536f,	0.47608075f, 0.125f,		//238
-		// ring 15
-		0.0f, -0.9808f, 0.1951f,		0.5f, 0.0625f,				//239
-		0.0747f, -0.9808f, 0.1802f,		0.51219375f, 0.0625f,		//240
-		0.1379f, -0.9808f, 0.1379f,		0.5243875f, 0.0625f,		//241
-		0.1802f, -0.9808f, 0.0747f,		0.53658125f, 0.0625f,		//242
-		0.1951f, -0.9808, 0.0f,			0.548775f, 0.0625f,			//243
-		0.1802f, -0.9808f, -0.0747f,	0.56096875f, 0.0625f,		//244
-		0.1379f, -0.9808f, -0.1379f,	0.5731625f, 0.0625f,		//245
-		0.0747f, -0.9808f, -0.1802f,	0.58535625f, 0.0625f,		//246
-		0.0f, -0.9808f, -0.1951f,		0.59755f, 0.0625f,			//247 - seam
-		0.0f, -0.9808f, -0.1951f,		0.40245f, 0.0625f,			//248 - seam
-		-0.0747f, -0.9808f, -0.1802f,	0.41464375f, 0.0625f,		//249
-		-0.1379f, -0.9808f, -0.1379f,	0.4268375f, 0.0625f,		//250
-		-0.1802f, -0.9808f, -0.0747f,	0.43903125f, 0.0625f,		//251
-		-0.1951f, -0.9808, 0.0f,		0.451225f, 0.0625f,			//252
-		-0.1802f, -0.9808f, 0.0747f,	0.46341875f, 0.0625f,		//253
-		-0.1379f, -0.9808f, 0.1379f,	0.4756125f, 0.0625f,		//254
-		-0.0747f, -0.9808f, 0.1802f,	0.48780625f, 0.0625f,		//255
-		// bottom center point
-		0.0f, -1.0f, 0.0f,				0.5f, 0.0f					//256
-	};
-
-	// index data
-	GLuint indices[] = {
-		//ring 1 - top
-		0,10,11,
-		0,11,12,
-		0,12,13,
-		0,13,14,
-		0,14,15,
-		0,15,16,
-		0,16,17,
-		0,17,1,
-		0,1,2,
-		0,2,3,
-		0,3,4,
-		0,4,5,
-		0,5,6,
-		0,6,7,
-		0,7,8,
-		0,8,9,
-		0,9,10,
-
-		// ring 1 to ring 2
-		10,27,28,
-		10,11,28,
-		11,28,29,
-		11,12,29,
-		12,29,30,
-		12,13,30,
-		13,30,31,
-		13,14,31,
-		14,31,32,
-		14,15,32,
-		15,32,33,
-		15,16,33,
-		16,33,34,
-		16,17,34,
-		17,34,18,
-		17,1,18,
-		1,18,19,
-		1,2,19,
-		2,19,20,
-		2,3,20,
-		3,20,21,
-		3,4,21,
-		4,21,22,
-		4,5,22,
-		5,22,23,
-		5,6,23,
-		6,23,24,
-		6,7,24,
-		7,24,25,
-		7,8,25,
-		8,25,26,
-		8,9,26,
-		9,26,27,
-		9,10,27,
-
-		// ring 2 to ring 3
-		27,44,45,
-		27,28,45,
-		28,45,46,
-		28,29,46,
-		29,46,47,
-		29,30,47,
-		30,47,48,
-		30,31,48,
-		31,48,49,
-		31,32,49,
-		32,49,50,
-		32,33,50,
-		33,50,51,
-		33,34,51,
-		34,51,35,
-		34,18,35,
-		18,35,36,
-		18,19,36,
-		19,36,37,
-		19,20,37,
-		20,37,38,
-		20,21,38,
-		21,38,39,
-		21,22,39,
-		22,39,40,
-		22,23,40,
-		23,40,41,
-		23,24,41,
-		24,41,42,
-		24,25,42,
-		25,42,43,
-		25,26,43,
-		26,43,44,
-		26,27,44,
-
-		// ring 3 to ring 4
-		44,61,62,
-		44,45,62,
-		45,62,63,
-		45,46,63,
-		46,63,64,
-		46,47,64,
-		47,64,65,
-		47,48,65,
-		48,65,66,
-		48,49,66,
-		49,66,67,
-		49,50,67,
-		50,67,68,
-		50,51,68,
-		51,68,52,
-		51,35,52,
-		35,52,53,
-		35,36,53,
-		36,53,54,
-		36,37,54,
-		37,54,55,
-		37,38,55,
-		38,55,56,
-		38,39,56,
-		39,56,57,
-		39,40,57,
-		40,57,58,
-		40,41,58,
-		41,58,59,
-		41,42,59,
-		42,59,60,
-		42,43,60,
-		43,60,61,
-		43,44,61,
-
-		// ring 4 to ring 5
-		61,78,79,
-		61,62,79,
-		62,79,80,
-		62,63,80,
-		63,80,81,
-		63,64,81,
-		64,81,82,
-		64,65,82,
-		65,82,83,
-		65,66,83,
-		66,83,84,
-		66,67,84,
-		67,84,85,
-		67,68,85,
-		68,85,69,
-		68,52,69,
-		52,69,70,
-		52,53,70,
-		53,70,71,
-		53,54,71,
-		54,71,72,
-		54,55,72,
-		55,72,73,
-		55,56,73,
-		56,73,74,
-		56,57,74,
-		57,74,75,
-		57,58,75,
-		58,75,76,
-		58,59,76,
-		59,76,77,
-		59,60,77,
-		60,77,78,
-		60,61,78,
-
-		// ring 5 to ring 6
-		78,95,96,
-		78,79,96,
-		79,96,97,
-		79,80,97,
-		80,97,98,
-		80,81,98,
-		81,98,99,
-		81,82,99,
-		82,99,100,
-		82,83,100,
-		83,100,101,
-		83,84,101,
-		84,101,102,
-		84,85,102,
-		85,102,86,
-		85,69,86,
-		69,86,87,
-		69,70,87,
-		70,87,88,
-		70,71,88,
-		71,88,89,
-		71,72,89,
-		72,89,90,
-		72,73,90,
-		73,90,91,
-		73,74,91,
-		74,91,92,
-		74,75,92,
-		75,92,93,
-		75,76,93,
-		76,93,94,
-		76,77,94,
-		77,94,95,
-		77,78,95,
-
-		// ring 6 to ring 7
-		95,112,113,
-		95,96,113,
-		96,113,114,
-		96,97,114,
-		97,114,115,
-		97,98,115,
-		98,115,116,
-		98,99,116,
-		99,116,117,
-		99,100,117,
-		100,117,118,
-		100,101,118,
-		101,118,119,
-		101,102,119,
-		102,119,103,
-		102,86,103,
-		86,103,104,
-		86,87,104,
-		87,104,105,
-		87,88,105,
-		88,105,106,
-		88,89,106,
-		89,106,107,
-		89,90,107,
-		90,107,108,
-		90,91,108,
-		91,108,109,
-		91,92,109,
-		92,109,110,
-		92,93,110,
-		93,110,111,
-		93,94,111,
-		94,111,112,
-		94,95,112,
-
-		// ring 7 to ring 8
-		112,129,130,
-		112,113,130,
-		113,130,131,
-		113,114,131,
-		114,131,132,
-		114,115,132,
-		115,132,133,
-		115,116,133,
-		116,133,134,
-		116,117,134,
-		117,134,135,
-		117,118,135,
-		118,135,136,
-		118,119,136,
-		119,136,120,
-		119,103,120,
-		103,120,121,
-		103,104,121,
-		104,121,122,
-		104,105,122,
-		105,122,123,
-		105,106,123,
-		106,123,124,
-		106,107,124,
-		107,124,125,
-		107,108,125,
-		108,125,126,
-		108,109,126,
-		109,126,127,
-		109,110,127,
-		110,127,128,
-		110,111,128,
-		111,128,129,
-		111,112,129,
-
-		// ring 8 to ring 9
-		129,146,147,
-		129,130,147,
-		130,147,148,
-		130,131,148,
-		131,148,149,
-		131,132,149,
-		132,149,150,
-		132,133,150,
-		133,150,151,
-		133,134,151,
-		134,151,152,
-		134,135,152,
-		135,152,153,
-		135,136,153,
-		136,153,137,
-		136,120,137,
-		120,137,138,
-		120,121,138,
-		121,138,139,
-		121,122,139,
-		122,139,140,
-		122,123,140,
-		123,140,141,
-		123,124,141,
-		124,141,142,
-		124,125,142,
-		125,142,143,
-		125,126,143,
-		126,143,144,
-		126,127,144,
-		127,144,145,
-		127,128,145,
-		128,145,146,
-		128,129,146,
-
-		// ring 9 to ring 10
-		146,163,164,
-		146,147,164,
-		147,164,165,
-		147,148,165,
-		148,165,166,
-		148,149,166,
-		149,166,167,
-		149,150,167,
-		150,167,168,
-		150,151,168,
-		151,168,169,
-		151,152,169,
-		152,169,170,
-		152,153,170,
-		153,170,154,
-		153,137,154,
-		137,154,155,
-		137,138,155,
-		138,155,156,
-		138,139,156,
-		139,156,157,
-		139,140,157,
-		140,157,158,
-		140,141,158,
-		141,158,159,
-		141,142,159,
-		142,159,160,
-		142,143,160,
-		143,160,161,
-		143,144,161,
-		144,161,162,
-		144,145,162,
-		145,162,163,
-		145,146,163,
-
-		// ring 10 to ring 11
-		163,180,181,
-		163,164,181,
-		164,181,182,
-		164,165,182,
-		165,182,183,
-		165,166,183,
-		166,183,184,
-		166,167,184,
-		167,184,185,
-		167,168,185,
-		168,185,186,
-		168,169,186,
-		169,186,187,
-		169,170,187,
-		170,187,171,
-		170,154,171,
-		154,171,172,
-		154,155,172,
-		155,172,173,
-		155,156,173,
-		156,173,174,
-		156,157,174,
-		157,174,175,
-		157,158,175,
-		158,175,176,
-		158,159,176,
-		159,176,177,
-		159,160,177,
-		160,177,178,
-		160,161,178,
-		161,178,179,
-		161,162,179,
-		162,179,180,
-		162,163,180,
-
-		// ring 11 to ring 12
-		180,197,198,
-		180,181,198,
-		181,198,199,
-		181,182,199,
-		182,199,200,
-		182,183,200,
-		183,200,201,
-		183,184,201,
-		184,201,202,
-		184,185,202,
-		185,202,203,
-		185,186,203,
-		186,203,204,
-		186,187,204,
-		187,204,188,
-		187,171,188,
-		171,188,189,
-		171,172,189,
-		172,189,190,
-		172,173,190,
-		173,190,191,
-		173,174,191,
-		174,191,192,
-		174,175,192,
-		175,192,193,
-		175,176,193,
-		176,193,194,
-		176,177,194,
-		177,194,195,
-		177,178,195,
-		178,195,196,
-		178,179,196,
-		179,196,197,
-		179,180,197,
-
-		// ring 12 to ring 13
-		197,214,215,
-		197,198,215,
-		198,215,216,
-		198,199,216,
-		199,216,217,
-		199,200,217,
-		200,217,218,
-		200,201,218,
-		201,218,219,
-		201,202,219,
-		202,219,220,
-		202,203,220,
-		203,220,221,
-		203,204,221,
-		204,221,205,
-		204,188,205,
-		188,205,206,
-		188,189,206,
-		189,206,207,
-		189,190,207,
-		190,207,208,
-		190,191,208,
-		191,208,209,
-		191,192,209,
-		192,209,210,
-		192,193,210,
-		193,210,211,
-		193,194,211,
-		194,211,212,
-		194,195,212,
-		195,212,213,
-		195,196,213,
-		196,213,214,
-		196,197,214,
-
-		// ring 13 to ring 14
-		214,231,232,
-		214,215,232,
-		215,232,233,
-		215,216,233,
-		216,233,234,
-		216,217,234,
-		217,234,235,
-		217,218,235,
-		218,235,236,
-		218,219,236,
-		219,236,237,
-		219,220,237,
-		220,237,238,
-		220,221,238,
-		221,238,222,
-		221,205,222,
-		205,222,223,
-		205,206,223,
-		206,223,224,
-		206,207,224,
-		207,224,225,
-		207,208,225,
-		208,225,226,
-		208,209,226,
-		209,226,227,
-		209,210,227,
-		210,227,228,
-		210,211,228,
-		211,228,229,
-		211,212,229,
-		212,229,230,
-		212,213,230,
-		213,230,231,
-		213,214,231,
-
-		// ring 14 to ring 15
-		231,248,249,
-		231,232,249,
-		232,249,250,
-		232,233,250,
-		233,250,251,
-		233,234,251,
-		234,251,252,
-		234,235,252,
-		235,252,253,
-		235,236,253,
-		236,253,254,
-		236,237,254,
-		237,254,255,
-		237,238,255,
-		238,255,239,
-		238,222,239,
-		222,239,240,
-		222,223,240,
-		223,240,241,
-		223,224,241,
-		224,241,242,
-		224,225,242,
-		225,242,243,
-		225,226,243,
-		226,243,244,
-		226,227,244,
-		227,244,245,
-		227,228,245,
-		228,245,246,
-		228,229,246,
-		229,246,247,
-		229,230,247,
-		230,247,248,
-		230,231,248,
-
-		// ring 15 - bottom
-		248,256,249,
-		249,256,250,
-		250,256,251,
-		251,256,252,
-		252,256,253,
-		253,256,254,
-		254,256,255,
-		255,256,239,
-		239,256,240,
-		240,256,241,
-		241,256,242,
-		242,256,243,
-		243,256,244,
-		244,256,245,
-		245,256,246,
-		246,256,247,
-		247,256,248
-	};
-
-	// total float values per each type
-	const GLuint floatsPerVertex = 3;
-	const GLuint floatsPerNormal = 3;
-	const GLuint floatsPerUV = 2;
-
 	// store vertex and index count
-	m_SphereMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex));
-	m_SphereMesh.nIndices = sizeof(indices) / (sizeof(indices[0]));
-
-	glm::vec3 normal;
-	glm::vec3 vert;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	float u, v;
-	std::vector<GLfloat> combined_values;
-
-	// combine interleaved vertices, normals, and texture coords
-	for (int i = 0; i < sizeof(verts) / (sizeof(verts[0])); i += 5)
-	{
-		vert = glm::vec3(verts[i], verts[i + 1], verts[i + 2]);
-		normal = normalize(vert - center);
-		//u = atan2(normal.x, normal.z) / (2 * M_PI) + 0.5;
-		//v = normal.y * 0.5 + 0.5;
-		combined_values.push_back(vert.x);
-		combined_values.push_back(vert.y);
-		combined_values.push_back(vert.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(verts[i + 3]);
-		combined_values.push_back(verts[i + 4]);
-	}
+	m_SphereMesh.nVertices = MeshBuilder::GetSphereVertexCount();
+	m_SphereMesh.nIndices = MeshBuilder::GetSphereIndexCount();
 
 	// Create VAO
 	glGenVertexArrays(1, &m_SphereMesh.vao); // we can also generate multiple VAOs or buffers at the same time
@@ -1692,11 +926,7 @@ void ShapeMeshes::LoadSphereMesh()
 
 	// Create VBOs
 	glGenBuffers(2, m_SphereMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_SphereMesh.vbos[0]); // Activates the vertex buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_SphereMesh.vbos[1]); // Activates the index buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	CreateMeshBuffers(m_SphereMesh, "sphere", MeshBuilder::WriteSphere, MeshBuilder::GetSphereIndices(), &m_meshTriangles[sphere]);
 
 	if (m_bMemoryLayoutDone == false)
 	{
@@ -1949,6 +1179,12 @@ void ShapeMeshes::LoadTaperedCylinderMesh()
 	m_TaperedCylinderMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
 	m_TaperedCylinderMesh.nIndices = 0;
 
+	// keep the triangles of the filled mesh for picking
+	m_meshTriangles[taperedCylinder].Clear();
+	AddMeshTriangles(m_meshTriangles[taperedCylinder], verts, m_TaperedCylinderMesh.nVertices, GL_TRIANGLE_FAN, 0, 36);
+	AddMeshTriangles(m_meshTriangles[taperedCylinder], verts, m_TaperedCylinderMesh.nVertices, GL_TRIANGLE_FAN, 36, 72);
+	AddMeshTriangles(m_meshTriangles[taperedCylinder], verts, m_TaperedCylinderMesh.nVertices, GL_TRIANGLE_STRIP, 72, 146);
+
 	// Create VAO
 	glGenVertexArrays(1, &m_TaperedCylinderMesh.vao); // we can also generate multiple VAOs or buffers at the same time
 	glBindVertexArray(m_TaperedCylinderMesh.vao);
@@ -1977,185 +1213,7 @@ void ShapeMeshes::LoadTaperedCylinderMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadTorusMesh(float thickness)
 {
-	int _mainSegments = 30;
-	int _tubeSegments = 30;
-	float _mainRadius = 1.0f;
-	float _tubeRadius = .1f;
-
-	if (thickness <= 1.0)
-	{
-		_tubeRadius = thickness;
-	}
-
-	auto mainSegmentAngleStep = glm::radians(360.0f / float(_mainSegments));
-	auto tubeSegmentAngleStep = glm::radians(360.0f / float(_tubeSegments));
-
-	std::vector<glm::vec3> vertex_list;
-	std::vector<std::vector<glm::vec3>> segments_list;
-	std::vector<glm::vec2> texture_coords;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	glm::vec3 normal;
-	glm::vec3 vertex;
-	glm::vec2 text_coord;
-
-	// generate the torus vertices
-	auto currentMainSegmentAngle = 0.0f;
-	for (auto i = 0; i < _mainSegments; i++)
-	{
-		// Calculate sine and cosine of main segment angle
-		auto sinMainSegment = sin(currentMainSegmentAngle);
-		auto cosMainSegment = cos(currentMainSegmentAngle);
-		auto currentTubeSegmentAngle = 0.0f;
-		std::vector<glm::vec3> segment_points;
-		for (auto j = 0; j < _tubeSegments; j++)
-		{
-			// Calculate sine and cosine of tube segment angle
-			auto sinTubeSegment = sin(currentTubeSegmentAngle);
-			auto cosTubeSegment = cos(currentTubeSegmentAngle);
-
-			// Calculate vertex position on the surface of torus
-			auto surfacePosition = glm::vec3(
-				(_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
-				(_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
-				_tubeRadius * sinTubeSegment);
-
-			//vertex_list.push_back(surfacePosition);
-			segment_points.push_back(surfacePosition);
-
-			// Update current tube angle
-			currentTubeSegmentAngle += tubeSegmentAngleStep;
-		}
-		segments_list.push_back(segment_points);
-		segment_points.clear();
-
-		// Update main segment angle
-		currentMainSegmentAngle += mainSegmentAngleStep;
-	}
-
-	float horizontalStep = 1.0 / _mainSegments;
-	float verticalStep = 1.0 / _tubeSegments;
-	float u = 0.0;
-	float v = 0.0;
-
-	// connect the various segments together, forming triangles
-	for (int i = 0; i < _mainSegments; i++)
-	{
-		for (int j = 0; j < _tubeSegments; j++)
-		{
-			if (((i + 1) < _mainSegments) && ((j + 1) < _tubeSegments))
-			{
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i][j + 1]);
-				texture_coords.push_back(glm::vec2(u, v + verticalStep));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v + verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i + 1][j]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v - verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-			}
-			else
-			{
-				if (((i + 1) == _mainSegments) && ((j + 1) == _tubeSegments))
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((i + 1) == _mainSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][j + 1]);
-					texture_coords.push_back(glm::vec2(u, v + verticalStep));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((j + 1) == _tubeSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i + 1][j]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-
-			}
-			v += verticalStep;
-		}
-		v = 0.0;
-		u += horizontalStep;
-	}
-
-	std::vector<GLfloat> combined_values;
-
-	// combine interleaved vertices, normals, and texture coords
-	for (int i = 0; i < vertex_list.size(); i++)
-	{
-		vertex = vertex_list[i];
-		normal = normalize(vertex);
-
-		text_coord = texture_coords[i];
-		combined_values.push_back(vertex.x);
-		combined_values.push_back(vertex.y);
-		combined_values.push_back(vertex.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(text_coord.x);
-		combined_values.push_back(text_coord.y);
-	}
-
-	// store vertex and index count
-	m_TorusMesh.nVertices = vertex_list.size();
-	m_TorusMesh.nIndices = 0;
-
-	// Create VAO
-	glGenVertexArrays(1, &m_TorusMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_TorusMesh.vao);
-
-	// Create VBOs
-	glGenBuffers(1, m_TorusMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_TorusMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	CreateTorusMesh(m_TorusMesh, thickness, &m_meshTriangles[torus]);
 }
 
 ///////////////////////////////////////////////////
@@ -2171,185 +1229,7 @@ void ShapeMeshes::LoadTorusMesh(float thickness)
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadExtraTorusMesh1(float thickness)
 {
-	int _mainSegments = 30;
-	int _tubeSegments = 30;
-	float _mainRadius = 1.0f;
-	float _tubeRadius = .1f;
-
-	if (thickness <= 1.0)
-	{
-		_tubeRadius = thickness;
-	}
-
-	auto mainSegmentAngleStep = glm::radians(360.0f / float(_mainSegments));
-	auto tubeSegmentAngleStep = glm::radians(360.0f / float(_tubeSegments));
-
-	std::vector<glm::vec3> vertex_list;
-	std::vector<std::vector<glm::vec3>> segments_list;
-	std::vector<glm::vec2> texture_coords;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	glm::vec3 normal;
-	glm::vec3 vertex;
-	glm::vec2 text_coord;
-
-	// generate the torus vertices
-	auto currentMainSegmentAngle = 0.0f;
-	for (auto i = 0; i < _mainSegments; i++)
-	{
-		// Calculate sine and cosine of main segment angle
-		auto sinMainSegment = sin(currentMainSegmentAngle);
-		auto cosMainSegment = cos(currentMainSegmentAngle);
-		auto currentTubeSegmentAngle = 0.0f;
-		std::vector<glm::vec3> segment_points;
-		for (auto j = 0; j < _tubeSegments; j++)
-		{
-			// Calculate sine and cosine of tube segment angle
-			auto sinTubeSegment = sin(currentTubeSegmentAngle);
-			auto cosTubeSegment = cos(currentTubeSegmentAngle);
-
-			// Calculate vertex position on the surface of torus
-			auto surfacePosition = glm::vec3(
-				(_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
-				(_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
-				_tubeRadius * sinTubeSegment);
-
-			//vertex_list.push_back(surfacePosition);
-			segment_points.push_back(surfacePosition);
-
-			// Update current tube angle
-			currentTubeSegmentAngle += tubeSegmentAngleStep;
-		}
-		segments_list.push_back(segment_points);
-		segment_points.clear();
-
-		// Update main segment angle
-		currentMainSegmentAngle += mainSegmentAngleStep;
-	}
-
-	float horizontalStep = 1.0 / _mainSegments;
-	float verticalStep = 1.0 / _tubeSegments;
-	float u = 0.0;
-	float v = 0.0;
-
-	// connect the various segments together, forming triangles
-	for (int i = 0; i < _mainSegments; i++)
-	{
-		for (int j = 0; j < _tubeSegments; j++)
-		{
-			if (((i + 1) < _mainSegments) && ((j + 1) < _tubeSegments))
-			{
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i][j + 1]);
-				texture_coords.push_back(glm::vec2(u, v + verticalStep));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v + verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i + 1][j]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v - verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-			}
-			else
-			{
-				if (((i + 1) == _mainSegments) && ((j + 1) == _tubeSegments))
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((i + 1) == _mainSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][j + 1]);
-					texture_coords.push_back(glm::vec2(u, v + verticalStep));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((j + 1) == _tubeSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i + 1][j]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-
-			}
-			v += verticalStep;
-		}
-		v = 0.0;
-		u += horizontalStep;
-	}
-
-	std::vector<GLfloat> combined_values;
-
-	// combine interleaved vertices, normals, and texture coords
-	for (int i = 0; i < vertex_list.size(); i++)
-	{
-		vertex = vertex_list[i];
-		normal = normalize(vertex);
-
-		text_coord = texture_coords[i];
-		combined_values.push_back(vertex.x);
-		combined_values.push_back(vertex.y);
-		combined_values.push_back(vertex.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(text_coord.x);
-		combined_values.push_back(text_coord.y);
-	}
-
-	// store vertex and index count
-	m_ExtraTorusMesh1.nVertices = vertex_list.size();
-	m_ExtraTorusMesh1.nIndices = 0;
-
-	// Create VAO
-	glGenVertexArrays(1, &m_ExtraTorusMesh1.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_ExtraTorusMesh1.vao);
-
-	// Create VBOs
-	glGenBuffers(1, m_ExtraTorusMesh1.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ExtraTorusMesh1.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	CreateTorusMesh(m_ExtraTorusMesh1, thickness, NULL);
 }
 
 ///////////////////////////////////////////////////
@@ -2365,185 +1245,303 @@ void ShapeMeshes::LoadExtraTorusMesh1(float thickness)
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadExtraTorusMesh2(float thickness)
 {
-	int _mainSegments = 30;
-	int _tubeSegments = 30;
-	float _mainRadius = 1.0f;
-	float _tubeRadius = .1f;
+	CreateTorusMesh(m_ExtraTorusMesh2, thickness, NULL);
+}
 
+///////////////////////////////////////////////////
+//	CreateTorusMesh()
+//
+//	Create the torus mesh shared by the torus loading
+//  methods in the passed in VAO/VBO.  The tube radius
+//  is the thickness, or 0.1 when the thickness is
+//  larger than 1.  The triangles are kept when a place
+//  for them is passed in.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::CreateTorusMesh(GLMesh& mesh, float thickness, MESH_TRIANGLES* pTriangles)
+{
+	float tubeRadius = .1f;
 	if (thickness <= 1.0)
 	{
-		_tubeRadius = thickness;
+		tubeRadius = thickness;
 	}
 
-	auto mainSegmentAngleStep = glm::radians(360.0f / float(_mainSegments));
-	auto tubeSegmentAngleStep = glm::radians(360.0f / float(_tubeSegments));
+	// store vertex and index count
+	mesh.nVertices = MeshBuilder::GetTorusVertexCount();
+	mesh.nIndices = 0;
 
-	std::vector<glm::vec3> vertex_list;
-	std::vector<std::vector<glm::vec3>> segments_list;
-	std::vector<glm::vec2> texture_coords;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	glm::vec3 normal;
-	glm::vec3 vertex;
-	glm::vec2 text_coord;
+	// Create VAO
+	glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
+	glBindVertexArray(mesh.vao);
 
-	// generate the torus vertices
-	auto currentMainSegmentAngle = 0.0f;
-	for (auto i = 0; i < _mainSegments; i++)
-	{
-		// Calculate sine and cosine of main segment angle
-		auto sinMainSegment = sin(currentMainSegmentAngle);
-		auto cosMainSegment = cos(currentMainSegmentAngle);
-		auto currentTubeSegmentAngle = 0.0f;
-		std::vector<glm::vec3> segment_points;
-		for (auto j = 0; j < _tubeSegments; j++)
-		{
-			// Calculate sine and cosine of tube segment angle
-			auto sinTubeSegment = sin(currentTubeSegmentAngle);
-			auto cosTubeSegment = cos(currentTubeSegmentAngle);
+	// Create VBOs - each thickness is cached on its own
+	glGenBuffers(1, mesh.vbos);
+	std::string cacheName = "torus_" + std::to_string(tubeRadius);
+	CreateMeshBuffers(mesh, cacheName.c_str(), [tubeRadius](GLfloat* pVertices) {
+		MeshBuilder::WriteTorus(tubeRadius, pVertices);
+	}, NULL, pTriangles);
 
-			// Calculate vertex position on the surface of torus
-			auto surfacePosition = glm::vec3(
-				(_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
-				(_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
-				_tubeRadius * sinTubeSegment);
+	if (m_bMemoryLayoutDone == false)
+	{
+		SetShaderMemoryLayout();
+	}
+}
 
-			//vertex_list.push_back(surfacePosition);
-			segment_points.push_back(surfacePosition);
+///////////////////////////////////////////////////
+//	CreateMeshBuffers()
+//
+//	Fill the vertex buffer, and the index buffer when
+//  there are indices, of a mesh.  They are sent
+//  straight from the mapped mesh cache file when it
+//  has the mesh.  Otherwise the mesh is generated into
+//  a new cache file and sent from there, or into the
+//  mapped vertex buffer when the file cannot be made.
+//  The vertex buffer stays bound for setting the
+//  memory layout.  The mesh's triangles are kept when
+//  a place for them is passed in.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::CreateMeshBuffers(
+	GLMesh& mesh,
+	const char* cacheName,
+	const std::function<void(GLfloat*)>& writeVertices,
+	const GLuint* pIndices,
+	MESH_TRIANGLES* pTriangles)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	GLsizeiptr vertexSize = sizeof(GLfloat) * MeshBuilder::FLOATS_PER_VERTEX * (GLsizeiptr)mesh.nVertices;
+	GLsizeiptr indexSize = sizeof(GLuint) * (GLsizeiptr)mesh.nIndices;
+	const char* result = NULL;
+	// the generated meshes are drawn as one list of triangles
+	GLsizei triangleCount = (mesh.nIndices > 0) ? mesh.nIndices : mesh.nVertices;
+	if (NULL != pTriangles)
+	{
+		pTriangles->Clear();
+	}
 
-			// Update current tube angle
-			currentTubeSegmentAngle += tubeSegmentAngleStep;
+	MeshCache::MESH_DATA cached;
+	if (m_meshCache.Open(cacheName, mesh.nVertices, mesh.nIndices, cached) == true)
+	{
+		CreateStaticBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1], indexSize, cached.pIndices);
+		CreateStaticBuffer(GL_ARRAY_BUFFER, mesh.vbos[0], vertexSize, cached.pVertices);
+		if (NULL != pTriangles)
+		{
+			AddMeshTriangles(*pTriangles, cached.pVertices, mesh.nVertices, GL_TRIANGLES, 0, triangleCount,
+				(indexSize > 0) ? cached.pIndices : NULL);
+		}
+		m_meshCache.Close();
+		result = "hit";
+	}
+	else if (m_meshCache.Create(cacheName, mesh.nVertices, mesh.nIndices, cached) == true)
+	{
+		writeVertices(cached.pVertices);
+		if (indexSize > 0)
+		{
+			memcpy(cached.pIndices, pIndices, indexSize);
 		}
-		segments_list.push_back(segment_points);
-		segment_points.clear();
+		CreateStaticBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1], indexSize, cached.pIndices);
+		CreateStaticBuffer(GL_ARRAY_BUFFER, mesh.vbos[0], vertexSize, cached.pVertices);
+		if (NULL != pTriangles)
+		{
+			AddMeshTriangles(*pTriangles, cached.pVertices, mesh.nVertices, GL_TRIANGLES, 0, triangleCount,
+				(indexSize > 0) ? cached.pIndices : NULL);
+		}
+		result = m_meshCache.Finish() ? "miss, generated and cached" : "miss, generated";
+	}
+	else
+	{
+		CreateStaticBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1], indexSize, pIndices);
+		CreateVertexBuffer(mesh, writeVertices);
+		result = "miss, generated";
 
-		// Update main segment angle
-		currentMainSegmentAngle += mainSegmentAngleStep;
+		// the mapped vertex buffer cannot be read, so the
+		// vertices are generated again for the triangles
+		if (NULL != pTriangles)
+		{
+			std::vector<GLfloat> vertices((size_t)mesh.nVertices * MeshBuilder::FLOATS_PER_VERTEX);
+			writeVertices(vertices.data());
+			AddMeshTriangles(*pTriangles, vertices.data(), mesh.nVertices, GL_TRIANGLES, 0, triangleCount, pIndices);
+		}
 	}
 
-	float horizontalStep = 1.0 / _mainSegments;
-	float verticalStep = 1.0 / _tubeSegments;
-	float u = 0.0;
-	float v = 0.0;
+	double milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	std::cout << "Mesh cache " << result << ": " << cacheName << " in " << milliseconds << " ms" << std::endl;
+}
 
-	// connect the various segments together, forming triangles
-	for (int i = 0; i < _mainSegments; i++)
+///////////////////////////////////////////////////
+//	AddMeshTriangles()
+//
+//	Add the triangles of one draw of a mesh's vertices
+//  to the triangles kept for its primitive type, in
+//  the order they are drawn, and grow their bounds.
+//  Triangles that would read past the last vertex are
+//  skipped, as some draws reach past the end.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::AddMeshTriangles(
+	MESH_TRIANGLES& triangles,
+	const GLfloat* pVertices,
+	GLuint vertexCount,
+	GLenum mode,
+	GLint first,
+	GLsizei count,
+	const GLuint* pIndices)
+{
+	for (GLsizei i = 0; i + 2 < count; i += ((mode == GL_TRIANGLES) ? 3 : 1))
 	{
-		for (int j = 0; j < _tubeSegments; j++)
+		// corners of the triangle in the draw's vertices
+		GLsizei corners[3] = { i, i + 1, i + 2 };
+		if (mode == GL_TRIANGLE_FAN)
 		{
-			if (((i + 1) < _mainSegments) && ((j + 1) < _tubeSegments))
+			corners[0] = 0;
+		}
+
+		const GLfloat* pCorners[3];
+		bool bInside = true;
+		for (int c = 0; c < 3; c++)
+		{
+			GLuint vertex = (NULL != pIndices) ? pIndices[first + corners[c]] : (GLuint)(first + corners[c]);
+			if (vertex >= vertexCount)
 			{
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i][j + 1]);
-				texture_coords.push_back(glm::vec2(u, v + verticalStep));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v + verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i + 1][j]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v - verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
+				bInside = false;
+				break;
 			}
-			else
-			{
-				if (((i + 1) == _mainSegments) && ((j + 1) == _tubeSegments))
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((i + 1) == _mainSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][j + 1]);
-					texture_coords.push_back(glm::vec2(u, v + verticalStep));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((j + 1) == _tubeSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i + 1][j]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
+			pCorners[c] = pVertices + (size_t)vertex * MeshBuilder::FLOATS_PER_VERTEX;
+		}
+		if (bInside == false)
+		{
+			continue;
+		}
 
+		// each vertex is a position, a normal and a texture coordinate
+		for (int c = 0; c < 3; c++)
+		{
+			const GLfloat* pVertex = pCorners[c];
+			glm::vec3 point(pVertex[0], pVertex[1], pVertex[2]);
+			if (triangles.corners.empty())
+			{
+				triangles.minCorner = point;
+				triangles.maxCorner = point;
 			}
-			v += verticalStep;
+			triangles.minCorner = glm::min(triangles.minCorner, point);
+			triangles.maxCorner = glm::max(triangles.maxCorner, point);
+			triangles.corners.push_back(point);
+			triangles.normals.push_back(glm::vec3(pVertex[3], pVertex[4], pVertex[5]));
+			triangles.textureCoordinates.push_back(glm::vec2(pVertex[6], pVertex[7]));
 		}
-		v = 0.0;
-		u += horizontalStep;
 	}
+}
 
-	std::vector<GLfloat> combined_values;
+///////////////////////////////////////////////////
+//	GetMeshTriangles()
+//
+//	Get the corners of the filled triangles of a
+//  primitive type, three per triangle, as DrawMesh()
+//  draws them.  There are none until the mesh is
+//  loaded.
+// 
+///////////////////////////////////////////////////
+const std::vector<glm::vec3>& ShapeMeshes::GetMeshTriangles(MeshType type) const
+{
+	return(m_meshTriangles[type].corners);
+}
 
-	// combine interleaved vertices, normals, and texture coords
-	for (int i = 0; i < vertex_list.size(); i++)
+///////////////////////////////////////////////////
+//	GetMeshNormals()
+//
+//	Get the normals and the texture coordinates of
+//  the corners returned by GetMeshTriangles(), in
+//  the same order.
+// 
+///////////////////////////////////////////////////
+const std::vector<glm::vec3>& ShapeMeshes::GetMeshNormals(MeshType type) const
+{
+	return(m_meshTriangles[type].normals);
+}
+
+const std::vector<glm::vec2>& ShapeMeshes::GetMeshTextureCoordinates(MeshType type) const
+{
+	return(m_meshTriangles[type].textureCoordinates);
+}
+
+///////////////////////////////////////////////////
+//	GetMeshBounds()
+//
+//	Get the bounds of the triangles of a primitive
+//  type, only valid once the mesh is loaded.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::GetMeshBounds(MeshType type, glm::vec3& minCorner, glm::vec3& maxCorner) const
+{
+	minCorner = m_meshTriangles[type].minCorner;
+	maxCorner = m_meshTriangles[type].maxCorner;
+}
+
+///////////////////////////////////////////////////
+//	CreateStaticBuffer()
+//
+//	Create the storage of a buffer that is never
+//  changed, filled from the passed in memory.  The
+//  storage is immutable when the driver supports it.
+//  Nothing is done when the size is 0.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::CreateStaticBuffer(GLenum target, GLuint buffer, GLsizeiptr size, const void* pData)
+{
+	if (size == 0)
 	{
-		vertex = vertex_list[i];
-		normal = normalize(vertex);
-
-		text_coord = texture_coords[i];
-		combined_values.push_back(vertex.x);
-		combined_values.push_back(vertex.y);
-		combined_values.push_back(vertex.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(text_coord.x);
-		combined_values.push_back(text_coord.y);
+		return;
 	}
 
-	// store vertex and index count
-	m_ExtraTorusMesh2.nVertices = vertex_list.size();
-	m_ExtraTorusMesh2.nIndices = 0;
+	glBindBuffer(target, buffer);
+	if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+	{
+		glBufferStorage(target, size, pData, 0);
+	}
+	else
+	{
+		glBufferData(target, size, pData, GL_STATIC_DRAW);
+	}
+}
 
-	// Create VAO
-	glGenVertexArrays(1, &m_ExtraTorusMesh2.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_ExtraTorusMesh2.vao);
+///////////////////////////////////////////////////
+//	CreateVertexBuffer()
+//
+//	Size the vertex buffer of a mesh for its vertex
+//  count and let the passed in function write the
+//  vertices straight into the mapped buffer.  They
+//  are written to a staging copy instead when the
+//  buffer cannot be mapped.  The buffer stays bound
+//  for setting the memory layout.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::CreateVertexBuffer(
+	GLMesh& mesh,
+	const std::function<void(GLfloat*)>& writeVertices)
+{
+	GLsizeiptr floatCount = (GLsizeiptr)mesh.nVertices * MeshBuilder::FLOATS_PER_VERTEX;
+	GLsizeiptr size = sizeof(GLfloat) * floatCount;
 
-	// Create VBOs
-	glGenBuffers(1, m_ExtraTorusMesh2.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ExtraTorusMesh2.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
+	glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STATIC_DRAW);
 
-	if (m_bMemoryLayoutDone == false)
+	GLfloat* pVertices = (GLfloat*)glMapBufferRange(
+		GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (pVertices != NULL)
 	{
-		SetShaderMemoryLayout();
+		writeVertices(pVertices);
+		// the contents are only lost in rare cases, like a
+		// display mode change, and are then sent again below
+		if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE)
+		{
+			return;
+		}
 	}
+
+	std::vector<GLfloat> staging(floatCount);
+	writeVertices(staging.data());
+	glBufferSubData(GL_ARRAY_BUFFER, 0, size, staging.data());
 }
 
 //**************************************************************************
@@ -2559,9 +1557,9 @@ void ShapeMeshes::LoadExtraTorusMesh2(float thickness)
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawBoxMesh()
 {
-	glBindVertexArray(m_BoxMesh.vao);
+	BindMesh(m_BoxMesh, box);
 
-	glDrawElements(GL_TRIANGLES, m_BoxMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawElements(GL_TRIANGLES, m_BoxMesh.nIndices);
 
 	glBindVertexArray(0);
 }
@@ -2576,27 +1574,27 @@ void ShapeMeshes::DrawBoxMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawBoxMeshSide(BoxSide side)
 {
-	glBindVertexArray(m_BoxMesh.vao);
+	BindMesh(m_BoxMesh, box);
 
 	switch (side)
 	{
 	case back:
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+		DrawArrays(GL_TRIANGLE_FAN, 0, 4);
 		break;
 	case bottom:
-		glDrawArrays(GL_TRIANGLE_FAN, 4, 4);
+		DrawArrays(GL_TRIANGLE_FAN, 4, 4);
 		break;
 	case left:
-		glDrawArrays(GL_TRIANGLE_FAN, 8, 4);
+		DrawArrays(GL_TRIANGLE_FAN, 8, 4);
 		break;
 	case right:
-		glDrawArrays(GL_TRIANGLE_FAN, 12, 4);
+		DrawArrays(GL_TRIANGLE_FAN, 12, 4);
 		break;
 	case top:
-		glDrawArrays(GL_TRIANGLE_FAN, 16, 4);
+		DrawArrays(GL_TRIANGLE_FAN, 16, 4);
 		break;
 	case front:
-		glDrawArrays(GL_TRIANGLE_FAN, 20, 4);
+		DrawArrays(GL_TRIANGLE_FAN, 20, 4);
 		break;
 	}
 
@@ -2611,9 +1609,9 @@ void ShapeMeshes::DrawBoxMeshSide(BoxSide side)
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawBoxMeshLines()
 {
-	glBindVertexArray(m_BoxMesh.vao);
+	BindMesh(m_BoxMesh, box);
 
-	glDrawElements(GL_LINE_LOOP, m_BoxMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawElements(GL_LINE_LOOP, m_BoxMesh.nIndices);
 
 	glBindVertexArray(0);
 }
@@ -2627,13 +1625,13 @@ void ShapeMeshes::DrawBoxMeshLines()
 void ShapeMeshes::DrawConeMesh(
 	bool bDrawBottom)
 {
-	glBindVertexArray(m_ConeMesh.vao);
+	BindMesh(m_ConeMesh, cone);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
+		DrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
 	}
-	glDrawArrays(GL_TRIANGLE_STRIP, 36, 108);	//sides
+	DrawArrays(GL_TRIANGLE_STRIP, 36, 108);	//sides
 
 	glBindVertexArray(0);
 }
@@ -2647,13 +1645,13 @@ void ShapeMeshes::DrawConeMesh(
 void ShapeMeshes::DrawConeMeshLines(
 	bool bDrawBottom)
 {
-	glBindVertexArray(m_ConeMesh.vao);
+	BindMesh(m_ConeMesh, cone);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_LINES, 0, 36);		//bottom
+		DrawArrays(GL_LINES, 0, 36);		//bottom
 	}
-	glDrawArrays(GL_LINE_STRIP, 36, 108);	//sides
+	DrawArrays(GL_LINE_STRIP, 36, 108);	//sides
 
 	glBindVertexArray(0);
 }
@@ -2669,19 +1667,19 @@ void ShapeMeshes::DrawCylinderMesh(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_CylinderMesh.vao);
+	BindMesh(m_CylinderMesh, cylinder);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);	//bottom
+		DrawArrays(GL_TRIANGLE_FAN, 0, 36);	//bottom
 	}
 	if (bDrawTop == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 36, 36);	//top
+		DrawArrays(GL_TRIANGLE_FAN, 36, 36);	//top
 	}
 	if (bDrawSides == true)
 	{
-		glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
+		DrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
 	}
 
 	glBindVertexArray(0);
@@ -2698,19 +1696,19 @@ void ShapeMeshes::DrawCylinderMeshLines(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_CylinderMesh.vao);
+	BindMesh(m_CylinderMesh, cylinder);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_LINE_LOOP, 0, 36);	//bottom
+		DrawArrays(GL_LINE_LOOP, 0, 36);	//bottom
 	}
 	if (bDrawTop == true)
 	{
-		glDrawArrays(GL_LINE_LOOP, 36, 36);	//top
+		DrawArrays(GL_LINE_LOOP, 36, 36);	//top
 	}
 	if (bDrawSides == true)
 	{
-		glDrawArrays(GL_LINE_STRIP, 72, 146);	//sides
+		DrawArrays(GL_LINE_STRIP, 72, 146);	//sides
 	}
 
 	glBindVertexArray(0);
@@ -2724,9 +1722,9 @@ void ShapeMeshes::DrawCylinderMeshLines(
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPlaneMesh()
 {
-	glBindVertexArray(m_PlaneMesh.vao);
+	BindMesh(m_PlaneMesh, plane);
 
-	glDrawElements(GL_TRIANGLES, m_PlaneMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawElements(GL_TRIANGLES, m_PlaneMesh.nIndices);
 	
 	glBindVertexArray(0);
 }
@@ -2739,9 +1737,9 @@ void ShapeMeshes::DrawPlaneMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPlaneMeshLines()
 {
-	glBindVertexArray(m_PlaneMesh.vao);
+	BindMesh(m_PlaneMesh, plane);
 
-	glDrawElements(GL_LINE_STRIP, m_PlaneMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawElements(GL_LINE_STRIP, m_PlaneMesh.nIndices);
 
 	glBindVertexArray(0);
 }
@@ -2754,9 +1752,9 @@ void ShapeMeshes::DrawPlaneMeshLines()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPrismMesh()
 {
-	glBindVertexArray(m_PrismMesh.vao);
+	BindMesh(m_PrismMesh, prism);
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_PrismMesh.nVertices);
+	DrawArrays(GL_TRIANGLE_STRIP, 0, m_PrismMesh.nVertices);
 
 	glBindVertexArray(0);
 }
@@ -2769,9 +1767,9 @@ void ShapeMeshes::DrawPrismMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPrismMeshLines()
 {
-	glBindVertexArray(m_PrismMesh.vao);
+	BindMesh(m_PrismMesh, prism);
 
-	glDrawArrays(GL_LINE_STRIP, 0, m_PrismMesh.nVertices);
+	DrawArrays(GL_LINE_STRIP, 0, m_PrismMesh.nVertices);
 
 	glBindVertexArray(0);
 }
@@ -2784,9 +1782,9 @@ void ShapeMeshes::DrawPrismMeshLines()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPyramid3Mesh()
 {
-	glBindVertexArray(m_Pyramid3Mesh.vao);
+	BindMesh(m_Pyramid3Mesh, pyramid3);
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid3Mesh.nVertices);
+	DrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid3Mesh.nVertices);
 
 	glBindVertexArray(0);
 }
@@ -2799,9 +1797,9 @@ void ShapeMeshes::DrawPyramid3Mesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPyramid3MeshLines()
 {
-	glBindVertexArray(m_Pyramid3Mesh.vao);
+	BindMesh(m_Pyramid3Mesh, pyramid3);
 
-	glDrawArrays(GL_LINE_STRIP, 0, m_Pyramid3Mesh.nVertices);
+	DrawArrays(GL_LINE_STRIP, 0, m_Pyramid3Mesh.nVertices);
 
 	glBindVertexArray(0);
 }
@@ -2814,9 +1812,9 @@ void ShapeMeshes::DrawPyramid3MeshLines()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPyramid4Mesh()
 {
-	glBindVertexArray(m_Pyramid4Mesh.vao);
+	BindMesh(m_Pyramid4Mesh, pyramid4);
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid4Mesh.nVertices);
+	DrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid4Mesh.nVertices);
 
 	glBindVertexArray(0);
 }
@@ -2829,9 +1827,9 @@ void ShapeMeshes::DrawPyramid4Mesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPyramid4MeshLines()
 {
-	glBindVertexArray(m_Pyramid4Mesh.vao);
+	BindMesh(m_Pyramid4Mesh, pyramid4);
 
-	glDrawArrays(GL_LINE_STRIP, 0, m_Pyramid4Mesh.nVertices);
+	DrawArrays(GL_LINE_STRIP, 0, m_Pyramid4Mesh.nVertices);
 
 	glBindVertexArray(0);
 }
@@ -2844,9 +1842,9 @@ void ShapeMeshes::DrawPyramid4MeshLines()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawSphereMesh()
 {
-	glBindVertexArray(m_SphereMesh.vao);
+	BindMesh(m_SphereMesh, sphere);
 
-	glDrawElements(GL_TRIANGLES, m_SphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawElements(GL_TRIANGLES, m_SphereMesh.nIndices);
 
 	glBindVertexArray(0);
 }
@@ -2859,9 +1857,9 @@ void ShapeMeshes::DrawSphereMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawSphereMeshLines()
 {
-	glBindVertexArray(m_SphereMesh.vao);
+	BindMesh(m_SphereMesh, sphere);
 
-	glDrawElements(GL_LINE_STRIP, m_SphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+	DrawElements(GL_LINE_STRIP, m_SphereMesh.nIndices);
 
 	glBindVertexArray(0);
 }
@@ -2874,9 +1872,9 @@ void ShapeMeshes::DrawSphereMeshLines()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawHalfSphereMesh()
 {
-	glBindVertexArray(m_SphereMesh.vao);
+	BindMesh(m_SphereMesh, sphere);
 
-	glDrawElements(GL_TRIANGLES, m_SphereMesh.nIndices/2, GL_UNSIGNED_INT, (void*)0);
+	DrawElements(GL_TRIANGLES, m_SphereMesh.nIndices/2);
 
 	glBindVertexArray(0);
 }
@@ -2889,9 +1887,9 @@ void ShapeMeshes::DrawHalfSphereMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawHalfSphereMeshLines()
 {
-	glBindVertexArray(m_SphereMesh.vao);
+	BindMesh(m_SphereMesh, sphere);
 
-	glDrawElements(GL_LINE_STRIP, m_SphereMesh.nIndices / 2, GL_UNSIGNED_INT, (void*)0);
+	DrawElements(GL_LINE_STRIP, m_SphereMesh.nIndices / 2);
 
 	glBindVertexArray(0);
 }
@@ -2907,19 +1905,19 @@ void ShapeMeshes::DrawTaperedCylinderMesh(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
+	BindMesh(m_TaperedCylinderMesh, taperedCylinder);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);	//bottom
+		DrawArrays(GL_TRIANGLE_FAN, 0, 36);	//bottom
 	}
 	if (bDrawTop == true)
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 36, 72);	//top
+		DrawArrays(GL_TRIANGLE_FAN, 36, 72);	//top
 	}
 	if (bDrawSides == true)
 	{
-		glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
+		DrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
 	}
 
 	glBindVertexArray(0);
@@ -2936,19 +1934,19 @@ void ShapeMeshes::DrawTaperedCylinderMeshLines(
 	bool bDrawBottom,
 	bool bDrawSides)
 {
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
+	BindMesh(m_TaperedCylinderMesh, taperedCylinder);
 
 	if (bDrawBottom == true)
 	{
-		glDrawArrays(GL_LINES, 0, 36);	//bottom
+		DrawArrays(GL_LINES, 0, 36);	//bottom
 	}
 	if (bDrawTop == true)
 	{
-		glDrawArrays(GL_LINES, 36, 72);	//top
+		DrawArrays(GL_LINES, 36, 72);	//top
 	}
 	if (bDrawSides == true)
 	{
-		glDrawArrays(GL_LINE_STRIP, 72, 146);	//sides
+		DrawArrays(GL_LINE_STRIP, 72, 146);	//sides
 	}
 
 	glBindVertexArray(0);
@@ -2962,9 +1960,9 @@ void ShapeMeshes::DrawTaperedCylinderMeshLines(
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawTorusMesh()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	BindMesh(m_TorusMesh, torus);
 
-	glDrawArrays(GL_TRIANGLES, 0, m_TorusMesh.nVertices);
+	DrawArrays(GL_TRIANGLES, 0, m_TorusMesh.nVertices);
 
 	glBindVertexArray(0);
 }
@@ -2977,9 +1975,9 @@ void ShapeMeshes::DrawTorusMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawTorusMeshLines()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	BindMesh(m_TorusMesh, torus);
 
-	glDrawArrays(GL_LINE_STRIP, 0, m_TorusMesh.nVertices);
+	DrawArrays(GL_LINE_STRIP, 0, m_TorusMesh.nVertices);
 
 	glBindVertexArray(0);
 }
@@ -2992,9 +1990,9 @@ void ShapeMeshes::DrawTorusMeshLines()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawExtraTorusMesh1()
 {
-	glBindVertexArray(m_ExtraTorusMesh1.vao);
+	BindMesh(m_ExtraTorusMesh1, torus);
 
-	glDrawArrays(GL_TRIANGLES, 0, m_ExtraTorusMesh1.nVertices);
+	DrawArrays(GL_TRIANGLES, 0, m_ExtraTorusMesh1.nVertices);
 
 	glBindVertexArray(0);
 }
@@ -3007,9 +2005,9 @@ void ShapeMeshes::DrawExtraTorusMesh1()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawExtraTorusMesh2()
 {
-	glBindVertexArray(m_ExtraTorusMesh2.vao);
+	BindMesh(m_ExtraTorusMesh2, torus);
 
-	glDrawArrays(GL_TRIANGLES, 0, m_ExtraTorusMesh2.nVertices);
+	DrawArrays(GL_TRIANGLES, 0, m_ExtraTorusMesh2.nVertices);
 
 	glBindVertexArray(0);
 }
@@ -3022,9 +2020,9 @@ void ShapeMeshes::DrawExtraTorusMesh2()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawHalfTorusMesh()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	BindMesh(m_TorusMesh, torus);
 
-	glDrawArrays(GL_TRIANGLES, 0, m_TorusMesh.nVertices/2);
+	DrawArrays(GL_TRIANGLES, 0, m_TorusMesh.nVertices/2);
 
 	glBindVertexArray(0);
 }
@@ -3037,13 +2035,61 @@ void ShapeMeshes::DrawHalfTorusMesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawHalfTorusMeshLines()
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	BindMesh(m_TorusMesh, torus);
 
-	glDrawArrays(GL_LINE_STRIP, 0, m_TorusMesh.nVertices / 2);
+	DrawArrays(GL_LINE_STRIP, 0, m_TorusMesh.nVertices / 2);
 
 	glBindVertexArray(0);
 }
 
+///////////////////////////////////////////////////
+//	BindMesh()
+//
+//	Bind the vertex array of a mesh and remember its
+//  primitive type for counting the following draws.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::BindMesh(const GLMesh& mesh, MeshType type)
+{
+	glBindVertexArray(mesh.vao);
+
+	m_boundMeshType = type;
+	RenderStats::CountVertexArrayBind();
+}
+
+///////////////////////////////////////////////////
+//	DrawArrays()
+//
+//	Submit a non-indexed draw call of the bound mesh
+//  and add it to the render statistics.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	PROFILE_FUNCTION();
+
+	glDrawArrays(mode, first, count);
+
+	RenderStats::CountDraw(m_boundMeshType, mode, count);
+}
+
+///////////////////////////////////////////////////
+//	DrawElements()
+//
+//	Submit an indexed draw call from the start of the
+//  bound index buffer and add it to the render
+//  statistics.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawElements(GLenum mode, GLsizei count)
+{
+	PROFILE_FUNCTION();
+
+	glDrawElements(mode, count, GL_UNSIGNED_INT, (void*)0);
+
+	RenderStats::CountDraw(m_boundMeshType, mode, count);
+}
+
 glm::vec3 ShapeMeshes::QuadCrossProduct(
 	glm::vec3 pnt0, glm::vec3 pnt1, glm::vec3 pnt2, glm::vec3 pnt3)
 {
@@ -3101,4 +2147,51 @@ void ShapeMeshes::SetShaderMemoryLayout()
 
 	glVertexAttribPointer(2, g_FloatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (g_FloatsPerVertex + g_FloatsPerNormal)));
 	glEnableVertexAttribArray(2);
-}
\ No newline at end of file
+}
+
+///////////////////////////////////////////////////
+//	DrawMesh()
+//
+//	Draw the whole filled mesh, or the mesh lines,
+//  of the passed in primitive type.  Used when the
+//  primitive type is stored with the scene objects.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawMesh(MeshType type, bool bLines)
+{
+	switch (type)
+	{
+	case box:
+		bLines ? DrawBoxMeshLines() : DrawBoxMesh();
+		break;
+	case cone:
+		bLines ? DrawConeMeshLines() : DrawConeMesh();
+		break;
+	case cylinder:
+		bLines ? DrawCylinderMeshLines() : DrawCylinderMesh();
+		break;
+	case plane:
+		bLines ? DrawPlaneMeshLines() : DrawPlaneMesh();
+		break;
+	case prism:
+		bLines ? DrawPrismMeshLines() : DrawPrismMesh();
+		break;
+	case pyramid3:
+		bLines ? DrawPyramid3MeshLines() : DrawPyramid3Mesh();
+		break;
+	case pyramid4:
+		bLines ? DrawPyramid4MeshLines() : DrawPyramid4Mesh();
+		break;
+	case sphere:
+		bLines ? DrawSphereMeshLines() : DrawSphereMesh();
+		break;
+	case taperedCylinder:
+		bLines ? DrawTaperedCylinderMeshLines() : DrawTaperedCylinderMesh();
+		break;
+	case torus:
+		bLines ? DrawTorusMeshLines() : DrawTorusMesh();
+		break;
+	default:
+		break;
+	}
+}
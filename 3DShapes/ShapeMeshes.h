@@ -12,8 +12,13 @@
 
 #include <GL/glew.h>
 
+#include "MeshCache.h"
+
 #include <glm/glm.hpp>
 
+#include <functional>
+#include <vector>
+
 /***********************************************************
  *  ShapeMeshes
  *
@@ -54,6 +59,9 @@ private:
 
 	bool m_bMemoryLayoutDone;
 
+	// generated meshes kept on disk between launches
+	MeshCache m_meshCache;
+
 public:
         enum BoxSide
 	{
@@ -65,6 +73,25 @@ public:
 		bottom
 	}; 
 
+	// the primitive types, used for counting draw calls
+	enum MeshType
+	{
+		box,
+		cone,
+		cylinder,
+		plane,
+		prism,
+		pyramid3,
+		pyramid4,
+		sphere,
+		taperedCylinder,
+		torus,
+		meshTypeCount
+	};
+
+	// name of a primitive type for exported statistics
+	static const char* GetMeshTypeName(MeshType type);
+
 	// methods for loading the shape mesh data 
 	// into memory
 	void LoadBoxMesh();
@@ -129,6 +156,19 @@ public:
 	void DrawExtraTorusMesh1();
 	void DrawExtraTorusMesh2();
 
+	// draw the whole filled mesh, or its lines, of a primitive type
+	void DrawMesh(MeshType type, bool bLines = false);
+
+	// corners of the filled triangles of a primitive type, three
+	// per triangle in the order DrawMesh() draws them - empty
+	// until the mesh is loaded
+	const std::vector<glm::vec3>& GetMeshTriangles(MeshType type) const;
+	// normals and texture coordinates of the same corners
+	const std::vector<glm::vec3>& GetMeshNormals(MeshType type) const;
+	const std::vector<glm::vec2>& GetMeshTextureCoordinates(MeshType type) const;
+	// bounds of the triangles of a primitive type
+	void GetMeshBounds(MeshType type, glm::vec3& minCorner, glm::vec3& maxCorner) const;
+
 
 private:
 
@@ -143,4 +183,63 @@ private:
 	// called to set the memory layout 
 	// template for shader data
 	void SetShaderMemoryLayout();
+
+	// triangles of a primitive type kept in memory, so rays can
+	// be tested against the meshes and shaded without reading
+	// them back
+	struct MESH_TRIANGLES
+	{
+		std::vector<glm::vec3> corners;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> textureCoordinates;
+		glm::vec3 minCorner;
+		glm::vec3 maxCorner;
+
+		void Clear()
+		{
+			corners.clear();
+			normals.clear();
+			textureCoordinates.clear();
+		}
+	};
+
+	// fill the buffers of a generated mesh from the mesh cache,
+	// generating the mesh when it is not cached yet, and keep
+	// its triangles when asked to
+	void CreateMeshBuffers(
+		GLMesh& mesh,
+		const char* cacheName,
+		const std::function<void(GLfloat*)>& writeVertices,
+		const GLuint* pIndices,
+		MESH_TRIANGLES* pTriangles);
+	// create the unchanging storage of a buffer from memory
+	void CreateStaticBuffer(GLenum target, GLuint buffer, GLsizeiptr size, const void* pData);
+	// create the vertex buffer of a mesh and write its
+	// vertices straight into it
+	void CreateVertexBuffer(
+		GLMesh& mesh,
+		const std::function<void(GLfloat*)>& writeVertices);
+	// create a torus mesh, shared by the torus loading methods
+	void CreateTorusMesh(GLMesh& mesh, float thickness, MESH_TRIANGLES* pTriangles);
+	// add the triangles of one draw of a mesh's vertices to the
+	// kept triangles, skipping any past the last vertex
+	void AddMeshTriangles(
+		MESH_TRIANGLES& triangles,
+		const GLfloat* pVertices,
+		GLuint vertexCount,
+		GLenum mode,
+		GLint first,
+		GLsizei count,
+		const GLuint* pIndices = NULL);
+
+	// bind a mesh for the following draw calls
+	void BindMesh(const GLMesh& mesh, MeshType type);
+	// submit a draw call and add it to the render statistics
+	void DrawArrays(GLenum mode, GLint first, GLsizei count);
+	void DrawElements(GLenum mode, GLsizei count);
+
+	// primitive type of the mesh bound by BindMesh()
+	MeshType m_boundMeshType;
+	// triangles of each primitive type as DrawMesh() draws them
+	MESH_TRIANGLES m_meshTriangles[meshTypeCount];
 };
\ No newline at end of file
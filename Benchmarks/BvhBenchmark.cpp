@@ -0,0 +1,319 @@
+///////////////////////////////////////////////////////////////////////////////
+// bvhbenchmark.cpp
+// ============
+// time building, refitting and querying BoundingVolumeHierarchy for parks
+// of 1k, 10k and 100k instances, against testing every instance
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+	const int g_InstanceCounts[] = { 1000, 10000, 100000 };
+	const int g_DefaultQueries = 1000;
+	// each measurement is repeated and the fastest run is kept
+	const int g_Runs = 5;
+	// share of the instances moved before a refit
+	const float g_MovedShare = 0.1f;
+
+	// the bounds of the instances of a park
+	struct PARK
+	{
+		std::vector<glm::vec3> minCorners;
+		std::vector<glm::vec3> maxCorners;
+		float size;
+	};
+
+	// scatter lamp post, bench and tree sized boxes over a square
+	// that grows with the count, so the density stays the same
+	void CreatePark(int count, PARK& park)
+	{
+		std::mt19937 generator(1234);
+		park.size = 10.0f * std::sqrt((float)count);
+		std::uniform_real_distribution<float> position(-park.size * 0.5f, park.size * 0.5f);
+		std::uniform_real_distribution<float> extent(1.0f, 4.0f);
+		std::uniform_real_distribution<float> height(2.0f, 45.0f);
+
+		park.minCorners.resize(count);
+		park.maxCorners.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			glm::vec3 center(position(generator), 0.0f, position(generator));
+			glm::vec3 half(extent(generator), 0.0f, extent(generator));
+			park.minCorners[i] = center - half;
+			park.maxCorners[i] = center + half + glm::vec3(0.0f, height(generator), 0.0f);
+		}
+	}
+
+	// the planes of a view projection matrix, pointing inwards
+	void GetFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+			glm::vec4 rowW(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+			planes[i * 2] = rowW + row;
+			planes[i * 2 + 1] = rowW - row;
+		}
+	}
+
+	// the frustum test of every instance that the tree replaces
+	void BruteForceFrustum(const PARK& park, const glm::mat4& viewProjection, std::vector<int>& instances)
+	{
+		glm::vec4 planes[6];
+		GetFrustumPlanes(viewProjection, planes);
+		for (size_t i = 0; i < park.minCorners.size(); i++)
+		{
+			bool bInside = true;
+			for (int p = 0; (p < 6) && bInside; p++)
+			{
+				glm::vec3 corner(
+					(planes[p].x >= 0.0f) ? park.maxCorners[i].x : park.minCorners[i].x,
+					(planes[p].y >= 0.0f) ? park.maxCorners[i].y : park.minCorners[i].y,
+					(planes[p].z >= 0.0f) ? park.maxCorners[i].z : park.minCorners[i].z);
+				bInside = (glm::dot(glm::vec3(planes[p]), corner) + planes[p].w >= 0.0f);
+			}
+			if (bInside == true)
+			{
+				instances.push_back((int)i);
+			}
+		}
+	}
+
+	// the region test of every instance
+	void BruteForceBox(const PARK& park, const glm::vec3& minCorner, const glm::vec3& maxCorner, std::vector<int>& instances)
+	{
+		for (size_t i = 0; i < park.minCorners.size(); i++)
+		{
+			if ((park.minCorners[i].x <= maxCorner.x) && (park.maxCorners[i].x >= minCorner.x)
+				&& (park.minCorners[i].y <= maxCorner.y) && (park.maxCorners[i].y >= minCorner.y)
+				&& (park.minCorners[i].z <= maxCorner.z) && (park.maxCorners[i].z >= minCorner.z))
+			{
+				instances.push_back((int)i);
+			}
+		}
+	}
+
+	// the nearest instance hit by a ray, testing every instance
+	int BruteForceRay(const PARK& park, const glm::vec3& origin, const glm::vec3& direction, float& distance)
+	{
+		int nearest = -1;
+		distance = FLT_MAX;
+		glm::vec3 inverseDirection = 1.0f / direction;
+		for (size_t i = 0; i < park.minCorners.size(); i++)
+		{
+			glm::vec3 t0 = (park.minCorners[i] - origin) * inverseDirection;
+			glm::vec3 t1 = (park.maxCorners[i] - origin) * inverseDirection;
+			glm::vec3 tNear = glm::min(t0, t1);
+			glm::vec3 tFar = glm::max(t0, t1);
+			float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+			float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+			if ((enter <= exit) && (enter < distance))
+			{
+				distance = enter;
+				nearest = (int)i;
+			}
+		}
+		return(nearest);
+	}
+
+	// time the passed in function and return the fastest run in ms
+	template <typename FUNCTION>
+	double Time(FUNCTION function)
+	{
+		double fastest = DBL_MAX;
+		for (int run = 0; run < g_Runs; run++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			function();
+			fastest = std::min(fastest, std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count());
+		}
+		return(fastest);
+	}
+}
+
+/***********************************************************
+ *  main()
+ *
+ *  Times the build, refit and queries for each park size,
+ *  with the number of queries and threads passed on the
+ *  command line, and checks that the tree finds the same
+ *  instances as testing all of them.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	int queries = (argc > 1) ? std::max(1, atoi(argv[1])) : g_DefaultQueries;
+	int threads = (argc > 2) ? std::max(0, atoi(argv[2])) : 0;
+	JobSystem jobSystem(threads);
+	bool bMatches = true;
+
+	for (size_t c = 0; c < sizeof(g_InstanceCounts) / sizeof(g_InstanceCounts[0]); c++)
+	{
+		int count = g_InstanceCounts[c];
+		PARK park;
+		CreatePark(count, park);
+
+		BoundingVolumeHierarchy hierarchy;
+		double serialBuild = Time([&]() {
+			hierarchy.Build(park.minCorners.data(), park.maxCorners.data(), count);
+		});
+		double parallelBuild = Time([&]() {
+			hierarchy.Build(park.minCorners.data(), park.maxCorners.data(), count, &jobSystem);
+			jobSystem.Reset();
+		});
+
+		std::cout << "instances: " << count << ", nodes " << hierarchy.GetNodeCount()
+			<< ", depth " << hierarchy.GetDepth() << ", SAH cost " << hierarchy.GetCost() << std::endl;
+		std::cout << "  build " << serialBuild << " ms, on " << jobSystem.GetThreadCount()
+			<< " threads " << parallelBuild << " ms" << std::endl;
+
+		// move some of the instances and refit the tree to them
+		PARK moved = park;
+		int movedCount = (int)(count * g_MovedShare);
+		for (int i = 0; i < movedCount; i++)
+		{
+			int instance = (i * count / std::max(movedCount, 1));
+			moved.minCorners[instance] += glm::vec3(0.5f, 0.0f, -0.5f);
+			moved.maxCorners[instance] += glm::vec3(0.5f, 0.0f, -0.5f);
+		}
+		double refit = Time([&]() {
+			hierarchy.Refit(moved.minCorners.data(), moved.maxCorners.data());
+		});
+		std::cout << "  refit after moving " << movedCount << " instances " << refit << " ms" << std::endl;
+
+		// a camera on the ground looking across the park from
+		// each of its sides in turn
+		std::vector<glm::mat4> views(queries);
+		std::mt19937 generator(5678);
+		std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+		for (int i = 0; i < queries; i++)
+		{
+			float a = angle(generator);
+			glm::vec3 eye(std::cos(a) * park.size * 0.25f, 5.0f, std::sin(a) * park.size * 0.25f);
+			views[i] = projection * glm::lookAt(eye, glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+
+		std::vector<int> found;
+		std::vector<int> expected;
+		found.reserve(count);
+		expected.reserve(count);
+		size_t visible = 0;
+		double treeFrustum = Time([&]() {
+			visible = 0;
+			for (int i = 0; i < queries; i++)
+			{
+				found.clear();
+				hierarchy.QueryFrustum(views[i], found);
+				visible += found.size();
+			}
+		});
+		double bruteFrustum = Time([&]() {
+			for (int i = 0; i < queries; i++)
+			{
+				expected.clear();
+				BruteForceFrustum(moved, views[i], expected);
+			}
+		});
+		std::cout << "  frustum " << treeFrustum * 1000.0 / queries << " us per query, testing all "
+			<< bruteFrustum * 1000.0 / queries << " us, " << visible / queries << " visible" << std::endl;
+
+		// regions of about the size of a tile
+		std::vector<glm::vec3> regions(queries);
+		std::uniform_real_distribution<float> position(-park.size * 0.5f, park.size * 0.5f);
+		for (int i = 0; i < queries; i++)
+		{
+			regions[i] = glm::vec3(position(generator), 0.0f, position(generator));
+		}
+		glm::vec3 regionHalf(50.0f, 100.0f, 50.0f);
+		size_t overlapping = 0;
+		double treeBox = Time([&]() {
+			overlapping = 0;
+			for (int i = 0; i < queries; i++)
+			{
+				found.clear();
+				hierarchy.QueryBox(regions[i] - regionHalf, regions[i] + regionHalf, found);
+				overlapping += found.size();
+			}
+		});
+		double bruteBox = Time([&]() {
+			for (int i = 0; i < queries; i++)
+			{
+				expected.clear();
+				BruteForceBox(moved, regions[i] - regionHalf, regions[i] + regionHalf, expected);
+			}
+		});
+		std::cout << "  region " << treeBox * 1000.0 / queries << " us per query, testing all "
+			<< bruteBox * 1000.0 / queries << " us, " << overlapping / queries << " overlapping" << std::endl;
+
+		// rays from above the park down at the ground, like picking
+		std::vector<glm::vec3> origins(queries);
+		std::vector<glm::vec3> directions(queries);
+		for (int i = 0; i < queries; i++)
+		{
+			origins[i] = glm::vec3(position(generator), 60.0f, position(generator));
+			directions[i] = glm::normalize(glm::vec3(regions[i].x, 0.0f, regions[i].z) - origins[i]);
+		}
+		int hits = 0;
+		double treeRay = Time([&]() {
+			hits = 0;
+			for (int i = 0; i < queries; i++)
+			{
+				float distance = 0.0f;
+				hits += (hierarchy.QueryRay(origins[i], directions[i], FLT_MAX, distance) >= 0) ? 1 : 0;
+			}
+		});
+		int bruteHits = 0;
+		double bruteRay = Time([&]() {
+			bruteHits = 0;
+			for (int i = 0; i < queries; i++)
+			{
+				float distance = 0.0f;
+				bruteHits += (BruteForceRay(moved, origins[i], directions[i], distance) >= 0) ? 1 : 0;
+			}
+		});
+		std::cout << "  ray " << treeRay * 1000.0 / queries << " us per query, testing all "
+			<< bruteRay * 1000.0 / queries << " us, " << hits << " hits" << std::endl;
+		bMatches = bMatches && (hits == bruteHits);
+
+		// the tree must find exactly what testing all instances finds
+		for (int i = 0; (i < queries) && bMatches; i++)
+		{
+			found.clear();
+			expected.clear();
+			hierarchy.QueryFrustum(views[i], found);
+			BruteForceFrustum(moved, views[i], expected);
+			std::sort(found.begin(), found.end());
+			bMatches = (found == expected);
+
+			found.clear();
+			expected.clear();
+			hierarchy.QueryBox(regions[i] - regionHalf, regions[i] + regionHalf, found);
+			BruteForceBox(moved, regions[i] - regionHalf, regions[i] + regionHalf, expected);
+			std::sort(found.begin(), found.end());
+			bMatches = bMatches && (found == expected);
+
+			float treeDistance = 0.0f;
+			float bruteDistance = 0.0f;
+			hierarchy.QueryRay(origins[i], directions[i], FLT_MAX, treeDistance);
+			int bruteHit = BruteForceRay(moved, origins[i], directions[i], bruteDistance);
+			bMatches = bMatches && ((bruteHit < 0) ? (treeDistance == FLT_MAX) : (treeDistance == bruteDistance));
+		}
+	}
+
+	std::cout << (bMatches ? "all queries match testing every instance" : "QUERIES DO NOT MATCH") << std::endl;
+	return(bMatches ? 0 : 1);
+}
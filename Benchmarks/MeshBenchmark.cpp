@@ -0,0 +1,303 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshbenchmark.cpp
+// ============
+// compare building the torus and sphere vertices the way ShapeMeshes
+// used to with the pre-sized builders in MeshBuilder
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshBuilder.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+	const int g_DefaultIterations = 200;
+	// each version is timed this many times and the fastest run is kept
+	const int g_Runs = 5;
+	// tube radius of the default torus
+	const float g_TubeRadius = 0.2f;
+
+	// the torus built the way LoadTorusMesh built it before
+	// MeshBuilder - a list for every segment, then every float
+	// pushed into a list that grows as it goes
+	std::vector<float> BuildTorusWithLists(float tubeRadius)
+	{
+		int _mainSegments = 30;
+		int _tubeSegments = 30;
+		float _mainRadius = 1.0f;
+		float _tubeRadius = tubeRadius;
+
+		auto mainSegmentAngleStep = glm::radians(360.0f / float(_mainSegments));
+		auto tubeSegmentAngleStep = glm::radians(360.0f / float(_tubeSegments));
+
+		std::vector<glm::vec3> vertex_list;
+		std::vector<std::vector<glm::vec3>> segments_list;
+		std::vector<glm::vec2> texture_coords;
+
+		auto currentMainSegmentAngle = 0.0f;
+		for (auto i = 0; i < _mainSegments; i++)
+		{
+			auto sinMainSegment = sin(currentMainSegmentAngle);
+			auto cosMainSegment = cos(currentMainSegmentAngle);
+			auto currentTubeSegmentAngle = 0.0f;
+			std::vector<glm::vec3> segment_points;
+			for (auto j = 0; j < _tubeSegments; j++)
+			{
+				auto sinTubeSegment = sin(currentTubeSegmentAngle);
+				auto cosTubeSegment = cos(currentTubeSegmentAngle);
+				segment_points.push_back(glm::vec3(
+					(_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
+					(_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
+					_tubeRadius * sinTubeSegment));
+				currentTubeSegmentAngle += tubeSegmentAngleStep;
+			}
+			segments_list.push_back(segment_points);
+			currentMainSegmentAngle += mainSegmentAngleStep;
+		}
+
+		float horizontalStep = 1.0 / _mainSegments;
+		float verticalStep = 1.0 / _tubeSegments;
+		float u = 0.0;
+		float v = 0.0;
+
+		// connect the various segments together, forming triangles
+		for (int i = 0; i < _mainSegments; i++)
+		{
+			for (int j = 0; j < _tubeSegments; j++)
+			{
+				if (((i + 1) < _mainSegments) && ((j + 1) < _tubeSegments))
+				{
+					vertex_list.push_back(segments_list[i][j]);
+					texture_coords.push_back(glm::vec2(u, v));
+					vertex_list.push_back(segments_list[i][j + 1]);
+					texture_coords.push_back(glm::vec2(u, v + verticalStep));
+					vertex_list.push_back(segments_list[i + 1][j + 1]);
+					texture_coords.push_back(glm::vec2(u + horizontalStep, v + verticalStep));
+					vertex_list.push_back(segments_list[i][j]);
+					texture_coords.push_back(glm::vec2(u, v));
+					vertex_list.push_back(segments_list[i + 1][j]);
+					texture_coords.push_back(glm::vec2(u + horizontalStep, v));
+					vertex_list.push_back(segments_list[i + 1][j + 1]);
+					texture_coords.push_back(glm::vec2(u + horizontalStep, v - verticalStep));
+					vertex_list.push_back(segments_list[i][j]);
+					texture_coords.push_back(glm::vec2(u, v));
+				}
+				else
+				{
+					if (((i + 1) == _mainSegments) && ((j + 1) == _tubeSegments))
+					{
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[i][0]);
+						texture_coords.push_back(glm::vec2(u, 0));
+						vertex_list.push_back(segments_list[0][0]);
+						texture_coords.push_back(glm::vec2(0, 0));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[0][j]);
+						texture_coords.push_back(glm::vec2(0, v));
+						vertex_list.push_back(segments_list[0][0]);
+						texture_coords.push_back(glm::vec2(0, 0));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+					}
+					else if ((i + 1) == _mainSegments)
+					{
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[i][j + 1]);
+						texture_coords.push_back(glm::vec2(u, v + verticalStep));
+						vertex_list.push_back(segments_list[0][j + 1]);
+						texture_coords.push_back(glm::vec2(0, v + verticalStep));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[0][j]);
+						texture_coords.push_back(glm::vec2(0, v));
+						vertex_list.push_back(segments_list[0][j + 1]);
+						texture_coords.push_back(glm::vec2(0, v + verticalStep));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+					}
+					else if ((j + 1) == _tubeSegments)
+					{
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[i][0]);
+						texture_coords.push_back(glm::vec2(u, 0));
+						vertex_list.push_back(segments_list[i + 1][0]);
+						texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+						vertex_list.push_back(segments_list[i + 1][j]);
+						texture_coords.push_back(glm::vec2(u + horizontalStep, v));
+						vertex_list.push_back(segments_list[i + 1][0]);
+						texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
+						vertex_list.push_back(segments_list[i][j]);
+						texture_coords.push_back(glm::vec2(u, v));
+					}
+
+				}
+				v += verticalStep;
+			}
+			v = 0.0;
+			u += horizontalStep;
+		}
+
+		std::vector<float> combined_values;
+		for (size_t i = 0; i < vertex_list.size(); i++)
+		{
+			glm::vec3 vertex = vertex_list[i];
+			glm::vec3 normal = normalize(vertex);
+			combined_values.push_back(vertex.x);
+			combined_values.push_back(vertex.y);
+			combined_values.push_back(vertex.z);
+			combined_values.push_back(normal.x);
+			combined_values.push_back(normal.y);
+			combined_values.push_back(normal.z);
+			combined_values.push_back(texture_coords[i].x);
+			combined_values.push_back(texture_coords[i].y);
+		}
+		return(combined_values);
+	}
+
+	// the sphere built the way LoadSphereMesh built it before
+	// MeshBuilder - the position and texture coordinate table
+	// pushed one float at a time into a list that grows
+	std::vector<float> BuildSphereWithLists(const std::vector<float>& table)
+	{
+		std::vector<float> combined_values;
+		for (size_t i = 0; i < table.size(); i += 5)
+		{
+			glm::vec3 vert = glm::vec3(table[i], table[i + 1], table[i + 2]);
+			glm::vec3 normal = normalize(vert);
+			combined_values.push_back(vert.x);
+			combined_values.push_back(vert.y);
+			combined_values.push_back(vert.z);
+			combined_values.push_back(normal.x);
+			combined_values.push_back(normal.y);
+			combined_values.push_back(normal.z);
+			combined_values.push_back(table[i + 3]);
+			combined_values.push_back(table[i + 4]);
+		}
+		return(combined_values);
+	}
+
+	// run the passed in function the passed in number of times and
+	// return the fastest of the runs in microseconds per mesh
+	template <typename FUNCTION>
+	double TimeVersion(FUNCTION function, int iterations)
+	{
+		double best = 1e30;
+		for (int run = 0; run < g_Runs; run++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int iteration = 0; iteration < iterations; iteration++)
+			{
+				function();
+			}
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			double microseconds = std::chrono::duration<double, std::micro>(end - start).count();
+			best = std::min(best, microseconds / iterations);
+		}
+		return(best);
+	}
+
+	// largest difference of any value between the vertex lists
+	float MaxDifference(const std::vector<float>& a, const std::vector<float>& b)
+	{
+		if (a.size() != b.size())
+		{
+			return(INFINITY);
+		}
+
+		float difference = 0.0f;
+		for (size_t index = 0; index < a.size(); index++)
+		{
+			difference = std::max(difference, std::fabs(a[index] - b[index]));
+		}
+		return(difference);
+	}
+
+	// sum of the values so the work cannot be optimized away
+	float Checksum(const std::vector<float>& values)
+	{
+		float sum = 0.0f;
+		for (size_t index = 0; index < values.size(); index++)
+		{
+			sum += values[index];
+		}
+		return(sum);
+	}
+}
+
+/***********************************************************
+ *  main()
+ *
+ *  Times both versions of the torus and the sphere for the
+ *  iterations that can be passed on the command line.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	int iterations = (argc > 1) ? std::max(1, atoi(argv[1])) : g_DefaultIterations;
+
+	// the sphere table is read back from the builder, without
+	// the normals that it adds
+	std::vector<float> sphereVertices(MeshBuilder::GetSphereVertexCount() * MeshBuilder::FLOATS_PER_VERTEX);
+	MeshBuilder::WriteSphere(sphereVertices.data());
+	std::vector<float> sphereTable;
+	for (size_t i = 0; i < sphereVertices.size(); i += MeshBuilder::FLOATS_PER_VERTEX)
+	{
+		sphereTable.insert(sphereTable.end(), &sphereVertices[i], &sphereVertices[i + 3]);
+		sphereTable.insert(sphereTable.end(), &sphereVertices[i + 6], &sphereVertices[i + 8]);
+	}
+
+	std::vector<float> torusWithLists;
+	std::vector<float> sphereWithLists;
+	std::vector<float> torusVertices(MeshBuilder::GetTorusVertexCount() * MeshBuilder::FLOATS_PER_VERTEX);
+
+	double torusListTime = TimeVersion([&]()
+	{
+		torusWithLists = BuildTorusWithLists(g_TubeRadius);
+	}, iterations);
+
+	double torusBuilderTime = TimeVersion([&]()
+	{
+		MeshBuilder::WriteTorus(g_TubeRadius, torusVertices.data());
+	}, iterations);
+
+	double sphereListTime = TimeVersion([&]()
+	{
+		sphereWithLists = BuildSphereWithLists(sphereTable);
+	}, iterations);
+
+	double sphereBuilderTime = TimeVersion([&]()
+	{
+		MeshBuilder::WriteSphere(sphereVertices.data());
+	}, iterations);
+
+	std::cout << "iterations: " << iterations << std::endl;
+	std::cout << "torus (" << MeshBuilder::GetTorusVertexCount() << " vertices)" << std::endl;
+	std::cout << "  growing lists: " << torusListTime << " us/mesh" << std::endl;
+	std::cout << "  builder:       " << torusBuilderTime << " us/mesh ("
+		<< torusListTime / torusBuilderTime << "x), max difference "
+		<< MaxDifference(torusWithLists, torusVertices) << std::endl;
+	std::cout << "sphere (" << MeshBuilder::GetSphereVertexCount() << " vertices)" << std::endl;
+	std::cout << "  growing lists: " << sphereListTime << " us/mesh" << std::endl;
+	std::cout << "  builder:       " << sphereBuilderTime << " us/mesh ("
+		<< sphereListTime / sphereBuilderTime << "x), max difference "
+		<< MaxDifference(sphereWithLists, sphereVertices) << std::endl;
+	std::cout << "checksum: " << Checksum(torusWithLists) + Checksum(torusVertices)
+		+ Checksum(sphereWithLists) + Checksum(sphereVertices) << std::endl;
+
+	return(0);
+}
@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+// rasterbenchmark.cpp
+// ============
+// time the SoftwareRasterizer drawing small, medium and large triangles
+// scattered over the screen, in triangles and pixels per second
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+	// pixels along the legs of the triangles of each run
+	const float g_TriangleSizes[] = { 2.0f, 16.0f, 128.0f };
+	const int g_DefaultTriangles = 100000;
+	const int g_Width = 1024;
+	const int g_Height = 768;
+	// each measurement is repeated and the fastest run is kept
+	const int g_Runs = 5;
+	// triangles queued by each draw, like the parts of the park
+	const int g_DrawTriangles = 256;
+
+	// scatter right triangles of a size over the screen, facing
+	// the camera at random depths, straight in clip space
+	void CreateTriangles(int count, float size, std::vector<glm::vec3>& corners)
+	{
+		std::mt19937 generator(1234);
+		std::uniform_real_distribution<float> x(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> y(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> depth(-0.9f, 0.9f);
+		glm::vec2 leg(size * 2.0f / g_Width, size * 2.0f / g_Height);
+
+		corners.resize((size_t)count * 3);
+		for (int i = 0; i < count; i++)
+		{
+			glm::vec3 corner(x(generator), y(generator), depth(generator));
+			corners[i * 3] = corner;
+			corners[i * 3 + 1] = corner + glm::vec3(leg.x, 0.0f, 0.0f);
+			corners[i * 3 + 2] = corner + glm::vec3(0.0f, leg.y, 0.0f);
+		}
+	}
+}
+
+/***********************************************************
+ *  main()
+ *
+ *  Draws the triangles of each size with the number of
+ *  triangles and threads passed on the command line, and
+ *  prints the fastest frame with the triangles and shaded
+ *  pixels per second.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	int triangles = (argc > 1) ? std::max(1, atoi(argv[1])) : g_DefaultTriangles;
+	int threads = (argc > 2) ? std::max(0, atoi(argv[2])) : 0;
+	JobSystem jobSystem(threads);
+
+	SoftwareRasterizer rasterizer;
+	if (rasterizer.Resize(g_Width, g_Height) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the corners are already in clip space
+	SoftwareRasterizer::CAMERA camera;
+	camera.view = glm::mat4(1.0f);
+	camera.projection = glm::mat4(1.0f);
+	camera.viewPosition = glm::vec3(0.0f, 0.0f, -2.0f);
+	rasterizer.SetCamera(camera);
+	SoftwareRasterizer::LIGHTS lights = SoftwareRasterizer::LIGHTS();
+	lights.directionalLight.direction = glm::vec3(0.0f, 0.0f, 1.0f);
+	lights.directionalLight.ambient = glm::vec3(0.2f);
+	lights.directionalLight.diffuse = glm::vec3(0.8f);
+	lights.directionalLight.specular = glm::vec3(0.2f);
+	lights.directionalLight.bActive = true;
+	rasterizer.SetLights(lights);
+
+	SoftwareRasterizer::SURFACE surface;
+	surface.texture = -1;
+	surface.color = glm::vec4(0.2f, 0.6f, 0.3f, 1.0f);
+	surface.diffuseColor = glm::vec3(1.0f);
+	surface.specularColor = glm::vec3(0.5f);
+	surface.shininess = 16.0f;
+
+	std::cout << "drawing " << triangles << " triangles at " << g_Width << "x" << g_Height
+		<< " on " << jobSystem.GetThreadCount() << " threads with "
+		<< SoftwareRasterizer::GetInstructionSet() << std::endl;
+
+	for (size_t s = 0; s < sizeof(g_TriangleSizes) / sizeof(g_TriangleSizes[0]); s++)
+	{
+		std::vector<glm::vec3> corners;
+		CreateTriangles(triangles, g_TriangleSizes[s], corners);
+		std::vector<glm::vec3> normals(corners.size(), glm::vec3(0.0f, 0.0f, -1.0f));
+		std::vector<glm::vec2> textureCoordinates(corners.size(), glm::vec2(0.0f));
+
+		double fastest = DBL_MAX;
+		SoftwareRasterizer::STATISTICS statistics = SoftwareRasterizer::STATISTICS();
+		for (int run = 0; run < g_Runs; run++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			rasterizer.Clear(glm::vec3(0.0f));
+			for (int first = 0; first < triangles; first += g_DrawTriangles)
+			{
+				rasterizer.Draw(
+					glm::mat4(1.0f),
+					corners.data() + (size_t)first * 3,
+					normals.data() + (size_t)first * 3,
+					textureCoordinates.data() + (size_t)first * 3,
+					std::min(g_DrawTriangles, triangles - first) * 3,
+					surface);
+			}
+			rasterizer.Finish(&jobSystem);
+			jobSystem.Reset();
+			double milliseconds = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count();
+			if (milliseconds < fastest)
+			{
+				fastest = milliseconds;
+				statistics = rasterizer.GetStatistics();
+			}
+		}
+
+		double seconds = std::max(fastest / 1000.0, 1e-9);
+		std::cout << "triangles of " << g_TriangleSizes[s] << " pixels: " << fastest << " ms (bin "
+			<< statistics.binMilliseconds << " ms, raster " << statistics.rasterMilliseconds << " ms), "
+			<< triangles / seconds / 1.0e6 << " Mtri/s, "
+			<< statistics.shadedPixels / seconds / 1.0e6 << " Mpixels/s, "
+			<< statistics.binnedTriangles << " binned" << std::endl;
+	}
+
+	return(EXIT_SUCCESS);
+}
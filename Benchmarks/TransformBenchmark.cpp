@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbenchmark.cpp
+// ============
+// compare building model matrices from chained glm calls with the
+// closed form and SIMD batch versions in TransformKernels
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformKernels.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+	// about the number of transforms set for each frame of the park
+	const int g_DefaultCount = 2048;
+	const int g_DefaultIterations = 500;
+	// each version is timed this many times and the fastest run is kept
+	const int g_Runs = 5;
+
+	// the transforms in the separate arrays used by the batch version
+	struct TRS_INPUT
+	{
+		std::vector<float> values[9];
+		TransformKernels::TRS_ARRAYS arrays;
+	};
+
+	// the model matrix built the way SceneManager built it before
+	// the transform kernels - five matrices multiplied together
+	glm::mat4 ComposeWithGLM(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ)
+	{
+		glm::mat4 scale = glm::scale(scaleXYZ);
+		glm::mat4 rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
+		glm::mat4 rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 translation = glm::translate(positionXYZ);
+
+		return(translation * rotationZ * rotationY * rotationX * scale);
+	}
+
+	// random transforms like the ones in the scene - most of the
+	// objects are only rotated around one or two axes
+	void CreateInput(int count, TRS_INPUT& input)
+	{
+		std::mt19937 generator(1234);
+		std::uniform_real_distribution<float> scale(0.1f, 30.0f);
+		std::uniform_real_distribution<float> angle(-360.0f, 360.0f);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_int_distribution<int> zeroAngle(0, 2);
+
+		for (int i = 0; i < 9; i++)
+		{
+			input.values[i].resize(count);
+		}
+		for (int index = 0; index < count; index++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				input.values[axis][index] = scale(generator);
+				input.values[3 + axis][index] = (zeroAngle(generator) == 0) ? 0.0f : angle(generator);
+				input.values[6 + axis][index] = position(generator);
+			}
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			input.arrays.scale[axis] = input.values[axis].data();
+			input.arrays.rotation[axis] = input.values[3 + axis].data();
+			input.arrays.position[axis] = input.values[6 + axis].data();
+		}
+	}
+
+	// run the passed in function the passed in number of times and
+	// return the fastest of the runs in nanoseconds per matrix
+	template <typename FUNCTION>
+	double TimeVersion(FUNCTION function, int count, int iterations)
+	{
+		double best = 1e30;
+		for (int run = 0; run < g_Runs; run++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int iteration = 0; iteration < iterations; iteration++)
+			{
+				function();
+			}
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+			best = std::min(best, nanoseconds / ((double)count * iterations));
+		}
+		return(best);
+	}
+
+	// largest difference of any element between the matrix arrays
+	float MaxDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+	{
+		float difference = 0.0f;
+		for (size_t index = 0; index < a.size(); index++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					difference = std::max(difference, std::fabs(a[index][column][row] - b[index][column][row]));
+				}
+			}
+		}
+		return(difference);
+	}
+
+	// sum of the matrix elements so the work cannot be optimized away
+	float Checksum(const std::vector<glm::mat4>& matrices)
+	{
+		float sum = 0.0f;
+		for (size_t index = 0; index < matrices.size(); index++)
+		{
+			sum += matrices[index][0][0] + matrices[index][3][2];
+		}
+		return(sum);
+	}
+}
+
+/***********************************************************
+ *  main()
+ *
+ *  Times the three versions for the transform count and
+ *  iterations that can be passed on the command line.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	int count = (argc > 1) ? std::max(1, atoi(argv[1])) : g_DefaultCount;
+	int iterations = (argc > 2) ? std::max(1, atoi(argv[2])) : g_DefaultIterations;
+
+	TRS_INPUT input;
+	CreateInput(count, input);
+	const TransformKernels::TRS_ARRAYS& arrays = input.arrays;
+
+	std::vector<glm::mat4> glmMatrices(count);
+	std::vector<glm::mat4> scalarMatrices(count);
+	std::vector<glm::mat4> batchMatrices(count);
+
+	double glmTime = TimeVersion([&]()
+	{
+		for (int index = 0; index < count; index++)
+		{
+			glmMatrices[index] = ComposeWithGLM(
+				glm::vec3(arrays.scale[0][index], arrays.scale[1][index], arrays.scale[2][index]),
+				arrays.rotation[0][index], arrays.rotation[1][index], arrays.rotation[2][index],
+				glm::vec3(arrays.position[0][index], arrays.position[1][index], arrays.position[2][index]));
+		}
+	}, count, iterations);
+
+	double scalarTime = TimeVersion([&]()
+	{
+		for (int index = 0; index < count; index++)
+		{
+			scalarMatrices[index] = TransformKernels::ComposeTRS(
+				glm::vec3(arrays.scale[0][index], arrays.scale[1][index], arrays.scale[2][index]),
+				glm::vec3(arrays.rotation[0][index], arrays.rotation[1][index], arrays.rotation[2][index]),
+				glm::vec3(arrays.position[0][index], arrays.position[1][index], arrays.position[2][index]));
+		}
+	}, count, iterations);
+
+	double batchTime = TimeVersion([&]()
+	{
+		TransformKernels::ComposeTRSBatch(arrays, count, batchMatrices.data());
+	}, count, iterations);
+
+	std::cout << "transforms: " << count << ", iterations: " << iterations
+		<< ", batch instructions: " << TransformKernels::GetInstructionSet() << std::endl;
+	std::cout << "glm chain:    " << glmTime << " ns/matrix" << std::endl;
+	std::cout << "closed form:  " << scalarTime << " ns/matrix ("
+		<< glmTime / scalarTime << "x), max error " << MaxDifference(glmMatrices, scalarMatrices) << std::endl;
+	std::cout << "batch:        " << batchTime << " ns/matrix ("
+		<< glmTime / batchTime << "x), max error " << MaxDifference(glmMatrices, batchMatrices) << std::endl;
+	std::cout << "checksum: " << Checksum(glmMatrices) + Checksum(scalarMatrices) + Checksum(batchMatrices) << std::endl;
+
+	return(0);
+}
@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformsystembenchmark.cpp
+// ============
+// time TransformSystem::Update() for a large animated park, where some
+// of the objects move every frame and carry their parts with them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	const int g_DefaultObjects = 100000;
+	const int g_DefaultFrames = 100;
+	// parts under each object, like the planes of a bench
+	const int g_PartsPerObject = 9;
+	// share of the objects moved every frame
+	const double g_MovedShares[] = { 0.0, 0.01, 0.1, 1.0 };
+
+	// add objects with their parts until the passed in total is reached
+	void CreatePark(int total, TransformSystem& transforms, std::vector<int>& roots)
+	{
+		while (transforms.GetCount() < total)
+		{
+			float x = (float)(transforms.GetCount() % 1000);
+			float z = (float)(transforms.GetCount() / 1000);
+			int root = transforms.AddTransform(glm::vec3(1.0f), glm::vec3(0.0f), glm::vec3(x, 0.0f, -z));
+			roots.push_back(root);
+
+			for (int part = 0; (part < g_PartsPerObject) && (transforms.GetCount() < total); part++)
+			{
+				transforms.AddTransform(
+					glm::vec3(1.0f, 2.0f, 2.0f),
+					glm::vec3(90.0f, 10.0f * part, 0.0f),
+					glm::vec3(0.0f, 2.0f, 0.5f * part),
+					root);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  main()
+ *
+ *  Times the update for each share of moved objects, with
+ *  the object count, frames and threads passed on the
+ *  command line.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	int objects = (argc > 1) ? std::max(1, atoi(argv[1])) : g_DefaultObjects;
+	int frames = (argc > 2) ? std::max(1, atoi(argv[2])) : g_DefaultFrames;
+	int threads = (argc > 3) ? std::max(0, atoi(argv[3])) : 0;
+	JobSystem jobSystem(threads);
+
+	TransformSystem transforms;
+	std::vector<int> roots;
+	CreatePark(objects, transforms, roots);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	transforms.Update(&jobSystem);
+	double firstUpdate = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	jobSystem.Reset();
+
+	std::cout << "transforms: " << transforms.GetCount() << " (" << roots.size()
+		<< " objects) on " << jobSystem.GetThreadCount()
+		<< " threads, first update " << firstUpdate << " ms" << std::endl;
+
+	for (size_t share = 0; share < sizeof(g_MovedShares) / sizeof(g_MovedShares[0]); share++)
+	{
+		int moved = (int)(roots.size() * g_MovedShares[share]);
+		int rebuilt = 0;
+		double total = 0.0;
+
+		for (int frame = 0; frame < frames; frame++)
+		{
+			// move a different spread out set of objects each frame
+			for (int i = 0; i < moved; i++)
+			{
+				int root = roots[(i * (int)roots.size() / std::max(moved, 1) + frame) % roots.size()];
+				glm::vec3 position = transforms.GetPosition(root);
+				transforms.SetPosition(root, position + glm::vec3(0.0f, 0.01f, 0.0f));
+			}
+
+			start = std::chrono::steady_clock::now();
+			rebuilt = transforms.Update(&jobSystem);
+			total += std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count();
+			jobSystem.Reset();
+		}
+
+		std::cout << "moved " << moved << " objects: " << total / frames
+			<< " ms per update, " << rebuilt << " world matrices rebuilt" << std::endl;
+	}
+
+	return(0);
+}
@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchmode.cpp
+// ============
+// render the view of each key of a camera path file into a PNG file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RunModes.h"
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <climits>          // INT_MAX
+#include <cstdio>           // batch image names
+#include <algorithm>
+#include <chrono>           // batch timing
+#include <filesystem>       // batch image directory
+#include <fstream>          // benchmark result output
+#include <sstream>          // benchmark result output
+
+#include <GL/glew.h>        // GLEW library
+
+#include "ViewManager.h"
+#include "OffscreenContext.h"
+#include "RenderTarget.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "CameraPath.h"
+#include "FrameReadback.h"
+#include "ImageWriter.h"
+#include "SoftwareRasterizer.h"
+
+bool RenderBatch(const APP_OPTIONS& options, std::ostream& output);
+
+/***********************************************************
+ *	RunBatch()
+ *
+ *  This function is used to render the views of the batch
+ *  file in place of the timed headless frames, print the
+ *  images per second as JSON and clean up the passed in
+ *  context and framebuffer.
+ ***********************************************************/
+int RunBatch(const APP_OPTIONS& options, OffscreenContext& context, RenderTarget& renderTarget)
+{
+	std::ostringstream batch;
+	bool bRendered = RenderBatch(options, batch);
+	renderTarget.Unbind();
+	if (bRendered == true)
+	{
+		std::ostringstream results;
+		results << "{\"mode\":\"batch\""
+			<< ",\"renderer\":\"" << glGetString(GL_RENDERER) << "\""
+			<< ",\"rasterizer\":\"" << ((NULL != g_SoftwareRasterizer) ? "software" : "gl") << "\""
+			<< ",\"width\":" << options.width
+			<< ",\"height\":" << options.height
+			<< ",\"threads\":" << g_JobSystem->GetThreadCount()
+			<< ",\"batch\":" << batch.str() << "}";
+		std::cout << results.str() << std::endl;
+		if (options.outputPath.empty() == false)
+		{
+			std::ofstream outputFile(options.outputPath);
+			outputFile << results.str() << std::endl;
+		}
+	}
+	if (options.tracePath.empty() == false)
+	{
+		Profiler::WriteChromeTrace(options.tracePath.c_str());
+	}
+
+	renderTarget.Destroy();
+	DestroyManagers();
+	context.Destroy();
+	return(bRendered ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *	RenderBatch()
+ *
+ *  This function is used to render the view of each key of
+ *  a camera path file into a PNG file in the batch
+ *  directory.  Each view is drawn into the bound framebuffer
+ *  and copied back through the readback ring while the next
+ *  views are drawn, and the copied frames are written by the
+ *  image writer's threads, so drawing, copying and writing
+ *  overlap.  The images per second are written as one JSON
+ *  object.
+ ***********************************************************/
+bool RenderBatch(const APP_OPTIONS& options, std::ostream& output)
+{
+	CameraPath poses;
+	if (poses.LoadFromFile(options.batchPath.c_str()) == false)
+	{
+		return false;
+	}
+	std::error_code error;
+	std::filesystem::create_directories(options.batchDirectory, error);
+	if (error)
+	{
+		std::cout << "Could not create the batch directory:" << options.batchDirectory << std::endl;
+		return false;
+	}
+
+	// the software frames are already on the CPU
+	FrameReadback readback;
+	if ((NULL == g_SoftwareRasterizer) && (readback.Create(options.width, options.height) == false))
+	{
+		return false;
+	}
+	ImageWriter writer;
+	writer.Start(options.threadCount, FrameReadback::SLOT_COUNT * 2);
+
+	size_t frameBytes = (size_t)options.width * options.height * 4;
+	std::vector<unsigned char> pixels;
+	char filename[64];
+	FrameReadback::CONSUME_FUNCTION consume = [&](int view, const unsigned char* pPixels) {
+		writer.AcquirePixels(pixels);
+		pixels.assign(pPixels, pPixels + frameBytes);
+		snprintf(filename, sizeof(filename), "/view_%05d.png", view);
+		writer.Submit(options.batchDirectory + filename, options.width, options.height, pixels);
+	};
+
+	// the GPU times are only read so the timer does not wait
+	FRAME_MEASUREMENTS measurements;
+	measurements.firstFrame = INT_MAX;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int view = 0; view < poses.GetKeyCount(); view++)
+	{
+		PROFILE_SCOPE("Frame");
+		const CameraPath::CAMERA_KEY& pose = poses.GetKey(view);
+		g_ViewManager->SetCameraPose(pose.position, pose.yaw, pose.pitch);
+		PrepareFramePacket(g_FramePacket);
+		DrawFramePacket(g_FramePacket);
+		if (NULL != g_SoftwareRasterizer)
+		{
+			writer.AcquirePixels(pixels);
+			pixels.resize(frameBytes);
+			g_SoftwareRasterizer->ReadColors(pixels.data());
+			consume(view, pixels.data());
+		}
+		else
+		{
+			readback.ReadFrame(view, consume);
+			readback.CollectFrames(false, consume);
+			CollectGpuTimes(measurements, false);
+		}
+		RenderStats::EndFrame(0.0);
+	}
+	readback.CollectFrames(true, consume);
+	writer.Finish();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	ImageWriter::STATISTICS statistics = writer.GetStatistics();
+	double imagesPerSecond = (double)statistics.images / std::max(seconds, 1e-9);
+	std::cout << "Rendered " << statistics.images << " of " << poses.GetKeyCount() << " views into "
+		<< options.batchDirectory << " in " << seconds << " s, " << imagesPerSecond << " images/s" << std::endl;
+
+	output << "{\"views\":" << poses.GetKeyCount()
+		<< ",\"images\":" << statistics.images
+		<< ",\"failed_images\":" << statistics.failedImages
+		<< ",\"seconds\":" << seconds
+		<< ",\"images_per_second\":" << imagesPerSecond
+		<< ",\"readback_stalls\":" << readback.GetStallCount()
+		<< ",\"writer_threads\":" << writer.GetThreadCount()
+		<< ",\"writer_stalls\":" << statistics.stalls
+		<< ",\"write_ms_per_image\":" << statistics.encodeMilliseconds / std::max(statistics.images + statistics.failedImages, 1)
+		<< "}";
+	return(statistics.failedImages == 0);
+}
@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+// distributedmode.cpp
+// ============
+// render one large frame in tiles on copies of this program started as
+// render services, and stitch the tiles into the frame image
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RunModes.h"
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <algorithm>
+#include <chrono>           // worker timing
+#include <filesystem>       // worker program and socket directory
+#include <fstream>          // benchmark result output
+#include <sstream>          // benchmark result output
+#include <string>
+#include <thread>           // worker thread counts
+#include <vector>
+
+#include "Profiler.h"
+#include "PngWriter.h"
+#include "TileCoordinator.h"
+
+// declaration of the global variables and defines
+namespace
+{
+	// time the distributed workers get to load the scene
+	const int g_WorkerStartMilliseconds = 60000;
+}
+
+/***********************************************************
+ *	RunDistributed()
+ *
+ *  This function is used to render one frame, which may be
+ *  far larger than a framebuffer, in tiles on copies of this
+ *  program started as render services.  Each worker loads
+ *  the scene the way this process would and draws its tiles
+ *  with the projection narrowed to them.  The stitched frame
+ *  is written into the frame image, and the timing of the
+ *  workers is printed as JSON.
+ ***********************************************************/
+int RunDistributed(const APP_OPTIONS& options)
+{
+	// share the hardware threads between the workers
+	int tileSize = options.distributedTile;
+	int threadCount = options.threadCount;
+	if (threadCount == 0)
+	{
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency() / options.distributedWorkers);
+	}
+	std::vector<std::string> arguments = {
+		"--headless",
+		"--width", std::to_string(tileSize),
+		"--height", std::to_string(tileSize),
+		"--threads", std::to_string(threadCount) };
+	if (options.scenePath.empty() == false)
+	{
+		arguments.insert(arguments.end(), { "--scene", options.scenePath });
+	}
+	if (options.worldPath.empty() == false)
+	{
+		arguments.insert(arguments.end(), {
+			"--world", options.worldPath,
+			"--tile-radius", std::to_string(options.tileRadius),
+			"--tile-budget", std::to_string(options.tileBudgetMegabytes) });
+	}
+	if (options.bSoftwareRenderer == true)
+	{
+		arguments.insert(arguments.end(), { "--renderer", "software" });
+	}
+
+	// start the workers from the same executable, found through
+	// /proc where it exists since argv[0] may not be a path
+	std::string program = options.programPath;
+	std::error_code error;
+	std::filesystem::path executable = std::filesystem::read_symlink("/proc/self/exe", error);
+	if (!error)
+	{
+		program = executable.string();
+	}
+	std::string directory = std::filesystem::temp_directory_path(error).string();
+	if (error)
+	{
+		directory = ".";
+	}
+
+	TileCoordinator coordinator;
+	std::chrono::steady_clock::time_point startupStart = std::chrono::steady_clock::now();
+	if (coordinator.StartWorkers(program, arguments, options.distributedWorkers, directory, g_WorkerStartMilliseconds) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+	double startupMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - startupStart).count();
+	std::cout << "Rendering " << options.width << "x" << options.height << " in tiles of " << tileSize
+		<< " on " << options.distributedWorkers << " workers" << std::endl;
+
+	TileCoordinator::VIEW view;
+	view.position = options.viewPosition;
+	view.yaw = options.viewYaw;
+	view.pitch = options.viewPitch;
+	std::vector<unsigned char> pixels;
+	std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
+	bool bRendered = coordinator.RenderFrame(view, options.width, options.height, tileSize, pixels);
+	double renderMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - renderStart).count();
+
+	std::ostringstream results;
+	results << "{\"mode\":\"distributed\""
+		<< ",\"rasterizer\":\"" << (options.bSoftwareRenderer ? "software" : "gl") << "\""
+		<< ",\"width\":" << options.width
+		<< ",\"height\":" << options.height
+		<< ",\"tile_size\":" << tileSize
+		<< ",\"tiles\":" << coordinator.GetTileCount()
+		<< ",\"workers\":" << coordinator.GetWorkerCount()
+		<< ",\"worker_threads\":" << threadCount
+		<< ",\"rendered\":" << (bRendered ? "true" : "false")
+		<< ",\"startup_ms\":" << startupMilliseconds
+		<< ",\"render_ms\":" << renderMilliseconds
+		<< ",\"megapixels_per_second\":"
+		<< (double)options.width * options.height / 1000.0 / std::max(renderMilliseconds, 1e-6)
+		<< ",\"retried_tiles\":" << coordinator.GetRetriedTiles()
+		<< ",\"worker_tiles\":[";
+	for (int i = 0; i < coordinator.GetWorkerCount(); i++)
+	{
+		TileCoordinator::WORKER_STATISTICS statistics = coordinator.GetWorkerStatistics(i);
+		results << ((i > 0) ? "," : "") << "{\"tiles\":" << statistics.tiles
+			<< ",\"ms\":" << statistics.milliseconds
+			<< ",\"lost\":" << (statistics.bFailed ? "true" : "false") << "}";
+	}
+	results << "]}";
+	coordinator.StopWorkers();
+
+	std::cout << results.str() << std::endl;
+	if (options.outputPath.empty() == false)
+	{
+		std::ofstream outputFile(options.outputPath);
+		outputFile << results.str() << std::endl;
+	}
+	if (options.tracePath.empty() == false)
+	{
+		Profiler::WriteChromeTrace(options.tracePath.c_str());
+	}
+
+	if ((bRendered == true) &&
+		(PngWriter::WriteRGB(options.frameImagePath.c_str(), options.width, options.height, pixels.data()) == false))
+	{
+		std::cout << "Could not write the frame image:" << options.frameImagePath << std::endl;
+		bRendered = false;
+	}
+	return(bRendered ? EXIT_SUCCESS : EXIT_FAILURE);
+}
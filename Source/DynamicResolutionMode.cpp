@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolutionmode.cpp
+// ============
+// draw the frames at a lower resolution that follows the GPU time, and
+// scale them up to the output on their own or gathered over time
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RunModes.h"
+
+#include <iostream>         // error handling and output
+
+#include "ResolutionScaler.h"
+
+/***********************************************************
+ *	CreateResolutionScaler()
+ *
+ *  This function is used to draw the frames at a resolution
+ *  that follows the GPU time, when a target time was passed
+ *  in, and scale them up to the output of the passed in size
+ *  on their own or gathered over time.
+ ***********************************************************/
+bool CreateResolutionScaler(const APP_OPTIONS& options, int width, int height)
+{
+	if ((options.targetFrameMilliseconds <= 0.0) && (options.bTemporalUpscale == false))
+	{
+		return(true);
+	}
+
+	ResolutionScaler::SETTINGS settings;
+	settings.targetMilliseconds = options.targetFrameMilliseconds;
+	settings.minScale = options.minScale;
+	settings.maxScale = options.maxScale;
+	settings.hysteresis = options.scaleHysteresis;
+	settings.bTemporal = options.bTemporalUpscale;
+	g_ResolutionScaler = new ResolutionScaler();
+	if (g_ResolutionScaler->Create(width, height, settings) == false)
+	{
+		std::cout << "Could not load the upscaling shaders" << std::endl;
+		delete g_ResolutionScaler;
+		g_ResolutionScaler = NULL;
+		return(false);
+	}
+	if (options.targetFrameMilliseconds > 0.0)
+	{
+		std::cout << "Scaling the resolution between " << options.minScale << " and " << options.maxScale
+			<< " for " << options.targetFrameMilliseconds << " ms GPU frames" << std::endl;
+	}
+	else
+	{
+		std::cout << "Drawing at " << options.maxScale << " of the resolution" << std::endl;
+	}
+	if (options.bTemporalUpscale == true)
+	{
+		std::cout << "Upscaling with jittered frames gathered over time" << std::endl;
+	}
+	return(true);
+}
+
+/***********************************************************
+ *	WriteScaleResults()
+ *
+ *  This function is used to write how the resolution scale
+ *  followed the target GPU time as a JSON object.
+ ***********************************************************/
+void WriteScaleResults(std::ostream& output)
+{
+	output << "{\"target_ms\":" << g_ResolutionScaler->GetSettings().targetMilliseconds
+		<< ",\"temporal\":" << (g_ResolutionScaler->IsTemporal() ? "true" : "false")
+		<< ",\"final_scale\":" << g_ResolutionScaler->GetScale()
+		<< ",\"mean_scale\":" << g_ResolutionScaler->GetMeanScale()
+		<< ",\"lowest_scale\":" << g_ResolutionScaler->GetLowestScale()
+		<< ",\"scale_changes\":" << g_ResolutionScaler->GetScaleChanges()
+		<< ",\"render_width\":" << g_ResolutionScaler->GetRenderWidth()
+		<< ",\"render_height\":" << g_ResolutionScaler->GetRenderHeight() << "}";
+}
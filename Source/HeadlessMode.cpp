@@ -0,0 +1,333 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlessmode.cpp
+// ============
+// render a fixed number of frames into an offscreen framebuffer and report
+// the frame times as JSON
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RunModes.h"
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <climits>          // INT_MAX
+#include <algorithm>
+#include <chrono>           // headless frame timing
+#include <fstream>          // benchmark result output
+#include <sstream>          // benchmark result output
+
+#include <GL/glew.h>        // GLEW library
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "OffscreenContext.h"
+#include "RenderTarget.h"
+#include "JobSystem.h"
+#include "RenderThread.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "AllocationCounter.h"
+#include "PngWriter.h"
+#include "SoftwareRasterizer.h"
+
+void DrawHeadlessFrame(
+	const FRAME_PACKET& packet,
+	FrameStatistics& frameTimes,
+	FRAME_MEASUREMENTS& measurements,
+	FRAME_CLOCK& clock);
+
+/***********************************************************
+ *	RunHeadless()
+ *
+ *  This function is used to render the 3D scene into an
+ *  offscreen framebuffer for a fixed number of frames, then
+ *  print the frame time statistics as JSON and exit.
+ ***********************************************************/
+int RunHeadless(const APP_OPTIONS& options)
+{
+	OffscreenContext context;
+	RenderTarget renderTarget;
+	FrameStatistics frameTimes;
+
+	if (StartHeadless(options, context) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	if (renderTarget.Create(options.width, options.height) == false)
+	{
+		DestroyManagers();
+		return(EXIT_FAILURE);
+	}
+	renderTarget.Bind();
+	if (CreateResolutionScaler(options, options.width, options.height) == false)
+	{
+		renderTarget.Destroy();
+		DestroyManagers();
+		return(EXIT_FAILURE);
+	}
+
+	// untimed frames from the starting view - their GPU times
+	// are read too, which finds the render passes and sizes the
+	// lists the timed frames are measured into
+	FRAME_MEASUREMENTS measurements;
+	measurements.firstFrame = INT_MAX;
+	for (int frame = 0; frame < options.warmupFrames; frame++)
+	{
+		RenderFrame();
+		glFinish();
+		CollectGpuTimes(measurements, false);
+		RenderStats::EndFrame(0.0);
+	}
+
+	// a batch renders its views in place of the timed frames
+	if (options.batchPath.empty() == false)
+	{
+		return(RunBatch(options, context, renderTarget));
+	}
+
+	// a replayed path decides how many frames are timed
+	int frames = options.frames;
+	bool bReplay = (options.replayPath.empty() == false);
+	measurements.firstFrame = g_FrameNumber;
+	if (bReplay == true)
+	{
+		if (g_ViewManager->StartReplay(options.replayPath.c_str(), 1.0f / options.replayFps) == false)
+		{
+			renderTarget.Destroy();
+			DestroyManagers();
+			return(EXIT_FAILURE);
+		}
+		frames = g_ViewManager->GetReplayFrameCount();
+	}
+	// keep the statistics of every timed frame, with every
+	// list sized up front so measuring does not allocate
+	RenderStats::SetHistorySize(std::max(frames, 300));
+	measurements.expectedFrames = frames;
+	measurements.replayFrames.reserve(bReplay ? frames : 0);
+	measurements.gpuFrameTimes.Reserve(frames);
+	measurements.gpuPassTimes.reserve(GpuTimer::MAX_PASSES);
+	for (size_t pass = 0; pass < measurements.gpuPassTimes.size(); pass++)
+	{
+		measurements.gpuPassTimes[pass].times.Reserve(frames);
+	}
+	frameTimes.Reserve(frames);
+
+	// heap allocations made by every thread during the timed
+	// frames, which should be none once the scene is warm
+	long long timedAllocations = 0;
+	int countedFrames = frames;
+
+	FRAME_CLOCK clock;
+	clock.lastFrameEnd = std::chrono::steady_clock::now();
+	if (options.bRenderThread == true)
+	{
+		// the render thread draws each frame while the main
+		// thread prepares the next one
+		RenderThread renderThread;
+		context.ReleaseCurrent();
+		renderThread.Start(
+			[&context]() { context.MakeCurrent(); },
+			[&frameTimes, &measurements, &clock](FRAME_PACKET& packet) {
+				DrawHeadlessFrame(packet, frameTimes, measurements, clock);
+			},
+			[&context]() { context.ReleaseCurrent(); });
+
+		long long allocationsBefore = AllocationCounter::GetAllocationCount();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			// each packet sizes its lists the first time it is
+			// filled, so the counting starts once all were used
+			if (frame == RenderThread::PACKET_COUNT)
+			{
+				allocationsBefore = AllocationCounter::GetAllocationCount();
+				countedFrames = frames - frame;
+			}
+
+			PROFILE_SCOPE("Frame");
+			FRAME_PACKET* packet = renderThread.AcquirePacket();
+			PrepareFramePacket(*packet);
+			renderThread.SubmitPacket(packet);
+		}
+
+		renderThread.Stop();
+		timedAllocations = AllocationCounter::GetAllocationCount() - allocationsBefore;
+		context.MakeCurrent();
+	}
+	else
+	{
+		long long allocationsBefore = AllocationCounter::GetAllocationCount();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			PROFILE_SCOPE("Frame");
+			PrepareFramePacket(g_FramePacket);
+			DrawHeadlessFrame(g_FramePacket, frameTimes, measurements, clock);
+		}
+		timedAllocations = AllocationCounter::GetAllocationCount() - allocationsBefore;
+	}
+
+	// write the last frame, and draw the view with OpenGL too
+	// for comparing the software frames
+	if (options.frameImagePath.empty() == false)
+	{
+		std::vector<unsigned char> pixels;
+		ReadFrameImage(options.width, options.height, pixels);
+		if (PngWriter::WriteRGB(options.frameImagePath.c_str(), options.width, options.height, pixels.data()) == false)
+		{
+			renderTarget.Destroy();
+			DestroyManagers();
+			return(EXIT_FAILURE);
+		}
+	}
+	std::ostringstream compare;
+	bool bCompared = (options.bCompareGL == true) && (CompareWithGL(options.width, options.height, compare) == true);
+	renderTarget.Unbind();
+
+	// pick from the view of the last frame
+	std::ostringstream pick;
+	if (options.bPick == true)
+	{
+		glm::vec3 pickOrigin;
+		glm::vec3 pickDirection;
+		g_ViewManager->GetPickRay(options.pickX, options.pickY, pickOrigin, pickDirection);
+		PickSceneObject(pickOrigin, pickDirection, pick);
+	}
+
+	// trace the same view on the CPU for comparing the lighting
+	std::ostringstream raytrace;
+	if ((options.raytracePath.empty() == false) &&
+		(TraceSceneImage(options.raytracePath, options.width, options.height, raytrace) == false))
+	{
+		renderTarget.Destroy();
+		DestroyManagers();
+		return(EXIT_FAILURE);
+	}
+
+	CollectGpuTimes(measurements, true);
+	if (bReplay == true)
+	{
+		WriteReplayCSV(options.csvPath, measurements);
+	}
+
+	// one line of JSON so the results are easy to collect
+	const TileStreamer* pStreamer = g_SceneManager->GetTileStreamer();
+	std::ostringstream results;
+	results << "{\"mode\":\"headless\""
+		<< ",\"renderer\":\"" << glGetString(GL_RENDERER) << "\""
+		<< ",\"rasterizer\":\"" << ((NULL != g_SoftwareRasterizer) ? "software" : "gl") << "\""
+		<< ",\"width\":" << options.width
+		<< ",\"height\":" << options.height
+		<< ",\"warmup_frames\":" << options.warmupFrames
+		<< ",\"frames\":" << frames
+		<< ",\"threads\":" << g_JobSystem->GetThreadCount()
+		<< ",\"render_thread\":" << (options.bRenderThread ? "true" : "false")
+		<< ",\"streaming_buffer\":\"" << (g_SceneManager->GetStreamingBuffer()->IsPersistent() ? "persistent" : "mapped") << "\""
+		<< ",\"streaming_stalls\":" << g_SceneManager->GetStreamingBuffer()->GetStallCount()
+		<< ",\"heap_allocations_per_frame\":" << (double)timedAllocations / std::max(countedFrames, 1)
+		<< ",\"frame_arena_peak_bytes\":" << g_JobSystem->GetFrameArena()->GetPeakBytes()
+		<< ",\"resident_tiles\":" << (NULL != pStreamer ? pStreamer->GetResidentCount() : 0)
+		<< ",\"resident_tile_bytes\":" << (NULL != pStreamer ? pStreamer->GetResidentBytes() : 0)
+		<< ",\"draw_calls\":" << RenderStats::GetLastFrame().drawCalls
+		<< ",\"triangles\":" << RenderStats::GetLastFrame().triangles;
+	if (options.bPick == true)
+	{
+		results << ",\"pick\":" << pick.str();
+	}
+	if (options.raytracePath.empty() == false)
+	{
+		results << ",\"raytrace\":" << raytrace.str();
+	}
+	if (NULL != g_SoftwareRasterizer)
+	{
+		results << ",\"software\":";
+		WriteSoftwareResults(measurements, results);
+	}
+	if (bCompared == true)
+	{
+		results << ",\"compare_gl\":" << compare.str();
+	}
+	if (NULL != g_ResolutionScaler)
+	{
+		results << ",\"dynamic_resolution\":";
+		WriteScaleResults(results);
+	}
+	results << ",\"frame_ms\":";
+	frameTimes.WriteJSON(results);
+	results << ",\"gpu_frame_ms\":";
+	measurements.gpuFrameTimes.WriteJSON(results);
+	results << ",\"gpu_pass_ms\":{";
+	for (size_t pass = 0; pass < measurements.gpuPassTimes.size(); pass++)
+	{
+		results << ((pass > 0) ? "," : "") << "\"" << measurements.gpuPassTimes[pass].name << "\":";
+		measurements.gpuPassTimes[pass].times.WriteJSON(results);
+	}
+	results << "}}";
+
+	std::cout << results.str() << std::endl;
+	if (options.outputPath.empty() == false)
+	{
+		std::ofstream outputFile(options.outputPath);
+		outputFile << results.str() << std::endl;
+	}
+
+	if (options.tracePath.empty() == false)
+	{
+		Profiler::WriteChromeTrace(options.tracePath.c_str());
+	}
+	if (options.statsPath.empty() == false)
+	{
+		RenderStats::Export(options.statsPath.c_str());
+	}
+
+	renderTarget.Destroy();
+	DestroyManagers();
+	context.Destroy();
+
+	return(EXIT_SUCCESS);
+}
+
+/***********************************************************
+ *	DrawHeadlessFrame()
+ *
+ *  This function is used to draw a prepared frame into the
+ *  offscreen framebuffer and wait for it to finish, so the
+ *  frame time covers the GPU work.  The frame time is taken
+ *  from the end of the last frame, which also counts the
+ *  preparing when it is not done on another thread.
+ ***********************************************************/
+void DrawHeadlessFrame(
+	const FRAME_PACKET& packet,
+	FrameStatistics& frameTimes,
+	FRAME_MEASUREMENTS& measurements,
+	FRAME_CLOCK& clock)
+{
+	std::chrono::steady_clock::time_point drawStart = std::chrono::steady_clock::now();
+	DrawFramePacket(packet);
+	if (packet.bReplayFrame == true)
+	{
+		double drawMilliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - drawStart).count();
+		RecordReplayFrame(packet, packet.prepareMilliseconds + drawMilliseconds, measurements);
+	}
+
+	// wait for the frame to finish so the time covers the GPU work
+	if (NULL == g_SoftwareRasterizer)
+	{
+		PROFILE_SCOPE("glFinish");
+		glFinish();
+	}
+	else if (packet.frame >= measurements.firstFrame)
+	{
+		const SoftwareRasterizer::STATISTICS& statistics = g_SoftwareRasterizer->GetStatistics();
+		measurements.softwareTriangles += statistics.triangles;
+		measurements.softwareMilliseconds += statistics.binMilliseconds + statistics.rasterMilliseconds;
+	}
+
+	std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+	double frameMilliseconds = std::chrono::duration<double, std::milli>(frameEnd - clock.lastFrameEnd).count();
+	clock.lastFrameEnd = frameEnd;
+	frameTimes.AddSample(frameMilliseconds);
+	RenderStats::EndFrame(frameMilliseconds);
+
+	CollectGpuTimes(measurements, false);
+}
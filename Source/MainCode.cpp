@@ -1,7 +1,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 // maincode.cpp
 // ============
-// gets called when application is launched - initializes GLEW, GLFW
+// gets called when application is launched - reads the command line and
+// starts the run mode it asks for
 //
 //  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
 //	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
@@ -9,42 +10,17 @@
 
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // command line parsing
+#include <string>
 
-#include <GL/glew.h>        // GLEW library
-#include <GLFW/glfw3.h>     // GLFW library
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-#include "SceneManager.h"
-#include "ViewManager.h"
-#include "ShapeMeshes.h"
-#include "ShaderManager.h"
-
-// Namespace for declaring global variables
-namespace
-{
-	// Macro for window title
-	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
-
-	// Main GLFW window
-	GLFWwindow* g_Window = nullptr;
-
-	// scene manager object for managing the 3D scene prepare and render
-	SceneManager* g_SceneManager = nullptr;
-	// shader manager object for dynamic interaction with the shader code
-	ShaderManager* g_ShaderManager = nullptr;
-	// view manager object for managing the 3D view setup and projection to 2D
-	ViewManager* g_ViewManager = nullptr;
-}
+#include "RunModes.h"
+#include "Profiler.h"
+#include "SceneFile.h"
+#include "RenderServer.h"
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
-bool InitializeGLFW();
-bool InitializeGLEW();
+bool ParseCommandLine(int argc, char* argv[], APP_OPTIONS& options);
 
 
 /***********************************************************
@@ -55,133 +31,314 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
-	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
+	APP_OPTIONS options;
+
+	// read the command line options
+	if (ParseCommandLine(argc, argv, options) == false)
 	{
 		return(EXIT_FAILURE);
 	}
+	Profiler::SetThreadName("main");
 
-	// try to create a new shader manager object
-	g_ShaderManager = new ShaderManager();
-	// try to create a new view manager object
-	g_ViewManager = new ViewManager(
-		g_ShaderManager);
-
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
-
-	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
+	// convert the scene file into the binary form and stop
+	if (options.convertScenePath.empty() == false)
 	{
-		return(EXIT_FAILURE);
+		bool bConverted = ConvertSceneFile(options.scenePath.c_str(), options.convertScenePath.c_str());
+		return(bConverted ? EXIT_SUCCESS : EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"shaders/vertexShader.glsl",
-		"shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
-
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
-	g_SceneManager->PrepareScene();
-
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
+	// split the scene file into the tiles of a world and stop
+	if (options.splitScenePath.empty() == false)
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
-
-		// Clear the frame and z buffers
-		glClearColor(1.0f, 0.843f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
-
-
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
-
-		// query the latest GLFW events
-		glfwPollEvents();
+		bool bSplit = SplitSceneFile(options.scenePath.c_str(), options.splitScenePath.c_str(), options.tileSize);
+		return(bSplit ? EXIT_SUCCESS : EXIT_FAILURE);
 	}
 
-	// clear the allocated manager objects from memory
-	if (NULL != g_SceneManager)
+	// split one large frame into tiles for worker processes
+	if (options.distributedWorkers > 0)
 	{
-		delete g_SceneManager;
-		g_SceneManager = NULL;
+		return(RunDistributed(options));
 	}
-	if (NULL != g_ViewManager)
+
+	// keep the scene loaded and render the views that are asked
+	// for over the socket until told to stop
+	if (options.servicePath.empty() == false)
 	{
-		delete g_ViewManager;
-		g_ViewManager = NULL;
+		return(RunService(options));
 	}
-	if (NULL != g_ShaderManager)
+
+	// render a fixed number of frames offscreen and report the timing
+	if (options.bHeadless == true)
 	{
-		delete g_ShaderManager;
-		g_ShaderManager = NULL;
+		return(RunHeadless(options));
 	}
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// draw the frames into the display window until it is closed
+	return(RunWindow(options));
 }
 
 /***********************************************************
- *	InitializeGLFW()
- * 
- *  This function is used to initialize the GLFW library.   
- ***********************************************************/
-bool InitializeGLFW()
-{
-	// GLFW: initialize and configure library
-	// --------------------------------------
-	glfwInit();
-
-#ifdef __APPLE__
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#endif
-	// GLFW: end -------------------------------
-
-	return(true);
-}
-
-/***********************************************************
- *	InitializeGLEW()
+ *	ParseCommandLine()
  *
- *  This function is used to initialize the GLEW library.
+ *  This function is used to read the command line options.
+ *  It returns false when the options are not valid.
  ***********************************************************/
-bool InitializeGLEW()
+bool ParseCommandLine(int argc, char* argv[], APP_OPTIONS& options)
 {
-	// GLEW: initialize
-	// -----------------------------------------
-	GLenum GLEWInitResult = GLEW_OK;
-
-	// try to initialize the GLEW library
-	GLEWInitResult = glewInit();
-	if (GLEW_OK != GLEWInitResult)
+	options.programPath = argv[0];
+	for (int i = 1; i < argc; i++)
 	{
-		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
-		return false;
+		// options that are followed by a value
+		bool bHasValue = (i + 1 < argc);
+
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			options.bHeadless = true;
+		}
+		else if ((strcmp(argv[i], "--frames") == 0) && bHasValue)
+		{
+			options.frames = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--warmup") == 0) && bHasValue)
+		{
+			options.warmupFrames = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--width") == 0) && bHasValue)
+		{
+			options.width = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--height") == 0) && bHasValue)
+		{
+			options.height = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--output") == 0) && bHasValue)
+		{
+			options.outputPath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--record") == 0) && bHasValue)
+		{
+			options.recordPath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--replay") == 0) && bHasValue)
+		{
+			options.replayPath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--csv") == 0) && bHasValue)
+		{
+			options.csvPath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--replay-fps") == 0) && bHasValue)
+		{
+			options.replayFps = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--trace") == 0) && bHasValue)
+		{
+			options.tracePath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--stats") == 0) && bHasValue)
+		{
+			options.statsPath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--threads") == 0) && bHasValue)
+		{
+			options.threadCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--render-thread") == 0)
+		{
+			options.bRenderThread = true;
+		}
+		else if ((strcmp(argv[i], "--scene") == 0) && bHasValue)
+		{
+			options.scenePath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--convert-scene") == 0) && bHasValue)
+		{
+			options.convertScenePath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--world") == 0) && bHasValue)
+		{
+			options.worldPath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--tile-radius") == 0) && bHasValue)
+		{
+			options.tileRadius = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--tile-budget") == 0) && bHasValue)
+		{
+			options.tileBudgetMegabytes = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--split-scene") == 0) && bHasValue)
+		{
+			options.splitScenePath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--tile-size") == 0) && bHasValue)
+		{
+			options.tileSize = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--pick") == 0) && (i + 2 < argc))
+		{
+			options.bPick = true;
+			options.pickX = (float)atof(argv[++i]);
+			options.pickY = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--raytrace") == 0) && bHasValue)
+		{
+			options.raytracePath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--renderer") == 0) && bHasValue &&
+			((strcmp(argv[i + 1], "gl") == 0) || (strcmp(argv[i + 1], "software") == 0)))
+		{
+			options.bSoftwareRenderer = (strcmp(argv[++i], "software") == 0);
+		}
+		else if ((strcmp(argv[i], "--frame-image") == 0) && bHasValue)
+		{
+			options.frameImagePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--compare-gl") == 0)
+		{
+			options.bCompareGL = true;
+		}
+		else if ((strcmp(argv[i], "--batch") == 0) && bHasValue)
+		{
+			options.batchPath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--batch-output") == 0) && bHasValue)
+		{
+			options.batchDirectory = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--service") == 0) && bHasValue)
+		{
+			options.servicePath = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--service-batch") == 0) && bHasValue)
+		{
+			options.serviceBatch = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--distributed") == 0) && bHasValue)
+		{
+			options.distributedWorkers = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--distributed-tile") == 0) && bHasValue)
+		{
+			options.distributedTile = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--target-frame-ms") == 0) && bHasValue)
+		{
+			options.targetFrameMilliseconds = atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--min-scale") == 0) && bHasValue)
+		{
+			options.minScale = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--max-scale") == 0) && bHasValue)
+		{
+			options.maxScale = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--scale-hysteresis") == 0) && bHasValue)
+		{
+			options.scaleHysteresis = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--temporal-upscale") == 0)
+		{
+			options.bTemporalUpscale = true;
+		}
+		else if ((strcmp(argv[i], "--view") == 0) && (i + 5 < argc))
+		{
+			options.viewPosition.x = (float)atof(argv[++i]);
+			options.viewPosition.y = (float)atof(argv[++i]);
+			options.viewPosition.z = (float)atof(argv[++i]);
+			options.viewYaw = (float)atof(argv[++i]);
+			options.viewPitch = (float)atof(argv[++i]);
+		}
+		else
+		{
+			std::cerr << "Unknown option: " << argv[i] << "\n"
+				<< "usage: " << argv[0] << " [--headless] [--frames N] [--warmup N]"
+				<< " [--width W] [--height H] [--output results.json]"
+				<< " [--record path.txt] [--replay path.txt] [--csv frames.csv] [--replay-fps N]"
+				<< " [--trace trace.json] [--stats stats.csv|stats.json] [--threads N] [--render-thread]"
+				<< " [--scene park.scene] [--convert-scene park.sceneb]"
+				<< " [--world world.txt] [--tile-radius R] [--tile-budget MB]"
+				<< " [--split-scene directory] [--tile-size S] [--pick X Y]"
+				<< " [--raytrace image.png] [--renderer gl|software] [--frame-image frame.png] [--compare-gl]"
+				<< " [--batch poses.txt] [--batch-output directory]"
+				<< " [--service socket] [--service-batch N]"
+				<< " [--distributed N] [--distributed-tile S] [--view X Y Z YAW PITCH]"
+				<< " [--target-frame-ms MS] [--min-scale S] [--max-scale S] [--scale-hysteresis H]"
+				<< " [--temporal-upscale]" << std::endl;
+			return(false);
+		}
 	}
-	// GLEW: end -------------------------------
 
-	// Displays a successful OpenGL initialization message
-	std::cout << "INFO: OpenGL Successfully Initialized\n";
-	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
+	if ((options.frames <= 0) || (options.warmupFrames < 0) ||
+		(options.width <= 0) || (options.height <= 0) || (options.threadCount < 0))
+	{
+		std::cerr << "Frame counts and sizes must be positive" << std::endl;
+		return(false);
+	}
+	if (options.replayFps <= 0.0f)
+	{
+		std::cerr << "The replay frame rate must be positive" << std::endl;
+		return(false);
+	}
+	if ((options.bHeadless == true) && (options.recordPath.empty() == false))
+	{
+		std::cerr << "Camera paths can only be recorded with a window" << std::endl;
+		return(false);
+	}
+	if (options.serviceBatch <= 0)
+	{
+		std::cerr << "The service batch size must be positive" << std::endl;
+		return(false);
+	}
+	if ((options.distributedWorkers < 0) ||
+		(options.distributedTile <= 0) || (options.distributedTile > RenderServer::MAX_SIZE))
+	{
+		std::cerr << "The worker count must be positive and the tiles from 1 to "
+			<< RenderServer::MAX_SIZE << " pixels" << std::endl;
+		return(false);
+	}
+	if ((options.distributedWorkers > 0) && ((options.frameImagePath.empty() == true) ||
+		(options.width > RenderServer::MAX_FRAME_SIZE) || (options.height > RenderServer::MAX_FRAME_SIZE)))
+	{
+		std::cerr << "A distributed frame needs --frame-image and a size up to "
+			<< RenderServer::MAX_FRAME_SIZE << std::endl;
+		return(false);
+	}
+	if ((options.targetFrameMilliseconds < 0.0) || (options.minScale <= 0.0f) ||
+		(options.minScale > options.maxScale) || (options.maxScale > 1.0f) ||
+		(options.scaleHysteresis < 0.0f) || (options.scaleHysteresis >= 1.0f))
+	{
+		std::cerr << "The resolution scales must be from 0 to 1 with the lowest first,"
+			<< " and the hysteresis below 1" << std::endl;
+		return(false);
+	}
+	if (((options.targetFrameMilliseconds > 0.0) || (options.bTemporalUpscale == true)) &&
+		(options.bSoftwareRenderer == true))
+	{
+		std::cerr << "The resolution is only scaled with the OpenGL renderer" << std::endl;
+		return(false);
+	}
+	if ((options.bHeadless == false) && (options.batchPath.empty() == false))
+	{
+		std::cerr << "Batches of views can only be rendered with --headless" << std::endl;
+		return(false);
+	}
+	if ((options.convertScenePath.empty() == false) && (options.scenePath.empty() == true))
+	{
+		std::cerr << "The scene file to convert must be passed with --scene" << std::endl;
+		return(false);
+	}
+	if ((options.splitScenePath.empty() == false) && (options.scenePath.empty() == true))
+	{
+		std::cerr << "The scene file to split must be passed with --scene" << std::endl;
+		return(false);
+	}
+	if ((options.tileRadius <= 0.0f) || (options.tileBudgetMegabytes <= 0) || (options.tileSize <= 0.0f))
+	{
+		std::cerr << "The tile radius, budget and size must be positive" << std::endl;
+		return(false);
+	}
 
 	return(true);
-}
\ No newline at end of file
+}
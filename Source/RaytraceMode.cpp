@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// raytracemode.cpp
+// ============
+// ray trace the current view of the scene on the CPU into a PNG file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RunModes.h"
+
+#include <iostream>         // error handling and output
+#include <algorithm>
+#include <vector>
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "JobSystem.h"
+#include "RayTracer.h"
+#include "PngWriter.h"
+
+/***********************************************************
+ *	TraceSceneImage()
+ *
+ *  This function is used to ray trace the current view of
+ *  the scene on the CPU into a PNG file, and to write how
+ *  long it took and how many rays were traced per second as
+ *  one JSON object.
+ ***********************************************************/
+bool TraceSceneImage(const std::string& filename, int width, int height, std::ostream& output)
+{
+	RayTracer::CAMERA camera;
+	camera.view = g_ViewManager->GetViewMatrix();
+	camera.projection = g_ViewManager->GetProjectionMatrix();
+	camera.viewPosition = g_ViewManager->GetViewPosition();
+
+	std::vector<unsigned char> pixels((size_t)width * height * 3);
+	RayTracer::STATISTICS statistics;
+	bool bTraced = g_SceneManager->TraceReferenceImage(camera, g_ClearColor, width, height, pixels.data(), statistics);
+	// the tree and the tiles were built by jobs
+	g_JobSystem->Reset();
+	if ((bTraced == false) || (PngWriter::WriteRGB(filename.c_str(), width, height, pixels.data()) == false))
+	{
+		return false;
+	}
+
+	double raysPerSecond = (double)statistics.rays / std::max(statistics.traceMilliseconds / 1000.0, 1e-9);
+	std::cout << "Ray traced " << filename << ": " << statistics.triangles << " triangles, "
+		<< statistics.rays << " rays in " << statistics.traceMilliseconds << " ms on "
+		<< statistics.threads << " threads, " << raysPerSecond / 1.0e6 << " Mrays/s" << std::endl;
+
+	output << "{\"file\":\"" << filename << "\""
+		<< ",\"instructions\":\"" << RayTracer::GetInstructionSet() << "\""
+		<< ",\"threads\":" << statistics.threads
+		<< ",\"triangles\":" << statistics.triangles
+		<< ",\"nodes\":" << statistics.nodes
+		<< ",\"build_ms\":" << statistics.buildMilliseconds
+		<< ",\"tiles\":" << statistics.tiles
+		<< ",\"rays\":" << statistics.rays
+		<< ",\"trace_ms\":" << statistics.traceMilliseconds
+		<< ",\"rays_per_second\":" << raysPerSecond << "}";
+	return true;
+}
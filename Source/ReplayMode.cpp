@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// replaymode.cpp
+// ============
+// keep the CPU and GPU times of the frames of a replayed camera path and
+// write them as CSV
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RunModes.h"
+
+#include <iostream>         // error handling and output
+#include <fstream>          // replay result output
+
+#include "RenderStats.h"
+
+/***********************************************************
+ *	RecordReplayFrame()
+ *
+ *  This function is used to keep the CPU time spent
+ *  preparing and issuing a frame of a replayed camera path,
+ *  with its draw call and triangle counts.
+ ***********************************************************/
+void RecordReplayFrame(const FRAME_PACKET& packet, double cpuMilliseconds, FRAME_MEASUREMENTS& measurements)
+{
+	REPLAY_FRAME replayFrame;
+	replayFrame.frame = packet.frame;
+	replayFrame.cpuMilliseconds = cpuMilliseconds;
+	// filled in once the GPU timer result is available
+	replayFrame.gpuMilliseconds = 0.0;
+	replayFrame.gpuPassCount = 0;
+	replayFrame.drawCalls = RenderStats::GetCurrentFrame().drawCalls;
+	replayFrame.triangles = (int)RenderStats::GetCurrentFrame().triangles;
+	replayFrame.culledObjects = RenderStats::GetCurrentFrame().culledObjects;
+	measurements.replayFrames.push_back(replayFrame);
+}
+
+/***********************************************************
+ *	WriteReplayCSV()
+ *
+ *  This function is used to write one CSV row per replayed
+ *  frame, with a GPU time column for every render pass.
+ ***********************************************************/
+bool WriteReplayCSV(const std::string& filename, FRAME_MEASUREMENTS& measurements)
+{
+	std::ofstream csvFile(filename);
+	if (!csvFile)
+	{
+		std::cerr << "Could not write the replay results to " << filename << std::endl;
+		return(false);
+	}
+
+	csvFile << "frame,cpu_ms,gpu_ms,draw_calls,triangles,culled_objects";
+	for (size_t pass = 0; pass < measurements.gpuPassTimes.size(); pass++)
+	{
+		csvFile << ",gpu_" << measurements.gpuPassTimes[pass].name << "_ms";
+	}
+	csvFile << "\n";
+
+	for (size_t i = 0; i < measurements.replayFrames.size(); i++)
+	{
+		const REPLAY_FRAME& replayFrame = measurements.replayFrames[i];
+		csvFile << i << ","
+			<< replayFrame.cpuMilliseconds << ","
+			<< replayFrame.gpuMilliseconds << ","
+			<< replayFrame.drawCalls << ","
+			<< replayFrame.triangles << ","
+			<< replayFrame.culledObjects;
+
+		// a pass that was not rendered in this frame took no time
+		for (size_t pass = 0; pass < measurements.gpuPassTimes.size(); pass++)
+		{
+			double milliseconds = 0.0;
+			for (int p = 0; p < replayFrame.gpuPassCount; p++)
+			{
+				if (measurements.gpuPassTimes[pass].name == replayFrame.gpuPasses[p].name)
+				{
+					milliseconds += replayFrame.gpuPasses[p].milliseconds;
+				}
+			}
+			csvFile << "," << milliseconds;
+		}
+		csvFile << "\n";
+	}
+
+	std::cout << "Wrote " << measurements.replayFrames.size() << " replayed frames to " << filename << std::endl;
+
+	return(true);
+}
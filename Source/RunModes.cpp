@@ -0,0 +1,442 @@
+///////////////////////////////////////////////////////////////////////////////
+// runmodes.cpp
+// ============
+// the managers shared by the run modes, preparing and drawing the frames of
+// the 3D scene and creating and destroying everything that draws them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RunModes.h"
+
+#include <iostream>         // error handling and output
+#include <algorithm>
+#include <chrono>           // frame timing
+
+#include <GL/glew.h>        // GLEW library
+#include <GLFW/glfw3.h>     // GLFW library
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "ShapeMeshes.h"
+#include "ShaderManager.h"
+#include "OffscreenContext.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "ResolutionScaler.h"
+#include "SoftwareRasterizer.h"
+
+// declaration of the global variables shared by the run modes
+const glm::vec3 g_ClearColor(1.0f, 0.843f, 0.0f);
+SceneManager* g_SceneManager = nullptr;
+ShaderManager* g_ShaderManager = nullptr;
+ViewManager* g_ViewManager = nullptr;
+GpuTimer* g_GpuTimer = nullptr;
+ResolutionScaler* g_ResolutionScaler = nullptr;
+JobSystem* g_JobSystem = nullptr;
+SoftwareRasterizer* g_SoftwareRasterizer = nullptr;
+JobSystem* g_RasterJobSystem = nullptr;
+int g_FrameNumber = 0;
+FRAME_PACKET g_FramePacket;
+
+/***********************************************************
+ *	PrepareFramePacket()
+ *
+ *  This function is used to fill the passed in packet with
+ *  the next frame - the view from the input or the replayed
+ *  path and the visible scene objects.  It makes no OpenGL
+ *  calls, so it runs while the last frame is drawn.
+ ***********************************************************/
+void PrepareFramePacket(FRAME_PACKET& packet)
+{
+	PROFILE_FUNCTION();
+
+	std::chrono::steady_clock::time_point prepareStart = std::chrono::steady_clock::now();
+	packet.frame = g_FrameNumber;
+	g_FrameNumber++;
+
+	// convert from 3D object space to 2D view, moved by the
+	// frame's jitter when the frames are gathered over time
+	if (NULL != g_ResolutionScaler)
+	{
+		packet.jitter = g_ResolutionScaler->GetJitter(packet.frame);
+		g_ViewManager->SetProjectionJitter(packet.jitter);
+	}
+	g_ViewManager->PrepareSceneView();
+	packet.view = g_ViewManager->GetViewMatrix();
+	packet.projection = g_ViewManager->GetProjectionMatrix();
+	packet.viewPosition = g_ViewManager->GetViewPosition();
+	packet.bReplayFrame = g_ViewManager->IsReplaying();
+	packet.bExportStats = g_ViewManager->TakeStatsExportRequest();
+
+	// cull the 3D scene for the new view
+	g_SceneManager->PrepareFrame(packet);
+
+	// all of the frame's jobs have finished once it is prepared
+	g_JobSystem->Reset();
+
+	packet.prepareMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - prepareStart).count();
+}
+
+/***********************************************************
+ *	DrawFramePacket()
+ *
+ *  This function is used to clear the bound framebuffer and
+ *  draw a prepared frame of the 3D scene into it, on the
+ *  thread that owns the OpenGL context.
+ ***********************************************************/
+void DrawFramePacket(const FRAME_PACKET& packet)
+{
+	PROFILE_FUNCTION();
+
+	RenderStats::BeginFrame();
+	if (NULL != g_SoftwareRasterizer)
+	{
+		// the frame is drawn into the rasterizer's buffers, and
+		// all of its jobs are done once it is finished
+		g_SoftwareRasterizer->Clear(g_ClearColor);
+		g_SceneManager->RasterizeFrame(packet);
+		g_SoftwareRasterizer->Finish(g_RasterJobSystem);
+		g_RasterJobSystem->Reset();
+		return;
+	}
+	g_GpuTimer->BeginFrame(packet.frame);
+	if (NULL != g_ResolutionScaler)
+	{
+		g_ResolutionScaler->BeginFrame(packet);
+	}
+
+	// Enable z-depth
+	glEnable(GL_DEPTH_TEST);
+
+	// Clear the frame and z buffers
+	glClearColor(g_ClearColor.r, g_ClearColor.g, g_ClearColor.b, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// refresh the 3D scene with the prepared view
+	g_SceneManager->DrawFrame(packet);
+
+	// scale the frame up to the output when it was drawn smaller
+	if (NULL != g_ResolutionScaler)
+	{
+		g_GpuTimer->BeginPass("Upscale");
+		g_ResolutionScaler->Present();
+		g_GpuTimer->EndPass();
+	}
+
+	g_GpuTimer->EndFrame();
+}
+
+/***********************************************************
+ *	RenderFrame()
+ *
+ *  This function is used to prepare and draw one frame of
+ *  the 3D scene on the calling thread.
+ ***********************************************************/
+void RenderFrame()
+{
+	PROFILE_FUNCTION();
+
+	PrepareFramePacket(g_FramePacket);
+	DrawFramePacket(g_FramePacket);
+}
+
+/***********************************************************
+ *	CollectGpuTimes()
+ *
+ *  This function is used to read the GPU frame and pass
+ *  times that are available and add the ones of measured
+ *  frames to the statistics and to the replayed frames.
+ *  When waiting, every frame still in flight is read.
+ ***********************************************************/
+void CollectGpuTimes(FRAME_MEASUREMENTS& measurements, bool bWait)
+{
+	std::vector<GpuTimer::GPU_TIME>& gpuTimes = measurements.gpuTimes;
+	gpuTimes.clear();
+	g_GpuTimer->CollectResults(gpuTimes, bWait);
+
+	for (size_t i = 0; i < gpuTimes.size(); i++)
+	{
+		const GpuTimer::GPU_TIME& gpuTime = gpuTimes[i];
+		if (NULL != g_ResolutionScaler)
+		{
+			g_ResolutionScaler->AddGpuTime(gpuTime.frame, gpuTime.milliseconds);
+		}
+		bool bMeasured = (gpuTime.frame >= measurements.firstFrame);
+		if (bMeasured == true)
+		{
+			measurements.gpuFrameTimes.AddSample(gpuTime.milliseconds);
+		}
+
+		// the passes of unmeasured frames are only registered
+		for (int p = 0; p < gpuTime.passCount; p++)
+		{
+			size_t pass = 0;
+			while ((pass < measurements.gpuPassTimes.size()) &&
+				(measurements.gpuPassTimes[pass].name != gpuTime.passes[p].name))
+			{
+				pass++;
+			}
+			if (pass == measurements.gpuPassTimes.size())
+			{
+				measurements.gpuPassTimes.push_back(GPU_PASS_STATISTICS());
+				measurements.gpuPassTimes.back().name = gpuTime.passes[p].name;
+				measurements.gpuPassTimes.back().times.Reserve(measurements.expectedFrames);
+			}
+			if (bMeasured == true)
+			{
+				measurements.gpuPassTimes[pass].times.AddSample(gpuTime.passes[p].milliseconds);
+			}
+		}
+		if (bMeasured == false)
+		{
+			continue;
+		}
+
+		// replayed frames are numbered from the first one
+		size_t replayIndex = (size_t)(gpuTime.frame - measurements.firstFrame);
+		if (replayIndex < measurements.replayFrames.size())
+		{
+			measurements.replayFrames[replayIndex].gpuMilliseconds = gpuTime.milliseconds;
+			measurements.replayFrames[replayIndex].gpuPassCount = gpuTime.passCount;
+			std::copy(gpuTime.passes, gpuTime.passes + gpuTime.passCount, measurements.replayFrames[replayIndex].gpuPasses);
+		}
+	}
+}
+
+/***********************************************************
+ *	PickSceneObject()
+ *
+ *  This function is used to pick the nearest scene object
+ *  hit by a world space ray and write what was hit, and how
+ *  long picking took, as one JSON object.
+ ***********************************************************/
+void PickSceneObject(const glm::vec3& origin, const glm::vec3& direction, std::ostream& output)
+{
+	SceneManager::PICK_RESULT result;
+	std::chrono::steady_clock::time_point pickStart = std::chrono::steady_clock::now();
+	bool bHit = g_SceneManager->PickObject(origin, direction, result);
+	double microseconds = std::chrono::duration<double, std::micro>(
+		std::chrono::steady_clock::now() - pickStart).count();
+
+	output << "{\"hit\":" << (bHit ? "true" : "false");
+	if (bHit == true)
+	{
+		output << ",\"pass\":\"" << result.passName << "\""
+			<< ",\"tile\":" << result.tile
+			<< ",\"object\":" << result.object
+			<< ",\"part\":" << result.part
+			<< ",\"mesh\":\"" << ShapeMeshes::GetMeshTypeName(result.mesh) << "\""
+			<< ",\"triangle\":" << result.triangle
+			<< ",\"distance\":" << result.distance
+			<< ",\"position\":[" << result.position.x << "," << result.position.y << "," << result.position.z << "]";
+	}
+	output << ",\"microseconds\":" << microseconds << "}";
+}
+
+/***********************************************************
+ *	CreateGpuTimer()
+ *
+ *  This function is used to create the GPU timer and hand
+ *  it to the scene manager for timing the render passes.
+ ***********************************************************/
+void CreateGpuTimer()
+{
+	g_GpuTimer = new GpuTimer();
+	g_GpuTimer->Create();
+	g_SceneManager->SetGpuTimer(g_GpuTimer);
+}
+
+/***********************************************************
+ *	CreateJobSystem()
+ *
+ *  This function is used to start the worker threads and
+ *  hand them to the scene manager for preparing the frames.
+ ***********************************************************/
+void CreateJobSystem(int threadCount)
+{
+	g_JobSystem = new JobSystem(threadCount);
+	g_SceneManager->SetJobSystem(g_JobSystem);
+	std::cout << "Preparing frames on " << g_JobSystem->GetThreadCount() << " threads" << std::endl;
+}
+
+/***********************************************************
+ *	OpenWorld()
+ *
+ *  This function is used to start streaming the tiles of the
+ *  world file around the camera, when one was passed in.
+ ***********************************************************/
+bool OpenWorld(const APP_OPTIONS& options)
+{
+	if (options.worldPath.empty() == true)
+	{
+		return(true);
+	}
+
+	return(g_SceneManager->OpenWorld(
+		options.worldPath,
+		options.tileRadius,
+		(size_t)options.tileBudgetMegabytes * 1024 * 1024));
+}
+
+/***********************************************************
+ *	StartHeadless()
+ *
+ *  This function is used to create the OpenGL context
+ *  without a display window, load the shaders and the scene
+ *  and create everything that draws the frames.
+ ***********************************************************/
+bool StartHeadless(const APP_OPTIONS& options, OffscreenContext& context)
+{
+	// create the OpenGL context without a display window
+	if (context.Create(options.width, options.height) == false)
+	{
+		return(false);
+	}
+	if (InitializeGLEW(true) == false)
+	{
+		return(false);
+	}
+
+	g_ShaderManager = new ShaderManager();
+	g_ViewManager = new ViewManager(
+		g_ShaderManager);
+	g_ViewManager->CreateOffscreenView(options.width, options.height);
+
+	// load the shader code from the external GLSL files
+	g_ShaderManager->LoadShaders(
+		"shaders/vertexShader.glsl",
+		"shaders/fragmentShader.glsl");
+	g_ShaderManager->use();
+
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetSceneFile(options.scenePath);
+	g_SceneManager->PrepareScene();
+	if (OpenWorld(options) == false)
+	{
+		DestroyManagers();
+		return(false);
+	}
+	CreateGpuTimer();
+	CreateJobSystem(options.threadCount);
+	if (options.bSoftwareRenderer == true)
+	{
+		CreateSoftwareRasterizer(options.width, options.height, options.threadCount);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *	DestroyManagers()
+ *
+ *  This function is used to free the allocated manager
+ *  objects from memory.
+ ***********************************************************/
+void DestroyManagers()
+{
+	if (NULL != g_ResolutionScaler)
+	{
+		delete g_ResolutionScaler;
+		g_ResolutionScaler = NULL;
+	}
+	if (NULL != g_GpuTimer)
+	{
+		delete g_GpuTimer;
+		g_GpuTimer = NULL;
+	}
+	if (NULL != g_SceneManager)
+	{
+		delete g_SceneManager;
+		g_SceneManager = NULL;
+	}
+	if (NULL != g_JobSystem)
+	{
+		delete g_JobSystem;
+		g_JobSystem = NULL;
+	}
+	if (NULL != g_SoftwareRasterizer)
+	{
+		delete g_SoftwareRasterizer;
+		g_SoftwareRasterizer = NULL;
+	}
+	if (NULL != g_RasterJobSystem)
+	{
+		delete g_RasterJobSystem;
+		g_RasterJobSystem = NULL;
+	}
+	if (NULL != g_ViewManager)
+	{
+		delete g_ViewManager;
+		g_ViewManager = NULL;
+	}
+	if (NULL != g_ShaderManager)
+	{
+		delete g_ShaderManager;
+		g_ShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *	InitializeGLFW()
+ * 
+ *  This function is used to initialize the GLFW library.   
+ ***********************************************************/
+bool InitializeGLFW()
+{
+	// GLFW: initialize and configure library
+	// --------------------------------------
+	glfwInit();
+
+#ifdef __APPLE__
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#endif
+	// GLFW: end -------------------------------
+
+	return(true);
+}
+
+/***********************************************************
+ *	InitializeGLEW()
+ *
+ *  This function is used to initialize the GLEW library.
+ *  Headless contexts are created through EGL, which a GLX
+ *  build of GLEW reports as a missing GLX display even though
+ *  the OpenGL functions were loaded.
+ ***********************************************************/
+bool InitializeGLEW(bool bHeadless)
+{
+	// GLEW: initialize
+	// -----------------------------------------
+	GLenum GLEWInitResult = GLEW_OK;
+
+	// try to initialize the GLEW library
+	glewExperimental = GL_TRUE;
+	GLEWInitResult = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	if ((bHeadless == true) && (GLEW_ERROR_NO_GLX_DISPLAY == GLEWInitResult))
+	{
+		GLEWInitResult = GLEW_OK;
+	}
+#endif
+	if (GLEW_OK != GLEWInitResult)
+	{
+		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
+		return false;
+	}
+	// GLEW: end -------------------------------
+
+	// Displays a successful OpenGL initialization message
+	std::cout << "INFO: OpenGL Successfully Initialized\n";
+	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
+
+	return(true);
+}
@@ -0,0 +1,246 @@
+///////////////////////////////////////////////////////////////////////////////
+// runmodes.h
+// ============
+// the command line options, the managers shared by the run modes and the
+// functions each run mode's source file provides to the others
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "FramePacket.h"
+#include "FrameStatistics.h"
+#include "GpuTimer.h"
+
+class SceneManager;
+class ShaderManager;
+class ViewManager;
+class ResolutionScaler;
+class JobSystem;
+class SoftwareRasterizer;
+class OffscreenContext;
+class RenderTarget;
+
+// options passed in on the command line
+struct APP_OPTIONS
+{
+	// render into an offscreen framebuffer without a window
+	bool bHeadless = false;
+	// number of timed frames for the headless benchmark
+	int frames = 300;
+	// number of untimed frames rendered before the timed ones
+	int warmupFrames = 10;
+	// size of the offscreen framebuffer
+	int width = 1000;
+	int height = 800;
+	// optional file for the benchmark results
+	std::string outputPath;
+	// camera path file to record while flying the camera
+	std::string recordPath;
+	// camera path file to replay instead of taking input
+	std::string replayPath;
+	// per-frame results of the replay
+	std::string csvPath = "replay_frames.csv";
+	// frames per second of replayed path time
+	float replayFps = 60.0f;
+	// profiler trace written when the program exits
+	std::string tracePath;
+	// render statistics history written when the program exits
+	std::string statsPath;
+	// threads that prepare the frames, 0 for one per hardware thread
+	int threadCount = 0;
+	// draw the headless frames on a render thread while the next
+	// one is prepared - the window always does
+	bool bRenderThread = false;
+	// scene file loaded in place of the built in park
+	std::string scenePath;
+	// binary scene file that the scene file is converted into,
+	// without rendering anything
+	std::string convertScenePath;
+	// world file whose tiles are streamed around the camera
+	std::string worldPath;
+	// distance from the camera that tiles are loaded within
+	float tileRadius = 150.0f;
+	// most megabytes of the resident tiles
+	int tileBudgetMegabytes = 256;
+	// directory that the scene file is split into tiles in,
+	// without rendering anything
+	std::string splitScenePath;
+	// size of the tiles of a split scene
+	float tileSize = 100.0f;
+	// window position picked after the headless frames, with
+	// the picked object added to the results
+	bool bPick = false;
+	float pickX = 0.0f;
+	float pickY = 0.0f;
+	// PNG file that the view after the headless frames is
+	// ray traced into on the CPU
+	std::string raytracePath;
+	// draw the headless frames with the software rasterizer
+	// instead of OpenGL
+	bool bSoftwareRenderer = false;
+	// PNG file that the last headless frame is written into
+	std::string frameImagePath;
+	// draw the view after the software frames with OpenGL too
+	// and add how far the two images differ to the results
+	bool bCompareGL = false;
+	// camera path file whose keys are each rendered into a
+	// PNG file in the batch directory, instead of the timed
+	// frames
+	std::string batchPath;
+	std::string batchDirectory = "batch";
+	// socket file that the render service listens on, and
+	// the most requests drawn in one batch
+	std::string servicePath;
+	int serviceBatch = 8;
+	// render one frame of width * height pixels in tiles of
+	// distributedTile pixels on this many worker processes
+	int distributedWorkers = 0;
+	int distributedTile = 512;
+	// camera pose of the distributed frame - the starting
+	// view of the camera unless --view is passed
+	glm::vec3 viewPosition = glm::vec3(0.0f, 5.0f, 12.0f);
+	float viewYaw = -90.0f;
+	float viewPitch = -14.036243f;
+	// the program, for starting the workers
+	std::string programPath;
+	// GPU frame time that the resolution scale follows - 0
+	// draws every frame at the full size
+	double targetFrameMilliseconds = 0.0;
+	float minScale = 0.5f;
+	float maxScale = 1.0f;
+	float scaleHysteresis = 0.1f;
+	// gather jittered frames into a history instead of scaling
+	// each one up - without a target time they are drawn at
+	// the largest scale
+	bool bTemporalUpscale = false;
+};
+
+// measurements taken for one replayed frame
+struct REPLAY_FRAME
+{
+	int frame;
+	double cpuMilliseconds;
+	double gpuMilliseconds;
+	int gpuPassCount;
+	GpuTimer::PASS_TIME gpuPasses[GpuTimer::MAX_PASSES];
+	int drawCalls;
+	int triangles;
+	int culledObjects;
+};
+
+// GPU times of one render pass over the measured frames
+struct GPU_PASS_STATISTICS
+{
+	std::string name;
+	FrameStatistics times;
+};
+
+// everything measured for the frames from firstFrame on
+struct FRAME_MEASUREMENTS
+{
+	int firstFrame = 0;
+	// number of frames that will be measured, so the lists
+	// below are sized up front
+	int expectedFrames = 0;
+	std::vector<REPLAY_FRAME> replayFrames;
+	FrameStatistics gpuFrameTimes;
+	// in the order the passes are first rendered
+	std::vector<GPU_PASS_STATISTICS> gpuPassTimes;
+	// results read from the GPU timer, reused every frame
+	std::vector<GpuTimer::GPU_TIME> gpuTimes;
+	// triangles drawn by the software rasterizer and the time
+	// it took over the measured frames
+	long long softwareTriangles = 0;
+	double softwareMilliseconds = 0.0;
+};
+
+// kept by the thread that draws the frames
+struct FRAME_CLOCK
+{
+	// the frame time is measured from the end of the last frame
+	std::chrono::steady_clock::time_point lastFrameEnd;
+	std::chrono::steady_clock::time_point lastTitleUpdate;
+};
+
+// color the frames are cleared to, and that the traced
+// rays that hit nothing get
+extern const glm::vec3 g_ClearColor;
+
+// scene manager object for managing the 3D scene prepare and render
+extern SceneManager* g_SceneManager;
+// shader manager object for dynamic interaction with the shader code
+extern ShaderManager* g_ShaderManager;
+// view manager object for managing the 3D view setup and projection to 2D
+extern ViewManager* g_ViewManager;
+// GPU timer for the frames and the render passes inside them
+extern GpuTimer* g_GpuTimer;
+// lower resolution the frames are drawn at to hold a target
+// GPU time, when one is set
+extern ResolutionScaler* g_ResolutionScaler;
+// worker threads that prepare each frame of the scene
+extern JobSystem* g_JobSystem;
+// CPU rasterizer that draws the headless frames in place of
+// OpenGL when it is picked, and the threads it draws on,
+// which run while the main threads prepare the next frame
+extern SoftwareRasterizer* g_SoftwareRasterizer;
+extern JobSystem* g_RasterJobSystem;
+// number of frames prepared so far
+extern int g_FrameNumber;
+// packet of the frames that are prepared and drawn on the
+// same thread
+extern FRAME_PACKET g_FramePacket;
+
+// RunModes.cpp - preparing and drawing the frames, and
+// creating and destroying the managers
+bool InitializeGLFW();
+bool InitializeGLEW(bool bHeadless = false);
+void PrepareFramePacket(FRAME_PACKET& packet);
+void DrawFramePacket(const FRAME_PACKET& packet);
+void RenderFrame();
+void CollectGpuTimes(FRAME_MEASUREMENTS& measurements, bool bWait);
+void PickSceneObject(const glm::vec3& origin, const glm::vec3& direction, std::ostream& output);
+void CreateGpuTimer();
+void CreateJobSystem(int threadCount);
+bool OpenWorld(const APP_OPTIONS& options);
+bool StartHeadless(const APP_OPTIONS& options, OffscreenContext& context);
+void DestroyManagers();
+
+// WindowMode.cpp - the frames drawn into the display window
+int RunWindow(const APP_OPTIONS& options);
+
+// HeadlessMode.cpp - the timed frames drawn offscreen
+int RunHeadless(const APP_OPTIONS& options);
+
+// ReplayMode.cpp - the measurements of a replayed camera path
+void RecordReplayFrame(const FRAME_PACKET& packet, double cpuMilliseconds, FRAME_MEASUREMENTS& measurements);
+bool WriteReplayCSV(const std::string& filename, FRAME_MEASUREMENTS& measurements);
+
+// BatchMode.cpp - the views of a camera path drawn into images
+int RunBatch(const APP_OPTIONS& options, OffscreenContext& context, RenderTarget& renderTarget);
+
+// ServiceMode.cpp - the views asked for over a socket
+int RunService(const APP_OPTIONS& options);
+
+// DistributedMode.cpp - one large frame drawn in tiles by workers
+int RunDistributed(const APP_OPTIONS& options);
+
+// RaytraceMode.cpp - the view traced on the CPU
+bool TraceSceneImage(const std::string& filename, int width, int height, std::ostream& output);
+
+// SoftwareMode.cpp - the frames drawn by the software rasterizer
+void CreateSoftwareRasterizer(int width, int height, int threadCount);
+void ReadFrameImage(int width, int height, std::vector<unsigned char>& pixels);
+bool CompareWithGL(int width, int height, std::ostream& output);
+void WriteSoftwareResults(const FRAME_MEASUREMENTS& measurements, std::ostream& output);
+
+// DynamicResolutionMode.cpp - the frames drawn at a lower resolution
+bool CreateResolutionScaler(const APP_OPTIONS& options, int width, int height);
+void WriteScaleResults(std::ostream& output);
@@ -8,6 +8,10 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "TransformKernels.h"
+#include "RenderThread.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -17,14 +21,181 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+// the blocks are copied straight into the uniform buffer, so
+// they must match the std140 sizes of the shader's blocks
+static_assert(sizeof(SceneManager::CAMERA_BLOCK) == 272, "CameraData does not match std140");
+static_assert(sizeof(SceneManager::LIGHT_BLOCK) == 160, "LightData does not match std140");
+static_assert(sizeof(SceneManager::OBJECT_BLOCK) == 176, "ObjectData does not match std140");
+
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+
+	// binding points of the shader's uniform blocks
+	const GLuint g_CameraBlockBinding = 0;
+	const GLuint g_LightBlockBinding = 1;
+	const GLuint g_ObjectBlockBinding = 2;
+
+	// render passes that the scene objects are timed in, in drawing order
+	enum
+	{
+		g_GroundPass,
+		g_TreePass,
+		g_LampPass,
+		g_FencePass,
+		g_BenchPass,
+		g_LeafPass
+	};
+	const char* g_RenderPassNames[] = { "ground", "trees", "lamps", "fences", "benches", "leaves" };
+	const int g_RenderPassCount = sizeof(g_RenderPassNames) / sizeof(g_RenderPassNames[0]);
+
+	// texture slot that makes the next draw set its texture or color
+	const int g_UnknownTextureSlot = -2;
+	// scene objects tested against the occluders by one job
+	const int g_ObjectsPerCullingJob = 64;
+	// render pass that the tiles of a world are timed in
+	const char* g_TilePassName = "tiles";
+	// slot of the first texture that the tile being loaded
+	// defines itself, until the tile is given texture units
+	const int g_TileTextureSlot = 16;
+	// bytes taken by each transform of a tile - its local values,
+	// parent, subtree end and both matrices
+	const size_t g_TransformBytes = 9 * sizeof(float) + 2 * sizeof(int) + 2 * sizeof(glm::mat4);
+	// bytes taken by each object of a tile in its hierarchy - its
+	// index and bounds, kept by the tile and by the tree
+	const size_t g_CullableObjectBytes = 2 * sizeof(int) + 4 * sizeof(glm::vec3);
+
+	// farthest distance along a picking ray, the far plane of
+	// the perspective projection
+	const float g_PickDistance = 100000.0f;
+
+	// records of a scene file read at a time
+	const int g_SceneRecordsPerChunk = 256;
+	// meshes loaded by PrepareScene() that the parts of a scene
+	// file can use
+	const ShapeMeshes::MeshType g_SceneFileMeshes[] = {
+		ShapeMeshes::plane,
+		ShapeMeshes::cylinder,
+		ShapeMeshes::cone,
+		ShapeMeshes::sphere
+	};
+	// parts added by each of the object functions, a lamp post
+	// without its lines and a tree with four levels of branches
+	const int g_LampPostParts = 3;
+	const int g_BenchParts = 4;
+	const int g_FenceParts = 3;
+	const int g_TreeParts = 30;
+
+	// order of the scene objects by render pass
+	bool IsInEarlierPass(const SceneManager::SCENE_OBJECT& a, const SceneManager::SCENE_OBJECT& b)
+	{
+		return(a.pass < b.pass);
+	}
+
+	// test a ray against a box, both in the same space, and
+	// return true when it enters the box nearer than the
+	// passed in distance
+	bool IntersectRayBounds(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		const glm::vec3& minCorner,
+		const glm::vec3& maxCorner,
+		float distance)
+	{
+		float enter = 0.0f;
+		float exit = distance;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (direction[axis] == 0.0f)
+			{
+				if ((origin[axis] < minCorner[axis]) || (origin[axis] > maxCorner[axis]))
+				{
+					return(false);
+				}
+				continue;
+			}
+			float inverse = 1.0f / direction[axis];
+			float nearHit = (minCorner[axis] - origin[axis]) * inverse;
+			float farHit = (maxCorner[axis] - origin[axis]) * inverse;
+			if (nearHit > farHit)
+			{
+				std::swap(nearHit, farHit);
+			}
+			enter = std::max(enter, nearHit);
+			exit = std::min(exit, farHit);
+		}
+		return(enter <= exit);
+	}
+
+	// test a ray against both sides of a triangle and move the
+	// distance to the hit when it is nearer
+	bool IntersectRayTriangle(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		const glm::vec3* pCorners,
+		float& distance)
+	{
+		glm::vec3 edge1 = pCorners[1] - pCorners[0];
+		glm::vec3 edge2 = pCorners[2] - pCorners[0];
+		glm::vec3 p = glm::cross(direction, edge2);
+		float determinant = glm::dot(edge1, p);
+		if (fabsf(determinant) < 1e-12f)
+		{
+			return(false);
+		}
+
+		float inverse = 1.0f / determinant;
+		glm::vec3 toOrigin = origin - pCorners[0];
+		float u = glm::dot(toOrigin, p) * inverse;
+		if ((u < 0.0f) || (u > 1.0f))
+		{
+			return(false);
+		}
+		glm::vec3 q = glm::cross(toOrigin, edge1);
+		float v = glm::dot(direction, q) * inverse;
+		if ((v < 0.0f) || (u + v > 1.0f))
+		{
+			return(false);
+		}
+
+		float hit = glm::dot(edge2, q) * inverse;
+		if ((hit < 0.0f) || (hit >= distance))
+		{
+			return(false);
+		}
+		distance = hit;
+		return(true);
+	}
+
+	// three values of a scene file record as a vector
+	glm::vec3 GetRecordVector(const SCENE_RECORD& record, int first)
+	{
+		return(glm::vec3(record.values[first], record.values[first + 1], record.values[first + 2]));
+	}
+
+	// build a model matrix from the scale, rotation and position
+	// values in the same order that the shader transform expects
+	glm::mat4 ComposeModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ)
+	{
+		// same result as translate * rotateZ * rotateY * rotateX * scale
+		// without building and multiplying the five matrices
+		return(TransformKernels::ComposeTRS(
+			scaleXYZ,
+			glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+			positionXYZ));
+	}
 }
 
 /***********************************************************
@@ -36,6 +207,31 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
 	m_basicMeshes = new ShapeMeshes();
+	m_loadedTextures = 0;
+	m_pOcclusionCuller = new OcclusionCuller();
+	m_bOcclusionCulling = true;
+	m_culledObjects = 0;
+	m_pGpuTimer = NULL;
+	m_scene.textureSlot = -1;
+	m_scene.color = glm::vec4(1.0f);
+	m_scene.material = 0;
+	m_boundTextureSlot = g_UnknownTextureSlot;
+	m_pJobSystem = NULL;
+	m_transformVersion = 0;
+	m_drawnTransformVersion = -1;
+	m_drawnViewProjection = glm::mat4(1.0f);
+	m_bFrameDrawn = false;
+	m_lights = {};
+	m_lightBlock = {};
+	m_pStreamingBuffer = new StreamingBuffer();
+	m_pTileStreamer = NULL;
+	for (int i = 0; i < 16; i++)
+	{
+		m_tileTextureUnits[i].references = 0;
+		m_tileTextureIDs[i] = 0;
+		m_softwareTextures[i] = ShadingModel::TEXTURE();
+	}
+	m_pSoftwareRasterizer = NULL;
 }
 
 /***********************************************************
@@ -48,6 +244,35 @@ SceneManager::~SceneManager()
 	m_pShaderManager = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	delete m_pOcclusionCuller;
+	m_pOcclusionCuller = NULL;
+	delete m_pStreamingBuffer;
+	m_pStreamingBuffer = NULL;
+
+	// the streaming thread is stopped before the tiles are freed,
+	// since it may be building one
+	if (NULL != m_pTileStreamer)
+	{
+		m_pTileStreamer->Stop();
+		delete m_pTileStreamer;
+		m_pTileStreamer = NULL;
+	}
+	for (size_t i = 0; i < m_residentTiles.size(); i++)
+	{
+		DestroyTile(m_residentTiles[i]);
+	}
+	for (size_t i = 0; i < m_evictedTiles.size(); i++)
+	{
+		DestroyTile(m_evictedTiles[i]);
+	}
+	m_residentTiles.clear();
+	m_evictedTiles.clear();
+
+	for (size_t i = 0; i < m_softwareImages.size(); i++)
+	{
+		stbi_image_free(m_softwareImages[i]);
+	}
+	m_softwareImages.clear();
 }
 
 /***********************************************************
@@ -113,6 +338,7 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 		// register the loaded texture and associate it with the special tag string
 		m_textureIDs[m_loadedTextures].ID = textureID;
 		m_textureIDs[m_loadedTextures].tag = tag;
+		m_textureIDs[m_loadedTextures].filename = filename;
 		m_loadedTextures++;
 
 		return true;
@@ -137,6 +363,7 @@ void SceneManager::BindGLTextures()
 		// bind textures on corresponding texture units
 		glActiveTexture(GL_TEXTURE0 + i);
 		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		RenderStats::CountTextureBind();
 	}
 }
 
@@ -186,7 +413,7 @@ int SceneManager::FindTextureID(std::string tag)
  *  This method is used for getting a slot index for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureSlot(std::string tag, const SCENE_TILE* pTile)
 {
 	int textureSlot = -1;
 	int index = 0;
@@ -203,6 +430,21 @@ int SceneManager::FindTextureSlot(std::string tag)
 			index++;
 	}
 
+	// the textures that a tile being loaded defines get slots
+	// after the last one, which become texture units once the
+	// tile is resident
+	if ((bFound == false) && (NULL != pTile))
+	{
+		for (size_t i = 0; i < pTile->textures.size(); i++)
+		{
+			if (pTile->textures[i].tag.compare(tag) == 0)
+			{
+				textureSlot = g_TileTextureSlot + (int)i;
+				break;
+			}
+		}
+	}
+
 	return(textureSlot);
 }
 
@@ -214,21 +456,21 @@ int SceneManager::FindTextureSlot(std::string tag)
  ***********************************************************/
 bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 {
-	if (m_objectMaterials.size() == 0)
+	if (m_scene.materials.size() == 0)
 	{
 		return(false);
 	}
 
 	int index = 0;
 	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	while ((index < m_scene.materials.size()) && (bFound == false))
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		if (m_scene.materials[index].tag.compare(tag) == 0)
 		{
 			bFound = true;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
+			material.diffuseColor = m_scene.materials[index].diffuseColor;
+			material.specularColor = m_scene.materials[index].specularColor;
+			material.shininess = m_scene.materials[index].shininess;
 		}
 		else
 		{
@@ -240,67 +482,49 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  FindMaterialIndex()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for getting the index of a material
+ *  defined for the content with the passed in tag.
  ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
-{
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
-
-	if (NULL != m_pShaderManager)
+int SceneManager::FindMaterialIndex(const SCENE_CONTENT& content, std::string tag)
+{
+	for (int index = 0; index < (int)content.materials.size(); index++)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		if (content.materials[index].tag.compare(tag) == 0)
+		{
+			return(index);
+		}
 	}
+
+	return(-1);
 }
 
 /***********************************************************
- *  SetShaderColor()
+ *  AddObjectMaterial()
  *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  This method is used for defining a material, along with
+ *  the values written into the object blocks of its parts.
+ *  A material with the same tag is replaced, so the parts
+ *  already using it are drawn with the new values.
  ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
+void SceneManager::AddObjectMaterial(SCENE_CONTENT& content, const OBJECT_MATERIAL& material)
 {
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
+	MATERIAL_BLOCK block;
+	block.diffuseColor = glm::vec4(material.diffuseColor, 0.0f);
+	block.specularColor = material.specularColor;
+	block.shininess = material.shininess;
 
-	if (NULL != m_pShaderManager)
+	int index = FindMaterialIndex(content, material.tag);
+	if (index >= 0)
+	{
+		content.materials[index] = material;
+		content.materialBlocks[index] = block;
+	}
+	else
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		content.materials.push_back(material);
+		content.materialBlocks.push_back(block);
 	}
 }
 
@@ -337,30 +561,6 @@ void SceneManager::SetTextureUVScale(float u, float v)
 	}
 }
 
-/***********************************************************
- *  SetShaderMaterial()
- *
- *  This method is used for passing the material values
- *  into the shader.
- ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
-{
-	if (m_objectMaterials.size() > 0)
-	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
-	}
-}
-
 /**************************************************************/
 /*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
 /*** preparing and rendering their own 3D replicated scenes.***/
@@ -377,6 +577,8 @@ void SceneManager::SetShaderMaterial(
   ***********************************************************/
 void SceneManager::LoadSceneTextures()
 {
+	PROFILE_FUNCTION();
+
 	bool bReturn = false;
 
 	// load textures from texture folder with appropriate tags
@@ -411,7 +613,7 @@ void SceneManager::DefineObjectMaterials()
 	plasticMaterial.specularColor = glm::vec3(0.2f, 0.2f, 0.2f);
 	plasticMaterial.shininess = 2.0;
 	plasticMaterial.tag = "plastic";
-	m_objectMaterials.push_back(plasticMaterial);
+	AddObjectMaterial(m_scene, plasticMaterial);
 }
 
 /***********************************************************
@@ -424,25 +626,29 @@ void SceneManager::SetupSceneLights()
 {
 	m_pShaderManager->setBoolValue(g_UseLightingName, true);
 
-	// ambient and directional lighting
-	m_pShaderManager->setVec3Value("directionalLight.direction", 0.2f, -0.2f, -0.5f);
-	m_pShaderManager->setVec3Value("directionalLight.ambient", 0.9f, 0.9f, 0.9f);
-	m_pShaderManager->setVec3Value("directionalLight.diffuse", 0.8f, 0.8f, 0.8f);
-	m_pShaderManager->setVec3Value("directionalLight.specular", 0.2f, 0.2f, 0.2f);
-	m_pShaderManager->setBoolValue("directionalLight.bActive", true);
-
+	// the light values are written into the light block of
+	// every frame, with the positions and directions taken
+	// from the frame packet since those lights can move
 
-	m_pShaderManager->setVec3Value("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-	m_pShaderManager->setVec3Value("spotLight.diffuse", 1.0f, 1.0f, 0.0f);
-	m_pShaderManager->setVec3Value("spotLight.specular", 0.0f, 0.0f, 0.0f);
-	m_pShaderManager->setFloatValue("spotLight.constant", 0.2f);
-	m_pShaderManager->setFloatValue("spotLight.linear", 0.0f);
-	m_pShaderManager->setFloatValue("spotLight.quadratic", 0.0f);
-	m_pShaderManager->setFloatValue("spotLight.cutOff", glm::cos(glm::radians(70.0f)));
-	m_pShaderManager->setFloatValue("spotLight.outerCutOff",glm::cos(glm::radians(110.0f)));
-	m_pShaderManager->setVec3Value("spotLight.position", glm::vec3(0.0f, 6.0f, -60.0f));
-	m_pShaderManager->setVec3Value("spotLight.direction", glm::vec3(0.0f, 0.0f, -1.0f));
-	m_pShaderManager->setBoolValue("spotLight.bActive", true);
+	// ambient and directional lighting
+	m_lights.directionalDirection = glm::vec3(0.2f, -0.2f, -0.5f);
+	m_lightBlock.directionalLight.ambient = glm::vec4(0.9f, 0.9f, 0.9f, 0.0f);
+	m_lightBlock.directionalLight.diffuse = glm::vec4(0.8f, 0.8f, 0.8f, 0.0f);
+	m_lightBlock.directionalLight.specular = glm::vec3(0.2f, 0.2f, 0.2f);
+	m_lightBlock.directionalLight.bActive = true;
+
+
+	m_lightBlock.spotLight.ambient = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+	m_lightBlock.spotLight.diffuse = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+	m_lightBlock.spotLight.specular = glm::vec3(0.0f, 0.0f, 0.0f);
+	m_lightBlock.spotLight.constant = 0.2f;
+	m_lightBlock.spotLight.linear = 0.0f;
+	m_lightBlock.spotLight.quadratic = 0.0f;
+	m_lightBlock.spotLight.cutOff = glm::cos(glm::radians(70.0f));
+	m_lightBlock.spotLight.outerCutOff = glm::cos(glm::radians(110.0f));
+	m_lights.spotPosition = glm::vec3(0.0f, 6.0f, -60.0f);
+	m_lights.spotDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+	m_lightBlock.spotLight.bActive = true;
 
 }
 
@@ -455,338 +661,2145 @@ void SceneManager::SetupSceneLights()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
+	PROFILE_FUNCTION();
+
+	// connect the shader's uniform blocks to the binding points
+	// that the streaming buffer ranges are bound to
+	m_pShaderManager->setUniformBlockBinding("CameraData", g_CameraBlockBinding);
+	m_pShaderManager->setUniformBlockBinding("LightData", g_LightBlockBinding);
+	m_pShaderManager->setUniformBlockBinding("ObjectData", g_ObjectBlockBinding);
+	m_pStreamingBuffer->Create(GL_UNIFORM_BUFFER);
+
 	LoadSceneTextures();
 	DefineObjectMaterials();
 	SetupSceneLights();
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
 	// in the rendered 3D scene
+	{
+		PROFILE_SCOPE("LoadMeshes");
+		m_basicMeshes->LoadPlaneMesh();
+		m_basicMeshes->LoadCylinderMesh();
+		//m_basicMeshes->LoadBoxMesh();
+		m_basicMeshes->LoadConeMesh();
+		m_basicMeshes->LoadSphereMesh();
+	}
 
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	//m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadConeMesh();
-	m_basicMeshes->LoadSphereMesh();
+	// the built in park is used when there is no scene file,
+	// or when the scene file cannot be loaded
+	if ((m_sceneFilename.empty() == true) || (LoadSceneFile(m_sceneFilename.c_str()) == false))
+	{
+		DefineSceneObjects();
+		DefineSceneOccluders();
+	}
 }
 
-/********************************************************
-* LampPost
-* 
-* This method draws a lamp post attached to the ground at a given postition 
-* 
-* this method also has an option for showing the wireframe lines
-*/
-void SceneManager::LampPost(glm::vec3 translation, bool use_lines) {
-	glm::vec4 color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); 
-	glm::vec4 color2 = glm::vec4(1.0f, 0.855f, 0.725f, 0.9f);
-	glm::vec4 line_color = glm::vec4(0, 1, 1, 1);
-	SetShaderColor(color.x, color.y, color.z, color.a);
+/***********************************************************
+ *  DefineSceneOccluders()
+ *
+ *  This method is used for registering the large, opaque parts
+ *  of the scene with the occlusion culler.  The transforms
+ *  match the ones used in DefineSceneObjects().
+ ***********************************************************/
+void SceneManager::DefineSceneOccluders()
+{
+	PROFILE_FUNCTION();
 
-	//cylander for main body
-	SetTransformations(
-		glm::vec3(0.5f, 10.0f, 0.5f), // this size seems good
-		0, 0, 0, // no rotation needed
-		translation // use unaltered translation to pout the lamp bottom where the function caller decides
-	);
-	m_basicMeshes->DrawCylinderMesh();
-	if (use_lines) { // when using lines we should switch render color for just a second
-		SetShaderColor(line_color.x,line_color.y,line_color.z,line_color.a);
-		m_basicMeshes->DrawCylinderMeshLines();
-		SetShaderColor(color.x, color.y, color.z, color.a);
-	}
-	
-	//cone 1 for top
-	SetTransformations(
-		glm::vec3(1.0f, 1.0f, 1.0f), // default size was great for this
-		0, 0, 0, // no rotation needed
-		translation + glm::vec3(0.0f, 12.0f, 0.0f) // this should be above the users given position because the user gives the ground and the top of the lamp post is up prety high
-	);
-	m_basicMeshes->DrawConeMesh(); // reusing color from the cylander
-	if (use_lines) {
-		SetShaderColor(line_color.x, line_color.y, line_color.z, line_color.a);
-		m_basicMeshes->DrawConeMeshLines();
+	m_pOcclusionCuller->ClearOccluders();
+
+	// ground plane
+	m_pOcclusionCuller->AddOccluderPlane(ComposeModelMatrix(
+		glm::vec3(100.0f, 1.0f, 200.0f),
+		0, 0, 0,
+		glm::vec3(0.0f, 0.0f, 0.0f)));
+
+	// hill - a box that fits inside of the sphere
+	m_pOcclusionCuller->AddOccluderBox(
+		ComposeModelMatrix(
+			glm::vec3(30.0f, 30.0f, 30.0f),
+			0, 180.0f, 90.0f,
+			glm::vec3(0.0f, -20.0f, -200.0f)),
+		glm::vec3(-0.57f, -0.57f, -0.57f),
+		glm::vec3(0.57f, 0.57f, 0.57f));
+
+	// fence supports of the right and left rows - the bars between
+	// them and the bench backs are mostly transparent, so they hide
+	// nothing, and each support is shared by two fences next to
+	// each other
+	for (int i = 31; i >= 0; i--) {
+		for (int side = 1; side >= -1; side -= 2) {
+			m_pOcclusionCuller->AddOccluderPlane(ComposeModelMatrix(
+				glm::vec3(1.0f, 2.0f, 2.0f),
+				90.0f, 0.0f, 0.0f,
+				glm::vec3(20.0f * side, 2.0f, 2.0f - 4.0f * i)));
+		}
 	}
+}
 
-	//cone 2 for glass
-	SetTransformations(
-		glm::vec3(1.0f, 4.0f, 1.0f), // elongate the cone for the glass
-		180.0f, 0, 0, // flip it upside down
-		translation + glm::vec3(0.0f, 12.0f, 0.0f) // move to same position as top cone
-	);
-	//SetShaderColor(color2.x, color2.y, color2.z, color2.a); // uses custom glass color with some transparency
-	SetShaderTexture("lamp_glass");
-	m_basicMeshes->DrawConeMesh();
-	if (use_lines) {
-		SetShaderColor(line_color.x, line_color.y, line_color.z, line_color.a);
-		m_basicMeshes->DrawConeMeshLines();
+/***********************************************************
+ *  IsObjectOccluded()
+ *
+ *  This method is used for testing the world space bounds of
+ *  an object against the occluders rendered for this frame.
+ ***********************************************************/
+bool SceneManager::IsObjectOccluded(glm::vec3 minCorner, glm::vec3 maxCorner) const
+{
+	if (m_bOcclusionCulling == false)
+	{
+		return(false);
 	}
 
+	return(m_pOcclusionCuller->IsOccluded(minCorner, maxCorner));
 }
 
-/*********************************************************
-* Bench()
-* 
-* this method will perform all transforms required to make a bench at a given position with a given orientation
-* 
-*/
-void SceneManager::Bench(glm::vec3 pos,bool facing_right) {
-	// TODO - fix blending issue where texture drawn first will clip later drawn tectures
+/***********************************************************
+ *  UpdateObjectHierarchy()
+ *
+ *  This method is used to keep the hierarchy of a content in
+ *  step with its transforms.  The first time, the objects
+ *  that can be culled are collected and the tree is built
+ *  over their world space bounds - after that it is refit to
+ *  the objects that moved.
+ ***********************************************************/
+void SceneManager::UpdateObjectHierarchy(SCENE_CONTENT& content, JobSystem* pJobSystem)
+{
+	PROFILE_FUNCTION();
 
-	//seat
-	SetShaderTexture("bench_body");
-	SetTransformations(
-		glm::vec3(1.0f, 1.0f, 2.0f),
-		0, 0, 0,
-		pos + glm::vec3(0.1f, 1.7f, 0)
-	);
-	m_basicMeshes->DrawPlaneMesh();
-	
-	//back 
-	float facing = 0.0f;
-	if (facing_right) {
-		facing = 180.0f;
+	bool bBuild = (content.hierarchy.GetInstanceCount() == 0);
+	if (bBuild == true)
+	{
+		content.cullableObjects.clear();
+		for (size_t i = 0; i < content.objects.size(); i++)
+		{
+			if (content.objects[i].bCullable == true)
+			{
+				content.cullableObjects.push_back((int)i);
+			}
+		}
+		content.objectMinCorners.resize(content.cullableObjects.size());
+		content.objectMaxCorners.resize(content.cullableObjects.size());
 	}
-	SetTransformations(
-		glm::vec3(1.0f, 1.0f, 2.0f),
-		0, facing , 90.0f,
-		pos + glm::vec3(1.7f*(facing_right?-1:1), 3.0f, 0)
-	);
-	m_basicMeshes->DrawPlaneMesh();
 
-	// structure left
-	SetShaderTexture("bench_struct");
-	SetTransformations(
-		glm::vec3(2.0f, 2.0f, 2.0f),
-		90.0f, facing, 0,
-		pos + glm::vec3(0, 2.0f, -2.0f) 
-	);
-	m_basicMeshes->DrawPlaneMesh();
-	
-	// structure right
-	SetTransformations(
-		glm::vec3(2.0f, 2.0f, 2.0f),
-		90.0f, facing, 0,
-		pos + glm::vec3(0, 2.0f, 2.0f)
-	);
-	m_basicMeshes->DrawPlaneMesh();
+	for (size_t i = 0; i < content.cullableObjects.size(); i++)
+	{
+		const SCENE_OBJECT& object = content.objects[content.cullableObjects[i]];
+		glm::vec3 position = glm::vec3(content.transforms.GetWorldMatrix(object.transform)[3]);
+		content.objectMinCorners[i] = position + object.minCorner;
+		content.objectMaxCorners[i] = position + object.maxCorner;
+	}
+
+	if (bBuild == true)
+	{
+		content.hierarchy.Build(
+			content.objectMinCorners.data(),
+			content.objectMaxCorners.data(),
+			(int)content.cullableObjects.size(),
+			pJobSystem);
+	}
+	else
+	{
+		content.hierarchy.Refit(content.objectMinCorners.data(), content.objectMaxCorners.data());
+	}
 }
 
-/**********************************************************
-* Fence()
-* 
-* this method will perform all transforms required to make a fence at a given position
-* 
-*/
-void SceneManager::Fence(glm::vec3 pos) {
-	SetShaderTexture("fence_support");
-	SetTransformations(
-		glm::vec3(1.0f, 2.0f, 2.0f),
-		90.0f, 0.0f, 0.0f,
-		pos + glm::vec3(0.0f, 2.0f, -2.0f)
-	);
-	m_basicMeshes->DrawPlaneMesh();
+/***********************************************************
+ *  CullSceneFrustum()
+ *
+ *  This method is used to mark the objects of the scene and
+ *  of the packet's tiles whose bounds are inside the frame's
+ *  frustum.  The other objects are left at 0, so only the
+ *  objects in view are tested against the occluders.
+ ***********************************************************/
+void SceneManager::CullSceneFrustum(FRAME_PACKET& packet)
+{
+	PROFILE_FUNCTION();
 
-	SetShaderTexture("fence_bars");
-	SetTransformations(
-		glm::vec3(2.0f, 2.0f, 2.0f),
-		90.0f, 90.0f, 0.0f,
-		pos + glm::vec3(0.0f, 2.0f, 0.0f)
-	);
-	m_basicMeshes->DrawPlaneMesh();
+	glm::mat4 viewProjection = packet.projection * packet.view;
+	std::fill(packet.visibleObjects.begin(), packet.visibleObjects.end(), (unsigned char)0);
 
-	SetShaderTexture("fence_support");
-	SetTransformations(
-		glm::vec3(1.0f, 2.0f, 2.0f),
-		90.0f, 0.0f, 0.0f,
-		pos + glm::vec3(0.0f, 2.0f, 2.0f)
-	);
-	m_basicMeshes->DrawPlaneMesh();
+	size_t contentStart = 0;
+	for (size_t i = 0; i <= packet.tiles.size(); i++)
+	{
+		const SCENE_CONTENT& content = (i == 0) ? m_scene : packet.tiles[i - 1]->content;
+		m_frustumInstances.clear();
+		content.hierarchy.QueryFrustum(viewProjection, m_frustumInstances);
+		for (size_t j = 0; j < m_frustumInstances.size(); j++)
+		{
+			packet.visibleObjects[contentStart + content.cullableObjects[m_frustumInstances[j]]] = 1;
+		}
+		contentStart += content.objects.size();
+	}
 }
 
+/***********************************************************
+ *  CullSceneObjects()
+ *
+ *  This method is used to test the passed in range of the
+ *  frame's objects against the occluders and mark which of
+ *  them are visible.  The objects of the packet's tiles are
+ *  numbered after the scene objects.  Objects that can be
+ *  culled are only tested when CullSceneFrustum() found them
+ *  in view.  It only reads the transforms and the depth
+ *  buffer, so several ranges can be tested at the same time.
+ ***********************************************************/
+void SceneManager::CullSceneObjects(FRAME_PACKET& packet, int first, int count)
+{
+	const SCENE_CONTENT* pContent = &m_scene;
+	int contentStart = 0;
+	size_t nextTile = 0;
+	for (int i = first; i < first + count; i++)
+	{
+		// move on to the content that holds the object
+		while (i - contentStart >= (int)pContent->objects.size())
+		{
+			contentStart += (int)pContent->objects.size();
+			pContent = &packet.tiles[nextTile++]->content;
+		}
+		const SCENE_OBJECT& object = pContent->objects[i - contentStart];
 
-
-//helper functions for recursive transformation math
-glm::vec3 pos_from_data(glm::vec3 prev, glm::vec3 rot, float scale) {
-	return glm::vec3(
-		prev.x + (-sin(glm::radians(rot.z))) * scale,
-		prev.y + (cos(glm::radians(rot.z))) * scale,
-		prev.z);
+		bool bVisible = true;
+		if (object.bCullable == true)
+		{
+			glm::vec3 position = glm::vec3(pContent->transforms.GetWorldMatrix(object.transform)[3]);
+			bVisible = (packet.visibleObjects[i] != 0)
+				&& !IsObjectOccluded(position + object.minCorner, position + object.maxCorner);
+		}
+		packet.visibleObjects[i] = bVisible ? 1 : 0;
+	}
 }
-glm::vec3 rot_add(glm::vec3 one, glm::vec3 two) {
 
-	float x = one.x + two.x;
-	while (x >= 360.0f){
-		x -= 360.0f;
-	}
-	float y = one.y + two.y;
-	while (y >= 360.0f) {
-		y -= 360.0f;
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used to find the nearest scene object that
+ *  a world space ray hits, along with the part and the
+ *  triangle of its mesh.  The hierarchies of the scene and
+ *  of the resident tiles find the objects whose bounds the
+ *  ray crosses, nearest first, and only the triangles of
+ *  those objects' parts are tested.  Objects without bounds,
+ *  like the ground, cannot be picked.  The transforms and
+ *  the tiles are only changed while a frame is prepared, so
+ *  it is called between frames on the same thread.
+ ***********************************************************/
+bool SceneManager::PickObject(const glm::vec3& origin, const glm::vec3& direction, PICK_RESULT& result) const
+{
+	PROFILE_FUNCTION();
+
+	float distance = g_PickDistance;
+	bool bHit = false;
+	for (size_t i = 0; i <= m_residentTiles.size(); i++)
+	{
+		const SCENE_CONTENT& content = (i == 0) ? m_scene : m_residentTiles[i - 1]->content;
+		if (PickContentObject(content, origin, direction, distance, result) == true)
+		{
+			result.tile = (int)i - 1;
+			bHit = true;
+		}
 	}
-	float z = one.z + two.z;
-	while (z >= 360.0f) {
-		z -= 360.0f;
+
+	if (bHit == true)
+	{
+		const SCENE_CONTENT& content = (result.tile < 0) ? m_scene : m_residentTiles[result.tile]->content;
+		int pass = content.objects[result.object].pass;
+		result.passName = ((pass >= 0) && (pass < g_RenderPassCount)) ? g_RenderPassNames[pass] : "unknown";
+		result.mesh = content.drawRecords[result.part].mesh;
+		result.distance = distance;
+		result.position = origin + direction * distance;
 	}
 
-	return glm::vec3(x, y, z);
+	return(bHit);
 }
 
-void SceneManager::Branch(glm::vec3 base, glm::vec3 rot, int recursions_left) {
-	if (recursions_left <= 0) {
-		return;
+/***********************************************************
+ *  PickContentObject()
+ *
+ *  This method is used to find the nearest part of the
+ *  objects of one content that a ray hits nearer than the
+ *  passed in distance, which is moved to the hit.  The
+ *  hierarchy visits the objects nearest first and skips
+ *  those that start beyond the nearest hit.
+ ***********************************************************/
+bool SceneManager::PickContentObject(
+	const SCENE_CONTENT& content,
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& distance,
+	PICK_RESULT& result) const
+{
+	// the triangle hit nearest so far, which the hierarchy
+	// also keeps as the nearest hit
+	float nearest = distance;
+	int nearestPart = -1;
+	int nearestTriangle = -1;
+	float hierarchyDistance = distance;
+	int instance = content.hierarchy.QueryRay(origin, direction, distance, hierarchyDistance,
+		[this, &content, &origin, &direction, &nearest, &nearestPart, &nearestTriangle](int candidate, float& hit) {
+			hit = nearest;
+			int part = -1;
+			int triangle = -1;
+			if (IntersectObjectParts(content, content.cullableObjects[candidate], origin, direction, hit, part, triangle) == false)
+			{
+				return(false);
+			}
+			nearest = hit;
+			nearestPart = part;
+			nearestTriangle = triangle;
+			return(true);
+		});
+	if (instance < 0)
+	{
+		return(false);
 	}
-	glm::vec3 base_scale = glm::vec3(1.0f, 20.0f, -1.0f);
-	glm::vec3 step_rot = rot_add(rot, glm::vec3(0, 0, 15.0f));
-	float scaling = recursions_left*0.2;
-	// draw two cylinders
-	SetShaderTexture("wood");
-	SetTransformations(
-		base_scale * scaling,
-		rot.x, rot.y, rot.z,
-		base
-	);
-	m_basicMeshes->DrawCylinderMesh();
-	SetTransformations(
-		base_scale * scaling,
-		step_rot.x, step_rot.y, step_rot.z,
-		pos_from_data(base,rot,base_scale.y*scaling*0.95f)
-	);
-	m_basicMeshes->DrawCylinderMesh();
-	// recurse (probably will need to use quaternions to make rotations easier)
-	Branch(pos_from_data(base,rot,base_scale.y*scaling*0.5),rot_add(rot,glm::vec3(0.0f, 0, 30.0f)), recursions_left - 1);
-	Branch(pos_from_data(base, rot, base_scale.y * scaling * 0.75), rot_add(rot, glm::vec3(0.0, 0, -30.0f)), recursions_left - 1);
-}
 
-/**********************************************************
-* Tree()
-* 
-* This method will perform all transforms required to make a tree at a given position with a given orientation
-* 
-* 
-*/
-void SceneManager::Tree(glm::vec3 pos, float angle) {
-	//
-	Branch(pos, glm::vec3(0.0f,angle,0.0f), 4);
+	distance = nearest;
+	result.object = content.cullableObjects[instance];
+	result.part = nearestPart;
+	result.triangle = nearestTriangle;
+	return(true);
 }
 
 /***********************************************************
- *  RenderScene()
+ *  IntersectObjectParts()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used to test a ray against the triangles
+ *  of each part of an object.  The ray is moved into the
+ *  space of the part's mesh, where the distances along it
+ *  stay the same, and the triangles are only tested when it
+ *  crosses the bounds of the mesh.
  ***********************************************************/
-void SceneManager::RenderScene()
+bool SceneManager::IntersectObjectParts(
+	const SCENE_CONTENT& content,
+	int object,
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& distance,
+	int& part,
+	int& triangle) const
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
+	const SCENE_OBJECT& sceneObject = content.objects[object];
+	bool bHit = false;
+	for (int i = sceneObject.firstDraw; i < sceneObject.firstDraw + sceneObject.drawCount; i++)
+	{
+		const DRAW_RECORD& record = content.drawRecords[i];
+		const std::vector<glm::vec3>& corners = m_basicMeshes->GetMeshTriangles(record.mesh);
+		if (corners.empty() == true)
+		{
+			continue;
+		}
+
+		glm::mat4 toMesh = glm::inverse(content.transforms.GetWorldMatrix(record.transform));
+		glm::vec3 meshOrigin = glm::vec3(toMesh * glm::vec4(origin, 1.0f));
+		glm::vec3 meshDirection = glm::vec3(toMesh * glm::vec4(direction, 0.0f));
+		glm::vec3 minCorner;
+		glm::vec3 maxCorner;
+		m_basicMeshes->GetMeshBounds(record.mesh, minCorner, maxCorner);
+		if (IntersectRayBounds(meshOrigin, meshDirection, minCorner, maxCorner, distance) == false)
+		{
+			continue;
+		}
+
+		for (size_t corner = 0; corner < corners.size(); corner += 3)
+		{
+			if (IntersectRayTriangle(meshOrigin, meshDirection, &corners[corner], distance) == true)
+			{
+				part = i;
+				triangle = (int)(corner / 3);
+				bHit = true;
+			}
+		}
+	}
+
+	return(bHit);
+}
+
+/***********************************************************
+ *  TraceReferenceImage()
+ *
+ *  This method is used to trace an image of every object of
+ *  the scene and of the resident tiles, culled or not, with
+ *  the lights of the next frame.  The scene's textures only
+ *  live on the GPU, so their image files are decoded again,
+ *  while the tiles keep theirs in memory.  The tree and the
+ *  image are built on the job system when there is one.
+ ***********************************************************/
+bool SceneManager::TraceReferenceImage(
+	const RayTracer::CAMERA& camera,
+	const glm::vec3& background,
+	int width,
+	int height,
+	unsigned char* pPixels,
+	RayTracer::STATISTICS& statistics) const
+{
+	PROFILE_FUNCTION();
+
+	if ((NULL == pPixels) || (width <= 0) || (height <= 0))
+	{
+		return false;
+	}
+
+	RayTracer tracer;
+	const int slotCount = sizeof(m_textureIDs) / sizeof(m_textureIDs[0]);
+	int sceneTextures[slotCount];
+	std::vector<unsigned char*> images;
+	for (int slot = 0; slot < slotCount; slot++)
+	{
+		sceneTextures[slot] = -1;
+		RayTracer::TEXTURE texture;
+		if (LoadTextureImage(slot, texture) == false)
+		{
+			continue;
+		}
+		images.push_back((unsigned char*)texture.pixels);
+		if ((texture.channels == 3) || (texture.channels == 4))
+		{
+			sceneTextures[slot] = tracer.AddTexture(texture);
+		}
+	}
+
+	AddTracedContent(tracer, m_scene, sceneTextures);
+	for (size_t i = 0; i < m_residentTiles.size(); i++)
+	{
+		// the parts of a tile were given the texture units of
+		// the tile's own images
+		const SCENE_TILE* pTile = m_residentTiles[i];
+		int tileTextures[slotCount];
+		memcpy(tileTextures, sceneTextures, sizeof(tileTextures));
+		for (size_t image = 0; image < pTile->textures.size(); image++)
+		{
+			const SCENE_TILE::TEXTURE_IMAGE& tileImage = pTile->textures[image];
+			if ((tileImage.unit >= 0) && (tileImage.unit < slotCount))
+			{
+				RayTracer::TEXTURE texture;
+				texture.pixels = tileImage.pixels;
+				texture.width = tileImage.width;
+				texture.height = tileImage.height;
+				texture.channels = tileImage.channels;
+				tileTextures[tileImage.unit] = tracer.AddTexture(texture);
+			}
+		}
+		AddTracedContent(tracer, pTile->content, tileTextures);
+	}
+
+	// the light values of the next frame's light block
+	RayTracer::LIGHTS lights;
+	GetShadingLights(m_lights, lights);
+
+	tracer.Build(m_pJobSystem);
+	tracer.Render(camera, lights, background, width, height, pPixels, m_pJobSystem);
+	statistics = tracer.GetStatistics();
+
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		stbi_image_free(images[i]);
+	}
+	return true;
+}
+
+/***********************************************************
+ *  AddTracedContent()
+ *
+ *  This method is used to add the filled parts of every
+ *  object of a content to a ray tracer, each with the color
+ *  or texture and the material it is drawn with.  Parts
+ *  drawn as lines are left out.
+ ***********************************************************/
+void SceneManager::AddTracedContent(RayTracer& tracer, const SCENE_CONTENT& content, const int* tracedTextures) const
+{
+	for (size_t i = 0; i < content.drawRecords.size(); i++)
+	{
+		const DRAW_RECORD& record = content.drawRecords[i];
+		const std::vector<glm::vec3>& corners = m_basicMeshes->GetMeshTriangles(record.mesh);
+		if ((record.bLines == true) || (corners.empty() == true))
+		{
+			continue;
+		}
+
+		const MATERIAL_BLOCK& material = content.materialBlocks[record.material];
+		RayTracer::SURFACE surface;
+		surface.texture = ((record.textureSlot >= 0) && (record.textureSlot < g_TileTextureSlot))
+			? tracedTextures[record.textureSlot] : -1;
+		surface.color = record.color;
+		surface.diffuseColor = glm::vec3(material.diffuseColor);
+		surface.specularColor = material.specularColor;
+		surface.shininess = material.shininess;
+
+		tracer.AddMesh(
+			content.transforms.GetWorldMatrix(record.transform),
+			corners.data(),
+			m_basicMeshes->GetMeshNormals(record.mesh).data(),
+			m_basicMeshes->GetMeshTextureCoordinates(record.mesh).data(),
+			(int)corners.size(),
+			tracer.AddSurface(surface));
+	}
+}
+
+/***********************************************************
+ *  LoadTextureImage()
+ *
+ *  This method is used to decode the image file of a loaded
+ *  texture again for the CPU renderers, since the textures
+ *  only live on the GPU once they are created.
+ ***********************************************************/
+bool SceneManager::LoadTextureImage(int slot, ShadingModel::TEXTURE& texture) const
+{
+	if ((slot < 0) || (slot >= m_loadedTextures))
+	{
+		return false;
+	}
+
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* pImage = stbi_load(m_textureIDs[slot].filename.c_str(),
+		&texture.width, &texture.height, &texture.channels, 0);
+	if (NULL == pImage)
+	{
+		std::cout << "Could not load image:" << m_textureIDs[slot].filename << std::endl;
+		return false;
+	}
+	texture.pixels = pImage;
+	return true;
+}
+
+/***********************************************************
+ *  GetShadingLights()
+ *
+ *  This method is used to fill the lights that the CPU
+ *  renderers shade with from the light block and the lights
+ *  that move between frames.
+ ***********************************************************/
+void SceneManager::GetShadingLights(const SCENE_LIGHTS& sceneLights, ShadingModel::LIGHTS& lights) const
+{
+	const DIRECTIONAL_LIGHT_BLOCK& directional = m_lightBlock.directionalLight;
+	lights.directionalLight.direction = sceneLights.directionalDirection;
+	lights.directionalLight.ambient = glm::vec3(directional.ambient);
+	lights.directionalLight.diffuse = glm::vec3(directional.diffuse);
+	lights.directionalLight.specular = directional.specular;
+	lights.directionalLight.bActive = (directional.bActive != 0);
+	const SPOT_LIGHT_BLOCK& spot = m_lightBlock.spotLight;
+	lights.spotLight.position = sceneLights.spotPosition;
+	lights.spotLight.direction = sceneLights.spotDirection;
+	lights.spotLight.cutOff = spot.cutOff;
+	lights.spotLight.outerCutOff = spot.outerCutOff;
+	lights.spotLight.constant = spot.constant;
+	lights.spotLight.linear = spot.linear;
+	lights.spotLight.quadratic = spot.quadratic;
+	lights.spotLight.ambient = glm::vec3(spot.ambient);
+	lights.spotLight.diffuse = glm::vec3(spot.diffuse);
+	lights.spotLight.specular = spot.specular;
+	lights.spotLight.bActive = (spot.bActive != 0);
+}
+
+/***********************************************************
+ *  SetOcclusionCulling()
+ *
+ *  This method is used for turning the software occlusion
+ *  culling on or off.
+ ***********************************************************/
+void SceneManager::SetOcclusionCulling(bool bEnabled)
+{
+	m_bOcclusionCulling = bEnabled;
+}
+
+/***********************************************************
+ *  SetSceneFile()
+ *
+ *  This method is used to set the scene file that is loaded
+ *  by PrepareScene() in place of the built in park.
+ ***********************************************************/
+void SceneManager::SetSceneFile(const std::string& filename)
+{
+	m_sceneFilename = filename;
+}
+
+/***********************************************************
+ *  SetGpuTimer()
+ *
+ *  This method is used to set the timer that measures the
+ *  GPU time of each render pass.
+ ***********************************************************/
+void SceneManager::SetGpuTimer(GpuTimer* pGpuTimer)
+{
+	m_pGpuTimer = pGpuTimer;
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used to set the job system that renders
+ *  the occluders, updates the transforms and culls the scene
+ *  objects before each frame is drawn.
+ ***********************************************************/
+void SceneManager::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+	m_pOcclusionCuller->SetJobSystem(pJobSystem);
+}
+
+/***********************************************************
+ *  BeginRenderPass()
+ *
+ *  This method is used to mark the start of a named group
+ *  of draw calls, so its GPU time can be reported.
+ ***********************************************************/
+void SceneManager::BeginRenderPass(const char* name)
+{
+	if (NULL != m_pGpuTimer)
+	{
+		m_pGpuTimer->BeginPass(name);
+	}
+}
+
+/***********************************************************
+ *  EndRenderPass()
+ *
+ *  This method is used to mark the end of the most recently
+ *  started render pass.
+ ***********************************************************/
+void SceneManager::EndRenderPass()
+{
+	if (NULL != m_pGpuTimer)
+	{
+		m_pGpuTimer->EndPass();
+	}
+}
+
+/***********************************************************
+ *  BeginSceneObject()
+ *
+ *  This method is used to start a new scene object.  The
+ *  parts added with AddObjectMesh() are placed relative to
+ *  the object's position, so moving its transform moves
+ *  all of them.
+ ***********************************************************/
+void SceneManager::BeginSceneObject(
+	SCENE_BUILDER& builder,
+	int pass,
+	glm::vec3 position,
+	bool bCullable,
+	glm::vec3 minCorner,
+	glm::vec3 maxCorner)
+{
+	SCENE_OBJECT object;
+	object.transform = builder.pContent->transforms.AddTransform(glm::vec3(1.0f), glm::vec3(0.0f), position);
+	object.pass = pass;
+	object.minCorner = minCorner;
+	object.maxCorner = maxCorner;
+	object.bCullable = bCullable;
+	object.firstDraw = (int)builder.pContent->drawRecords.size();
+	object.drawCount = 0;
+	builder.pContent->objects.push_back(object);
+}
+
+/***********************************************************
+ *  SetObjectTexture()
+ *
+ *  This method is used to set the texture that the parts
+ *  added next are drawn with.
+ ***********************************************************/
+void SceneManager::SetObjectTexture(SCENE_BUILDER& builder, std::string textureTag)
+{
+	builder.pContent->textureSlot = FindTextureSlot(textureTag, builder.pTile);
+}
+
+/***********************************************************
+ *  SetObjectColor()
+ *
+ *  This method is used to set the color that the parts
+ *  added next are drawn with instead of a texture.
+ ***********************************************************/
+void SceneManager::SetObjectColor(SCENE_BUILDER& builder, glm::vec4 color)
+{
+	builder.pContent->textureSlot = -1;
+	builder.pContent->color = color;
+}
+
+/***********************************************************
+ *  SetObjectMaterial()
+ *
+ *  This method is used to set the material that the parts
+ *  added next are lit with.  An unknown tag leaves the
+ *  material unchanged.
+ ***********************************************************/
+void SceneManager::SetObjectMaterial(SCENE_BUILDER& builder, std::string materialTag)
+{
+	int index = FindMaterialIndex(*builder.pContent, materialTag);
+	if (index >= 0)
+	{
+		builder.pContent->material = index;
+	}
+}
+
+/***********************************************************
+ *  AddObjectMesh()
+ *
+ *  This method is used to add a part to the current scene
+ *  object with the current texture or color.
+ ***********************************************************/
+void SceneManager::AddObjectMesh(
+	SCENE_BUILDER& builder,
+	ShapeMeshes::MeshType mesh,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	bool bLines)
+{
+	if (builder.pContent->objects.empty())
+	{
+		std::cout << "A scene object must be started before its parts are added" << std::endl;
+		return;
+	}
+
+	SCENE_OBJECT& object = builder.pContent->objects.back();
+
+	DRAW_RECORD record;
+	record.transform = builder.pContent->transforms.AddTransform(
+		scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+		positionXYZ,
+		object.transform);
+	record.mesh = mesh;
+	record.bLines = bLines;
+	record.textureSlot = builder.pContent->textureSlot;
+	record.color = builder.pContent->color;
+	record.material = builder.pContent->material;
+	builder.pContent->drawRecords.push_back(record);
+	object.drawCount++;
+}
+
+/***********************************************************
+ *  DrawRecord()
+ *
+ *  This method is used to draw one part of a scene object
+ *  with the object block written for it this frame.  The
+ *  texture is only set into the shader when it differs from
+ *  the part drawn before.
+ ***********************************************************/
+void SceneManager::DrawRecord(const DRAW_RECORD& record, GLintptr objectOffset)
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	if (record.textureSlot != m_boundTextureSlot)
+	{
+		m_pShaderManager->setIntValue(g_UseTextureName, record.textureSlot >= 0);
+		if (record.textureSlot >= 0)
+		{
+			// the textures stay bound to fixed units, so pointing
+			// the sampler at another unit is the texture switch
+			m_pShaderManager->setSampler2DValue(g_TextureValueName, record.textureSlot);
+			RenderStats::CountTextureBind();
+		}
+		m_boundTextureSlot = record.textureSlot;
+	}
+
+	m_pShaderManager->bindUniformBlockRange(
+		g_ObjectBlockBinding,
+		m_pStreamingBuffer->GetBuffer(),
+		objectOffset,
+		sizeof(OBJECT_BLOCK));
+	m_basicMeshes->DrawMesh(record.mesh, record.bLines);
+}
+
+/********************************************************
+* LampPost
+* 
+* This method adds a lamp post attached to the ground at a given postition 
+* 
+* this method also has an option for showing the wireframe lines
+*/
+void SceneManager::LampPost(SCENE_BUILDER& builder, glm::vec3 translation, bool use_lines) {
+	// the whole lamp post is skipped when it is hidden behind an occluder
+	BeginSceneObject(builder, g_LampPass, translation, true, glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(1.0f, 13.0f, 1.0f));
+
+	glm::vec4 color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); 
+	glm::vec4 color2 = glm::vec4(1.0f, 0.855f, 0.725f, 0.9f);
+	glm::vec4 line_color = glm::vec4(0, 1, 1, 1);
+	SetObjectColor(builder, color);
+
+	//cylander for main body
+	glm::vec3 body_scale = glm::vec3(0.5f, 10.0f, 0.5f); // this size seems good
+	AddObjectMesh(builder, ShapeMeshes::cylinder,
+		body_scale,
+		0, 0, 0, // no rotation needed
+		glm::vec3(0.0f) // the lamp bottom stays where the function caller decides
+	);
+	if (use_lines) { // when using lines we should switch render color for just a second
+		SetObjectColor(builder, line_color);
+		AddObjectMesh(builder, ShapeMeshes::cylinder, body_scale, 0, 0, 0, glm::vec3(0.0f), true);
+		SetObjectColor(builder, color);
+	}
+	
+	//cone 1 for top
+	AddObjectMesh(builder, ShapeMeshes::cone,
+		glm::vec3(1.0f, 1.0f, 1.0f), // default size was great for this
+		0, 0, 0, // no rotation needed
+		glm::vec3(0.0f, 12.0f, 0.0f) // this should be above the users given position because the user gives the ground and the top of the lamp post is up prety high
+	); // reusing color from the cylander
+	if (use_lines) {
+		SetObjectColor(builder, line_color);
+		AddObjectMesh(builder, ShapeMeshes::cone, glm::vec3(1.0f, 1.0f, 1.0f), 0, 0, 0, glm::vec3(0.0f, 12.0f, 0.0f), true);
+	}
+
+	//cone 2 for glass
+	//SetObjectColor(builder, color2); // uses custom glass color with some transparency
+	SetObjectTexture(builder, "lamp_glass");
+	AddObjectMesh(builder, ShapeMeshes::cone,
+		glm::vec3(1.0f, 4.0f, 1.0f), // elongate the cone for the glass
+		180.0f, 0, 0, // flip it upside down
+		glm::vec3(0.0f, 12.0f, 0.0f) // move to same position as top cone
+	);
+	if (use_lines) {
+		SetObjectColor(builder, line_color);
+		AddObjectMesh(builder, ShapeMeshes::cone, glm::vec3(1.0f, 4.0f, 1.0f), 180.0f, 0, 0, glm::vec3(0.0f, 12.0f, 0.0f), true);
+	}
+
+}
+
+/*********************************************************
+* Bench()
+* 
+* this method will add all the parts required to make a bench at a given position with a given orientation
+* 
+*/
+void SceneManager::Bench(SCENE_BUILDER& builder, glm::vec3 pos,bool facing_right) {
+	// TODO - fix blending issue where texture drawn first will clip later drawn tectures
+	BeginSceneObject(builder, g_BenchPass, pos, true, glm::vec3(-2.0f, 0.0f, -2.0f), glm::vec3(2.0f, 4.0f, 2.0f));
+
+	//seat
+	SetObjectTexture(builder, "bench_body");
+	AddObjectMesh(builder, ShapeMeshes::plane,
+		glm::vec3(1.0f, 1.0f, 2.0f),
+		0, 0, 0,
+		glm::vec3(0.1f, 1.7f, 0)
+	);
+	
+	//back 
+	float facing = 0.0f;
+	if (facing_right) {
+		facing = 180.0f;
+	}
+	AddObjectMesh(builder, ShapeMeshes::plane,
+		glm::vec3(1.0f, 1.0f, 2.0f),
+		0, facing , 90.0f,
+		glm::vec3(1.7f*(facing_right?-1:1), 3.0f, 0)
+	);
+
+	// structure left
+	SetObjectTexture(builder, "bench_struct");
+	AddObjectMesh(builder, ShapeMeshes::plane,
+		glm::vec3(2.0f, 2.0f, 2.0f),
+		90.0f, facing, 0,
+		glm::vec3(0, 2.0f, -2.0f) 
+	);
+	
+	// structure right
+	AddObjectMesh(builder, ShapeMeshes::plane,
+		glm::vec3(2.0f, 2.0f, 2.0f),
+		90.0f, facing, 0,
+		glm::vec3(0, 2.0f, 2.0f)
+	);
+}
+
+/**********************************************************
+* Fence()
+* 
+* this method will add all the parts required to make a fence at a given position
+* 
+*/
+void SceneManager::Fence(SCENE_BUILDER& builder, glm::vec3 pos) {
+	BeginSceneObject(builder, g_FencePass, pos, true, glm::vec3(-1.0f, 0.0f, -2.0f), glm::vec3(1.0f, 4.0f, 2.0f));
+
+	SetObjectTexture(builder, "fence_support");
+	AddObjectMesh(builder, ShapeMeshes::plane,
+		glm::vec3(1.0f, 2.0f, 2.0f),
+		90.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 2.0f, -2.0f)
+	);
+
+	SetObjectTexture(builder, "fence_bars");
+	AddObjectMesh(builder, ShapeMeshes::plane,
+		glm::vec3(2.0f, 2.0f, 2.0f),
+		90.0f, 90.0f, 0.0f,
+		glm::vec3(0.0f, 2.0f, 0.0f)
+	);
+
+	SetObjectTexture(builder, "fence_support");
+	AddObjectMesh(builder, ShapeMeshes::plane,
+		glm::vec3(1.0f, 2.0f, 2.0f),
+		90.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 2.0f, 2.0f)
+	);
+}
+
+
+
+//helper functions for recursive transformation math
+glm::vec3 pos_from_data(glm::vec3 prev, glm::vec3 rot, float scale) {
+	return glm::vec3(
+		prev.x + (-sin(glm::radians(rot.z))) * scale,
+		prev.y + (cos(glm::radians(rot.z))) * scale,
+		prev.z);
+}
+glm::vec3 rot_add(glm::vec3 one, glm::vec3 two) {
+
+	float x = one.x + two.x;
+	while (x >= 360.0f){
+		x -= 360.0f;
+	}
+	float y = one.y + two.y;
+	while (y >= 360.0f) {
+		y -= 360.0f;
+	}
+	float z = one.z + two.z;
+	while (z >= 360.0f) {
+		z -= 360.0f;
+	}
+
+	return glm::vec3(x, y, z);
+}
+
+void SceneManager::Branch(SCENE_BUILDER& builder, glm::vec3 base, glm::vec3 rot, int recursions_left) {
+	if (recursions_left <= 0) {
+		return;
+	}
+	glm::vec3 base_scale = glm::vec3(1.0f, 20.0f, -1.0f);
+	glm::vec3 step_rot = rot_add(rot, glm::vec3(0, 0, 15.0f));
+	float scaling = recursions_left*0.2;
+	// add two cylinders
+	SetObjectTexture(builder, "wood");
+	AddObjectMesh(builder, ShapeMeshes::cylinder,
+		base_scale * scaling,
+		rot.x, rot.y, rot.z,
+		base
+	);
+	AddObjectMesh(builder, ShapeMeshes::cylinder,
+		base_scale * scaling,
+		step_rot.x, step_rot.y, step_rot.z,
+		pos_from_data(base,rot,base_scale.y*scaling*0.95f)
+	);
+	// recurse (probably will need to use quaternions to make rotations easier)
+	Branch(builder, pos_from_data(base,rot,base_scale.y*scaling*0.5),rot_add(rot,glm::vec3(0.0f, 0, 30.0f)), recursions_left - 1);
+	Branch(builder, pos_from_data(base, rot, base_scale.y * scaling * 0.75), rot_add(rot, glm::vec3(0.0, 0, -30.0f)), recursions_left - 1);
+}
+
+/**********************************************************
+* Tree()
+* 
+* This method will add all the branches required to make a tree at a given position with a given orientation
+* 
+* 
+*/
+void SceneManager::Tree(SCENE_BUILDER& builder, glm::vec3 pos, float angle) {
+	// the branches only spread out sideways in the XY plane
+	BeginSceneObject(builder, g_TreePass, pos, true, glm::vec3(-30.0f, -1.0f, -2.0f), glm::vec3(30.0f, 45.0f, 2.0f));
+	// the branches are placed relative to the base of the tree
+	Branch(builder, glm::vec3(0.0f), glm::vec3(0.0f,angle,0.0f), 4);
+}
+
+/***********************************************************
+ *  ClearSceneObjects()
+ *
+ *  This method is used to remove the scene objects of the
+ *  content, their parts and transforms, and to reset the
+ *  texture, color and material given to the next parts.
+ ***********************************************************/
+void SceneManager::ClearSceneObjects(SCENE_CONTENT& content)
+{
+	content.transforms.Clear();
+	content.objects.clear();
+	content.drawRecords.clear();
+	content.textureSlot = -1;
+	content.color = glm::vec4(1.0f);
+	// the first defined material is used until another is set
+	content.material = 0;
+	content.hierarchy.Clear();
+	content.cullableObjects.clear();
+}
+
+/***********************************************************
+ *  DefineSceneObjects()
+ *
+ *  This method is used for adding the transformed basic
+ *  shapes that make up the 3D scene.  They are drawn in the
+ *  same order by DrawFrame().
+ ***********************************************************/
+void SceneManager::DefineSceneObjects()
+{
+	PROFILE_FUNCTION();
+
+	// declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
 	float YrotationDegrees = 0.0f;
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
 
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(100.0f, 1.0f, 200.0f);
+	SCENE_BUILDER builder = { &m_scene, NULL };
+	ClearSceneObjects(m_scene);
+
+	// the ground and hill are never hidden
+	BeginSceneObject(builder, g_GroundPass, glm::vec3(0.0f, 0.0f, 0.0f));
+
+	/*** Set needed transformations before adding the basic mesh.   ***/
+	/*** This same ordering of code should be used for transforming ***/
+	/*** and adding all the basic 3D shapes.						***/
+	/******************************************************************/
+	// set the XYZ scale for the mesh
+	scaleXYZ = glm::vec3(100.0f, 1.0f, 200.0f);
+
+	// set the XYZ rotation for the mesh
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+
+	// set the XYZ position for the mesh
+	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+
+	SetObjectTexture(builder, "ground_1");
+
+	// add the mesh with transformation values
+	AddObjectMesh(builder, ShapeMeshes::plane,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	SetObjectTexture(builder, "ground_2");
+	AddObjectMesh(builder, ShapeMeshes::plane,
+		scaleXYZ*0.4f,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ + glm::vec3(0.0f, 0.01f, -70.0f)
+	);
+
+	/****************************************************************/
+	// here is where all the components go, be sure to give them the correct locations
+	
+	// hill
+	SetObjectTexture(builder, "ground_1");
+	AddObjectMesh(builder, ShapeMeshes::sphere,
+		glm::vec3(30.0f, 30.0f, 30.0f),
+		0, 180.0f, 90.0f,
+		glm::vec3(0.0f, -20.0f, -200.0f)
+	);
+
+
+	// trees
+	Tree(builder, glm::vec3(0.0f, 10.0f, -200.0f), 0);
+	for (int i = 0; i < 5; i++) {
+		Tree(builder, glm::vec3(-25.0f, 0.0f, -40.0f - 40.0f * i),0);
+		Tree(builder, glm::vec3(-60.0f, 0.0f, -60.0f - 36.0f * i),0);
+		Tree(builder, glm::vec3(25.0f, 0.0f, -30.0f - 50.0f * i), 0);
+		Tree(builder, glm::vec3(60.0f, 0.0f, -50.0f - 44.0f * i), 0);
+	}
+	
+	// right row of lamp posts
+	for (int i = 0; i < 9; i++) {
+		LampPost(builder, glm::vec3(22.0f, 0.0f, -12.0f-20.0f*i)); // testing lamp in center for demo, pushed back a bit so that the top is visible
+	}
+	// left row of lamp posts
+	for (int i = 0; i < 9; i++) {
+		LampPost(builder, glm::vec3(-22.0f, 0.0f, -16.0f - 20.0f * i));
+	}
+
+	// right and left side fences
+	for (int i = 30; i >= 0; i--) {
+		Fence(builder, glm::vec3(20.0f, 0.0f, -4.0f * i));
+		Fence(builder, glm::vec3(-20.0f, 0.0f, -4.0f * i));
+	}
+
+
+	// right side benches
+	for (int i = 5; i >= 0 ; i--) {
+		for (int j = 4; j >= 0; j--) {
+			Bench(builder, glm::vec3(17.0f, 0.0f, -17.0f-4.0f*j-30.0f*i));
+		}
+	}
+
+	// left side benches
+	for (int i = 5; i >= 0; i--) {
+		for (int j = 4; j >= 0; j--) {
+			Bench(builder, glm::vec3(-17.0f, 0.0f, -10.0f - 4.0f * j - 30.0f * i),true);
+		}
+	}
+
+	// leaves
+	BeginSceneObject(builder, g_LeafPass, glm::vec3(0.0f, 0.0f, 0.0f));
+	SetObjectTexture(builder, "ground_2");
+	for (int i = 0; i < 8; i++) {
+		AddObjectMesh(builder, ShapeMeshes::plane,
+			glm::vec3(150.0f , 1.0f, 100.0f),
+			-90.0f,
+			0,
+			180.0f,
+			glm::vec3(i*10.0f*cos(i*95.0f), 100.0f, -200.0f + 30.0f * i)
+		);
+	}
+
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used for adding the scene objects and the
+ *  occluders described by a scene file, in place of the
+ *  built in park.  The records are added as they are read,
+ *  so only one chunk of them is held in memory at a time.
+ *  A binary file gives its counts up front, which lets the
+ *  retained arrays be sized once instead of growing.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile(const char* filename)
+{
+	PROFILE_FUNCTION();
+
+	SceneReader reader;
+	if (reader.Open(filename) == false)
+	{
+		return false;
+	}
+
+	SCENE_BUILDER builder = { &m_scene, NULL };
+	ClearSceneObjects(m_scene);
+	m_pOcclusionCuller->ClearOccluders();
+	int loadedTextures = m_loadedTextures;
+
+	if (ReadSceneRecords(builder, reader) == false)
+	{
+		std::cout << "Could not load the scene file:" << filename << std::endl;
+		return false;
+	}
+
+	// the textures added by the scene file need their slots
+	if (m_loadedTextures != loadedTextures)
+	{
+		BindGLTextures();
+	}
+
+	std::cout << "Loaded scene file:" << filename << ", objects:" << m_scene.objects.size()
+		<< ", parts:" << m_scene.drawRecords.size() << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  ReadSceneRecords()
+ *
+ *  This method is used for adding the records of an open
+ *  scene file to the content of the builder, a chunk at a
+ *  time, and putting its objects into pass order.
+ ***********************************************************/
+bool SceneManager::ReadSceneRecords(SCENE_BUILDER& builder, SceneReader& reader)
+{
+	size_t objectCount =
+		reader.GetTypeCount(SCENE_RECORD::object) +
+		reader.GetTypeCount(SCENE_RECORD::lampPost) +
+		reader.GetTypeCount(SCENE_RECORD::bench) +
+		reader.GetTypeCount(SCENE_RECORD::fence) +
+		reader.GetTypeCount(SCENE_RECORD::tree);
+	size_t drawCount =
+		reader.GetTypeCount(SCENE_RECORD::part) +
+		reader.GetTypeCount(SCENE_RECORD::lampPost) * g_LampPostParts +
+		reader.GetTypeCount(SCENE_RECORD::bench) * g_BenchParts +
+		reader.GetTypeCount(SCENE_RECORD::fence) * g_FenceParts +
+		reader.GetTypeCount(SCENE_RECORD::tree) * g_TreeParts;
+	builder.pContent->objects.reserve(objectCount);
+	builder.pContent->drawRecords.reserve(drawCount);
+	builder.pContent->transforms.Reserve((int)(objectCount + drawCount));
+
+	std::vector<SCENE_RECORD> records(g_SceneRecordsPerChunk);
+	bool bLoaded = true;
+	int count = 0;
+	while ((bLoaded == true) && ((count = reader.ReadRecords(records.data(), g_SceneRecordsPerChunk)) > 0))
+	{
+		for (int i = 0; (i < count) && (bLoaded == true); i++)
+		{
+			bLoaded = AddSceneRecord(builder, records[i], reader);
+		}
+	}
+	if ((bLoaded == false) || (reader.HasFailed() == true))
+	{
+		return false;
+	}
+
+	// DrawFrame() expects the objects in pass order - the order
+	// within a pass is kept, since the parts are blended over
+	// the ones drawn before them
+	if (std::is_sorted(builder.pContent->objects.begin(), builder.pContent->objects.end(), IsInEarlierPass) == false)
+	{
+		std::stable_sort(builder.pContent->objects.begin(), builder.pContent->objects.end(), IsInEarlierPass);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  AddSceneRecord()
+ *
+ *  This method is used for adding one record of a scene file
+ *  to the scene.  The lamp posts, benches, fences and trees
+ *  are added by their object functions, which set their own
+ *  textures - the texture and color of the parts after them
+ *  are the ones from before.  It returns false for a record
+ *  that cannot be added, which stops the loading.
+ ***********************************************************/
+bool SceneManager::AddSceneRecord(SCENE_BUILDER& builder, const SCENE_RECORD& record, const SceneReader& reader)
+{
+	glm::vec3 position = GetRecordVector(record, 0);
+	int textureSlot = builder.pContent->textureSlot;
+	glm::vec4 color = builder.pContent->color;
+
+	switch (record.type)
+	{
+	case SCENE_RECORD::texture:
+	{
+		// a texture that is already loaded keeps its slot
+		const std::string& tag = reader.GetString(record.strings[0]);
+		if (FindTextureSlot(tag, builder.pTile) >= 0)
+		{
+			break;
+		}
+		// a tile decodes its textures, which are uploaded once
+		// it is resident
+		if (NULL != builder.pTile)
+		{
+			LoadTileTexture(builder.pTile, reader.GetString(record.strings[1]).c_str(), tag);
+			break;
+		}
+		if (m_loadedTextures == sizeof(m_textureIDs) / sizeof(m_textureIDs[0]))
+		{
+			std::cout << "Could not load more textures, all slots are used:" << tag << std::endl;
+			break;
+		}
+		CreateGLTexture(reader.GetString(record.strings[1]).c_str(), tag);
+		break;
+	}
+	case SCENE_RECORD::material:
+	{
+		OBJECT_MATERIAL material;
+		material.diffuseColor = position;
+		material.specularColor = GetRecordVector(record, 3);
+		material.shininess = record.values[6];
+		material.tag = reader.GetString(record.strings[0]);
+		AddObjectMaterial(*builder.pContent, material);
+		break;
+	}
+	case SCENE_RECORD::object:
+	{
+		const std::string& passName = reader.GetString(record.strings[0]);
+		int pass = 0;
+		while ((pass < g_RenderPassCount) && (passName.compare(g_RenderPassNames[pass]) != 0))
+		{
+			pass++;
+		}
+		if (pass == g_RenderPassCount)
+		{
+			std::cout << "Unknown render pass in the scene file:" << passName << std::endl;
+			return false;
+		}
+		BeginSceneObject(builder, pass, position, record.bFlag != 0, GetRecordVector(record, 3), GetRecordVector(record, 6));
+		break;
+	}
+	case SCENE_RECORD::useTexture:
+		SetObjectTexture(builder, reader.GetString(record.strings[0]));
+		break;
+	case SCENE_RECORD::useColor:
+		SetObjectColor(builder, glm::vec4(position, record.values[3]));
+		break;
+	case SCENE_RECORD::useMaterial:
+		SetObjectMaterial(builder, reader.GetString(record.strings[0]));
+		break;
+	case SCENE_RECORD::part:
+	{
+		const std::string& meshName = reader.GetString(record.strings[0]);
+		int mesh = 0;
+		const int meshCount = sizeof(g_SceneFileMeshes) / sizeof(g_SceneFileMeshes[0]);
+		while ((mesh < meshCount) && (meshName.compare(ShapeMeshes::GetMeshTypeName(g_SceneFileMeshes[mesh])) != 0))
+		{
+			mesh++;
+		}
+		if (mesh == meshCount)
+		{
+			std::cout << "Unknown mesh in the scene file:" << meshName << std::endl;
+			return false;
+		}
+		if (builder.pContent->objects.empty() == true)
+		{
+			std::cout << "A part comes before the first object in the scene file" << std::endl;
+			return false;
+		}
+		AddObjectMesh(builder, g_SceneFileMeshes[mesh],
+			position,
+			record.values[3], record.values[4], record.values[5],
+			GetRecordVector(record, 6),
+			record.bFlag != 0);
+		break;
+	}
+	case SCENE_RECORD::lampPost:
+		LampPost(builder, position, record.bFlag != 0);
+		builder.pContent->textureSlot = textureSlot;
+		builder.pContent->color = color;
+		break;
+	case SCENE_RECORD::bench:
+		Bench(builder, position, record.bFlag != 0);
+		builder.pContent->textureSlot = textureSlot;
+		builder.pContent->color = color;
+		break;
+	case SCENE_RECORD::fence:
+		Fence(builder, position);
+		builder.pContent->textureSlot = textureSlot;
+		builder.pContent->color = color;
+		break;
+	case SCENE_RECORD::tree:
+		Tree(builder, position, record.values[3]);
+		builder.pContent->textureSlot = textureSlot;
+		builder.pContent->color = color;
+		break;
+	// the occluders of a world stay with the scene, since the
+	// culler is shared by all of the tiles
+	case SCENE_RECORD::occluderPlane:
+		if (NULL != builder.pTile)
+		{
+			break;
+		}
+		m_pOcclusionCuller->AddOccluderPlane(ComposeModelMatrix(
+			position,
+			record.values[3], record.values[4], record.values[5],
+			GetRecordVector(record, 6)));
+		break;
+	case SCENE_RECORD::occluderBox:
+		if (NULL != builder.pTile)
+		{
+			break;
+		}
+		m_pOcclusionCuller->AddOccluderBox(
+			ComposeModelMatrix(
+				position,
+				record.values[3], record.values[4], record.values[5],
+				GetRecordVector(record, 6)),
+			GetRecordVector(record, 9),
+			GetRecordVector(record, 12));
+		break;
+	default:
+		std::cout << "Unknown record type " << record.type << " in the scene file" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  PrepareFrame()
+ *
+ *  This method is used for preparing the frame in the passed
+ *  in packet, after its view and projection are set.  The
+ *  occluders are rasterized for the frame's view and the
+ *  transforms moved since the last frame are rebuilt, then
+ *  the scene objects and the objects of the resident tiles
+ *  are tested against the occluders.  No OpenGL calls are
+ *  made, so the next frame can be prepared while the render
+ *  thread draws the last one.
+ ***********************************************************/
+void SceneManager::PrepareFrame(FRAME_PACKET& packet)
+{
+	PROFILE_FUNCTION();
+
+	if (NULL != m_pTileStreamer)
+	{
+		UpdateTiles(packet);
+	}
+
+	size_t objectCount = m_scene.objects.size();
+	for (size_t i = 0; i < packet.tiles.size(); i++)
+	{
+		objectCount += packet.tiles[i]->content.objects.size();
+	}
+
+	glm::mat4 viewProjection = packet.projection * packet.view;
+	packet.visibleObjects.resize(objectCount);
+	packet.lights = m_lights;
+
+	// the jobs capture at most two pointers, which std::function
+	// stores without allocating - the frame's scratch data goes
+	// into the job system's frame arena instead
+	std::function<void()> renderOccluders = [this, &viewProjection]() {
+		if (m_bOcclusionCulling == true)
+		{
+			PROFILE_SCOPE("RenderOccluders");
+			m_pOcclusionCuller->RenderOccluders(viewProjection);
+		}
+	};
+	std::function<void()> updateTransforms = [this]() {
+		if (m_scene.transforms.Update(m_pJobSystem) > 0)
+		{
+			m_transformVersion++;
+			UpdateObjectHierarchy(m_scene, m_pJobSystem);
+		}
+	};
+
+	if (NULL != m_pJobSystem)
+	{
+		// the occluders and the transforms do not depend on each
+		// other, and the culling needs both of them
+		JobSystem::JOB* occluders = m_pJobSystem->CreateJob("RenderOccluders", renderOccluders);
+		JobSystem::JOB* transforms = m_pJobSystem->CreateJob("UpdateTransforms", updateTransforms);
+		JobSystem::JOB* culling = m_pJobSystem->CreateJob("CullSceneObjects", [this, &packet]() {
+			CullSceneFrustum(packet);
+			m_pJobSystem->ParallelFor((int)packet.visibleObjects.size(), g_ObjectsPerCullingJob,
+				[this, &packet](int first, int count) { CullSceneObjects(packet, first, count); });
+		});
+		m_pJobSystem->AddDependency(culling, occluders);
+		m_pJobSystem->AddDependency(culling, transforms);
+		m_pJobSystem->Submit(culling);
+		m_pJobSystem->Submit(occluders);
+		m_pJobSystem->Submit(transforms);
+		m_pJobSystem->Wait(culling);
+	}
+	else
+	{
+		renderOccluders();
+		updateTransforms();
+		CullSceneFrustum(packet);
+		CullSceneObjects(packet, 0, (int)packet.visibleObjects.size());
+	}
+
+	// the packet keeps its own copy of the world matrices, so the
+	// transforms can change while the packet is drawn
+	if (packet.transformVersion != m_transformVersion)
+	{
+		packet.worldMatrices.assign(
+			m_scene.transforms.GetWorldMatrices(),
+			m_scene.transforms.GetWorldMatrices() + m_scene.transforms.GetCount());
+		packet.transformVersion = m_transformVersion;
+	}
+}
+
+/***********************************************************
+ *  WriteFrameBlocks()
+ *
+ *  This method is used to write the uniform blocks of a
+ *  frame into the next region of the streaming buffer - the
+ *  camera and light blocks once, and an object block for each
+ *  part of the visible scene objects and tile objects.  All
+ *  of the blocks are written before the first draw reads any
+ *  of them.  The camera and the parts also get their matrices
+ *  of the frame drawn before, from which the shader measures
+ *  how far each pixel moved for the temporal upscaling.
+ ***********************************************************/
+bool SceneManager::WriteFrameBlocks(const FRAME_PACKET& packet)
+{
+	PROFILE_FUNCTION();
+
+	size_t drawCount = m_scene.drawRecords.size();
+	for (size_t i = 0; i < packet.tiles.size(); i++)
+	{
+		drawCount += packet.tiles[i]->content.drawRecords.size();
+	}
+
+	GLsizeiptr cameraSize = m_pStreamingBuffer->GetAlignedSize(sizeof(CAMERA_BLOCK));
+	GLsizeiptr lightSize = m_pStreamingBuffer->GetAlignedSize(sizeof(LIGHT_BLOCK));
+	GLsizeiptr objectSize = m_pStreamingBuffer->GetAlignedSize(sizeof(OBJECT_BLOCK));
+	if (m_pStreamingBuffer->BeginFrame(cameraSize + lightSize + objectSize * drawCount) == false)
+	{
+		std::cout << "Could not write the frame into the streaming buffer" << std::endl;
+		return false;
+	}
+
+	// the blocks are built on the stack and copied whole, since
+	// the mapped memory may be slow to read
+	// the velocity leaves out the jitter the projection was
+	// moved by, which is not a movement of the scene
+	glm::mat4 unjitter(1.0f);
+	unjitter[3][0] = -packet.jitter.x;
+	unjitter[3][1] = -packet.jitter.y;
+	CAMERA_BLOCK camera;
+	camera.view = packet.view;
+	camera.projection = packet.projection;
+	camera.viewPosition = glm::vec4(packet.viewPosition, 0.0f);
+	camera.viewProjection = unjitter * packet.projection * packet.view;
+	camera.previousViewProjection = (m_bFrameDrawn == true) ? m_drawnViewProjection : camera.viewProjection;
+	GLintptr cameraOffset = 0;
+	memcpy(m_pStreamingBuffer->Allocate(sizeof(camera), cameraOffset), &camera, sizeof(camera));
+
+	LIGHT_BLOCK lights = m_lightBlock;
+	lights.directionalLight.direction = glm::vec4(packet.lights.directionalDirection, 0.0f);
+	lights.spotLight.position = glm::vec4(packet.lights.spotPosition, 0.0f);
+	lights.spotLight.direction = packet.lights.spotDirection;
+	GLintptr lightOffset = 0;
+	memcpy(m_pStreamingBuffer->Allocate(sizeof(lights), lightOffset), &lights, sizeof(lights));
+
+	// the scene is drawn with the packet's copy of its world
+	// matrices, while the tiles never move once loaded - the
+	// parts were where the last frame drew them, unless the
+	// transforms are the same ones
+	const glm::mat4* previousMatrices = packet.worldMatrices.data();
+	if ((packet.transformVersion != m_drawnTransformVersion) &&
+		(m_drawnWorldMatrices.size() == packet.worldMatrices.size()))
+	{
+		previousMatrices = m_drawnWorldMatrices.data();
+	}
+	m_drawOffsets.resize(drawCount);
+	WriteObjectBlocks(
+		m_scene,
+		packet.worldMatrices.data(),
+		previousMatrices,
+		packet.visibleObjects.data(),
+		m_drawOffsets.data());
+	size_t firstObject = m_scene.objects.size();
+	size_t firstDraw = m_scene.drawRecords.size();
+	for (size_t i = 0; i < packet.tiles.size(); i++)
+	{
+		const SCENE_CONTENT& content = packet.tiles[i]->content;
+		WriteObjectBlocks(
+			content,
+			content.transforms.GetWorldMatrices(),
+			content.transforms.GetWorldMatrices(),
+			packet.visibleObjects.data() + firstObject,
+			m_drawOffsets.data() + firstDraw);
+		firstObject += content.objects.size();
+		firstDraw += content.drawRecords.size();
+	}
+	m_pStreamingBuffer->FinishWriting();
+
+	if (packet.transformVersion != m_drawnTransformVersion)
+	{
+		m_drawnWorldMatrices.assign(packet.worldMatrices.begin(), packet.worldMatrices.end());
+		m_drawnTransformVersion = packet.transformVersion;
+	}
+	m_drawnViewProjection = camera.viewProjection;
+	m_bFrameDrawn = true;
+
+	GLuint buffer = m_pStreamingBuffer->GetBuffer();
+	m_pShaderManager->bindUniformBlockRange(g_CameraBlockBinding, buffer, cameraOffset, sizeof(CAMERA_BLOCK));
+	m_pShaderManager->bindUniformBlockRange(g_LightBlockBinding, buffer, lightOffset, sizeof(LIGHT_BLOCK));
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	return true;
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+/***********************************************************
+ *  WriteObjectBlocks()
+ *
+ *  This method is used to write an object block for each
+ *  part of the visible objects of one content, and to keep
+ *  the offsets of the blocks for drawing the parts.  The
+ *  region was sized for every draw record, so the
+ *  allocations cannot fail.
+ ***********************************************************/
+void SceneManager::WriteObjectBlocks(
+	const SCENE_CONTENT& content,
+	const glm::mat4* worldMatrices,
+	const glm::mat4* previousWorldMatrices,
+	const unsigned char* visibleObjects,
+	GLintptr* drawOffsets)
+{
+	OBJECT_BLOCK object;
+	for (size_t i = 0; i < content.objects.size(); i++)
+	{
+		if (visibleObjects[i] == 0)
+		{
+			continue;
+		}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+		const SCENE_OBJECT& sceneObject = content.objects[i];
+		for (int draw = sceneObject.firstDraw; draw < sceneObject.firstDraw + sceneObject.drawCount; draw++)
+		{
+			const DRAW_RECORD& record = content.drawRecords[draw];
+			object.model = worldMatrices[record.transform];
+			object.previousModel = previousWorldMatrices[record.transform];
+			object.objectColor = record.color;
+			object.material = content.materialBlocks[record.material];
+			memcpy(m_pStreamingBuffer->Allocate(sizeof(object), drawOffsets[draw]), &object, sizeof(object));
+		}
+	}
+}
+
+/***********************************************************
+ *  DrawFrame()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  drawing the scene objects of a prepared frame that are
+ *  not hidden, followed by the objects of its tiles.  It only
+ *  reads the scene's draw records and the packet, which the
+ *  main thread does not change while the frame is drawn.  The
+ *  region of the streaming buffer that the frame was written
+ *  into is fenced after the last draw.
+ ***********************************************************/
+void SceneManager::DrawFrame(const FRAME_PACKET& packet)
+{
+	PROFILE_FUNCTION();
 
-	SetShaderTexture("ground_1");
-	SetShaderMaterial("plastic");
+	m_culledObjects = 0;
+	UpdateTileTextures(packet);
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+	if (WriteFrameBlocks(packet) == false)
+	{
+		return;
+	}
 
-	SetShaderTexture("ground_2");
-	SetTransformations(
-		scaleXYZ*0.4f,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ + glm::vec3(0.0f, 0.01f, -70.0f)
-	);
-	m_basicMeshes->DrawPlaneMesh();
+	// the texture is set into the shader again each frame
+	m_boundTextureSlot = g_UnknownTextureSlot;
 
-	/****************************************************************/
-	// here is where all the components go, be sure to give them the correct locations
-	
-	// hill
-	SetTransformations(
-		glm::vec3(30.0f, 30.0f, 30.0f),
-		0, 180.0f, 90.0f,
-		glm::vec3(0.0f, -20.0f, -200.0f)
-	);
-	SetShaderTexture("ground_1");
-	m_basicMeshes->DrawSphereMesh();
+	int pass = -1;
+	for (size_t i = 0; i < m_scene.objects.size(); i++)
+	{
+		const SCENE_OBJECT& object = m_scene.objects[i];
 
+		// the objects are stored in pass order
+		if (object.pass != pass)
+		{
+			if (pass >= 0)
+			{
+				EndRenderPass();
+			}
+			pass = object.pass;
+			BeginRenderPass(g_RenderPassNames[pass]);
+		}
 
-	// trees
-	Tree(glm::vec3(0.0f, 10.0f, -200.0f), 0);
-	for (int i = 0; i < 5; i++) {
-		Tree(glm::vec3(-25.0f, 0.0f, -40.0f - 40.0f * i),0);
-		Tree(glm::vec3(-60.0f, 0.0f, -60.0f - 36.0f * i),0);
-		Tree(glm::vec3(25.0f, 0.0f, -30.0f - 50.0f * i), 0);
-		Tree(glm::vec3(60.0f, 0.0f, -50.0f - 44.0f * i), 0);
+		// skip the whole object when it is hidden behind an occluder
+		if (packet.visibleObjects[i] == 0)
+		{
+			m_culledObjects++;
+			RenderStats::CountCulledObject();
+			continue;
+		}
+
+		for (int draw = object.firstDraw; draw < object.firstDraw + object.drawCount; draw++)
+		{
+			DrawRecord(m_scene.drawRecords[draw], m_drawOffsets[draw]);
+		}
 	}
-	
-	// right row of lamp posts
-	for (int i = 0; i < 9; i++) {
-		LampPost(glm::vec3(22.0f, 0.0f, -12.0f-20.0f*i)); // testing lamp in center for demo, pushed back a bit so that the top is visible
+	if (pass >= 0)
+	{
+		EndRenderPass();
 	}
-	// left row of lamp posts
-	for (int i = 0; i < 9; i++) {
-		LampPost(glm::vec3(-22.0f, 0.0f, -16.0f - 20.0f * i));
+
+	// the tiles are timed together and drawn a pass at a time
+	// across all of them, so the blended passes still come last
+	if (packet.tiles.empty() == false)
+	{
+		BeginRenderPass(g_TilePassName);
+		m_tileNextObjects.assign(packet.tiles.size(), 0);
+		for (pass = 0; pass < g_RenderPassCount; pass++)
+		{
+			size_t firstObject = m_scene.objects.size();
+			size_t firstDraw = m_scene.drawRecords.size();
+			for (size_t tile = 0; tile < packet.tiles.size(); tile++)
+			{
+				// the objects of a tile are stored in pass order
+				const SCENE_CONTENT& content = packet.tiles[tile]->content;
+				int& next = m_tileNextObjects[tile];
+				for (; (next < (int)content.objects.size()) && (content.objects[next].pass == pass); next++)
+				{
+					if (packet.visibleObjects[firstObject + next] == 0)
+					{
+						m_culledObjects++;
+						RenderStats::CountCulledObject();
+						continue;
+					}
+
+					const SCENE_OBJECT& object = content.objects[next];
+					for (int draw = object.firstDraw; draw < object.firstDraw + object.drawCount; draw++)
+					{
+						DrawRecord(content.drawRecords[draw], m_drawOffsets[firstDraw + draw]);
+					}
+				}
+				firstObject += content.objects.size();
+				firstDraw += content.drawRecords.size();
+			}
+		}
+		EndRenderPass();
 	}
 
-	// right and left side fences
-	for (int i = 30; i >= 0; i--) {
-		Fence(glm::vec3(20.0f, 0.0f, -4.0f * i));
-		Fence(glm::vec3(-20.0f, 0.0f, -4.0f * i));
+	m_pStreamingBuffer->EndFrame();
+}
+
+/***********************************************************
+ *  SetSoftwareRasterizer()
+ *
+ *  This method is used to draw the frames with a software
+ *  rasterizer.  The images of the scene's textures are
+ *  decoded once and set into the rasterizer's units, and
+ *  the textures of the tiles are set as the frames fill
+ *  their units.
+ ***********************************************************/
+void SceneManager::SetSoftwareRasterizer(SoftwareRasterizer* pRasterizer)
+{
+	for (size_t i = 0; i < m_softwareImages.size(); i++)
+	{
+		stbi_image_free(m_softwareImages[i]);
+	}
+	m_softwareImages.clear();
+	m_pSoftwareRasterizer = pRasterizer;
+	if (NULL == pRasterizer)
+	{
+		return;
 	}
 
+	const int slotCount = sizeof(m_softwareTextures) / sizeof(m_softwareTextures[0]);
+	for (int slot = 0; slot < slotCount; slot++)
+	{
+		m_softwareTextures[slot] = ShadingModel::TEXTURE();
+		pRasterizer->SetTexture(slot, NULL);
+		if (LoadTextureImage(slot, m_softwareTextures[slot]) == true)
+		{
+			m_softwareImages.push_back((unsigned char*)m_softwareTextures[slot].pixels);
+			pRasterizer->SetTexture(slot, &m_softwareTextures[slot]);
+		}
+	}
+}
 
-	// right side benches
-	for (int i = 5; i >= 0 ; i--) {
-		for (int j = 4; j >= 0; j--) {
-			Bench(glm::vec3(17.0f, 0.0f, -17.0f-4.0f*j-30.0f*i));
+/***********************************************************
+ *  RasterizeFrame()
+ *
+ *  This method is used to queue a prepared frame on the
+ *  software rasterizer, as DrawFrame() draws it with OpenGL
+ *  - the scene objects in pass order, then the objects of
+ *  the tiles a pass at a time, with the culled objects left
+ *  out.  The tile texture units are freed and filled first.
+ ***********************************************************/
+void SceneManager::RasterizeFrame(const FRAME_PACKET& packet)
+{
+	PROFILE_FUNCTION();
+
+	if (NULL == m_pSoftwareRasterizer)
+	{
+		return;
+	}
+
+	m_culledObjects = 0;
+	for (size_t i = 0; i < packet.textureReleases.size(); i++)
+	{
+		int unit = packet.textureReleases[i];
+		m_softwareTextures[unit] = ShadingModel::TEXTURE();
+		m_pSoftwareRasterizer->SetTexture(unit, NULL);
+	}
+	for (size_t i = 0; i < packet.textureUploads.size(); i++)
+	{
+		const TEXTURE_UPLOAD& upload = packet.textureUploads[i];
+		ShadingModel::TEXTURE& texture = m_softwareTextures[upload.unit];
+		texture.pixels = upload.pixels;
+		texture.width = upload.width;
+		texture.height = upload.height;
+		texture.channels = upload.channels;
+		m_pSoftwareRasterizer->SetTexture(upload.unit, &texture);
+	}
+
+	SoftwareRasterizer::CAMERA camera;
+	camera.view = packet.view;
+	camera.projection = packet.projection;
+	camera.viewPosition = packet.viewPosition;
+	m_pSoftwareRasterizer->SetCamera(camera);
+	SoftwareRasterizer::LIGHTS lights;
+	GetShadingLights(packet.lights, lights);
+	m_pSoftwareRasterizer->SetLights(lights);
+
+	RasterizeContent(m_scene, packet.worldMatrices.data(), packet.visibleObjects.data(), 0, (int)m_scene.objects.size());
+
+	// the blended passes of the tiles still come last
+	m_tileNextObjects.assign(packet.tiles.size(), 0);
+	for (int pass = 0; pass < g_RenderPassCount; pass++)
+	{
+		size_t firstObject = m_scene.objects.size();
+		for (size_t tile = 0; tile < packet.tiles.size(); tile++)
+		{
+			const SCENE_CONTENT& content = packet.tiles[tile]->content;
+			int& next = m_tileNextObjects[tile];
+			int first = next;
+			while ((next < (int)content.objects.size()) && (content.objects[next].pass == pass))
+			{
+				next++;
+			}
+			RasterizeContent(
+				content,
+				content.transforms.GetWorldMatrices(),
+				packet.visibleObjects.data() + firstObject,
+				first,
+				next - first);
+			firstObject += content.objects.size();
 		}
 	}
+}
 
-	// left side benches
-	for (int i = 5; i >= 0; i--) {
-		for (int j = 4; j >= 0; j--) {
-			Bench(glm::vec3(-17.0f, 0.0f, -10.0f - 4.0f * j - 30.0f * i),true);
+/***********************************************************
+ *  RasterizeContent()
+ *
+ *  This method is used to queue the parts of a range of
+ *  objects on the software rasterizer, each with its color
+ *  or texture unit and its material.  Parts drawn as lines
+ *  are left out, like for tracing.
+ ***********************************************************/
+void SceneManager::RasterizeContent(
+	const SCENE_CONTENT& content,
+	const glm::mat4* worldMatrices,
+	const unsigned char* visibleObjects,
+	int firstObject,
+	int objectCount)
+{
+	for (int i = firstObject; i < firstObject + objectCount; i++)
+	{
+		if (visibleObjects[i] == 0)
+		{
+			m_culledObjects++;
+			RenderStats::CountCulledObject();
+			continue;
+		}
+
+		const SCENE_OBJECT& object = content.objects[i];
+		for (int draw = object.firstDraw; draw < object.firstDraw + object.drawCount; draw++)
+		{
+			const DRAW_RECORD& record = content.drawRecords[draw];
+			const std::vector<glm::vec3>& corners = m_basicMeshes->GetMeshTriangles(record.mesh);
+			if ((record.bLines == true) || (corners.empty() == true))
+			{
+				continue;
+			}
+
+			const MATERIAL_BLOCK& material = content.materialBlocks[record.material];
+			SoftwareRasterizer::SURFACE surface;
+			surface.texture = record.textureSlot;
+			surface.color = record.color;
+			surface.diffuseColor = glm::vec3(material.diffuseColor);
+			surface.specularColor = material.specularColor;
+			surface.shininess = material.shininess;
+
+			m_pSoftwareRasterizer->Draw(
+				worldMatrices[record.transform],
+				corners.data(),
+				m_basicMeshes->GetMeshNormals(record.mesh).data(),
+				m_basicMeshes->GetMeshTextureCoordinates(record.mesh).data(),
+				(int)corners.size(),
+				surface);
+			RenderStats::CountDraw(record.mesh, GL_TRIANGLES, (int)corners.size());
 		}
 	}
+}
 
-	// leaves
-	for (int i = 0; i < 8; i++) {
-		SetShaderTexture("ground_2");
-		SetTransformations(
-			glm::vec3(150.0f , 1.0f, 100.0f),
-			-90.0f,
-			0,
-			180.0f,
-			glm::vec3(i*10.0f*cos(i*95.0f), 100.0f, -200.0f + 30.0f * i)
-		);
-		m_basicMeshes->DrawPlaneMesh();
+/***********************************************************
+ *  OpenWorld()
+ *
+ *  This method is used to stream the tiles of a world file
+ *  around the camera, once the scene is prepared.  The tiles
+ *  closer than the load radius are loaded nearest first, as
+ *  long as they fit into the memory budget.
+ ***********************************************************/
+bool SceneManager::OpenWorld(const std::string& filename, float loadRadius, size_t memoryBudget)
+{
+	if (NULL != m_pTileStreamer)
+	{
+		std::cout << "A world is already open" << std::endl;
+		return false;
+	}
+
+	TileStreamer* pStreamer = new TileStreamer();
+	if (pStreamer->OpenWorld(filename.c_str()) == false)
+	{
+		delete pStreamer;
+		return false;
+	}
+	pStreamer->SetLoadRadius(loadRadius);
+	pStreamer->SetMemoryBudget(memoryBudget);
+
+	// the tiles are built on the streaming thread by the same
+	// functions that build the scene
+	pStreamer->Start(
+		[this](const std::string& tileFilename, size_t& bytes) { return(LoadTile(tileFilename, bytes)); },
+		[this](void* pContent) { DestroyTile((SCENE_TILE*)pContent); });
+	m_pTileStreamer = pStreamer;
+
+	return true;
+}
+
+/***********************************************************
+ *  LoadTile()
+ *
+ *  This method is used to build a tile from its scene file
+ *  on the streaming thread.  The tile starts with the scene's
+ *  materials, which do not change once the scene is prepared,
+ *  and its textures are decoded but left for the render
+ *  thread to upload.  The tiles never move, so their world
+ *  matrices are built here once.
+ ***********************************************************/
+void* SceneManager::LoadTile(const std::string& filename, size_t& bytes)
+{
+	PROFILE_FUNCTION();
+
+	SceneReader reader;
+	if (reader.Open(filename.c_str()) == false)
+	{
+		return(NULL);
+	}
+
+	SCENE_TILE* pTile = new SCENE_TILE();
+	pTile->evictedFrame = -1;
+	SCENE_BUILDER builder = { &pTile->content, pTile };
+	ClearSceneObjects(pTile->content);
+	pTile->content.materials = m_scene.materials;
+	pTile->content.materialBlocks = m_scene.materialBlocks;
+	bool bLoaded = ReadSceneRecords(builder, reader);
+
+	if (bLoaded == false)
+	{
+		DestroyTile(pTile);
+		return(NULL);
+	}
+	pTile->content.transforms.Update();
+	UpdateObjectHierarchy(pTile->content, NULL);
+
+	bytes = sizeof(SCENE_TILE) +
+		pTile->content.objects.size() * sizeof(SCENE_OBJECT) +
+		pTile->content.drawRecords.size() * sizeof(DRAW_RECORD) +
+		pTile->content.transforms.GetCount() * g_TransformBytes +
+		pTile->content.hierarchy.GetNodeCount() * sizeof(BoundingVolumeHierarchy::NODE) +
+		pTile->content.cullableObjects.size() * g_CullableObjectBytes;
+	for (size_t i = 0; i < pTile->textures.size(); i++)
+	{
+		const SCENE_TILE::TEXTURE_IMAGE& image = pTile->textures[i];
+		bytes += (size_t)image.width * image.height * image.channels;
+	}
+
+	return(pTile);
+}
+
+/***********************************************************
+ *  LoadTileTexture()
+ *
+ *  This method is used to decode a texture image that the
+ *  tile being loaded defines.  The flip is set for the
+ *  streaming thread only.
+ ***********************************************************/
+bool SceneManager::LoadTileTexture(SCENE_TILE* pTile, const char* filename, std::string tag)
+{
+	SCENE_TILE::TEXTURE_IMAGE image;
+	stbi_set_flip_vertically_on_load_thread(true);
+	image.pixels = stbi_load(filename, &image.width, &image.height, &image.channels, 0);
+	if (NULL == image.pixels)
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return false;
+	}
+	if ((image.channels != 3) && (image.channels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << image.channels << " channels" << std::endl;
+		stbi_image_free(image.pixels);
+		return false;
+	}
+
+	image.tag = tag;
+	image.unit = -1;
+	pTile->textures.push_back(image);
+	return true;
+}
+
+/***********************************************************
+ *  DestroyTile()
+ *
+ *  This method is used to free a tile along with its
+ *  decoded texture images.
+ ***********************************************************/
+void SceneManager::DestroyTile(SCENE_TILE* pTile)
+{
+	for (size_t i = 0; i < pTile->textures.size(); i++)
+	{
+		stbi_image_free(pTile->textures[i].pixels);
+	}
+	delete pTile;
+}
+
+/***********************************************************
+ *  UpdateTiles()
+ *
+ *  This method is used to move the tiles for the camera of
+ *  the packet.  The tiles that arrived are given texture
+ *  units and drawn from this frame on, and the evicted ones
+ *  are no longer drawn but only freed once the frames in
+ *  flight that draw them are done.
+ ***********************************************************/
+void SceneManager::UpdateTiles(FRAME_PACKET& packet)
+{
+	PROFILE_FUNCTION();
+
+	m_pTileStreamer->Update(packet.viewPosition, m_arrivedTiles, m_leavingTiles);
+
+	for (size_t i = 0; i < m_arrivedTiles.size(); i++)
+	{
+		SCENE_TILE* pTile = (SCENE_TILE*)m_arrivedTiles[i];
+		AssignTileTextures(pTile);
+		m_residentTiles.push_back(pTile);
+	}
+	for (size_t i = 0; i < m_leavingTiles.size(); i++)
+	{
+		SCENE_TILE* pTile = (SCENE_TILE*)m_leavingTiles[i];
+		ReleaseTileTextures(pTile);
+		pTile->evictedFrame = packet.frame;
+		m_residentTiles.erase(std::find(m_residentTiles.begin(), m_residentTiles.end(), pTile));
+		m_evictedTiles.push_back(pTile);
+	}
+
+	// a tile evicted in frame E is in no packet from E on, and
+	// once frame E + PACKET_COUNT is prepared every packet
+	// before E has been drawn
+	for (size_t i = 0; i < m_evictedTiles.size();)
+	{
+		if (packet.frame >= m_evictedTiles[i]->evictedFrame + RenderThread::PACKET_COUNT)
+		{
+			DestroyTile(m_evictedTiles[i]);
+			m_evictedTiles[i] = m_evictedTiles.back();
+			m_evictedTiles.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	packet.tiles.assign(m_residentTiles.begin(), m_residentTiles.end());
+	packet.textureReleases.assign(m_pendingTextureReleases.begin(), m_pendingTextureReleases.end());
+	packet.textureUploads.assign(m_pendingTextureUploads.begin(), m_pendingTextureUploads.end());
+	m_pendingTextureReleases.clear();
+	m_pendingTextureUploads.clear();
+}
+
+/***********************************************************
+ *  AssignTileTextures()
+ *
+ *  This method is used to give the textures of an arrived
+ *  tile the texture units above the scene's textures.  The
+ *  tiles share a unit for a texture with the same tag, and a
+ *  texture is uploaded when it takes a free unit.  The parts
+ *  were given slots for the tile's own textures, which are
+ *  replaced by the units - a part whose texture found no unit
+ *  is drawn with its color.
+ ***********************************************************/
+void SceneManager::AssignTileTextures(SCENE_TILE* pTile)
+{
+	const int unitCount = sizeof(m_tileTextureUnits) / sizeof(m_tileTextureUnits[0]);
+	for (size_t i = 0; i < pTile->textures.size(); i++)
+	{
+		SCENE_TILE::TEXTURE_IMAGE& image = pTile->textures[i];
+		int freeUnit = -1;
+		image.unit = -1;
+		for (int unit = m_loadedTextures; (unit < unitCount) && (image.unit < 0); unit++)
+		{
+			if ((m_tileTextureUnits[unit].references > 0) && (m_tileTextureUnits[unit].tag.compare(image.tag) == 0))
+			{
+				image.unit = unit;
+			}
+			else if ((m_tileTextureUnits[unit].references == 0) && (freeUnit < 0))
+			{
+				freeUnit = unit;
+			}
+		}
+
+		if ((image.unit < 0) && (freeUnit >= 0))
+		{
+			image.unit = freeUnit;
+			m_tileTextureUnits[freeUnit].tag = image.tag;
+			TEXTURE_UPLOAD upload;
+			upload.unit = freeUnit;
+			upload.pixels = image.pixels;
+			upload.width = image.width;
+			upload.height = image.height;
+			upload.channels = image.channels;
+			m_pendingTextureUploads.push_back(upload);
+		}
+
+		if (image.unit >= 0)
+		{
+			m_tileTextureUnits[image.unit].references++;
+		}
+		else
+		{
+			std::cout << "Could not give a tile texture a unit, all are used:" << image.tag << std::endl;
+		}
+	}
+
+	std::vector<DRAW_RECORD>& drawRecords = pTile->content.drawRecords;
+	for (size_t i = 0; i < drawRecords.size(); i++)
+	{
+		if (drawRecords[i].textureSlot >= g_TileTextureSlot)
+		{
+			drawRecords[i].textureSlot = pTile->textures[drawRecords[i].textureSlot - g_TileTextureSlot].unit;
+		}
 	}
+}
+
+/***********************************************************
+ *  ReleaseTileTextures()
+ *
+ *  This method is used to take the texture units back from
+ *  an evicted tile.  A unit that no resident tile uses is
+ *  freed by the next frame, and an upload into it that no
+ *  frame has made yet is dropped.
+ ***********************************************************/
+void SceneManager::ReleaseTileTextures(SCENE_TILE* pTile)
+{
+	for (size_t i = 0; i < pTile->textures.size(); i++)
+	{
+		int unit = pTile->textures[i].unit;
+		if ((unit < 0) || (--m_tileTextureUnits[unit].references > 0))
+		{
+			continue;
+		}
 
+		m_tileTextureUnits[unit].tag.clear();
+		for (size_t upload = 0; upload < m_pendingTextureUploads.size();)
+		{
+			if (m_pendingTextureUploads[upload].unit == unit)
+			{
+				m_pendingTextureUploads.erase(m_pendingTextureUploads.begin() + upload);
+			}
+			else
+			{
+				upload++;
+			}
+		}
+		m_pendingTextureReleases.push_back(unit);
+	}
 }
 
+/***********************************************************
+ *  UpdateTileTextures()
+ *
+ *  This method is used to free and fill the tile texture
+ *  units of a frame before it is drawn.  A filled texture
+ *  stays bound to its unit, like the scene's textures.
+ ***********************************************************/
+void SceneManager::UpdateTileTextures(const FRAME_PACKET& packet)
+{
+	for (size_t i = 0; i < packet.textureReleases.size(); i++)
+	{
+		GLuint& textureID = m_tileTextureIDs[packet.textureReleases[i]];
+		if (textureID != 0)
+		{
+			glDeleteTextures(1, &textureID);
+			textureID = 0;
+		}
+	}
+
+	for (size_t i = 0; i < packet.textureUploads.size(); i++)
+	{
+		const TEXTURE_UPLOAD& upload = packet.textureUploads[i];
+		GLuint& textureID = m_tileTextureIDs[upload.unit];
+		if (textureID != 0)
+		{
+			glDeleteTextures(1, &textureID);
+		}
 
+		glGenTextures(1, &textureID);
+		glActiveTexture(GL_TEXTURE0 + upload.unit);
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		if (upload.channels == 3)
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, upload.width, upload.height, 0, GL_RGB, GL_UNSIGNED_BYTE, upload.pixels);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, upload.width, upload.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, upload.pixels);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		RenderStats::CountTextureBind();
+	}
+}
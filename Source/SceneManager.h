@@ -11,6 +11,17 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "OcclusionCuller.h"
+#include "GpuTimer.h"
+#include "TransformSystem.h"
+#include "JobSystem.h"
+#include "FramePacket.h"
+#include "StreamingBuffer.h"
+#include "SceneFile.h"
+#include "TileStreamer.h"
+#include "BoundingVolumeHierarchy.h"
+#include "RayTracer.h"
+#include "SoftwareRasterizer.h"
 
 #include <string>
 #include <vector>
@@ -33,6 +44,8 @@ public:
 	{
 		std::string tag;
 		uint32_t ID;
+		// image file, read again for tracing the scene
+		std::string filename;
 	};
 
 	struct OBJECT_MATERIAL
@@ -43,6 +56,162 @@ public:
 		std::string tag;
 	};
 
+	// one draw call of a scene object
+	struct DRAW_RECORD
+	{
+		// transform that places the mesh in the world
+		int transform;
+		ShapeMeshes::MeshType mesh;
+		bool bLines;
+		// texture slot, or -1 to draw with the color
+		int textureSlot;
+		glm::vec4 color;
+		// index of the material in the defined materials
+		int material;
+	};
+
+	// the parts of a lamp post, bench, tree, etc. that are
+	// culled and drawn together
+	struct SCENE_OBJECT
+	{
+		// transform that the parts are placed under
+		int transform;
+		// index of the render pass the object is drawn in
+		int pass;
+		// bounds relative to the object's position, tested
+		// against the occluders when bCullable is set
+		glm::vec3 minCorner;
+		glm::vec3 maxCorner;
+		bool bCullable;
+		// range of the object's parts in the draw records
+		int firstDraw;
+		int drawCount;
+	};
+
+	// std140 layouts of the shader's uniform blocks - a vec3 is
+	// padded to a vec4 unless a scalar fills its last slot
+	struct CAMERA_BLOCK
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec4 viewPosition;
+		// view-projection of this frame and of the frame drawn
+		// before it, both without the jitter, for the velocity
+		glm::mat4 viewProjection;
+		glm::mat4 previousViewProjection;
+	};
+
+	struct DIRECTIONAL_LIGHT_BLOCK
+	{
+		glm::vec4 direction;
+		glm::vec4 ambient;
+		glm::vec4 diffuse;
+		glm::vec3 specular;
+		int bActive;
+	};
+
+	struct SPOT_LIGHT_BLOCK
+	{
+		glm::vec4 position;
+		glm::vec3 direction;
+		float cutOff;
+		float outerCutOff;
+		float constant;
+		float linear;
+		float quadratic;
+		glm::vec4 ambient;
+		glm::vec4 diffuse;
+		glm::vec3 specular;
+		int bActive;
+	};
+
+	struct LIGHT_BLOCK
+	{
+		DIRECTIONAL_LIGHT_BLOCK directionalLight;
+		SPOT_LIGHT_BLOCK spotLight;
+	};
+
+	struct MATERIAL_BLOCK
+	{
+		glm::vec4 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+	};
+
+	struct OBJECT_BLOCK
+	{
+		glm::mat4 model;
+		// world matrix of the part in the frame drawn before
+		glm::mat4 previousModel;
+		glm::vec4 objectColor;
+		MATERIAL_BLOCK material;
+	};
+
+	// the scene objects with their parts, transforms and materials
+	// - the scene built by PrepareScene() and every streamed tile
+	// of a world have their own
+	struct SCENE_CONTENT
+	{
+		// transforms of the scene objects and all of their parts
+		TransformSystem transforms;
+		// scene objects in drawing order and the draw calls of their parts
+		std::vector<SCENE_OBJECT> objects;
+		std::vector<DRAW_RECORD> drawRecords;
+		// defined object materials and the values written into the
+		// object blocks for each of them
+		std::vector<OBJECT_MATERIAL> materials;
+		std::vector<MATERIAL_BLOCK> materialBlocks;
+		// texture slot, color and material given to the parts added next
+		int textureSlot;
+		glm::vec4 color;
+		int material;
+		// tree over the world space bounds of the objects that can
+		// be culled, and the object of each of its instances
+		BoundingVolumeHierarchy hierarchy;
+		std::vector<int> cullableObjects;
+		std::vector<glm::vec3> objectMinCorners;
+		std::vector<glm::vec3> objectMaxCorners;
+	};
+
+	// what the object functions add to - the content of the scene,
+	// or of a tile being loaded on the streaming thread along with
+	// the tile, which is NULL for the scene
+	struct SCENE_BUILDER
+	{
+		SCENE_CONTENT* pContent;
+		SCENE_TILE* pTile;
+	};
+
+	// a texture unit above the scene's textures that holds a
+	// texture of the resident tiles
+	struct TILE_TEXTURE_UNIT
+	{
+		std::string tag;
+		// resident tiles that use the texture
+		int references;
+	};
+
+	// the nearest part of a scene object hit by a ray
+	struct PICK_RESULT
+	{
+		// resident tile that holds the object, or -1 for the
+		// scene added by PrepareScene()
+		int tile;
+		// the object, and the draw record of its part, in the
+		// lists of the scene or the tile
+		int object;
+		int part;
+		// render pass of the object, like "lamps" or "trees"
+		const char* passName;
+		ShapeMeshes::MeshType mesh;
+		// triangle of the part's mesh, in the order of
+		// ShapeMeshes::GetMeshTriangles()
+		int triangle;
+		// distance along the ray and world space position of the hit
+		float distance;
+		glm::vec3 position;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
@@ -52,8 +221,70 @@ private:
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
-	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// software depth buffer for skipping hidden objects
+	OcclusionCuller* m_pOcclusionCuller;
+	// true when objects are tested against the occluders
+	bool m_bOcclusionCulling;
+	// number of objects skipped during the last drawn frame
+	int m_culledObjects;
+	// optional timer for the GPU time of each render pass
+	GpuTimer* m_pGpuTimer;
+	// scene objects added by PrepareScene()
+	SCENE_CONTENT m_scene;
+	// texture slot last set into the shader
+	int m_boundTextureSlot;
+	// optional job system that prepares each frame before drawing
+	JobSystem* m_pJobSystem;
+	// scene file loaded by PrepareScene(), or empty for the
+	// built in park
+	std::string m_sceneFilename;
+	// counts the changes of the transforms, so a frame packet
+	// only copies the world matrices when they changed
+	int m_transformVersion;
+	// lights of the next prepared frame
+	SCENE_LIGHTS m_lights;
+	// light values written into each frame's blocks
+	LIGHT_BLOCK m_lightBlock;
+	// ring of uniform buffer regions that the blocks of each
+	// frame are written into
+	StreamingBuffer* m_pStreamingBuffer;
+	// offsets of the object blocks of the frame being drawn,
+	// one for each draw record of the scene and then of the tiles
+	std::vector<GLintptr> m_drawOffsets;
+	// world matrices and view-projection of the frame drawn
+	// last, which the velocity of the next frame is measured
+	// from - the matrices are copied only when they changed
+	std::vector<glm::mat4> m_drawnWorldMatrices;
+	int m_drawnTransformVersion;
+	glm::mat4 m_drawnViewProjection;
+	bool m_bFrameDrawn;
+	// optional streamer for the tiles of a world
+	TileStreamer* m_pTileStreamer;
+	// tiles handed to the frames, and evicted tiles that are
+	// freed once no frame in flight draws them
+	std::vector<SCENE_TILE*> m_residentTiles;
+	std::vector<SCENE_TILE*> m_evictedTiles;
+	// tiles handed back by the streamer each frame
+	std::vector<void*> m_arrivedTiles;
+	std::vector<void*> m_leavingTiles;
+	// texture units shared by the resident tiles, and the changes
+	// to them that the next frame makes before drawing
+	TILE_TEXTURE_UNIT m_tileTextureUnits[16];
+	std::vector<int> m_pendingTextureReleases;
+	std::vector<TEXTURE_UPLOAD> m_pendingTextureUploads;
+	// textures in the tile texture units and the next object of
+	// each tile to draw, only used by the thread that draws the
+	// frames
+	GLuint m_tileTextureIDs[16];
+	std::vector<int> m_tileNextObjects;
+	// instances of a hierarchy found inside the frustum
+	std::vector<int> m_frustumInstances;
+	// optional rasterizer that draws the frames on the CPU in
+	// place of OpenGL, with the decoded images of the scene's
+	// textures and the textures of its units
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+	std::vector<unsigned char*> m_softwareImages;
+	ShadingModel::TEXTURE m_softwareTextures[16];
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
@@ -65,25 +296,14 @@ private:
 	void DestroyGLTextures();
 	// find a loaded texture by tag
 	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	// also searching the textures of a tile being loaded
+	int FindTextureSlot(std::string tag, const SCENE_TILE* pTile = NULL);
 	// find a defined material by tag
 	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
-
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
-
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
+	int FindMaterialIndex(const SCENE_CONTENT& content, std::string tag);
+	// define a material of the content, replacing one with the
+	// same tag
+	void AddObjectMaterial(SCENE_CONTENT& content, const OBJECT_MATERIAL& material);
 
 	// set the texture data into the shader
 	void SetShaderTexture(
@@ -93,25 +313,218 @@ private:
 	void SetTextureUVScale(
 		float u, float v);
 
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
+	// my object functions - they add the objects to the content
+	// of the builder
+	void LampPost(SCENE_BUILDER& builder, glm::vec3 translation, bool use_lines = false);
+	void Bench(SCENE_BUILDER& builder, glm::vec3 pos,bool facing_left = false);
+	void Fence(SCENE_BUILDER& builder, glm::vec3 pos);
+	void Tree(SCENE_BUILDER& builder, glm::vec3 pos, float angle);
+	void Branch(SCENE_BUILDER& builder, glm::vec3 base, glm::vec3 rot, int recursions_left = 1);
 
-	// my object functions
-	void LampPost(glm::vec3 translation, bool use_lines = false);
-	void Bench(glm::vec3 pos,bool facing_left = false);
-	void Fence(glm::vec3 pos);
-	void Tree(glm::vec3 pos, float angle);
-	void Branch(glm::vec3 base, glm::vec3 rot, int recursions_left = 1);
+	// remove all of the scene objects of the content
+	void ClearSceneObjects(SCENE_CONTENT& content);
+	// add all of the scene objects
+	void DefineSceneObjects();
+	// add the scene objects and occluders of a scene file
+	bool LoadSceneFile(const char* filename);
+	// add the records of an open scene file to the content of
+	// the builder
+	bool ReadSceneRecords(SCENE_BUILDER& builder, SceneReader& reader);
+	// add one record of a scene file to the content of the builder
+	bool AddSceneRecord(SCENE_BUILDER& builder, const SCENE_RECORD& record, const SceneReader& reader);
+	// start a new scene object at the passed in position - the
+	// bounds are only used when the object can be culled
+	void BeginSceneObject(
+		SCENE_BUILDER& builder,
+		int pass,
+		glm::vec3 position,
+		bool bCullable = false,
+		glm::vec3 minCorner = glm::vec3(0.0f),
+		glm::vec3 maxCorner = glm::vec3(0.0f));
+	// set the texture or color of the parts added next
+	void SetObjectTexture(SCENE_BUILDER& builder, std::string textureTag);
+	void SetObjectColor(SCENE_BUILDER& builder, glm::vec4 color);
+	// set the material of the parts added next
+	void SetObjectMaterial(SCENE_BUILDER& builder, std::string materialTag);
+	// add a part to the current scene object, positioned
+	// relative to the object
+	void AddObjectMesh(
+		SCENE_BUILDER& builder,
+		ShapeMeshes::MeshType mesh,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		bool bLines = false);
+	// bind the object block of a part, set its texture and draw it
+	void DrawRecord(const DRAW_RECORD& record, GLintptr objectOffset);
+	// write the camera, light and object blocks of a frame into
+	// the streaming buffer and bind the blocks shared by all draws
+	bool WriteFrameBlocks(const FRAME_PACKET& packet);
+	// write the object blocks of the visible objects of one content
+	void WriteObjectBlocks(
+		const SCENE_CONTENT& content,
+		const glm::mat4* worldMatrices,
+		const glm::mat4* previousWorldMatrices,
+		const unsigned char* visibleObjects,
+		GLintptr* drawOffsets);
+
+	// build a tile from its scene file, run by the streaming thread
+	void* LoadTile(const std::string& filename, size_t& bytes);
+	// decode a texture image of the tile being loaded
+	bool LoadTileTexture(SCENE_TILE* pTile, const char* filename, std::string tag);
+	// free a tile and its texture images
+	void DestroyTile(SCENE_TILE* pTile);
+	// take the tiles the streamer loaded and evicted, and hand
+	// the resident tiles to the packet
+	void UpdateTiles(FRAME_PACKET& packet);
+	// give the textures of an arrived tile texture units, and
+	// take them back from an evicted tile
+	void AssignTileTextures(SCENE_TILE* pTile);
+	void ReleaseTileTextures(SCENE_TILE* pTile);
+	// free and fill the tile texture units of a frame
+	void UpdateTileTextures(const FRAME_PACKET& packet);
 
 	void DefineObjectMaterials();
 	void SetupSceneLights();
 
+	// register the large objects that hide the rest of the scene
+	void DefineSceneOccluders();
+	// test an object's world space bounds against the occluders
+	bool IsObjectOccluded(glm::vec3 minCorner, glm::vec3 maxCorner) const;
+	// build or refit the hierarchy of a content to the world
+	// space bounds of its objects
+	void UpdateObjectHierarchy(SCENE_CONTENT& content, JobSystem* pJobSystem);
+	// mark the objects of the frame whose bounds are inside the
+	// frustum, using the hierarchies
+	void CullSceneFrustum(FRAME_PACKET& packet);
+	// test the passed in range of the frame's objects against
+	// the occluders - ranges can be tested at the same time
+	void CullSceneObjects(FRAME_PACKET& packet, int first, int count);
+	// find the nearest part of the objects of a content that a
+	// ray hits nearer than the passed in distance
+	bool PickContentObject(
+		const SCENE_CONTENT& content,
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& distance,
+		PICK_RESULT& result) const;
+	// find the nearest triangle of the parts of one object that
+	// a ray hits nearer than the passed in distance
+	bool IntersectObjectParts(
+		const SCENE_CONTENT& content,
+		int object,
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& distance,
+		int& part,
+		int& triangle) const;
+	// add the filled parts of the objects of a content to a ray
+	// tracer, with the tracer's texture for each texture slot
+	void AddTracedContent(RayTracer& tracer, const SCENE_CONTENT& content, const int* tracedTextures) const;
+	// decode the image file of a loaded texture again, with the
+	// first row at the bottom - free it with stbi_image_free()
+	bool LoadTextureImage(int slot, ShadingModel::TEXTURE& texture) const;
+	// the light values of the light block for the passed in
+	// lights, as the CPU renderers shade with them
+	void GetShadingLights(const SCENE_LIGHTS& sceneLights, ShadingModel::LIGHTS& lights) const;
+	// queue the filled parts of a range of the objects of one
+	// content on the software rasterizer, skipping the culled ones
+	void RasterizeContent(
+		const SCENE_CONTENT& content,
+		const glm::mat4* worldMatrices,
+		const unsigned char* visibleObjects,
+		int firstObject,
+		int objectCount);
+
+	// mark the start and end of a named group of draw calls
+	void BeginRenderPass(const char* name);
+	void EndRenderPass();
+
 public:
 
 	// The following methods are for the students to 
 	// customize for their own 3D scene
 	void PrepareScene();
-	void RenderScene();
+	// load the scene from the passed in file instead of the
+	// built in park - must be set before PrepareScene()
+	void SetSceneFile(const std::string& filename);
+	// cull the scene for the view of the passed in packet and
+	// fill in the rest of it - no OpenGL calls are made
+	void PrepareFrame(FRAME_PACKET& packet);
+	// draw a prepared frame on the thread that owns the context
+	void DrawFrame(const FRAME_PACKET& packet);
+	// draw the frames with the passed in rasterizer on the CPU
+	// instead, or with OpenGL again when it is NULL - must be set
+	// after PrepareScene() and before the first frame
+	void SetSoftwareRasterizer(SoftwareRasterizer* pRasterizer);
+	// queue the parts of a prepared frame on the software
+	// rasterizer in the order DrawFrame() draws them, for the
+	// caller to clear before and finish after
+	void RasterizeFrame(const FRAME_PACKET& packet);
+	// stream the tiles of a world file around the camera, with
+	// the scene prepared by PrepareScene() drawn underneath
+	bool OpenWorld(const std::string& filename, float loadRadius, size_t memoryBudget);
+	// find the nearest scene object hit by a world space ray and
+	// the triangle of its part - only objects with bounds can be
+	// picked, and only between frames on the preparing thread
+	bool PickObject(const glm::vec3& origin, const glm::vec3& direction, PICK_RESULT& result) const;
+	// trace an image of the scene and the resident tiles with the
+	// current lights on the CPU, into width * height RGB pixels
+	// with the top row first - called between frames like picking
+	bool TraceReferenceImage(
+		const RayTracer::CAMERA& camera,
+		const glm::vec3& background,
+		int width,
+		int height,
+		unsigned char* pPixels,
+		RayTracer::STATISTICS& statistics) const;
+
+	// turn the software occlusion culling on or off
+	void SetOcclusionCulling(bool bEnabled);
+	// time the render passes with the passed in timer, or
+	// stop timing them when it is NULL
+	void SetGpuTimer(GpuTimer* pGpuTimer);
+	// prepare the frames on the passed in job system, or on the
+	// calling thread when it is NULL
+	void SetJobSystem(JobSystem* pJobSystem);
+	// number of objects that were culled during the last frame
+	int GetCulledObjectCount() const { return(m_culledObjects); }
+	// transforms of the scene objects, for moving them between frames
+	TransformSystem* GetTransforms() { return(&m_scene.transforms); }
+	// lights that can be moved between frames
+	SCENE_LIGHTS* GetLights() { return(&m_lights); }
+	// buffer that the per-frame shader data is streamed through
+	const StreamingBuffer* GetStreamingBuffer() const { return(m_pStreamingBuffer); }
+	// streamer of the world's tiles, or NULL without a world
+	const TileStreamer* GetTileStreamer() const { return(m_pTileStreamer); }
+
+};
+
+/***********************************************************
+ *  SCENE_TILE
+ *
+ *  This structure contains one streamed tile of a world.  It
+ *  is built on the streaming thread with its textures decoded
+ *  but not uploaded, and is only read once it is resident.
+ ***********************************************************/
+struct SCENE_TILE
+{
+	// image of a texture that the tile defines
+	struct TEXTURE_IMAGE
+	{
+		std::string tag;
+		unsigned char* pixels;
+		int width;
+		int height;
+		int channels;
+		// texture unit the image was given, or -1
+		int unit;
+	};
 
+	SceneManager::SCENE_CONTENT content;
+	std::vector<TEXTURE_IMAGE> textures;
+	// frame in which the tile was evicted
+	int evictedFrame;
 };
\ No newline at end of file
@@ -0,0 +1,276 @@
+///////////////////////////////////////////////////////////////////////////////
+// servicemode.cpp
+// ============
+// keep the scene loaded and render the views that clients ask for over a
+// Unix domain socket
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RunModes.h"
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <climits>          // INT_MAX
+#include <fstream>          // service statistics output
+#include <sstream>          // service statistics output
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "OffscreenContext.h"
+#include "RenderTarget.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "FrameReadback.h"
+#include "RenderServer.h"
+#include "SoftwareRasterizer.h"
+
+// declaration of the global variables and defines
+namespace
+{
+	// image sizes whose framebuffers the render service keeps
+	const int g_MaxServiceTargets = 4;
+
+	// framebuffer and readback ring of one image size that the
+	// render service drew into lately
+	struct SERVICE_TARGET
+	{
+		RenderTarget renderTarget;
+		FrameReadback readback;
+		// number of the batch that last drew into it
+		long long lastBatch;
+	};
+
+	// what the render service keeps between batches
+	struct SERVICE_STATE
+	{
+		std::vector<SERVICE_TARGET*> targets;
+		// rasterizer of the software requests, created by the
+		// first one
+		SoftwareRasterizer* pRasterizer = nullptr;
+		long long batch = 0;
+		int threadCount = 0;
+		bool bSoftwareDefault = false;
+		// the tile textures of a streamed world are only kept
+		// current for the renderer that draws the frames, so the
+		// requests may not switch to the other one
+		bool bWorld = false;
+		FRAME_MEASUREMENTS measurements;
+	};
+}
+
+void RenderServiceBatch(const std::vector<RenderServer::REQUEST*>& requests, RenderServer& server, SERVICE_STATE& state);
+SERVICE_TARGET* GetServiceTarget(
+	SERVICE_STATE& state,
+	int width,
+	int height,
+	const FrameReadback::CONSUME_FUNCTION& consume);
+
+/***********************************************************
+ *	RunService()
+ *
+ *  This function is used to load the scene once and then
+ *  render the views that clients ask for over a Unix domain
+ *  socket, until one of them asks the service to shut down.
+ *  The requests that arrive while a batch is drawn make up
+ *  the next batch.
+ ***********************************************************/
+int RunService(const APP_OPTIONS& options)
+{
+	OffscreenContext context;
+	if (StartHeadless(options, context) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	SERVICE_STATE state;
+	state.threadCount = options.threadCount;
+	state.bSoftwareDefault = options.bSoftwareRenderer;
+	state.bWorld = (options.worldPath.empty() == false);
+	state.pRasterizer = g_SoftwareRasterizer;
+	state.measurements.firstFrame = INT_MAX;
+	// the rasterizer only draws the requests that ask for it
+	g_SoftwareRasterizer = NULL;
+
+	RenderServer server;
+	if (server.Start(options.servicePath.c_str(), options.bSoftwareRenderer) == false)
+	{
+		g_SoftwareRasterizer = state.pRasterizer;
+		DestroyManagers();
+		context.Destroy();
+		return(EXIT_FAILURE);
+	}
+	std::cout << "Rendering views for the requests on " << options.servicePath << std::endl;
+
+	std::vector<RenderServer::REQUEST*> requests;
+	while (server.TakeRequests(requests, options.serviceBatch, 100) == true)
+	{
+		if (requests.empty() == false)
+		{
+			RenderServiceBatch(requests, server, state);
+		}
+	}
+
+	std::ostringstream statistics;
+	server.WriteStatistics(statistics);
+	server.Stop();
+	std::cout << statistics.str() << std::endl;
+	if (options.outputPath.empty() == false)
+	{
+		std::ofstream outputFile(options.outputPath);
+		outputFile << statistics.str() << std::endl;
+	}
+	if (options.tracePath.empty() == false)
+	{
+		Profiler::WriteChromeTrace(options.tracePath.c_str());
+	}
+
+	for (size_t i = 0; i < state.targets.size(); i++)
+	{
+		delete state.targets[i];
+	}
+	g_SoftwareRasterizer = state.pRasterizer;
+	DestroyManagers();
+	context.Destroy();
+
+	return(EXIT_SUCCESS);
+}
+
+/***********************************************************
+ *	RenderServiceBatch()
+ *
+ *  This function is used to draw a batch of requested views.
+ *  The OpenGL views are all drawn and their copies queued
+ *  before any of them is read back, so the GPU works through
+ *  the whole batch without the CPU waiting in between, and
+ *  each request is completed as its pixels arrive.  The
+ *  software views are drawn and completed one at a time.
+ ***********************************************************/
+void RenderServiceBatch(const std::vector<RenderServer::REQUEST*>& requests, RenderServer& server, SERVICE_STATE& state)
+{
+	PROFILE_FUNCTION();
+
+	state.batch++;
+	FrameReadback::CONSUME_FUNCTION consume = [&requests, &server](int index, const unsigned char* pPixels) {
+		RenderServer::REQUEST* pRequest = requests[index];
+		pRequest->pixels.assign(pPixels, pPixels + (size_t)pRequest->width * pRequest->height * 4);
+		server.CompleteRequest(pRequest);
+	};
+
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		RenderServer::REQUEST* pRequest = requests[i];
+		g_ViewManager->SetCameraPose(pRequest->position, pRequest->yaw, pRequest->pitch);
+		g_ViewManager->SetViewSize(pRequest->width, pRequest->height);
+		g_ViewManager->SetViewRegion(pRequest->regionX, pRequest->regionY, pRequest->frameWidth, pRequest->frameHeight);
+		g_SceneManager->SetOcclusionCulling(pRequest->bOcclusionCulling);
+
+		if ((state.bWorld == true) && (pRequest->bSoftware != state.bSoftwareDefault))
+		{
+			pRequest->error = "the renderer cannot be switched while a world is streamed";
+			server.CompleteRequest(pRequest);
+			continue;
+		}
+		if (pRequest->bSoftware == true)
+		{
+			if (NULL == state.pRasterizer)
+			{
+				CreateSoftwareRasterizer(pRequest->width, pRequest->height, state.threadCount);
+				state.pRasterizer = g_SoftwareRasterizer;
+			}
+			g_SoftwareRasterizer = state.pRasterizer;
+			if (((g_SoftwareRasterizer->GetWidth() != pRequest->width) ||
+				(g_SoftwareRasterizer->GetHeight() != pRequest->height)) &&
+				(g_SoftwareRasterizer->Resize(pRequest->width, pRequest->height) == false))
+			{
+				pRequest->error = "the software rasterizer cannot draw that size";
+			}
+			else
+			{
+				PrepareFramePacket(g_FramePacket);
+				DrawFramePacket(g_FramePacket);
+				pRequest->pixels.resize((size_t)pRequest->width * pRequest->height * 4);
+				g_SoftwareRasterizer->ReadColors(pRequest->pixels.data());
+			}
+			g_SoftwareRasterizer = NULL;
+			server.CompleteRequest(pRequest);
+			RenderStats::EndFrame(0.0);
+			continue;
+		}
+
+		SERVICE_TARGET* pTarget = GetServiceTarget(state, pRequest->width, pRequest->height, consume);
+		if (NULL == pTarget)
+		{
+			pRequest->error = "could not create a framebuffer of that size";
+			server.CompleteRequest(pRequest);
+			continue;
+		}
+		pTarget->lastBatch = state.batch;
+		pTarget->renderTarget.Bind();
+		PrepareFramePacket(g_FramePacket);
+		DrawFramePacket(g_FramePacket);
+		pTarget->readback.ReadFrame((int)i, consume);
+		pTarget->readback.CollectFrames(false, consume);
+		CollectGpuTimes(state.measurements, false);
+		RenderStats::EndFrame(0.0);
+	}
+
+	for (size_t i = 0; i < state.targets.size(); i++)
+	{
+		state.targets[i]->readback.CollectFrames(true, consume);
+	}
+	if (state.targets.empty() == false)
+	{
+		state.targets[0]->renderTarget.Unbind();
+	}
+	g_SceneManager->SetOcclusionCulling(true);
+}
+
+/***********************************************************
+ *	GetServiceTarget()
+ *
+ *  This function is used to find the framebuffer of an
+ *  image size, or create it.  Only a few sizes are kept, and
+ *  the one drawn into longest ago makes room for a new one,
+ *  once the frames it still copies are read back.
+ ***********************************************************/
+SERVICE_TARGET* GetServiceTarget(
+	SERVICE_STATE& state,
+	int width,
+	int height,
+	const FrameReadback::CONSUME_FUNCTION& consume)
+{
+	for (size_t i = 0; i < state.targets.size(); i++)
+	{
+		if ((state.targets[i]->renderTarget.GetWidth() == width) &&
+			(state.targets[i]->renderTarget.GetHeight() == height))
+		{
+			return(state.targets[i]);
+		}
+	}
+
+	if ((int)state.targets.size() >= g_MaxServiceTargets)
+	{
+		size_t oldest = 0;
+		for (size_t i = 1; i < state.targets.size(); i++)
+		{
+			if (state.targets[i]->lastBatch < state.targets[oldest]->lastBatch)
+			{
+				oldest = i;
+			}
+		}
+		state.targets[oldest]->readback.CollectFrames(true, consume);
+		delete state.targets[oldest];
+		state.targets.erase(state.targets.begin() + oldest);
+	}
+
+	SERVICE_TARGET* pTarget = new SERVICE_TARGET();
+	pTarget->lastBatch = state.batch;
+	if ((pTarget->renderTarget.Create(width, height) == false) ||
+		(pTarget->readback.Create(width, height) == false))
+	{
+		delete pTarget;
+		return(NULL);
+	}
+	state.targets.push_back(pTarget);
+	return(pTarget);
+}
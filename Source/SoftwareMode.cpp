@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwaremode.cpp
+// ============
+// draw the frames with the software rasterizer in place of OpenGL, and
+// compare its frames with the OpenGL ones
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RunModes.h"
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // std::abs
+#include <algorithm>
+#include <vector>
+
+#include <GL/glew.h>        // GLEW library
+
+#include "SceneManager.h"
+#include "JobSystem.h"
+#include "SoftwareRasterizer.h"
+
+/***********************************************************
+ *	CreateSoftwareRasterizer()
+ *
+ *  This function is used to create the software rasterizer
+ *  that draws the frames in place of OpenGL, with its own
+ *  threads, and hand it to the scene manager.
+ ***********************************************************/
+void CreateSoftwareRasterizer(int width, int height, int threadCount)
+{
+	g_SoftwareRasterizer = new SoftwareRasterizer();
+	g_SoftwareRasterizer->Resize(width, height);
+	g_RasterJobSystem = new JobSystem(threadCount);
+	g_SceneManager->SetSoftwareRasterizer(g_SoftwareRasterizer);
+	std::cout << "Drawing frames on the CPU on " << g_RasterJobSystem->GetThreadCount()
+		<< " threads with " << SoftwareRasterizer::GetInstructionSet() << std::endl;
+}
+
+/***********************************************************
+ *	ReadFrameImage()
+ *
+ *  This function is used to read the last drawn frame as RGB
+ *  pixels with the top row first, from the software
+ *  rasterizer when it draws the frames and from the bound
+ *  framebuffer otherwise.
+ ***********************************************************/
+void ReadFrameImage(int width, int height, std::vector<unsigned char>& pixels)
+{
+	pixels.resize((size_t)width * height * 3);
+	if (NULL != g_SoftwareRasterizer)
+	{
+		g_SoftwareRasterizer->ReadPixels(pixels.data());
+		return;
+	}
+
+	// OpenGL reads the bottom row first
+	std::vector<unsigned char> rows(pixels.size());
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rows.data());
+	size_t rowBytes = (size_t)width * 3;
+	for (int y = 0; y < height; y++)
+	{
+		std::copy(
+			rows.begin() + (size_t)(height - 1 - y) * rowBytes,
+			rows.begin() + (size_t)(height - y) * rowBytes,
+			pixels.begin() + (size_t)y * rowBytes);
+	}
+}
+
+/***********************************************************
+ *	CompareWithGL()
+ *
+ *  This function is used to prepare one more frame of the
+ *  current view, draw it with the software rasterizer and
+ *  with OpenGL into the bound framebuffer, and write how far
+ *  the two images differ as one JSON object - the mean
+ *  difference of the color channels, and the share of the
+ *  pixels with a channel more than 16 apart.
+ ***********************************************************/
+bool CompareWithGL(int width, int height, std::ostream& output)
+{
+	if (NULL == g_SoftwareRasterizer)
+	{
+		return false;
+	}
+
+	PrepareFramePacket(g_FramePacket);
+	std::vector<unsigned char> softwarePixels;
+	DrawFramePacket(g_FramePacket);
+	ReadFrameImage(width, height, softwarePixels);
+
+	// the same packet drawn with OpenGL
+	SoftwareRasterizer* pRasterizer = g_SoftwareRasterizer;
+	g_SoftwareRasterizer = NULL;
+	std::vector<unsigned char> glPixels;
+	DrawFramePacket(g_FramePacket);
+	glFinish();
+	ReadFrameImage(width, height, glPixels);
+	g_SoftwareRasterizer = pRasterizer;
+
+	long long difference = 0;
+	long long differentPixels = 0;
+	for (size_t i = 0; i < softwarePixels.size(); i += 3)
+	{
+		int largest = 0;
+		for (int channel = 0; channel < 3; channel++)
+		{
+			int channelDifference = std::abs((int)softwarePixels[i + channel] - (int)glPixels[i + channel]);
+			difference += channelDifference;
+			largest = std::max(largest, channelDifference);
+		}
+		differentPixels += (largest > 16) ? 1 : 0;
+	}
+
+	double meanDifference = (double)difference / std::max(softwarePixels.size(), (size_t)1);
+	double differentShare = (double)differentPixels / std::max((double)width * height, 1.0);
+	std::cout << "Compared the software frame with OpenGL: mean difference " << meanDifference
+		<< ", " << differentShare * 100.0 << "% of the pixels more than 16 apart" << std::endl;
+
+	output << "{\"mean_difference\":" << meanDifference
+		<< ",\"different_pixels\":" << differentShare << "}";
+	return true;
+}
+
+/***********************************************************
+ *	WriteSoftwareResults()
+ *
+ *  This function is used to write the counters of the last
+ *  software frame and the triangles drawn per second over
+ *  the measured frames as one JSON object.
+ ***********************************************************/
+void WriteSoftwareResults(const FRAME_MEASUREMENTS& measurements, std::ostream& output)
+{
+	const SoftwareRasterizer::STATISTICS& statistics = g_SoftwareRasterizer->GetStatistics();
+	double trianglesPerSecond = (double)measurements.softwareTriangles /
+		std::max(measurements.softwareMilliseconds / 1000.0, 1e-9);
+	std::cout << "Software rasterizer: " << trianglesPerSecond / 1.0e6 << " Mtri/s on "
+		<< statistics.threads << " threads with " << SoftwareRasterizer::GetInstructionSet() << std::endl;
+
+	output << "{\"instructions\":\"" << SoftwareRasterizer::GetInstructionSet() << "\""
+		<< ",\"threads\":" << statistics.threads
+		<< ",\"tile_size\":" << SoftwareRasterizer::TILE_SIZE
+		<< ",\"tiles\":" << statistics.tiles
+		<< ",\"draws\":" << statistics.draws
+		<< ",\"triangles\":" << statistics.triangles
+		<< ",\"setup_triangles\":" << statistics.setupTriangles
+		<< ",\"binned_triangles\":" << statistics.binnedTriangles
+		<< ",\"shaded_pixels\":" << statistics.shadedPixels
+		<< ",\"bin_ms\":" << statistics.binMilliseconds
+		<< ",\"raster_ms\":" << statistics.rasterMilliseconds
+		<< ",\"mtri_per_second\":" << trianglesPerSecond / 1.0e6 << "}";
+}
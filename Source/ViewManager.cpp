@@ -8,6 +8,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "Profiler.h"
+
+#include <cmath>
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
@@ -21,8 +24,6 @@ namespace
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -36,6 +37,11 @@ namespace
 	// time between current frame and last frame
 	float gDeltaTime = 0.0f; 
 	float gLastFrame = 0.0f;
+	// time step used when there is no display window to
+	// take input from, so every rendered frame is the same
+	const float g_OffscreenDeltaTime = 1.0f / 60.0f;
+	// shortest time between two recorded camera keys
+	const float g_RecordInterval = 1.0f / 60.0f;
 
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
@@ -53,11 +59,34 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_viewWidth = WINDOW_WIDTH;
+	m_viewHeight = WINDOW_HEIGHT;
+	m_regionX = 0;
+	m_regionY = 0;
+	m_frameWidth = 0;
+	m_frameHeight = 0;
+	m_projectionJitter = glm::vec2(0.0f);
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_bTraceKeyDown = false;
+	m_bStatsKeyDown = false;
+	m_bStatsExportRequested = false;
+	m_bCursorCaptured = true;
+	m_bCursorKeyDown = false;
+	m_bPickRequested = false;
+	m_pickX = 0.0f;
+	m_pickY = 0.0f;
+	m_bRecording = false;
+	m_recordTime = 0.0f;
+	m_bReplaying = false;
+	m_replayTime = 0.0f;
+	m_replayTimeStep = g_OffscreenDeltaTime;
 	g_pCamera = new Camera();
-	// default camera view parameters
+	// default camera view parameters - the front is set through
+	// the Euler angles so recorded paths start from the same view
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
-	g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
-	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+	g_pCamera->SetEulerAngles(-90.0f, glm::degrees(atan2f(-0.5f, 2.0f)));
 	g_pCamera->Zoom = 80;
 	g_pCamera->MovementSpeed = 20;
 }
@@ -69,6 +98,12 @@ ViewManager::ViewManager(
  ***********************************************************/
 ViewManager::~ViewManager()
 {
+	// keep a recording that was not stopped explicitly
+	if (m_bRecording == true)
+	{
+		StopRecording();
+	}
+
 	// free up allocated memory
 	m_pShaderManager = NULL;
 	m_pWindow = NULL;
@@ -107,6 +142,8 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 
 	// this callback is used to receive mouse moving events
 	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
+	// this callback is used to receive mouse clicks for picking
+	glfwSetMouseButtonCallback(window, &ViewManager::Mouse_Button_Callback);
 
 	// this callback is used to recieve window moving evnets
 	glfwSetWindowUserPointer(window, this);
@@ -129,6 +166,264 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	return(window);
 }
 
+/***********************************************************
+ *  CreateOffscreenView()
+ *
+ *  This method is used to set up the view when the scene is
+ *  rendered into an offscreen framebuffer with no display
+ *  window, using the same render state as the window.
+ ***********************************************************/
+void ViewManager::CreateOffscreenView(int width, int height)
+{
+	m_pWindow = NULL;
+	m_viewWidth = width;
+	m_viewHeight = height;
+
+	// enable blending for supporting tranparent rendering
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+/***********************************************************
+ *  StartRecording()
+ *
+ *  This method is used to start sampling the camera position
+ *  and orientation every frame.  The path is written to the
+ *  passed in file by StopRecording().
+ ***********************************************************/
+void ViewManager::StartRecording(const char* filename)
+{
+	m_cameraPath.Clear();
+	m_recordFilename = filename;
+	m_recordTime = 0.0f;
+	m_bRecording = true;
+	m_bReplaying = false;
+}
+
+/***********************************************************
+ *  StopRecording()
+ *
+ *  This method is used to stop recording the camera and
+ *  save the recorded path.
+ ***********************************************************/
+bool ViewManager::StopRecording()
+{
+	if (m_bRecording == false)
+	{
+		return false;
+	}
+	m_bRecording = false;
+
+	// always keep the last view, even when it was sampled
+	// sooner than the record interval
+	m_cameraPath.AddKey(m_recordTime, g_pCamera->Position, g_pCamera->Yaw, g_pCamera->Pitch);
+
+	return(m_cameraPath.SaveToFile(m_recordFilename.c_str()));
+}
+
+/***********************************************************
+ *  StartReplay()
+ *
+ *  This method is used to load a recorded camera path and
+ *  drive the camera from it.  Every prepared frame advances
+ *  the path by the passed in time step, regardless of how
+ *  long the frame took, so every replay shows the same views.
+ ***********************************************************/
+bool ViewManager::StartReplay(const char* filename, float timeStep)
+{
+	if ((timeStep <= 0.0f) || (m_cameraPath.LoadFromFile(filename) == false))
+	{
+		return false;
+	}
+
+	m_bRecording = false;
+	m_bReplaying = true;
+	m_replayTime = 0.0f;
+	m_replayTimeStep = timeStep;
+	is_ortho = false;
+
+	std::cout << "Replaying " << m_cameraPath.GetKeyCount() << " camera keys over "
+		<< m_cameraPath.GetDuration() << " seconds" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  IsReplayFinished()
+ *
+ *  This method is used to check whether the frame at the end
+ *  of the replayed path has been prepared.
+ ***********************************************************/
+bool ViewManager::IsReplayFinished() const
+{
+	if (m_bReplaying == false)
+	{
+		return true;
+	}
+
+	return(m_replayTime > m_cameraPath.GetDuration() + m_replayTimeStep * 0.5f);
+}
+
+/***********************************************************
+ *  GetReplayFrameCount()
+ *
+ *  This method is used to get the number of frames that a
+ *  replay of the loaded path will render.
+ ***********************************************************/
+int ViewManager::GetReplayFrameCount() const
+{
+	if (m_bReplaying == false)
+	{
+		return 0;
+	}
+
+	return((int)(m_cameraPath.GetDuration() / m_replayTimeStep + 0.5f) + 1);
+}
+
+/***********************************************************
+ *  SetViewSize()
+ *
+ *  This method is used to change the size the projection is
+ *  set up for, when views of different sizes are rendered
+ *  without a window.
+ ***********************************************************/
+void ViewManager::SetViewSize(int width, int height)
+{
+	m_viewWidth = width;
+	m_viewHeight = height;
+}
+
+/***********************************************************
+ *  SetViewRegion()
+ *
+ *  This method is used to make the view show one rectangle
+ *  of a larger frame.  The projection of the whole frame is
+ *  narrowed to the rectangle, so the tiles of a frame drawn
+ *  one at a time fit together without seams.
+ ***********************************************************/
+void ViewManager::SetViewRegion(int x, int y, int frameWidth, int frameHeight)
+{
+	m_regionX = x;
+	m_regionY = y;
+	m_frameWidth = frameWidth;
+	m_frameHeight = frameHeight;
+}
+
+/***********************************************************
+ *  SetProjectionJitter()
+ *
+ *  This method is used to offset the projection of the next
+ *  prepared frames by a fraction of a pixel, for upscaling
+ *  that gathers the samples of several frames.
+ ***********************************************************/
+void ViewManager::SetProjectionJitter(const glm::vec2& jitter)
+{
+	m_projectionJitter = jitter;
+}
+
+/***********************************************************
+ *  SetCameraPose()
+ *
+ *  This method is used to move and turn the camera to a
+ *  pose, the way a replayed path does for each frame.
+ ***********************************************************/
+void ViewManager::SetCameraPose(const glm::vec3& position, float yaw, float pitch)
+{
+	g_pCamera->Position = position;
+	g_pCamera->SetEulerAngles(yaw, pitch);
+	is_ortho = false;
+}
+
+/***********************************************************
+ *  TakeStatsExportRequest()
+ *
+ *  This method is used to check whether the render statistics
+ *  should be written since the last check.  The statistics
+ *  belong to the thread that draws the frames, so the key
+ *  only asks for them to be written.
+ ***********************************************************/
+bool ViewManager::TakeStatsExportRequest()
+{
+	bool bRequested = m_bStatsExportRequested;
+	m_bStatsExportRequested = false;
+	return(bRequested);
+}
+
+/***********************************************************
+ *  GetPickRay()
+ *
+ *  This method is used to get the world space ray through a
+ *  position in the window, measured from the top left corner,
+ *  with the view and projection of the last prepared frame.
+ *  The ray starts on the near plane and its direction has a
+ *  length of 1.
+ ***********************************************************/
+void ViewManager::GetPickRay(float x, float y, glm::vec3& origin, glm::vec3& direction) const
+{
+	glm::mat4 inverseViewProjection = glm::inverse(m_projectionMatrix * m_viewMatrix);
+	float ndcX = 2.0f * x / (float)m_viewWidth - 1.0f;
+	float ndcY = 1.0f - 2.0f * y / (float)m_viewHeight;
+
+	// the far plane is very far away, so the second point is
+	// taken halfway into the depth range to keep its precision
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 depthPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 0.0f, 1.0f);
+	origin = glm::vec3(nearPoint) / nearPoint.w;
+	direction = glm::normalize(glm::vec3(depthPoint) / depthPoint.w - origin);
+}
+
+/***********************************************************
+ *  TakePickRequest()
+ *
+ *  This method is used to check whether the scene was clicked
+ *  since the last check, and to get the ray through the
+ *  clicked position.  While the mouse turns the camera the
+ *  cursor is hidden, so the center of the view is picked.
+ ***********************************************************/
+bool ViewManager::TakePickRequest(glm::vec3& origin, glm::vec3& direction)
+{
+	if (m_bPickRequested == false)
+	{
+		return false;
+	}
+	m_bPickRequested = false;
+
+	GetPickRay(m_pickX, m_pickY, origin, direction);
+	return true;
+}
+
+/***********************************************************
+ *  Mouse_Button_Callback()
+ *
+ *  This method is automatically called from GLFW whenever a
+ *  mouse button is pressed or released within the active
+ *  GLFW display window.  A left click asks for the object
+ *  under the cursor to be picked.
+ ***********************************************************/
+void ViewManager::Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods)
+{
+	ViewManager* pViewManager = static_cast<ViewManager*>(glfwGetWindowUserPointer(window));
+	if ((NULL == pViewManager) || (button != GLFW_MOUSE_BUTTON_LEFT) || (action != GLFW_PRESS))
+	{
+		return;
+	}
+
+	if (pViewManager->m_bCursorCaptured == true)
+	{
+		pViewManager->m_pickX = pViewManager->m_viewWidth / 2.0f;
+		pViewManager->m_pickY = pViewManager->m_viewHeight / 2.0f;
+	}
+	else
+	{
+		double xCursorPos = 0.0;
+		double yCursorPos = 0.0;
+		glfwGetCursorPos(window, &xCursorPos, &yCursorPos);
+		pViewManager->m_pickX = (float)xCursorPos;
+		pViewManager->m_pickY = (float)yCursorPos;
+	}
+	pViewManager->m_bPickRequested = true;
+}
+
 /***********************************************************
  *  Mouse_Position_Callback()
  *
@@ -155,6 +450,13 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 	gLastX = xMousePos;
 	gLastY = yMousePos;
 
+	// a free cursor is used for picking and leaves the camera
+	ViewManager* pViewManager = static_cast<ViewManager*>(glfwGetWindowUserPointer(window));
+	if ((NULL != pViewManager) && (pViewManager->m_bCursorCaptured == false))
+	{
+		return;
+	}
+
 	// move the 3D camera according to the calculated offsets
 	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
 }
@@ -167,6 +469,8 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
  ***********************************************************/
 void ViewManager::ProcessKeyboardEvents()
 {
+	PROFILE_FUNCTION();
+
 	// close the window if the escape key has been pressed
 	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 	{
@@ -212,48 +516,133 @@ void ViewManager::ProcessKeyboardEvents()
 	{
 		is_ortho = true;
 	}
+
+	// write the profiler trace once each time F12 is pressed
+	bool bTraceKeyDown = (glfwGetKey(m_pWindow, GLFW_KEY_F12) == GLFW_PRESS);
+	if ((bTraceKeyDown == true) && (m_bTraceKeyDown == false))
+	{
+		Profiler::WriteChromeTrace("profile_trace.json");
+	}
+	m_bTraceKeyDown = bTraceKeyDown;
+
+	// write the render statistics history once each time F11 is pressed
+	bool bStatsKeyDown = (glfwGetKey(m_pWindow, GLFW_KEY_F11) == GLFW_PRESS);
+	if ((bStatsKeyDown == true) && (m_bStatsKeyDown == false))
+	{
+		m_bStatsExportRequested = true;
+	}
+	m_bStatsKeyDown = bStatsKeyDown;
+
+	// free the cursor for picking, or capture it again for
+	// turning the camera, once each time C is pressed
+	bool bCursorKeyDown = (glfwGetKey(m_pWindow, GLFW_KEY_C) == GLFW_PRESS);
+	if ((bCursorKeyDown == true) && (m_bCursorKeyDown == false))
+	{
+		m_bCursorCaptured = !m_bCursorCaptured;
+		glfwSetInputMode(m_pWindow, GLFW_CURSOR, m_bCursorCaptured ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
+		// the cursor jumps when it is captured again
+		gFirstMouse = true;
+	}
+	m_bCursorKeyDown = bCursorKeyDown;
 }
 
 /***********************************************************
  *  PrepareSceneView()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for preparing the view of the next
+ *  frame from the input or the replayed path.  It does not
+ *  make any OpenGL calls, so it can run while the render
+ *  thread draws the previous frame.
  ***********************************************************/
 void ViewManager::PrepareSceneView()
 {
-	glm::mat4 view;
-	glm::mat4 persp;
-	glm::mat4 ortho;
+	PROFILE_FUNCTION();
 
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
+	if (NULL != m_pWindow)
+	{
+		// per-frame timing
+		float currentFrame = glfwGetTime();
+		gDeltaTime = currentFrame - gLastFrame;
+		gLastFrame = currentFrame;
 
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
+		// process any keyboard events that may be waiting in the 
+		// event queue
+		ProcessKeyboardEvents();
+	}
+	else
+	{
+		// without a window there is no input, so use a fixed step
+		gDeltaTime = g_OffscreenDeltaTime;
+	}
+
+	if (m_bReplaying == true)
+	{
+		// the recorded path replaces any user input
+		glm::vec3 position;
+		float yaw = 0.0f;
+		float pitch = 0.0f;
+		gDeltaTime = m_replayTimeStep;
+		m_cameraPath.Sample(m_replayTime, position, yaw, pitch);
+		g_pCamera->Position = position;
+		g_pCamera->SetEulerAngles(yaw, pitch);
+		m_replayTime += m_replayTimeStep;
+	}
+	else if (m_bRecording == true)
+	{
+		// the first prepared frame is at time zero - its delta
+		// includes the time spent loading the scene
+		if (m_cameraPath.GetKeyCount() == 0)
+		{
+			m_recordTime = 0.0f;
+			m_cameraPath.AddKey(m_recordTime, g_pCamera->Position, g_pCamera->Yaw, g_pCamera->Pitch);
+		}
+		else
+		{
+			m_recordTime += gDeltaTime;
+			if (m_recordTime - m_cameraPath.GetDuration() >= g_RecordInterval)
+			{
+				m_cameraPath.AddKey(m_recordTime, g_pCamera->Position, g_pCamera->Yaw, g_pCamera->Pitch);
+			}
+		}
+	}
 
 	// get the current view matrix from the camera
-	view = g_pCamera->GetViewMatrix();
+	m_viewMatrix = g_pCamera->GetViewMatrix();
+	m_viewPosition = g_pCamera->Position;
+
+	// a region of a larger frame is projected as part of it
+	bool bRegion = (m_frameWidth > 0) && (m_frameHeight > 0);
+	GLfloat frameWidth = bRegion ? (GLfloat)m_frameWidth : (GLfloat)m_viewWidth;
+	GLfloat frameHeight = bRegion ? (GLfloat)m_frameHeight : (GLfloat)m_viewHeight;
 
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
+	// define the selected projection matrix
+	if (is_ortho) {
+		float ORTHO_ZOOM = 50.0f;
+		m_projectionMatrix = glm::ortho(-frameWidth/ORTHO_ZOOM, frameWidth/ORTHO_ZOOM, -frameHeight/ ORTHO_ZOOM, frameHeight/ ORTHO_ZOOM,-1000.0f,1000.0f);
+	} else {
+		m_projectionMatrix = glm::perspective(glm::radians(g_pCamera->Zoom), frameWidth / frameHeight, 0.1f, 100000.0f);
+	}
+
+	if (bRegion == true)
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// define and set the selected projection matrix into the shader for proper rendering
-		if (is_ortho) {
-			float ORTHO_ZOOM = 50.0f;
-			ortho = glm::ortho(-(GLfloat)WINDOW_WIDTH/ORTHO_ZOOM, (GLfloat)WINDOW_WIDTH/ORTHO_ZOOM, -(GLfloat)WINDOW_HEIGHT/ ORTHO_ZOOM, (GLfloat)WINDOW_HEIGHT/ ORTHO_ZOOM,-1000.0f,1000.0f);
-			m_pShaderManager->setMat4Value(g_ProjectionName, ortho);
-		} else {
-			persp = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100000.0f);
-			m_pShaderManager->setMat4Value(g_ProjectionName, persp);
-		}
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		// scale and move the region's part of the normalized
+		// device coordinates to fill them - the rows of the
+		// region count down from the top of the frame
+		glm::mat4 crop(1.0f);
+		crop[0][0] = frameWidth / (GLfloat)m_viewWidth;
+		crop[1][1] = frameHeight / (GLfloat)m_viewHeight;
+		crop[3][0] = (frameWidth - 2.0f * m_regionX - m_viewWidth) / (GLfloat)m_viewWidth;
+		crop[3][1] = -(frameHeight - 2.0f * m_regionY - m_viewHeight) / (GLfloat)m_viewHeight;
+		m_projectionMatrix = crop * m_projectionMatrix;
 	}
-}
\ No newline at end of file
+
+	if ((m_projectionJitter.x != 0.0f) || (m_projectionJitter.y != 0.0f))
+	{
+		// move the whole view by the jitter after the projection,
+		// so every pixel is sampled at the same offset
+		glm::mat4 jitter(1.0f);
+		jitter[3][0] = m_projectionJitter.x;
+		jitter[3][1] = m_projectionJitter.y;
+		m_projectionMatrix = jitter * m_projectionMatrix;
+	}
+}
@@ -11,6 +11,9 @@
 
 #include "ShaderManager.h"
 #include "camera.h"
+#include "CameraPath.h"
+
+#include <string>
 
 // GLFW library
 #include "GLFW/glfw3.h" 
@@ -26,6 +29,8 @@ public:
 
 	// mouse position callback for mouse interaction with the 3D scene
 	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
+	// mouse button callback for picking objects in the 3D scene
+	static void Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods);
 
 private:
 	// pointer to shader manager object
@@ -34,6 +39,43 @@ private:
 	GLFWwindow* m_pWindow;
 	float speed = 100.0f;
 	bool is_ortho = false;
+	// size of the area the scene is projected into
+	int m_viewWidth;
+	int m_viewHeight;
+	// part of a larger frame that the view shows, with the
+	// top left corner at x, y - an empty frame shows all of it
+	int m_regionX;
+	int m_regionY;
+	int m_frameWidth;
+	int m_frameHeight;
+	// sub-pixel offset of the projection in normalized device
+	// coordinates
+	glm::vec2 m_projectionJitter;
+	// view and projection matrices used for the last prepared frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::vec3 m_viewPosition;
+	// camera path being recorded or replayed
+	CameraPath m_cameraPath;
+	std::string m_recordFilename;
+	bool m_bRecording;
+	float m_recordTime;
+	bool m_bReplaying;
+	float m_replayTime;
+	float m_replayTimeStep;
+	// true while the profiler trace or statistics keys are held down
+	bool m_bTraceKeyDown;
+	bool m_bStatsKeyDown;
+	// true once the statistics key was pressed, until taken
+	bool m_bStatsExportRequested;
+	// true while the mouse turns the camera, false while the
+	// cursor is free for picking
+	bool m_bCursorCaptured;
+	bool m_bCursorKeyDown;
+	// window position clicked for picking, until taken
+	bool m_bPickRequested;
+	float m_pickX;
+	float m_pickY;
 	
 
 	// process keyboard events for interaction with the 3D scene
@@ -42,7 +84,48 @@ private:
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	// set up the view for rendering without a display window
+	void CreateOffscreenView(int width, int height);
 	
 	// prepare the conversion from 3D object display to 2D scene display
+	// for the next frame - no OpenGL calls are made
 	void PrepareSceneView();
+
+	// sample the camera every frame and save the path to a file
+	// when the recording is stopped
+	void StartRecording(const char* filename);
+	bool StopRecording();
+	// drive the camera from a recorded path with a fixed time step
+	bool StartReplay(const char* filename, float timeStep);
+	bool IsReplaying() const { return(m_bReplaying); }
+	// true once every frame of the replayed path has been prepared
+	bool IsReplayFinished() const;
+	// number of frames needed to replay the whole path
+	int GetReplayFrameCount() const;
+	// size of the area the next views are projected into
+	void SetViewSize(int width, int height);
+	// show only the view size rectangle at x, y of a larger
+	// frame, for rendering it in tiles - an empty frame size
+	// shows the whole view again
+	void SetViewRegion(int x, int y, int frameWidth, int frameHeight);
+	// move the projection of the next views by a fraction of a
+	// pixel, in normalized device coordinates, so consecutive
+	// frames sample different points of each pixel
+	void SetProjectionJitter(const glm::vec2& jitter);
+	// place the camera, for rendering a list of views - the
+	// next prepared frame is seen from it
+	void SetCameraPose(const glm::vec3& position, float yaw, float pitch);
+	// true once after the render statistics key was pressed
+	bool TakeStatsExportRequest();
+	// world space ray through a window position, for the view
+	// of the last prepared frame
+	void GetPickRay(float x, float y, glm::vec3& origin, glm::vec3& direction) const;
+	// true once after the scene was clicked, with the ray
+	// through the clicked position
+	bool TakePickRequest(glm::vec3& origin, glm::vec3& direction);
+
+	// get the matrices set up by the last call to PrepareSceneView()
+	glm::mat4 GetViewMatrix() const { return(m_viewMatrix); }
+	glm::mat4 GetProjectionMatrix() const { return(m_projectionMatrix); }
+	glm::vec3 GetViewPosition() const { return(m_viewPosition); }
 };
\ No newline at end of file
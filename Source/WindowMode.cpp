@@ -0,0 +1,246 @@
+///////////////////////////////////////////////////////////////////////////////
+// windowmode.cpp
+// ============
+// draw the 3D scene into the display window, preparing each frame while
+// the render thread draws the last one
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RunModes.h"
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <climits>          // INT_MAX
+#include <chrono>           // frame timing
+#include <string>
+
+#include <GL/glew.h>        // GLEW library
+#include <GLFW/glfw3.h>     // GLFW library
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "ShaderManager.h"
+#include "RenderThread.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "ResolutionScaler.h"
+
+// declaration of the global variables and defines
+namespace
+{
+	// Macro for window title
+	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
+
+	// Main GLFW window
+	GLFWwindow* g_Window = nullptr;
+}
+
+void PresentWindowFrame(FRAME_PACKET& packet, FRAME_MEASUREMENTS& measurements, FRAME_CLOCK& clock);
+
+/***********************************************************
+ *	RunWindow()
+ *
+ *  This function is used to create the display window and
+ *  draw the 3D scene into it, recording or replaying a
+ *  camera path when asked to, until the window is closed.
+ ***********************************************************/
+int RunWindow(const APP_OPTIONS& options)
+{
+	// if GLFW fails initialization, then terminate the application
+	if (InitializeGLFW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// try to create a new shader manager object
+	g_ShaderManager = new ShaderManager();
+	// try to create a new view manager object
+	g_ViewManager = new ViewManager(
+		g_ShaderManager);
+
+	// try to create the main display window
+	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+
+	// if GLEW fails initialization, then terminate the application
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// load the shader code from the external GLSL files
+	g_ShaderManager->LoadShaders(
+		"shaders/vertexShader.glsl",
+		"shaders/fragmentShader.glsl");
+	g_ShaderManager->use();
+
+	// try to create a new scene manager object and prepare the 3D scene
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetSceneFile(options.scenePath);
+	g_SceneManager->PrepareScene();
+	if (OpenWorld(options) == false)
+	{
+		DestroyManagers();
+		return(EXIT_FAILURE);
+	}
+	CreateGpuTimer();
+	CreateJobSystem(options.threadCount);
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	glfwGetFramebufferSize(g_Window, &framebufferWidth, &framebufferHeight);
+	if (CreateResolutionScaler(options, framebufferWidth, framebufferHeight) == false)
+	{
+		DestroyManagers();
+		return(EXIT_FAILURE);
+	}
+
+	// record or replay a camera path when asked to - only the
+	// replayed frames are kept, other frames are only timed
+	// for the profiler trace
+	FRAME_MEASUREMENTS measurements;
+	measurements.firstFrame = INT_MAX;
+	if (options.replayPath.empty() == false)
+	{
+		if (g_ViewManager->StartReplay(options.replayPath.c_str(), 1.0f / options.replayFps) == false)
+		{
+			DestroyManagers();
+			return(EXIT_FAILURE);
+		}
+		measurements.firstFrame = g_FrameNumber;
+	}
+	else if (options.recordPath.empty() == false)
+	{
+		g_ViewManager->StartRecording(options.recordPath.c_str());
+	}
+
+	// the render statistics are shown in the window title
+	FRAME_CLOCK clock;
+	clock.lastFrameEnd = std::chrono::steady_clock::now();
+	clock.lastTitleUpdate = clock.lastFrameEnd;
+
+	// from here on the render thread owns the OpenGL context and
+	// draws each frame while the next one is prepared
+	RenderThread renderThread;
+	glfwMakeContextCurrent(NULL);
+	renderThread.Start(
+		[]() { glfwMakeContextCurrent(g_Window); },
+		[&measurements, &clock](FRAME_PACKET& packet) { PresentWindowFrame(packet, measurements, clock); },
+		[]() { glfwMakeContextCurrent(NULL); });
+
+	// loop will keep running until the application is closed 
+	// or until an error has occurred
+	while (!glfwWindowShouldClose(g_Window))
+	{
+		PROFILE_SCOPE("Frame");
+
+		// query the latest GLFW events
+		{
+			PROFILE_SCOPE("glfwPollEvents");
+			glfwPollEvents();
+		}
+
+		// wait until the render thread is done with a packet,
+		// which is at most one frame behind
+		FRAME_PACKET* packet = renderThread.AcquirePacket();
+		if (packet->statusText.empty() == false)
+		{
+			glfwSetWindowTitle(g_Window, packet->statusText.c_str());
+			packet->statusText.clear();
+		}
+
+		// prepare the next frame and hand it to the render thread
+		PrepareFramePacket(*packet);
+		renderThread.SubmitPacket(packet);
+
+		// pick the object under the cursor once the scene was
+		// clicked - the render thread only reads the scene
+		glm::vec3 pickOrigin;
+		glm::vec3 pickDirection;
+		if (g_ViewManager->TakePickRequest(pickOrigin, pickDirection) == true)
+		{
+			std::cout << "Picked ";
+			PickSceneObject(pickOrigin, pickDirection, std::cout);
+			std::cout << std::endl;
+		}
+
+		// close the window at the end of the replayed path
+		if ((g_ViewManager->IsReplaying() == true) && (g_ViewManager->IsReplayFinished() == true))
+		{
+			glfwSetWindowShouldClose(g_Window, true);
+		}
+	}
+
+	// draw the frames that are still queued, then take the
+	// context back for cleaning up
+	renderThread.Stop();
+	glfwMakeContextCurrent(g_Window);
+
+	// save the recorded path and the replay results
+	g_ViewManager->StopRecording();
+	if (g_ViewManager->IsReplaying() == true)
+	{
+		CollectGpuTimes(measurements, true);
+		WriteReplayCSV(options.csvPath, measurements);
+	}
+	if (options.tracePath.empty() == false)
+	{
+		Profiler::WriteChromeTrace(options.tracePath.c_str());
+	}
+	if (options.statsPath.empty() == false)
+	{
+		RenderStats::Export(options.statsPath.c_str());
+	}
+
+	// clear the allocated manager objects from memory
+	DestroyManagers();
+
+	return(EXIT_SUCCESS);
+}
+
+/***********************************************************
+ *	PresentWindowFrame()
+ *
+ *  This function is used on the render thread to draw a
+ *  prepared frame into the window and show it.  The window
+ *  title can only be set by the main thread, so the new
+ *  title is passed back in the packet.
+ ***********************************************************/
+void PresentWindowFrame(FRAME_PACKET& packet, FRAME_MEASUREMENTS& measurements, FRAME_CLOCK& clock)
+{
+	// draw the 3D scene into the back buffer
+	std::chrono::steady_clock::time_point drawStart = std::chrono::steady_clock::now();
+	DrawFramePacket(packet);
+	if (packet.bReplayFrame == true)
+	{
+		double drawMilliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - drawStart).count();
+		RecordReplayFrame(packet, packet.prepareMilliseconds + drawMilliseconds, measurements);
+	}
+
+	// read the GPU times of earlier frames that are done
+	CollectGpuTimes(measurements, false);
+
+	// Flips the the back buffer with the front buffer every frame.
+	{
+		PROFILE_SCOPE("glfwSwapBuffers");
+		glfwSwapBuffers(g_Window);
+	}
+
+	// the frame time is measured from the end of the last frame
+	std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+	RenderStats::EndFrame(std::chrono::duration<double, std::milli>(frameEnd - clock.lastFrameEnd).count());
+	clock.lastFrameEnd = frameEnd;
+	if (frameEnd - clock.lastTitleUpdate >= std::chrono::milliseconds(500))
+	{
+		packet.statusText = std::string(WINDOW_TITLE) + " | " + RenderStats::GetOverlayText();
+		if (NULL != g_ResolutionScaler)
+		{
+			packet.statusText += " | scale " + std::to_string((int)(g_ResolutionScaler->GetScale() * 100.0f + 0.5f)) + "%";
+		}
+		clock.lastTitleUpdate = frameEnd;
+	}
+
+	if (packet.bExportStats == true)
+	{
+		RenderStats::Export("render_stats.csv");
+	}
+}
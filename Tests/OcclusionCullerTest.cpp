@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusioncullertest.cpp
+// ============
+// rasterize one known occluder with OcclusionCuller and check which boxes
+// around it are reported as hidden - returns non-zero when a check fails
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the wall the boxes are tested against - a square facing the
+	// camera, which looks down the negative z axis from the origin,
+	// and fills about the middle half of its view
+	const float g_WallHalfSize = 5.0f;
+	const float g_WallDistance = 20.0f;
+
+	// one box to test and whether it has to be reported as hidden
+	struct BOX_CASE
+	{
+		const char* name;
+		glm::vec3 minCorner;
+		glm::vec3 maxCorner;
+		bool bOccluded;
+	};
+
+	const BOX_CASE g_BoxCases[] =
+	{
+		// right behind the middle of the wall
+		{ "behind", glm::vec3(-1.0f, -1.0f, -41.0f), glm::vec3(1.0f, 1.0f, -39.0f), true },
+		// between the camera and the wall
+		{ "in front", glm::vec3(-1.0f, -1.0f, -12.0f), glm::vec3(1.0f, 1.0f, -10.0f), false },
+		// reaching through the wall, its front half is visible
+		{ "through", glm::vec3(-1.0f, -1.0f, -22.0f), glm::vec3(1.0f, 1.0f, -18.0f), false },
+		// behind the wall, but sticking out past its right edge
+		{ "right edge", glm::vec3(8.0f, -1.0f, -41.0f), glm::vec3(14.0f, 1.0f, -39.0f), false },
+		// behind the wall, but sticking out past its top edge
+		{ "top edge", glm::vec3(-1.0f, 8.0f, -41.0f), glm::vec3(1.0f, 14.0f, -39.0f), false },
+		// farther away than the wall, but beside it
+		{ "beside", glm::vec3(13.0f, -1.0f, -41.0f), glm::vec3(15.0f, 1.0f, -39.0f), false },
+		// behind the wall and just inside of its right edge
+		{ "inside edge", glm::vec3(6.0f, -1.0f, -41.0f), glm::vec3(8.0f, 1.0f, -39.0f), true },
+	};
+
+	// register the wall and render it for the camera
+	void RenderWall(OcclusionCuller& culler, int threadCount)
+	{
+		glm::vec3 lowerLeft(-g_WallHalfSize, -g_WallHalfSize, -g_WallDistance);
+		glm::vec3 lowerRight(g_WallHalfSize, -g_WallHalfSize, -g_WallDistance);
+		glm::vec3 upperRight(g_WallHalfSize, g_WallHalfSize, -g_WallDistance);
+		glm::vec3 upperLeft(-g_WallHalfSize, g_WallHalfSize, -g_WallDistance);
+
+		culler.SetThreadCount(threadCount);
+		culler.ClearOccluders();
+		culler.AddOccluderTriangle(lowerLeft, lowerRight, upperRight);
+		culler.AddOccluderTriangle(lowerLeft, upperRight, upperLeft);
+
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f),
+			(float)culler.GetWidth() / (float)culler.GetHeight(), 0.1f, 100.0f);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		culler.RenderOccluders(projection * view);
+	}
+}
+
+int main()
+{
+	int failures = 0;
+
+	// the tiles are rasterized apart, so the answers may not depend
+	// on the number of threads
+	const int threadCounts[] = { 1, 4 };
+	for (int threadCount : threadCounts)
+	{
+		OcclusionCuller culler;
+		RenderWall(culler, threadCount);
+
+		for (const BOX_CASE& box : g_BoxCases)
+		{
+			bool bOccluded = culler.IsOccluded(box.minCorner, box.maxCorner);
+			if (bOccluded != box.bOccluded)
+			{
+				std::cout << "FAILED: the box " << box.name << " with " << threadCount
+					<< " threads is " << (bOccluded ? "occluded" : "visible") << std::endl;
+				failures++;
+			}
+		}
+	}
+
+	// nothing is hidden by an empty depth buffer
+	OcclusionCuller emptyCuller;
+	emptyCuller.RenderOccluders(glm::perspective(glm::radians(45.0f), 1.25f, 0.1f, 100.0f));
+	if (emptyCuller.IsOccluded(g_BoxCases[0].minCorner, g_BoxCases[0].maxCorner) == true)
+	{
+		std::cout << "FAILED: a box is occluded without any occluders" << std::endl;
+		failures++;
+	}
+
+	if (failures > 0)
+	{
+		std::cout << failures << " occlusion checks failed" << std::endl;
+		return(1);
+	}
+	std::cout << "all occlusion checks passed" << std::endl;
+	return(0);
+}
@@ -0,0 +1,158 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderservertest.cpp
+// ============
+// send known request lines to a RenderServer over its socket and check which
+// of them are rendered and which are answered with an error - returns
+// non-zero when a check fails
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderServer.h"
+#include "LocalSocket.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+	// one request line and whether it has to be rendered
+	struct REQUEST_CASE
+	{
+		const char* name;
+		const char* line;
+		bool bRendered;
+	};
+
+	const REQUEST_CASE g_RequestCases[] =
+	{
+		{ "plain view", "render 0 5 12 -90 -14 10 10 raw", true },
+		{ "empty size", "render 0 5 12 -90 -14 0 10", false },
+		{ "missing size", "render 0 5 12 -90 -14 10", false },
+		{ "unknown flag", "render 0 5 12 -90 -14 10 10 sparkle", false },
+		{ "region", "render 0 5 12 -90 -14 10 10 region 40 30 100 100 raw", true },
+		{ "region in the corner", "render 0 5 12 -90 -14 10 10 region 90 90 100 100 raw", true },
+		{ "missing region size", "render 0 5 12 -90 -14 10 10 region 0 0 100", false },
+		{ "negative region", "render 0 5 12 -90 -14 10 10 region -1 0 100 100", false },
+		{ "region past the right", "render 0 5 12 -90 -14 10 10 region 91 0 100 100", false },
+		{ "region past the bottom", "render 0 5 12 -90 -14 10 10 region 0 91 100 100", false },
+		{ "frame smaller than the image", "render 0 5 12 -90 -14 10 10 region 0 0 5 100", false },
+		{ "frame too large", "render 0 5 12 -90 -14 10 10 region 0 0 40000 100", false },
+		// the region and the image size would overflow an int
+		{ "overflowing region x", "render 0 0 0 0 0 10 10 region 2147483647 0 32768 32768", false },
+		{ "overflowing region y", "render 0 0 0 0 0 10 10 region 0 2147483647 32768 32768", false },
+	};
+
+	// read one response line, without its newline
+	bool ReadLine(int connection, std::string& line)
+	{
+		line.clear();
+		char character = 0;
+		while (LocalSocket::ReadAll(connection, &character, 1) == true)
+		{
+			if (character == '\n')
+			{
+				return(true);
+			}
+			line += character;
+		}
+		return(false);
+	}
+
+	// send a request line and read its answer, with the bytes
+	// of a rendered image - returns false when the connection
+	// was lost
+	bool SendRequest(int connection, const std::string& request, std::string& response)
+	{
+		std::string line = request + "\n";
+		if ((LocalSocket::WriteAll(connection, line.data(), line.size()) == false) ||
+			(ReadLine(connection, response) == false))
+		{
+			return(false);
+		}
+		if (response.compare(0, 3, "ok ") != 0)
+		{
+			return(true);
+		}
+		size_t size = (size_t)std::strtoull(response.c_str() + response.rfind(' ') + 1, NULL, 10);
+		std::vector<unsigned char> bytes(size);
+		return(LocalSocket::ReadAll(connection, bytes.data(), size));
+	}
+}
+
+int main()
+{
+	std::string socketPath = (std::filesystem::temp_directory_path() /
+		("render_server_test_" + std::to_string(
+			std::chrono::steady_clock::now().time_since_epoch().count()) + ".sock")).string();
+
+	RenderServer server;
+	if (server.Start(socketPath.c_str(), false) == false)
+	{
+		std::cout << "FAILED: could not start the server on " << socketPath << std::endl;
+		return(1);
+	}
+
+	// complete every request with a blank image in place of the
+	// renderer
+	std::atomic<bool> bQuit(false);
+	std::thread renderer([&server, &bQuit]() {
+		std::vector<RenderServer::REQUEST*> requests;
+		while (bQuit.load() == false)
+		{
+			server.TakeRequests(requests, 8, 10);
+			for (RenderServer::REQUEST* pRequest : requests)
+			{
+				pRequest->pixels.assign((size_t)pRequest->width * pRequest->height * 4, 0);
+				server.CompleteRequest(pRequest);
+			}
+		}
+	});
+
+	int failures = 0;
+	int connection = LocalSocket::Connect(socketPath.c_str());
+	if (connection < 0)
+	{
+		std::cout << "FAILED: could not connect to " << socketPath << std::endl;
+		failures++;
+	}
+	for (size_t i = 0; (connection >= 0) && (i < sizeof(g_RequestCases) / sizeof(g_RequestCases[0])); i++)
+	{
+		const REQUEST_CASE& request = g_RequestCases[i];
+		std::string response;
+		if (SendRequest(connection, request.line, response) == false)
+		{
+			std::cout << "FAILED: the connection was lost on the request " << request.name << std::endl;
+			failures++;
+			break;
+		}
+		bool bRendered = (response.compare(0, 3, "ok ") == 0);
+		if (bRendered != request.bRendered)
+		{
+			std::cout << "FAILED: the request " << request.name << " was answered with " << response << std::endl;
+			failures++;
+		}
+	}
+	if (connection >= 0)
+	{
+		LocalSocket::Close(connection);
+	}
+
+	bQuit.store(true);
+	renderer.join();
+	server.Stop();
+
+	if (failures > 0)
+	{
+		std::cout << failures << " render server checks failed" << std::endl;
+		return(1);
+	}
+	std::cout << "all render server checks passed" << std::endl;
+	return(0);
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// allocationcounter.cpp
+// ============
+// count the heap allocations of the whole program, so frames that should not
+// allocate can be checked
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// declaration of the global variables and defines
+namespace
+{
+	// constant initialized, so allocations made before main()
+	// are counted as well
+	std::atomic<long long> g_AllocationCount(0);
+	std::atomic<long long> g_AllocatedBytes(0);
+}
+
+/***********************************************************
+ *  operator new()
+ *
+ *  The replacement of the global allocation function.  The
+ *  array and nothrow forms call this one, so they are counted
+ *  too.  Over-aligned allocations use their own form and are
+ *  not counted.
+ ***********************************************************/
+void* operator new(std::size_t size)
+{
+	g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	g_AllocatedBytes.fetch_add((long long)size, std::memory_order_relaxed);
+
+	void* pointer = std::malloc((size > 0) ? size : 1);
+	if (NULL == pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return(pointer);
+}
+
+/***********************************************************
+ *  operator delete()
+ *
+ *  The replacements of the global deallocation functions
+ *  that match the replaced operator new().
+ ***********************************************************/
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+/***********************************************************
+ *  GetAllocationCount()
+ *
+ *  This method is used to get the number of allocations made
+ *  since the program started.
+ ***********************************************************/
+long long AllocationCounter::GetAllocationCount()
+{
+	return(g_AllocationCount.load(std::memory_order_relaxed));
+}
+
+/***********************************************************
+ *  GetAllocatedBytes()
+ *
+ *  This method is used to get the number of bytes requested
+ *  by the allocations made since the program started.
+ ***********************************************************/
+long long AllocationCounter::GetAllocatedBytes()
+{
+	return(g_AllocatedBytes.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,27 @@
+///////////////////////////////////////////////////////////////////////////////
+// allocationcounter.h
+// ============
+// count the heap allocations of the whole program, so frames that should not
+// allocate can be checked
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  AllocationCounter
+ *
+ *  This class contains the counters of the global operator
+ *  new, which its source file replaces.  Every allocation of
+ *  every thread is counted, including the ones made by the
+ *  standard containers, so the difference of two readings is
+ *  the number of allocations made in between.
+ ***********************************************************/
+class AllocationCounter
+{
+public:
+	// number of allocations made since the program started
+	static long long GetAllocationCount();
+	// number of bytes requested by those allocations
+	static long long GetAllocatedBytes();
+};
@@ -0,0 +1,643 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// find the scene instances inside a frustum or a box, or hit by a ray,
+// without testing every one of them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+
+// declaration of the global variables and defines
+namespace
+{
+	// positions along each axis that the splits are tried at
+	const int g_BinCount = 16;
+	// cost of visiting a node, against 1 for testing an instance
+	const float g_TraversalCost = 1.0f;
+	// nodes deeper than this are split in the middle, so the
+	// depth stays within the query stack
+	const int g_MaxSahDepth = 64;
+	// nodes a query can have waiting at the same time
+	const int g_StackSize = 128;
+	// smallest node whose subtrees are built as separate jobs
+	const int g_InstancesPerBuildJob = 4096;
+
+	// the bounds and instance count of one bin of a split
+	struct BIN
+	{
+		glm::vec3 minCorner;
+		glm::vec3 maxCorner;
+		int count;
+	};
+
+	// half the surface area of a box
+	float GetHalfArea(const glm::vec3& minCorner, const glm::vec3& maxCorner)
+	{
+		glm::vec3 size = glm::max(maxCorner - minCorner, glm::vec3(0.0f));
+		return(size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	// true when two boxes overlap, including touching
+	bool Overlaps(
+		const glm::vec3& minA,
+		const glm::vec3& maxA,
+		const glm::vec3& minB,
+		const glm::vec3& maxB)
+	{
+		return((minA.x <= maxB.x) && (maxA.x >= minB.x)
+			&& (minA.y <= maxB.y) && (maxA.y >= minB.y)
+			&& (minA.z <= maxB.z) && (maxA.z >= minB.z));
+	}
+
+	// distance along a ray to where it enters a box, or FLT_MAX
+	// when it misses the box or enters it beyond the passed in
+	// distance
+	float IntersectRayBox(
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		float maxDistance,
+		const glm::vec3& minCorner,
+		const glm::vec3& maxCorner)
+	{
+		glm::vec3 t0 = (minCorner - origin) * inverseDirection;
+		glm::vec3 t1 = (maxCorner - origin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+		float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+		return((enter <= exit) ? enter : FLT_MAX);
+	}
+
+	// test a box against the frustum planes whose bits are set in
+	// the mask - returns false when the box is outside of one of
+	// them and clears the bits of the planes it is fully inside
+	bool IsBoxInFrustum(
+		const glm::vec4* planes,
+		const glm::vec3& minCorner,
+		const glm::vec3& maxCorner,
+		int& mask)
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			if ((mask & (1 << i)) == 0)
+			{
+				continue;
+			}
+
+			// the corners farthest along and against the normal
+			const glm::vec4& plane = planes[i];
+			glm::vec3 inner(
+				(plane.x >= 0.0f) ? maxCorner.x : minCorner.x,
+				(plane.y >= 0.0f) ? maxCorner.y : minCorner.y,
+				(plane.z >= 0.0f) ? maxCorner.z : minCorner.z);
+			if (glm::dot(glm::vec3(plane), inner) + plane.w < 0.0f)
+			{
+				return(false);
+			}
+
+			glm::vec3 outer(
+				(plane.x >= 0.0f) ? minCorner.x : maxCorner.x,
+				(plane.y >= 0.0f) ? minCorner.y : maxCorner.y,
+				(plane.z >= 0.0f) ? minCorner.z : maxCorner.z);
+			if (glm::dot(glm::vec3(plane), outer) + plane.w >= 0.0f)
+			{
+				mask &= ~(1 << i);
+			}
+		}
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+	m_instanceCount = 0;
+	m_depth = 0;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove the tree.  The arrays keep
+ *  their memory for the next build.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Clear()
+{
+	m_nodes.clear();
+	m_instances.clear();
+	m_minCorners.clear();
+	m_maxCorners.clear();
+	m_instanceCount = 0;
+	m_depth = 0;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used to build the tree over the bounds of
+ *  the passed in instances.  A tree over n instances never
+ *  has more than 2n - 1 nodes, so the nodes are allocated
+ *  once and handed out to the jobs with an atomic counter.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(
+	const glm::vec3* minCorners,
+	const glm::vec3* maxCorners,
+	int count,
+	JobSystem* pJobSystem)
+{
+	PROFILE_FUNCTION();
+
+	Clear();
+	if (count <= 0)
+	{
+		return;
+	}
+
+	m_instanceCount = count;
+	m_buildItems.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		m_buildItems[i].minCorner = minCorners[i];
+		m_buildItems[i].instance = i;
+		m_buildItems[i].maxCorner = maxCorners[i];
+	}
+	m_nodes.resize(2 * count - 1);
+
+	BUILD_STATE state;
+	state.pJobSystem = pJobSystem;
+	state.nodeCount = 1;
+	state.depth = 1;
+	BuildNode(state, 0, 0, count, 1);
+
+	m_nodes.resize(state.nodeCount);
+	m_depth = state.depth;
+
+	// the queries read the bounds in the order of the leaves
+	m_instances.resize(count);
+	m_minCorners.resize(count);
+	m_maxCorners.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		m_instances[i] = m_buildItems[i].instance;
+		m_minCorners[i] = m_buildItems[i].minCorner;
+		m_maxCorners[i] = m_buildItems[i].maxCorner;
+	}
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used to build the subtree of a node over
+ *  the passed in range of instances.  The centers of the
+ *  instances are sorted into bins along each axis, and the
+ *  split between two bins that gives the cheapest halves is
+ *  used.  A node that is cheaper to test as a whole becomes
+ *  a leaf.  The range is then partitioned in place, so every
+ *  subtree holds a contiguous range of instances.
+ ***********************************************************/
+void BoundingVolumeHierarchy::BuildNode(BUILD_STATE& state, int nodeIndex, int first, int count, int depth)
+{
+	NODE& node = m_nodes[nodeIndex];
+
+	int deepest = state.depth;
+	while ((depth > deepest) && (state.depth.compare_exchange_weak(deepest, depth) == false))
+	{
+	}
+
+	// the bounds of the instances and of their centers
+	glm::vec3 centerMin(FLT_MAX);
+	glm::vec3 centerMax(-FLT_MAX);
+	node.minCorner = glm::vec3(FLT_MAX);
+	node.maxCorner = glm::vec3(-FLT_MAX);
+	BUILD_ITEM* items = m_buildItems.data();
+	for (int i = first; i < first + count; i++)
+	{
+		node.minCorner = glm::min(node.minCorner, items[i].minCorner);
+		node.maxCorner = glm::max(node.maxCorner, items[i].maxCorner);
+		glm::vec3 center = (items[i].minCorner + items[i].maxCorner) * 0.5f;
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+
+	node.first = first;
+	node.count = count;
+	if (count == 1)
+	{
+		return;
+	}
+
+	glm::vec3 extent = centerMax - centerMin;
+	glm::vec3 scale(0.0f);
+	int bestAxis = -1;
+	int bestSplit = 0;
+	float bestCost = FLT_MAX;
+
+	if (depth < g_MaxSahDepth)
+	{
+		// the instances are sorted into the bins of all three axes
+		// in one pass
+		BIN bins[3][g_BinCount];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			scale[axis] = (extent[axis] > 0.0f) ? g_BinCount / extent[axis] : 0.0f;
+			for (int b = 0; b < g_BinCount; b++)
+			{
+				bins[axis][b].minCorner = glm::vec3(FLT_MAX);
+				bins[axis][b].maxCorner = glm::vec3(-FLT_MAX);
+				bins[axis][b].count = 0;
+			}
+		}
+
+		for (int i = first; i < first + count; i++)
+		{
+			glm::vec3 position = ((items[i].minCorner + items[i].maxCorner) * 0.5f - centerMin) * scale;
+			int binIndices[3] = {
+				std::min((int)position.x, g_BinCount - 1),
+				std::min((int)position.y, g_BinCount - 1),
+				std::min((int)position.z, g_BinCount - 1) };
+			for (int axis = 0; axis < 3; axis++)
+			{
+				BIN& bin = bins[axis][binIndices[axis]];
+				bin.minCorner = glm::min(bin.minCorner, items[i].minCorner);
+				bin.maxCorner = glm::max(bin.maxCorner, items[i].maxCorner);
+				bin.count++;
+			}
+		}
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (extent[axis] <= 0.0f)
+			{
+				continue;
+			}
+
+			// the cost of the bins right of each split, swept from
+			// the right, then the splits are swept from the left
+			float rightCosts[g_BinCount];
+			glm::vec3 rightMin(FLT_MAX);
+			glm::vec3 rightMax(-FLT_MAX);
+			int rightCount = 0;
+			for (int b = g_BinCount - 1; b > 0; b--)
+			{
+				rightMin = glm::min(rightMin, bins[axis][b].minCorner);
+				rightMax = glm::max(rightMax, bins[axis][b].maxCorner);
+				rightCount += bins[axis][b].count;
+				rightCosts[b] = (rightCount > 0) ? GetHalfArea(rightMin, rightMax) * rightCount : 0.0f;
+			}
+
+			glm::vec3 leftMin(FLT_MAX);
+			glm::vec3 leftMax(-FLT_MAX);
+			int leftCount = 0;
+			for (int split = 1; split < g_BinCount; split++)
+			{
+				const BIN& bin = bins[axis][split - 1];
+				leftMin = glm::min(leftMin, bin.minCorner);
+				leftMax = glm::max(leftMax, bin.maxCorner);
+				leftCount += bin.count;
+				if ((leftCount == 0) || (leftCount == count))
+				{
+					continue;
+				}
+
+				float cost = GetHalfArea(leftMin, leftMax) * leftCount + rightCosts[split];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+	}
+
+	int middle = first;
+	if (bestAxis >= 0)
+	{
+		float nodeArea = GetHalfArea(node.minCorner, node.maxCorner);
+		float splitCost = g_TraversalCost + ((nodeArea > 0.0f) ? bestCost / nodeArea : (float)count);
+		if ((count <= MAX_LEAF_SIZE) && ((float)count <= splitCost))
+		{
+			return;
+		}
+
+		float axisScale = scale[bestAxis];
+		float start = centerMin[bestAxis];
+		middle = (int)(std::partition(items + first, items + first + count,
+			[bestAxis, bestSplit, axisScale, start](const BUILD_ITEM& item) {
+				float center = (item.minCorner[bestAxis] + item.maxCorner[bestAxis]) * 0.5f;
+				return(std::min((int)((center - start) * axisScale), g_BinCount - 1) < bestSplit);
+			}) - items);
+	}
+	else
+	{
+		if (count <= MAX_LEAF_SIZE)
+		{
+			return;
+		}
+
+		// the centers are all in one place, or the tree is too
+		// deep - split the range in the middle of its widest axis
+		int axis = (extent.x >= extent.y) ? ((extent.x >= extent.z) ? 0 : 2) : ((extent.y >= extent.z) ? 1 : 2);
+		middle = first + count / 2;
+		std::nth_element(items + first, items + middle, items + first + count,
+			[axis](const BUILD_ITEM& a, const BUILD_ITEM& b) {
+				return(a.minCorner[axis] + a.maxCorner[axis] < b.minCorner[axis] + b.maxCorner[axis]);
+			});
+	}
+
+	int left = state.nodeCount.fetch_add(2);
+	node.first = left;
+	node.count = 0;
+
+	int leftCount = middle - first;
+	int rightCount = count - leftCount;
+	if ((NULL != state.pJobSystem) && (count >= g_InstancesPerBuildJob))
+	{
+		// the left subtree is built by another thread while this
+		// one builds the right subtree
+		JobSystem::JOB* job = state.pJobSystem->CreateJob("BuildBVH", [this, &state, left, first, leftCount, depth]() {
+			BuildNode(state, left, first, leftCount, depth + 1);
+		});
+		state.pJobSystem->Submit(job);
+		BuildNode(state, left + 1, middle, rightCount, depth + 1);
+		state.pJobSystem->Wait(job);
+	}
+	else
+	{
+		BuildNode(state, left, first, leftCount, depth + 1);
+		BuildNode(state, left + 1, middle, rightCount, depth + 1);
+	}
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used to move the boxes of the tree to the
+ *  new bounds of the instances it was built over.  The nodes
+ *  are walked backwards, so the children of a node are
+ *  always done before it.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Refit(const glm::vec3* minCorners, const glm::vec3* maxCorners)
+{
+	PROFILE_FUNCTION();
+
+	for (int i = 0; i < m_instanceCount; i++)
+	{
+		m_minCorners[i] = minCorners[m_instances[i]];
+		m_maxCorners[i] = maxCorners[m_instances[i]];
+	}
+
+	for (int i = (int)m_nodes.size() - 1; i >= 0; i--)
+	{
+		NODE& node = m_nodes[i];
+		if (node.count > 0)
+		{
+			node.minCorner = m_minCorners[node.first];
+			node.maxCorner = m_maxCorners[node.first];
+			for (int j = node.first + 1; j < node.first + node.count; j++)
+			{
+				node.minCorner = glm::min(node.minCorner, m_minCorners[j]);
+				node.maxCorner = glm::max(node.maxCorner, m_maxCorners[j]);
+			}
+		}
+		else
+		{
+			const NODE& left = m_nodes[node.first];
+			const NODE& right = m_nodes[node.first + 1];
+			node.minCorner = glm::min(left.minCorner, right.minCorner);
+			node.maxCorner = glm::max(left.maxCorner, right.maxCorner);
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used to add the instances whose bounds are
+ *  not fully outside of the frustum of the passed in matrix.
+ *  The planes a node is fully inside are not tested for its
+ *  children, so a subtree inside the frustum is added without
+ *  testing it.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryFrustum(const glm::mat4& viewProjection, std::vector<int>& instances) const
+{
+	if (m_nodes.empty() == true)
+	{
+		return;
+	}
+
+	// the planes of the frustum in world space, pointing inwards
+	glm::vec4 rowX(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 rowY(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 rowZ(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 rowW(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+	glm::vec4 planes[6] = {
+		rowW + rowX, rowW - rowX,
+		rowW + rowY, rowW - rowY,
+		rowW + rowZ, rowW - rowZ };
+
+	int stack[g_StackSize];
+	int masks[g_StackSize];
+	int size = 0;
+	stack[size] = 0;
+	masks[size++] = 0x3F;
+
+	while (size > 0)
+	{
+		size--;
+		const NODE& node = m_nodes[stack[size]];
+		int mask = masks[size];
+		if ((mask != 0) && (IsBoxInFrustum(planes, node.minCorner, node.maxCorner, mask) == false))
+		{
+			continue;
+		}
+
+		if (node.count == 0)
+		{
+			stack[size] = node.first + 1;
+			masks[size++] = mask;
+			stack[size] = node.first;
+			masks[size++] = mask;
+			continue;
+		}
+
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			int instanceMask = mask;
+			if ((instanceMask == 0) || (IsBoxInFrustum(planes, m_minCorners[i], m_maxCorners[i], instanceMask) == true))
+			{
+				instances.push_back(m_instances[i]);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryBox()
+ *
+ *  This method is used to add the instances whose bounds
+ *  overlap the passed in box.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryBox(
+	const glm::vec3& minCorner,
+	const glm::vec3& maxCorner,
+	std::vector<int>& instances) const
+{
+	if (m_nodes.empty() == true)
+	{
+		return;
+	}
+
+	int stack[g_StackSize];
+	int size = 0;
+	stack[size++] = 0;
+
+	while (size > 0)
+	{
+		const NODE& node = m_nodes[stack[--size]];
+		if (Overlaps(node.minCorner, node.maxCorner, minCorner, maxCorner) == false)
+		{
+			continue;
+		}
+
+		if (node.count == 0)
+		{
+			stack[size++] = node.first + 1;
+			stack[size++] = node.first;
+			continue;
+		}
+
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			if (Overlaps(m_minCorners[i], m_maxCorners[i], minCorner, maxCorner) == true)
+			{
+				instances.push_back(m_instances[i]);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryRay()
+ *
+ *  This method is used to find the nearest instance hit by a
+ *  ray.  The nearer child of a node is visited first, and
+ *  nodes that start beyond the nearest hit so far are
+ *  skipped.  Without a test the bounds of an instance count
+ *  as the hit, otherwise the test decides and can move the
+ *  hit farther along the ray.
+ ***********************************************************/
+int BoundingVolumeHierarchy::QueryRay(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float maxDistance,
+	float& distance,
+	const RAY_TEST& test) const
+{
+	int nearest = -1;
+	distance = maxDistance;
+	if (m_nodes.empty() == true)
+	{
+		return(nearest);
+	}
+
+	glm::vec3 inverseDirection = 1.0f / direction;
+	int stack[g_StackSize];
+	float enters[g_StackSize];
+	int size = 0;
+	stack[size] = 0;
+	enters[size++] = IntersectRayBox(origin, inverseDirection, distance, m_nodes[0].minCorner, m_nodes[0].maxCorner);
+
+	while (size > 0)
+	{
+		size--;
+		if (enters[size] > distance)
+		{
+			continue;
+		}
+		const NODE& node = m_nodes[stack[size]];
+
+		if (node.count == 0)
+		{
+			const NODE& left = m_nodes[node.first];
+			const NODE& right = m_nodes[node.first + 1];
+			float leftEnter = IntersectRayBox(origin, inverseDirection, distance, left.minCorner, left.maxCorner);
+			float rightEnter = IntersectRayBox(origin, inverseDirection, distance, right.minCorner, right.maxCorner);
+
+			// the farther child goes on the stack first
+			int nearChild = node.first;
+			int farChild = node.first + 1;
+			if (rightEnter < leftEnter)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(leftEnter, rightEnter);
+			}
+			if (rightEnter != FLT_MAX)
+			{
+				stack[size] = farChild;
+				enters[size++] = rightEnter;
+			}
+			if (leftEnter != FLT_MAX)
+			{
+				stack[size] = nearChild;
+				enters[size++] = leftEnter;
+			}
+			continue;
+		}
+
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			float enter = IntersectRayBox(origin, inverseDirection, distance, m_minCorners[i], m_maxCorners[i]);
+			if (enter == FLT_MAX)
+			{
+				continue;
+			}
+
+			if (test)
+			{
+				if ((test(m_instances[i], enter) == false) || (enter > distance))
+				{
+					continue;
+				}
+			}
+			distance = enter;
+			nearest = m_instances[i];
+		}
+	}
+
+	return(nearest);
+}
+
+/***********************************************************
+ *  GetCost()
+ *
+ *  This method is used to get the expected cost of a query
+ *  under the surface area heuristic - the area of each node
+ *  relative to the root, times the cost of visiting it.
+ ***********************************************************/
+float BoundingVolumeHierarchy::GetCost() const
+{
+	if (m_nodes.empty() == true)
+	{
+		return(0.0f);
+	}
+
+	float rootArea = std::max(GetHalfArea(m_nodes[0].minCorner, m_nodes[0].maxCorner), FLT_MIN);
+	float cost = 0.0f;
+	for (size_t i = 0; i < m_nodes.size(); i++)
+	{
+		const NODE& node = m_nodes[i];
+		float area = GetHalfArea(node.minCorner, node.maxCorner) / rootArea;
+		cost += area * ((node.count == 0) ? g_TraversalCost : (float)node.count);
+	}
+	return(cost);
+}
@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// find the scene instances inside a frustum or a box, or hit by a ray,
+// without testing every one of them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class contains a tree of boxes over the bounds of
+ *  the instances of a scene.  Build() splits the instances
+ *  with the surface area heuristic, which compares the area
+ *  of the boxes of the two halves at 16 bins along each axis
+ *  and picks the cheapest split.  The subtrees of large nodes
+ *  are built as jobs when a job system is given.
+ *
+ *  A node's children are always stored after it, so Refit()
+ *  updates the boxes of moved instances in one backwards pass
+ *  without changing the tree.  That keeps queries correct,
+ *  but the tree gets slower as the instances move away from
+ *  where it was built, so it should be built again after
+ *  large changes.
+ *
+ *  The queries only read the tree and keep their stack on
+ *  the thread's stack, so any number of them can run at the
+ *  same time.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// one box of the tree, 32 bytes
+	struct NODE
+	{
+		glm::vec3 minCorner;
+		// index of the first of the two children of an inner
+		// node, or of the first instance of a leaf
+		int first;
+		glm::vec3 maxCorner;
+		// instances of a leaf, 0 for an inner node
+		int count;
+	};
+
+	// test run on the instances whose bounds a ray hits - it
+	// returns true when the instance itself is hit and can move
+	// the distance of the hit farther along the ray
+	typedef std::function<bool(int instance, float& distance)> RAY_TEST;
+
+	// most instances in a leaf
+	static const int MAX_LEAF_SIZE = 8;
+
+	// constructor
+	BoundingVolumeHierarchy();
+
+	// remove the tree
+	void Clear();
+	// build the tree over the bounds of the passed in instances -
+	// the subtrees are built on the job system when given
+	void Build(
+		const glm::vec3* minCorners,
+		const glm::vec3* maxCorners,
+		int count,
+		JobSystem* pJobSystem = NULL);
+	// move the boxes of the tree to the new bounds of the same
+	// instances, keeping the tree
+	void Refit(const glm::vec3* minCorners, const glm::vec3* maxCorners);
+
+	// add the instances whose bounds are inside or cross the
+	// frustum of the passed in view projection matrix
+	void QueryFrustum(const glm::mat4& viewProjection, std::vector<int>& instances) const;
+	// add the instances whose bounds overlap the passed in box
+	void QueryBox(
+		const glm::vec3& minCorner,
+		const glm::vec3& maxCorner,
+		std::vector<int>& instances) const;
+	// find the nearest instance whose bounds the ray hits within
+	// the passed in distance, and which passes the test when one
+	// is given - returns -1 when there is none
+	int QueryRay(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		float& distance,
+		const RAY_TEST& test = RAY_TEST()) const;
+
+	int GetInstanceCount() const { return(m_instanceCount); }
+	int GetNodeCount() const { return((int)m_nodes.size()); }
+	int GetDepth() const { return(m_depth); }
+	const NODE* GetNodes() const { return(m_nodes.data()); }
+	// instances in the order of the leaves, which a leaf's first
+	// and count index into
+	const int* GetInstances() const { return(m_instances.data()); }
+	// expected cost of a query under the surface area heuristic,
+	// for comparing trees
+	float GetCost() const;
+
+private:
+	// an instance being sorted into the tree, kept together
+	// with its bounds so the build reads them in order
+	struct BUILD_ITEM
+	{
+		glm::vec3 minCorner;
+		int instance;
+		glm::vec3 maxCorner;
+	};
+
+	// state shared by the jobs of one build
+	struct BUILD_STATE
+	{
+		JobSystem* pJobSystem;
+		// next free node, handed out two at a time
+		std::atomic<int> nodeCount;
+		std::atomic<int> depth;
+	};
+
+	std::vector<NODE> m_nodes;
+	// instances in the order of the leaves that hold them, and
+	// their bounds in the same order
+	std::vector<int> m_instances;
+	std::vector<glm::vec3> m_minCorners;
+	std::vector<glm::vec3> m_maxCorners;
+	// the instances in the order of the build so far
+	std::vector<BUILD_ITEM> m_buildItems;
+	int m_instanceCount;
+	int m_depth;
+
+	// build the subtree of a node over a range of m_buildItems
+	void BuildNode(BUILD_STATE& state, int node, int first, int count, int depth);
+};
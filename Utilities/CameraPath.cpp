@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.cpp
+// ============
+// record the camera position and orientation over time and play it back
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+/***********************************************************
+ *  CameraPath()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CameraPath::CameraPath()
+{
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove all of the keys.
+ ***********************************************************/
+void CameraPath::Clear()
+{
+	m_keys.clear();
+}
+
+/***********************************************************
+ *  AddKey()
+ *
+ *  This method is used to add a camera key to the end of the
+ *  path.  Keys that are older than the last key are ignored
+ *  so the path always stays sorted by time.
+ ***********************************************************/
+void CameraPath::AddKey(float time, glm::vec3 position, float yaw, float pitch)
+{
+	if ((m_keys.empty() == false) && (time < m_keys.back().time))
+	{
+		return;
+	}
+
+	CAMERA_KEY key;
+	key.time = time;
+	key.position = position;
+	key.yaw = yaw;
+	key.pitch = pitch;
+	m_keys.push_back(key);
+}
+
+/***********************************************************
+ *  GetDuration()
+ *
+ *  This method is used to get the time of the last key.
+ ***********************************************************/
+float CameraPath::GetDuration() const
+{
+	if (m_keys.empty())
+	{
+		return(0.0f);
+	}
+
+	return(m_keys.back().time);
+}
+
+/***********************************************************
+ *  SaveToFile()
+ *
+ *  This method is used to write the keys to a text file, one
+ *  "time x y z yaw pitch" line per key.
+ ***********************************************************/
+bool CameraPath::SaveToFile(const char* filename) const
+{
+	std::ofstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not write camera path:" << filename << std::endl;
+		return false;
+	}
+
+	file << "# camera path: time x y z yaw pitch" << std::endl;
+	// enough digits that a replayed path matches the recording
+	file << std::setprecision(9);
+	for (size_t i = 0; i < m_keys.size(); i++)
+	{
+		const CAMERA_KEY& key = m_keys[i];
+		file << key.time << " "
+			<< key.position.x << " " << key.position.y << " " << key.position.z << " "
+			<< key.yaw << " " << key.pitch << std::endl;
+	}
+
+	std::cout << "Saved " << m_keys.size() << " camera keys to:" << filename << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  LoadFromFile()
+ *
+ *  This method is used to read the keys from a text file
+ *  written by SaveToFile().  Empty lines and lines starting
+ *  with '#' are skipped.
+ ***********************************************************/
+bool CameraPath::LoadFromFile(const char* filename)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not load camera path:" << filename << std::endl;
+		return false;
+	}
+
+	Clear();
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		if ((line.empty() == true) || (line[0] == '#'))
+		{
+			continue;
+		}
+
+		std::istringstream values(line);
+		float time = 0.0f;
+		glm::vec3 position;
+		float yaw = 0.0f;
+		float pitch = 0.0f;
+		if (!(values >> time >> position.x >> position.y >> position.z >> yaw >> pitch))
+		{
+			std::cout << "Invalid camera key on line " << lineNumber << " of:" << filename << std::endl;
+			Clear();
+			return false;
+		}
+		AddKey(time, position, yaw, pitch);
+	}
+
+	if (m_keys.empty())
+	{
+		std::cout << "Camera path has no keys:" << filename << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Sample()
+ *
+ *  This method is used to get the camera at the passed in
+ *  time by linearly interpolating between the two keys
+ *  around it.  Times outside of the path are clamped to the
+ *  first or last key.
+ ***********************************************************/
+bool CameraPath::Sample(float time, glm::vec3& position, float& yaw, float& pitch) const
+{
+	if (m_keys.empty())
+	{
+		return false;
+	}
+
+	// find the first key after the passed in time
+	std::vector<CAMERA_KEY>::const_iterator nextKey = std::upper_bound(
+		m_keys.begin(), m_keys.end(), time,
+		[](float value, const CAMERA_KEY& key) { return(value < key.time); });
+	size_t next = nextKey - m_keys.begin();
+
+	if (next == 0)
+	{
+		position = m_keys.front().position;
+		yaw = m_keys.front().yaw;
+		pitch = m_keys.front().pitch;
+		return true;
+	}
+	if (next == m_keys.size())
+	{
+		position = m_keys.back().position;
+		yaw = m_keys.back().yaw;
+		pitch = m_keys.back().pitch;
+		return true;
+	}
+
+	const CAMERA_KEY& key0 = m_keys[next - 1];
+	const CAMERA_KEY& key1 = m_keys[next];
+	float amount = 0.0f;
+	if (key1.time > key0.time)
+	{
+		amount = (time - key0.time) / (key1.time - key0.time);
+	}
+
+	// the camera does not wrap the yaw angle, so a plain
+	// blend follows the same turn that was recorded
+	position = glm::mix(key0.position, key1.position, amount);
+	yaw = key0.yaw + (key1.yaw - key0.yaw) * amount;
+	pitch = key0.pitch + (key1.pitch - key0.pitch) * amount;
+
+	return true;
+}
@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.h
+// ============
+// record the camera position and orientation over time and play it back
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  CameraPath
+ *
+ *  This class contains the code for storing timestamped
+ *  camera keys, saving them to and loading them from a
+ *  text file, and sampling the path at any time between
+ *  the first and last key.
+ ***********************************************************/
+class CameraPath
+{
+public:
+	// constructor
+	CameraPath();
+
+	// one sample of the camera taken at a point in time
+	struct CAMERA_KEY
+	{
+		float time;
+		glm::vec3 position;
+		float yaw;
+		float pitch;
+	};
+
+	// remove all of the keys
+	void Clear();
+	// add a key - keys must be added in time order
+	void AddKey(float time, glm::vec3 position, float yaw, float pitch);
+
+	// write the keys as one line of text per key
+	bool SaveToFile(const char* filename) const;
+	// replace the keys with the ones read from a file
+	bool LoadFromFile(const char* filename);
+
+	// interpolate the camera at the passed in time
+	bool Sample(float time, glm::vec3& position, float& yaw, float& pitch) const;
+
+	int GetKeyCount() const { return((int)m_keys.size()); }
+	const CAMERA_KEY& GetKey(int index) const { return(m_keys[index]); }
+	// time of the last key, the first key is at time zero
+	float GetDuration() const;
+
+private:
+	// keys sorted by time
+	std::vector<CAMERA_KEY> m_keys;
+};
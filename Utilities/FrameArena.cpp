@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.cpp
+// ============
+// hand out the short lived memory of a frame from one block that is reset
+// as a whole once the frame is prepared
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+/***********************************************************
+ *  FrameArena()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameArena::FrameArena(size_t capacity)
+{
+	m_capacity = std::max<size_t>(capacity, 1024);
+	m_pBlock = new unsigned char[m_capacity];
+	m_used = 0;
+	m_overflowBytes = 0;
+	m_peakBytes = 0;
+	m_overflowCount = 0;
+}
+
+/***********************************************************
+ *  ~FrameArena()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameArena::~FrameArena()
+{
+	Reset();
+	delete[] m_pBlock;
+	m_pBlock = NULL;
+}
+
+/***********************************************************
+ *  do_allocate()
+ *
+ *  This method is used to bump allocate memory from the
+ *  block.  Threads that allocate at the same time each move
+ *  the end of the used bytes past their own allocation.
+ ***********************************************************/
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+	uintptr_t base = (uintptr_t)m_pBlock;
+	size_t used = m_used.load(std::memory_order_relaxed);
+	while (true)
+	{
+		// align the address rather than the offset, so any
+		// alignment works whatever the block's own alignment
+		uintptr_t start = (base + used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		size_t end = (size_t)(start - base) + bytes;
+		if (end > m_capacity)
+		{
+			break;
+		}
+		if (m_used.compare_exchange_weak(used, end, std::memory_order_relaxed) == true)
+		{
+			return((void*)start);
+		}
+	}
+
+	// the block is full - take the memory from the heap for
+	// now and remember how much the frame needed
+	std::lock_guard<std::mutex> lock(m_overflowMutex);
+	OVERFLOW_ALLOCATION allocation;
+	allocation.pointer = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	allocation.bytes = bytes;
+	allocation.alignment = alignment;
+	m_overflows.push_back(allocation);
+	m_overflowBytes += bytes + alignment;
+	m_overflowCount++;
+
+	return(allocation.pointer);
+}
+
+/***********************************************************
+ *  do_deallocate()
+ *
+ *  This method does nothing, since the memory is released
+ *  all at once by Reset().
+ ***********************************************************/
+void FrameArena::do_deallocate(void* /*pointer*/, size_t /*bytes*/, size_t /*alignment*/)
+{
+}
+
+/***********************************************************
+ *  do_is_equal()
+ *
+ *  This method is used to check whether memory from one
+ *  resource can be freed by the other, which is only the
+ *  case for the same arena.
+ ***********************************************************/
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return(this == &other);
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used to release every allocation of the
+ *  frame.  When the block was too small it is replaced by
+ *  one that holds everything the frame needed.
+ ***********************************************************/
+void FrameArena::Reset()
+{
+	size_t frameBytes = m_used.load(std::memory_order_relaxed) + m_overflowBytes;
+	m_peakBytes = std::max(m_peakBytes, frameBytes);
+
+	for (size_t i = 0; i < m_overflows.size(); i++)
+	{
+		const OVERFLOW_ALLOCATION& allocation = m_overflows[i];
+		std::pmr::new_delete_resource()->deallocate(allocation.pointer, allocation.bytes, allocation.alignment);
+	}
+
+	if (m_overflows.empty() == false)
+	{
+		m_capacity = std::max(m_capacity * 2, frameBytes);
+		delete[] m_pBlock;
+		m_pBlock = new unsigned char[m_capacity];
+	}
+
+	m_overflows.clear();
+	m_overflowBytes = 0;
+	m_used.store(0, std::memory_order_relaxed);
+}
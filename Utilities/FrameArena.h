@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.h
+// ============
+// hand out the short lived memory of a frame from one block that is reset
+// as a whole once the frame is prepared
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+/***********************************************************
+ *  FrameArena
+ *
+ *  This class contains a linear allocator for data that
+ *  only lives while a frame is prepared, such as the job
+ *  graph and the scratch lists built for it.  It is a
+ *  std::pmr::memory_resource, so standard containers can
+ *  use it through std::pmr::polymorphic_allocator.  Memory
+ *  is bump allocated from one block without locking, so
+ *  worker threads can allocate at the same time, and freeing
+ *  does nothing until Reset() releases everything at once.
+ *
+ *  Allocations that do not fit are taken from the heap and
+ *  the block grows at the next reset, so after a few frames
+ *  the arena no longer touches the heap at all.
+ ***********************************************************/
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+	// constructor
+	FrameArena(size_t capacity = 64 * 1024);
+	// destructor
+	~FrameArena();
+
+	// release everything allocated since the last reset - no
+	// allocation may be in use and none may be made meanwhile
+	void Reset();
+
+	size_t GetCapacity() const { return(m_capacity); }
+	// bytes allocated since the last reset, inside the block
+	size_t GetUsedBytes() const { return(m_used.load(std::memory_order_relaxed)); }
+	// most bytes a frame has needed so far
+	size_t GetPeakBytes() const { return(m_peakBytes); }
+	// number of allocations that did not fit into the block
+	int GetOverflowCount() const { return(m_overflowCount); }
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+	// an allocation taken from the heap because the block was full
+	struct OVERFLOW_ALLOCATION
+	{
+		void* pointer;
+		size_t bytes;
+		size_t alignment;
+	};
+
+	unsigned char* m_pBlock;
+	size_t m_capacity;
+	std::atomic<size_t> m_used;
+	// heap allocations of this frame, freed by Reset()
+	std::mutex m_overflowMutex;
+	std::vector<OVERFLOW_ALLOCATION> m_overflows;
+	size_t m_overflowBytes;
+	size_t m_peakBytes;
+	int m_overflowCount;
+};
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacket.h
+// ============
+// everything the render thread needs to draw one frame, prepared ahead of
+// time by the main thread
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// tile of a streamed world, defined by the scene manager
+struct SCENE_TILE;
+
+// lights that can move between frames
+struct SCENE_LIGHTS
+{
+	glm::vec3 directionalDirection;
+	glm::vec3 spotPosition;
+	glm::vec3 spotDirection;
+};
+
+// texture of a streamed tile that is uploaded into a texture
+// unit before the frame is drawn
+struct TEXTURE_UPLOAD
+{
+	int unit;
+	// owned by the tile, which outlives the packets that draw it
+	const unsigned char* pixels;
+	int width;
+	int height;
+	int channels;
+};
+
+/***********************************************************
+ *  FRAME_PACKET
+ *
+ *  This structure contains one prepared frame.  The main
+ *  thread fills it from the input, the camera and the scene,
+ *  and the render thread draws it without looking at any of
+ *  those, so the next frame can be prepared at the same time.
+ *  The vectors keep their memory when a packet is reused.
+ ***********************************************************/
+struct FRAME_PACKET
+{
+	// number of the frame
+	int frame = 0;
+	// camera of the frame
+	glm::mat4 view = glm::mat4(1.0f);
+	glm::mat4 projection = glm::mat4(1.0f);
+	glm::vec3 viewPosition = glm::vec3(0.0f);
+	// sub-pixel offset the projection was moved by, in normalized
+	// device coordinates, for the temporal upscaling
+	glm::vec2 jitter = glm::vec2(0.0f);
+	SCENE_LIGHTS lights = {};
+	// whether each scene object passed the culling
+	std::vector<unsigned char> visibleObjects;
+	// world matrices of the scene's transforms, copied again
+	// only when the transforms changed since the last copy
+	std::vector<glm::mat4> worldMatrices;
+	int transformVersion = -1;
+	// resident tiles of a streamed world, whose objects follow
+	// the scene objects in visibleObjects
+	std::vector<const SCENE_TILE*> tiles;
+	// tile texture units freed and then filled before drawing
+	std::vector<int> textureReleases;
+	std::vector<TEXTURE_UPLOAD> textureUploads;
+	// CPU time spent preparing the frame
+	double prepareMilliseconds = 0.0;
+	// true when the frame is part of a replayed camera path
+	bool bReplayFrame = false;
+	// true to write the render statistics after drawing the frame
+	bool bExportStats = false;
+	// text for the window title, set by the render thread and
+	// shown by the main thread when it reuses the packet
+	std::string statusText;
+};
@@ -0,0 +1,211 @@
+///////////////////////////////////////////////////////////////////////////////
+// framereadback.cpp
+// ============
+// copy drawn frames back from the GPU through a ring of pixel buffers that
+// are guarded by fences, without waiting for each frame
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameReadback.h"
+#include "GpuFence.h"
+#include "Profiler.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  FrameReadback()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameReadback::FrameReadback()
+{
+	for (int i = 0; i < SLOT_COUNT; i++)
+	{
+		m_slots[i].buffer = 0;
+		m_slots[i].fence = NULL;
+		m_slots[i].frame = -1;
+	}
+	m_first = 0;
+	m_count = 0;
+	m_width = 0;
+	m_height = 0;
+	m_stalls = 0;
+}
+
+/***********************************************************
+ *  ~FrameReadback()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameReadback::~FrameReadback()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create a pixel pack buffer for
+ *  each slot, large enough for one RGBA frame.  The buffers
+ *  are only read by the CPU, so the driver keeps them where
+ *  mapping them is fast.
+ ***********************************************************/
+bool FrameReadback::Create(int width, int height)
+{
+	Destroy();
+	if ((width <= 0) || (height <= 0))
+	{
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	GLsizeiptr size = (GLsizeiptr)width * height * 4;
+	for (int i = 0; i < SLOT_COUNT; i++)
+	{
+		glGenBuffers(1, &m_slots[i].buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_slots[i].buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (glGetError() != GL_NO_ERROR)
+	{
+		std::cout << "Could not create the readback buffers:" << width << "x" << height << std::endl;
+		Destroy();
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to free the buffers and fences.  The
+ *  buffers are only deleted once the GPU is done with them,
+ *  which OpenGL takes care of.
+ ***********************************************************/
+void FrameReadback::Destroy()
+{
+	for (int i = 0; i < SLOT_COUNT; i++)
+	{
+		if (NULL != m_slots[i].fence)
+		{
+			glDeleteSync(m_slots[i].fence);
+			m_slots[i].fence = NULL;
+		}
+		if (m_slots[i].buffer != 0)
+		{
+			glDeleteBuffers(1, &m_slots[i].buffer);
+			m_slots[i].buffer = 0;
+		}
+		m_slots[i].frame = -1;
+	}
+	m_first = 0;
+	m_count = 0;
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  ReadFrame()
+ *
+ *  This method is used to queue the copy of the bound
+ *  framebuffer into the next free buffer.  glReadPixels()
+ *  into a bound pack buffer returns at once, and the fence
+ *  after it tells when the copy is done.
+ ***********************************************************/
+void FrameReadback::ReadFrame(int frame, const CONSUME_FUNCTION& consume)
+{
+	PROFILE_FUNCTION();
+
+	if (m_width == 0)
+	{
+		return;
+	}
+	if (m_count == SLOT_COUNT)
+	{
+		CollectOldest(true, consume);
+	}
+
+	SLOT& slot = m_slots[(m_first + m_count) % SLOT_COUNT];
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = frame;
+	m_count++;
+
+	// make sure the copy starts while the next frame is drawn
+	glFlush();
+}
+
+/***********************************************************
+ *  CollectFrames()
+ *
+ *  This method is used to hand the frames whose copies have
+ *  finished to the consume function in the order they were
+ *  read.  A frame that is not finished stops the collection
+ *  unless waiting, so the frames stay in order.
+ ***********************************************************/
+int FrameReadback::CollectFrames(bool bWait, const CONSUME_FUNCTION& consume)
+{
+	int collected = 0;
+	while ((m_count > 0) && (CollectOldest(bWait, consume) == true))
+	{
+		collected++;
+	}
+	return(collected);
+}
+
+/***********************************************************
+ *  CollectOldest()
+ *
+ *  This method is used to check the fence of the oldest
+ *  frame in flight, wait for it when asked to, and map its
+ *  buffer for the consume function.
+ ***********************************************************/
+bool FrameReadback::CollectOldest(bool bWait, const CONSUME_FUNCTION& consume)
+{
+	SLOT& slot = m_slots[m_first];
+
+	GpuFence::RESULT result = GpuFence::Check(slot.fence);
+	if (result == GpuFence::PENDING)
+	{
+		if (bWait == false)
+		{
+			return false;
+		}
+
+		PROFILE_SCOPE("FrameReadback stall");
+		m_stalls++;
+		result = GpuFence::Wait(slot.fence);
+	}
+	if (result == GpuFence::FAILED)
+	{
+		std::cout << "Waiting for a readback fence failed" << std::endl;
+	}
+	glDeleteSync(slot.fence);
+	slot.fence = NULL;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	GLsizeiptr size = (GLsizeiptr)m_width * m_height * 4;
+	const unsigned char* pPixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (NULL != pPixels)
+	{
+		PROFILE_SCOPE("ConsumeFrame");
+		consume(slot.frame, pPixels);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	else
+	{
+		std::cout << "Could not map the readback buffer of frame:" << slot.frame << std::endl;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.frame = -1;
+	m_first = (m_first + 1) % SLOT_COUNT;
+	m_count--;
+	return true;
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// framereadback.h
+// ============
+// copy drawn frames back from the GPU through a ring of pixel buffers that
+// are guarded by fences, without waiting for each frame
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <functional>
+
+/***********************************************************
+ *  FrameReadback
+ *
+ *  This class contains SLOT_COUNT pixel pack buffers that
+ *  the bound framebuffer is copied into.  ReadFrame() only
+ *  queues the copy and places a fence after it, so the GPU
+ *  copies the frame while the next frames are drawn.  Once
+ *  a fence has passed, the buffer is mapped and its pixels
+ *  handed to the consume function, oldest frame first.
+ *
+ *  When every buffer is still in flight, the oldest one is
+ *  waited for, which is counted as a stall.
+ ***********************************************************/
+class FrameReadback
+{
+public:
+	// frames that can be copied at the same time
+	static const int SLOT_COUNT = 4;
+
+	// function that gets the RGBA pixels of a finished frame,
+	// bottom row first - the pixels are only valid during the call
+	typedef std::function<void(int frame, const unsigned char* pPixels)> CONSUME_FUNCTION;
+
+	// constructor
+	FrameReadback();
+	// destructor
+	~FrameReadback();
+
+	// create the pixel buffers for frames of the passed in size
+	bool Create(int width, int height);
+	// free the buffers - the frames still in flight are dropped
+	void Destroy();
+
+	// start copying the bound framebuffer - when no buffer is
+	// free, the oldest frame is waited for and consumed first
+	void ReadFrame(int frame, const CONSUME_FUNCTION& consume);
+	// consume the frames whose copies have finished, or every
+	// frame in flight when waiting, and return how many
+	int CollectFrames(bool bWait, const CONSUME_FUNCTION& consume);
+
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
+	// number of frames that had to wait for a free buffer
+	int GetStallCount() const { return(m_stalls); }
+
+private:
+	// one buffer of the ring and the frame copied into it
+	struct SLOT
+	{
+		GLuint buffer;
+		GLsync fence;
+		int frame;
+	};
+
+	SLOT m_slots[SLOT_COUNT];
+	// oldest slot in flight and the number of slots in flight
+	int m_first;
+	int m_count;
+	int m_width;
+	int m_height;
+	int m_stalls;
+
+	// consume the oldest frame in flight if its copy has
+	// finished, or wait for it - returns false when it is not
+	// finished and not waited for
+	bool CollectOldest(bool bWait, const CONSUME_FUNCTION& consume);
+};
@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+// framestatistics.cpp
+// ============
+// collect frame times and summarize them as mean and percentiles
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+/***********************************************************
+ *  FrameStatistics()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameStatistics::FrameStatistics()
+{
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove all collected samples.
+ ***********************************************************/
+void FrameStatistics::Clear()
+{
+	m_samples.clear();
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used to size the sample list for the
+ *  frames that will be measured.
+ ***********************************************************/
+void FrameStatistics::Reserve(int samples)
+{
+	m_samples.reserve(samples);
+}
+
+/***********************************************************
+ *  AddSample()
+ *
+ *  This method is used to add the time of one frame.
+ ***********************************************************/
+void FrameStatistics::AddSample(double milliseconds)
+{
+	m_samples.push_back(milliseconds);
+}
+
+/***********************************************************
+ *  GetMean()
+ *
+ *  This method is used to get the average frame time.
+ ***********************************************************/
+double FrameStatistics::GetMean() const
+{
+	if (m_samples.empty())
+	{
+		return(0.0);
+	}
+
+	double total = 0.0;
+	for (size_t i = 0; i < m_samples.size(); i++)
+	{
+		total += m_samples[i];
+	}
+
+	return(total / m_samples.size());
+}
+
+/***********************************************************
+ *  GetMin()
+ *
+ *  This method is used to get the fastest frame time.
+ ***********************************************************/
+double FrameStatistics::GetMin() const
+{
+	if (m_samples.empty())
+	{
+		return(0.0);
+	}
+
+	return(*std::min_element(m_samples.begin(), m_samples.end()));
+}
+
+/***********************************************************
+ *  GetMax()
+ *
+ *  This method is used to get the slowest frame time.
+ ***********************************************************/
+double FrameStatistics::GetMax() const
+{
+	if (m_samples.empty())
+	{
+		return(0.0);
+	}
+
+	return(*std::max_element(m_samples.begin(), m_samples.end()));
+}
+
+/***********************************************************
+ *  GetPercentile()
+ *
+ *  This method is used to get the frame time that the passed
+ *  in percentage of frames are at or below.
+ ***********************************************************/
+double FrameStatistics::GetPercentile(double percent) const
+{
+	if (m_samples.empty())
+	{
+		return(0.0);
+	}
+
+	std::vector<double> sorted(m_samples);
+	std::sort(sorted.begin(), sorted.end());
+
+	// nearest rank - the smallest sample with at least
+	// the requested share of samples at or below it
+	int rank = (int)std::ceil(percent / 100.0 * sorted.size());
+	rank = std::min(std::max(rank, 1), (int)sorted.size());
+
+	return(sorted[rank - 1]);
+}
+
+/***********************************************************
+ *  WriteJSON()
+ *
+ *  This method is used to write the mean, percentiles and
+ *  range of the collected frame times as a JSON object.
+ ***********************************************************/
+void FrameStatistics::WriteJSON(std::ostream& output) const
+{
+	output << "{\"samples\":" << m_samples.size()
+		<< ",\"mean\":" << GetMean()
+		<< ",\"p50\":" << GetPercentile(50.0)
+		<< ",\"p95\":" << GetPercentile(95.0)
+		<< ",\"p99\":" << GetPercentile(99.0)
+		<< ",\"min\":" << GetMin()
+		<< ",\"max\":" << GetMax()
+		<< "}";
+}
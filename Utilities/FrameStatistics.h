@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// framestatistics.h
+// ============
+// collect frame times and summarize them as mean and percentiles
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+/***********************************************************
+ *  FrameStatistics
+ *
+ *  This class contains the code for collecting per-frame
+ *  times in milliseconds and reporting their distribution.
+ ***********************************************************/
+class FrameStatistics
+{
+public:
+	// constructor
+	FrameStatistics();
+
+	// remove all of the collected samples
+	void Clear();
+	// make room for the passed in number of samples, so adding
+	// them does not allocate
+	void Reserve(int samples);
+	// add the time of one frame in milliseconds
+	void AddSample(double milliseconds);
+
+	int GetSampleCount() const { return((int)m_samples.size()); }
+	double GetMean() const;
+	double GetMin() const;
+	double GetMax() const;
+	// nearest rank percentile, percent is from 0 to 100
+	double GetPercentile(double percent) const;
+
+	// write the summary as a JSON object
+	void WriteJSON(std::ostream& output) const;
+
+private:
+	// collected frame times in milliseconds
+	std::vector<double> m_samples;
+};
@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpufence.cpp
+// ============
+// check and wait for the fences that guard memory the GPU still uses
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuFence.h"
+
+// declaration of the global variables and defines
+namespace
+{
+	// nanoseconds to wait for a fence before checking it again
+	const GLuint64 g_FenceWaitNanoseconds = 1000000;
+
+	GpuFence::RESULT ToResult(GLenum result)
+	{
+		if (result == GL_WAIT_FAILED)
+		{
+			return(GpuFence::FAILED);
+		}
+		return((result == GL_TIMEOUT_EXPIRED) ? GpuFence::PENDING : GpuFence::SIGNALED);
+	}
+}
+
+/***********************************************************
+ *  Check()
+ *
+ *  This method is used to check a fence without waiting.
+ *  The check also flushes the fence to the GPU, so the
+ *  waits after it cannot block forever.
+ ***********************************************************/
+GpuFence::RESULT GpuFence::Check(GLsync fence)
+{
+	return(ToResult(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0)));
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used to wait for a fence in short steps
+ *  until the GPU has passed it.
+ ***********************************************************/
+GpuFence::RESULT GpuFence::Wait(GLsync fence)
+{
+	GLenum result = GL_TIMEOUT_EXPIRED;
+	while (result == GL_TIMEOUT_EXPIRED)
+	{
+		result = glClientWaitSync(fence, 0, g_FenceWaitNanoseconds);
+	}
+	return(ToResult(result));
+}
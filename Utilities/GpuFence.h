@@ -0,0 +1,36 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpufence.h
+// ============
+// check and wait for the fences that guard memory the GPU still uses
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+/***********************************************************
+ *  GpuFence
+ *
+ *  This class contains the fence checks shared by the ring
+ *  buffers that the CPU and the GPU take turns on.  Check()
+ *  never blocks, so the caller can count a stall and time it
+ *  before calling Wait().
+ ***********************************************************/
+class GpuFence
+{
+public:
+	// state of a fence
+	enum RESULT
+	{
+		SIGNALED,
+		PENDING,
+		FAILED
+	};
+
+	// check whether the GPU has passed the fence, flushing it so
+	// a later Wait() cannot block forever
+	static RESULT Check(GLsync fence);
+	// block until the GPU has passed a checked fence
+	static RESULT Wait(GLsync fence);
+};
@@ -0,0 +1,308 @@
+///////////////////////////////////////////////////////////////////////////////
+// gputimer.cpp
+// ============
+// measure how long the GPU spends on each frame and on each render pass
+// with timer queries
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuTimer.h"
+#include "Profiler.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  GpuTimer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GpuTimer::GpuTimer()
+{
+	m_readSlot = 0;
+	m_pendingCount = 0;
+	m_bInFrame = false;
+}
+
+/***********************************************************
+ *  ~GpuTimer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuTimer::~GpuTimer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create the ring of query slots.
+ *  Timer queries are core since OpenGL 3.3.  The query
+ *  objects are created the first time a slot needs them.
+ ***********************************************************/
+bool GpuTimer::Create(int ringSize)
+{
+	Destroy();
+
+	if (ringSize < 2)
+	{
+		std::cout << "The GPU timer needs at least two query slots" << std::endl;
+		return false;
+	}
+
+	m_slots.resize(ringSize);
+	for (size_t i = 0; i < m_slots.size(); i++)
+	{
+		m_slots[i].frame = -1;
+		m_slots[i].usedQueries = 0;
+		m_slots[i].profilerOffset = 0;
+		// room for the frame and every pass, so slots that are
+		// first written by a timed frame do not allocate
+		m_slots[i].queries.reserve(2 + MAX_PASSES * 2);
+		m_slots[i].passes.reserve(MAX_PASSES);
+	}
+	// every pending frame can be read before it is collected
+	m_finished.reserve(ringSize);
+	m_openPasses.reserve(MAX_PASSES);
+	m_timestamps.reserve(2 + MAX_PASSES * 2);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to free the queries and drop any
+ *  results that were not collected.
+ ***********************************************************/
+void GpuTimer::Destroy()
+{
+	for (size_t i = 0; i < m_slots.size(); i++)
+	{
+		if (m_slots[i].queries.empty() == false)
+		{
+			glDeleteQueries((GLsizei)m_slots[i].queries.size(), m_slots[i].queries.data());
+		}
+	}
+	m_slots.clear();
+	m_openPasses.clear();
+	m_finished.clear();
+	m_readSlot = 0;
+	m_pendingCount = 0;
+	m_bInFrame = false;
+}
+
+/***********************************************************
+ *  WriteTimestamp()
+ *
+ *  This method is used to record the GPU time once all of
+ *  the previously issued commands have been processed.  It
+ *  returns the index of the query within the current slot.
+ ***********************************************************/
+int GpuTimer::WriteTimestamp()
+{
+	FRAME_QUERIES& slot = m_slots[(m_readSlot + m_pendingCount) % (int)m_slots.size()];
+
+	if (slot.usedQueries == (int)slot.queries.size())
+	{
+		GLuint query = 0;
+		glGenQueries(1, &query);
+		slot.queries.push_back(query);
+	}
+
+	int index = slot.usedQueries++;
+	glQueryCounter(slot.queries[index], GL_TIMESTAMP);
+
+	return(index);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to start timing the GPU commands of
+ *  the passed in frame.  When every slot in the ring is
+ *  still pending, the oldest one is read first - it was
+ *  issued several frames ago, so it is normally finished.
+ ***********************************************************/
+void GpuTimer::BeginFrame(int frame)
+{
+	if ((m_slots.empty()) || (m_bInFrame == true))
+	{
+		return;
+	}
+
+	if (m_pendingCount == (int)m_slots.size())
+	{
+		ReadOldest(true);
+	}
+
+	FRAME_QUERIES& slot = m_slots[(m_readSlot + m_pendingCount) % (int)m_slots.size()];
+	slot.frame = frame;
+	slot.usedQueries = 0;
+	slot.passes.clear();
+	slot.profilerOffset = 0;
+
+	// line the GPU clock up with the profiler clock so the
+	// passes can be shown next to the CPU scopes
+	if (Profiler::IsEnabled() == true)
+	{
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		slot.profilerOffset = (int64_t)Profiler::GetTimeNanoseconds() - (int64_t)gpuNow;
+	}
+
+	m_bInFrame = true;
+	WriteTimestamp();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to stop timing the current frame.
+ *  Passes that were not ended are ended with the frame.
+ ***********************************************************/
+void GpuTimer::EndFrame()
+{
+	if (m_bInFrame == false)
+	{
+		return;
+	}
+
+	while (m_openPasses.empty() == false)
+	{
+		EndPass();
+	}
+
+	WriteTimestamp();
+	m_bInFrame = false;
+	m_pendingCount++;
+}
+
+/***********************************************************
+ *  BeginPass()
+ *
+ *  This method is used to start timing a named pass of the
+ *  current frame.
+ ***********************************************************/
+void GpuTimer::BeginPass(const char* name)
+{
+	if (m_bInFrame == false)
+	{
+		return;
+	}
+
+	FRAME_QUERIES& slot = m_slots[(m_readSlot + m_pendingCount) % (int)m_slots.size()];
+
+	PASS_QUERIES pass;
+	pass.name = name;
+	pass.beginQuery = WriteTimestamp();
+	pass.endQuery = -1;
+	slot.passes.push_back(pass);
+	m_openPasses.push_back((int)slot.passes.size() - 1);
+}
+
+/***********************************************************
+ *  EndPass()
+ *
+ *  This method is used to stop timing the most recently
+ *  started pass.
+ ***********************************************************/
+void GpuTimer::EndPass()
+{
+	if ((m_bInFrame == false) || (m_openPasses.empty()))
+	{
+		return;
+	}
+
+	FRAME_QUERIES& slot = m_slots[(m_readSlot + m_pendingCount) % (int)m_slots.size()];
+
+	slot.passes[m_openPasses.back()].endQuery = WriteTimestamp();
+	m_openPasses.pop_back();
+}
+
+/***********************************************************
+ *  ReadOldest()
+ *
+ *  This method is used to read the results of the oldest
+ *  pending frame.  Without waiting, false is returned when
+ *  the GPU has not finished the frame yet.  The finished
+ *  passes are also handed to the profiler.
+ ***********************************************************/
+bool GpuTimer::ReadOldest(bool bWait)
+{
+	if (m_pendingCount == 0)
+	{
+		return false;
+	}
+
+	FRAME_QUERIES& slot = m_slots[m_readSlot];
+
+	// the end of frame query is written last, so once it is
+	// available every other query of the frame is as well
+	if (bWait == false)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(slot.queries[slot.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == 0)
+		{
+			return false;
+		}
+	}
+
+	m_timestamps.resize(slot.usedQueries);
+	for (int i = 0; i < slot.usedQueries; i++)
+	{
+		glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &m_timestamps[i]);
+	}
+
+	m_finished.push_back(GPU_TIME());
+	GPU_TIME& result = m_finished.back();
+	result.frame = slot.frame;
+	result.milliseconds = (m_timestamps.back() - m_timestamps.front()) / 1000000.0;
+	result.passCount = (int)slot.passes.size();
+	if (result.passCount > MAX_PASSES)
+	{
+		result.passCount = MAX_PASSES;
+	}
+	for (int i = 0; i < result.passCount; i++)
+	{
+		const PASS_QUERIES& pass = slot.passes[i];
+		GLuint64 begin = m_timestamps[pass.beginQuery];
+		GLuint64 end = m_timestamps[pass.endQuery];
+
+		PASS_TIME& passTime = result.passes[i];
+		passTime.name = pass.name;
+		passTime.milliseconds = (end - begin) / 1000000.0;
+
+		if (Profiler::IsEnabled() == true)
+		{
+			Profiler::RecordGpuEvent(pass.name,
+				(uint64_t)((int64_t)begin + slot.profilerOffset),
+				(uint64_t)((int64_t)end + slot.profilerOffset));
+		}
+	}
+
+	m_readSlot = (m_readSlot + 1) % (int)m_slots.size();
+	m_pendingCount--;
+
+	return true;
+}
+
+/***********************************************************
+ *  CollectResults()
+ *
+ *  This method is used to append every finished frame to
+ *  the passed in list and returns how many were added.
+ ***********************************************************/
+int GpuTimer::CollectResults(std::vector<GPU_TIME>& results, bool bWait)
+{
+	while (ReadOldest(bWait) == true)
+	{
+	}
+
+	int count = (int)m_finished.size();
+	results.insert(results.end(), m_finished.begin(), m_finished.end());
+	m_finished.clear();
+
+	return(count);
+}
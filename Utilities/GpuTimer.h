@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// gputimer.h
+// ============
+// measure how long the GPU spends on each frame and on each render pass
+// with timer queries
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  GpuTimer
+ *
+ *  This class contains the code for timing frames and the
+ *  named passes inside of them on the GPU.  GL_TIMESTAMP
+ *  queries are written at the start and end of the frame
+ *  and of every pass, so passes can be nested inside the
+ *  frame.  Each frame uses its own slot of a query ring and
+ *  is read back a few frames later, once the GPU has
+ *  finished it, so timing never makes the CPU wait.  The
+ *  results are kept in fixed size records, so reading them
+ *  does not allocate.
+ ***********************************************************/
+class GpuTimer
+{
+public:
+	// constructor
+	GpuTimer();
+	// destructor
+	~GpuTimer();
+
+	// passes of a frame that are timed, later ones are skipped
+	static const int MAX_PASSES = 16;
+
+	// GPU time measured for one pass
+	struct PASS_TIME
+	{
+		const char* name;
+		double milliseconds;
+	};
+
+	// GPU time measured for one frame and its passes
+	struct GPU_TIME
+	{
+		int frame;
+		double milliseconds;
+		int passCount;
+		PASS_TIME passes[MAX_PASSES];
+	};
+
+	// create the query ring - it holds this many frames
+	// that are still waiting for their results
+	bool Create(int ringSize = 4);
+	// free the queries
+	void Destroy();
+
+	// start and stop timing the passed in frame
+	void BeginFrame(int frame);
+	void EndFrame();
+	// start and stop timing a pass of the current frame - the
+	// name must be a string literal
+	void BeginPass(const char* name);
+	void EndPass();
+
+	// move the finished results into the passed in list, in
+	// frame order - when waiting, every pending frame is read
+	int CollectResults(std::vector<GPU_TIME>& results, bool bWait = false);
+
+private:
+	// a pass and the timestamp queries around it
+	struct PASS_QUERIES
+	{
+		const char* name;
+		int beginQuery;
+		int endQuery;
+	};
+
+	// every query written for one frame
+	struct FRAME_QUERIES
+	{
+		int frame;
+		// query objects, reused by later frames in this slot
+		std::vector<GLuint> queries;
+		int usedQueries;
+		std::vector<PASS_QUERIES> passes;
+		// profiler time minus GPU time when the frame started
+		int64_t profilerOffset;
+	};
+
+	std::vector<FRAME_QUERIES> m_slots;
+	// oldest pending slot and the number of pending slots
+	int m_readSlot;
+	int m_pendingCount;
+	// true between BeginFrame() and EndFrame()
+	bool m_bInFrame;
+	// passes of the current frame that have not ended
+	std::vector<int> m_openPasses;
+	// results that were read but not collected yet
+	std::vector<GPU_TIME> m_finished;
+	// timestamps of the slot being read
+	std::vector<GLuint64> m_timestamps;
+
+	// write a timestamp query into the current slot
+	int WriteTimestamp();
+	// read the oldest pending slot, optionally waiting for it
+	bool ReadOldest(bool bWait);
+};
@@ -0,0 +1,209 @@
+///////////////////////////////////////////////////////////////////////////////
+// imagewriter.cpp
+// ============
+// encode and write read back frames as PNG files on background threads
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ImageWriter.h"
+#include "PngWriter.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+/***********************************************************
+ *  ImageWriter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ImageWriter::ImageWriter()
+{
+	m_queueLength = 1;
+	m_writing = 0;
+	m_statistics = STATISTICS();
+	m_bQuit = false;
+}
+
+/***********************************************************
+ *  ~ImageWriter()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ImageWriter::~ImageWriter()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to start the writing threads.
+ ***********************************************************/
+void ImageWriter::Start(int threadCount, int queueLength)
+{
+	Stop();
+
+	if (threadCount <= 0)
+	{
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	m_queueLength = (size_t)std::max(1, queueLength);
+	m_queue.reserve(m_queueLength);
+	m_bQuit = false;
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_threads.push_back(std::thread(&ImageWriter::ThreadLoop, this));
+	}
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used to write the queued frames, then
+ *  stop and join the threads.
+ ***********************************************************/
+void ImageWriter::Stop()
+{
+	if (m_threads.empty() == true)
+	{
+		return;
+	}
+
+	Finish();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bQuit = true;
+	}
+	m_wakeCondition.notify_all();
+	for (size_t i = 0; i < m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+	m_threads.clear();
+}
+
+/***********************************************************
+ *  AcquirePixels()
+ *
+ *  This method is used to hand out the pixel list of a
+ *  written frame, or an empty list when there is none.
+ ***********************************************************/
+void ImageWriter::AcquirePixels(std::vector<unsigned char>& pixels)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_freePixels.empty() == false)
+	{
+		pixels.swap(m_freePixels.back());
+		m_freePixels.pop_back();
+	}
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used to queue a frame for the threads,
+ *  waiting first while the queue is full.  A frame that is
+ *  submitted before Start() is dropped and counted as failed.
+ ***********************************************************/
+void ImageWriter::Submit(const std::string& filename, int width, int height, std::vector<unsigned char>& pixels)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_threads.empty() == true)
+	{
+		m_statistics.failedImages++;
+		return;
+	}
+	if (m_queue.size() >= m_queueLength)
+	{
+		PROFILE_SCOPE("ImageWriter stall");
+		m_statistics.stalls++;
+		m_doneCondition.wait(lock, [this]() { return(m_queue.size() < m_queueLength); });
+	}
+
+	m_queue.push_back(IMAGE());
+	IMAGE& image = m_queue.back();
+	image.filename = filename;
+	image.width = width;
+	image.height = height;
+	image.pixels.swap(pixels);
+	lock.unlock();
+	m_wakeCondition.notify_one();
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used to wait until the queue is empty and
+ *  no thread is writing.
+ ***********************************************************/
+void ImageWriter::Finish()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this]() { return((m_queue.empty() == true) && (m_writing == 0)); });
+}
+
+/***********************************************************
+ *  GetStatistics()
+ *
+ *  This method is used to get the counters of the images
+ *  written so far.
+ ***********************************************************/
+ImageWriter::STATISTICS ImageWriter::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return(m_statistics);
+}
+
+/***********************************************************
+ *  ThreadLoop()
+ *
+ *  This method is run by each writing thread.  It takes the
+ *  oldest queued frame, turns its rows around into RGB and
+ *  writes the PNG file, until it is told to quit.
+ ***********************************************************/
+void ImageWriter::ThreadLoop()
+{
+	Profiler::SetThreadName("Image writer");
+
+	// the RGB rows of the frame being written
+	std::vector<unsigned char> rgb;
+	IMAGE image;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wakeCondition.wait(lock, [this]() { return((m_bQuit == true) || (m_queue.empty() == false)); });
+		if (m_queue.empty() == true)
+		{
+			break;
+		}
+
+		image.filename.swap(m_queue.front().filename);
+		image.width = m_queue.front().width;
+		image.height = m_queue.front().height;
+		image.pixels.swap(m_queue.front().pixels);
+		m_queue.erase(m_queue.begin());
+		m_writing++;
+		lock.unlock();
+		m_doneCondition.notify_all();
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		bool bWritten = false;
+		{
+			PROFILE_SCOPE("WriteImage");
+			PngWriter::FlipRGBAToRGB(image.width, image.height, image.pixels.data(), rgb);
+			bWritten = PngWriter::WriteRGB(image.filename.c_str(), image.width, image.height, rgb.data());
+		}
+		double milliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+
+		lock.lock();
+		m_freePixels.push_back(std::vector<unsigned char>());
+		m_freePixels.back().swap(image.pixels);
+		m_statistics.images += bWritten ? 1 : 0;
+		m_statistics.failedImages += bWritten ? 0 : 1;
+		m_statistics.encodeMilliseconds += milliseconds;
+		m_writing--;
+		m_doneCondition.notify_all();
+	}
+}
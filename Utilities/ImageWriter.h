@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// imagewriter.h
+// ============
+// encode and write read back frames as PNG files on background threads
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  ImageWriter
+ *
+ *  This class contains a few threads that turn RGBA frames,
+ *  bottom row first as OpenGL reads them, into PNG files.
+ *  Submit() takes the pixels of a frame and returns at
+ *  once, so the frames are encoded while the next ones are
+ *  drawn.  At most the queue length of frames wait to be
+ *  written - a frame submitted to a full queue waits, which
+ *  is counted as a stall, so a slow disk cannot use up the
+ *  memory.
+ *
+ *  The pixel lists of the written frames are kept and handed
+ *  out again by AcquirePixels(), so a long batch of frames
+ *  does not keep allocating them.
+ ***********************************************************/
+class ImageWriter
+{
+public:
+	// the images written so far
+	struct STATISTICS
+	{
+		int images;
+		int failedImages;
+		// time the threads spent encoding and writing, summed
+		double encodeMilliseconds;
+		// frames that waited for room in the queue
+		int stalls;
+	};
+
+	// constructor
+	ImageWriter();
+	// destructor
+	~ImageWriter();
+
+	// start the threads - 0 uses one thread for each hardware
+	// thread - and set the most frames that wait to be written
+	void Start(int threadCount, int queueLength);
+	// write the queued frames and stop the threads
+	void Stop();
+
+	// get a list for the pixels of the next frame, reusing the
+	// list of a written frame when there is one
+	void AcquirePixels(std::vector<unsigned char>& pixels);
+	// queue width * height RGBA pixels, bottom row first, to be
+	// written into a PNG file - the pixels are taken out of the
+	// passed in list
+	void Submit(const std::string& filename, int width, int height, std::vector<unsigned char>& pixels);
+	// wait until every queued frame is written
+	void Finish();
+
+	STATISTICS GetStatistics();
+	int GetThreadCount() const { return((int)m_threads.size()); }
+
+private:
+	// one frame waiting to be written
+	struct IMAGE
+	{
+		std::string filename;
+		int width;
+		int height;
+		std::vector<unsigned char> pixels;
+	};
+
+	std::vector<std::thread> m_threads;
+	// shared with the threads under m_mutex - the queued frames,
+	// the frames being written and the lists to reuse
+	std::mutex m_mutex;
+	std::condition_variable m_wakeCondition;
+	std::condition_variable m_doneCondition;
+	std::vector<IMAGE> m_queue;
+	size_t m_queueLength;
+	int m_writing;
+	std::vector<std::vector<unsigned char>> m_freePixels;
+	STATISTICS m_statistics;
+	bool m_bQuit;
+
+	// run by each writing thread
+	void ThreadLoop();
+};
@@ -0,0 +1,394 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// run the per-frame scene work as a graph of jobs on a pool of worker
+// threads that steal work from each other
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <string>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the job system and queue that the current thread belongs to
+	thread_local const JobSystem* t_pJobSystem = NULL;
+	thread_local int t_queueIndex = 0;
+
+	// jobs every queue has room for before it has to grow
+	const size_t g_InitialQueueSize = 64;
+}
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem(int threadCount)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	m_queuedJobs = 0;
+	m_bQuit = false;
+	for (int i = 0; i < threadCount; i++)
+	{
+		// the rings are sized here, so queues that a frame pushes
+		// to for the first time do not allocate
+		JOB_QUEUE* queue = new JOB_QUEUE();
+		queue->jobs.resize(g_InitialQueueSize);
+		queue->first = 0;
+		queue->count = 0;
+		m_queues.push_back(queue);
+	}
+
+	// the calling thread is the first one, so one fewer
+	// worker is started than the thread count
+	for (int i = 1; i < threadCount; i++)
+	{
+		m_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_bQuit = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	for (size_t i = 0; i < m_queues.size(); i++)
+	{
+		delete m_queues[i];
+	}
+	m_queues.clear();
+
+	Reset();
+}
+
+/***********************************************************
+ *  CreateJob()
+ *
+ *  This method is used to create a job that runs the passed
+ *  in function once it is submitted and its dependencies
+ *  have finished.
+ ***********************************************************/
+JobSystem::JOB* JobSystem::CreateJob(const char* name, std::function<void()> work)
+{
+	JOB* job = new (m_frameArena.allocate(sizeof(JOB), alignof(JOB))) JOB(&m_frameArena);
+	{
+		std::lock_guard<std::mutex> lock(m_jobsMutex);
+		m_jobs.push_back(job);
+	}
+
+	job->name = name;
+	job->work = std::move(work);
+	job->dependencies = 1;
+	job->bFinished = false;
+
+	return(job);
+}
+
+/***********************************************************
+ *  AddDependency()
+ *
+ *  This method is used to make a job wait for another job
+ *  before it can run.
+ ***********************************************************/
+void JobSystem::AddDependency(JOB* job, JOB* dependency)
+{
+	dependency->successors.push_back(job);
+	job->dependencies++;
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used to release a job, so it is queued as
+ *  soon as all of its dependencies have finished.
+ ***********************************************************/
+void JobSystem::Submit(JOB* job)
+{
+	if (job->dependencies.fetch_sub(1) == 1)
+	{
+		QueueJob(job);
+	}
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used to wait for a job to finish while
+ *  running any queued jobs on the calling thread.
+ ***********************************************************/
+void JobSystem::Wait(JOB* job)
+{
+	while (job->bFinished.load(std::memory_order_acquire) == false)
+	{
+		JOB* next = FindJob();
+		if (NULL != next)
+		{
+			RunJob(next);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used to run the passed in function over
+ *  the range [0, count) in batches on all of the threads.
+ *  It returns when all of the batches have finished.
+ ***********************************************************/
+void JobSystem::ParallelFor(
+	int count,
+	int batchSize,
+	const std::function<void(int first, int count)>& work)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	// small ranges are not worth handing to other threads
+	batchSize = std::max(1, batchSize);
+	if (m_workers.empty() || (count <= batchSize))
+	{
+		work(0, count);
+		return;
+	}
+
+	JOB* done = CreateJob("ParallelFor", []() {});
+	// both lists are sized up front so they are not grown
+	// and copied while the batches are created
+	size_t batchTotal = (size_t)((count + batchSize - 1) / batchSize);
+	std::pmr::vector<JOB*> batches(&m_frameArena);
+	batches.reserve(batchTotal);
+	done->successors.reserve(batchTotal);
+	for (int first = 0; first < count; first += batchSize)
+	{
+		int batchCount = std::min(batchSize, count - first);
+		JOB* batch = CreateJob("ParallelForBatch", [&work, first, batchCount]() {
+			work(first, batchCount);
+		});
+		AddDependency(done, batch);
+		batches.push_back(batch);
+	}
+
+	Submit(done);
+	for (size_t i = 0; i < batches.size(); i++)
+	{
+		Submit(batches[i]);
+	}
+	Wait(done);
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used to free the created jobs and the
+ *  rest of the frame arena, usually once at the end of each
+ *  frame.
+ ***********************************************************/
+void JobSystem::Reset()
+{
+	std::lock_guard<std::mutex> lock(m_jobsMutex);
+	for (size_t i = 0; i < m_jobs.size(); i++)
+	{
+		m_jobs[i]->~JOB();
+	}
+	m_jobs.clear();
+	m_frameArena.Reset();
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is run by each worker thread.  It runs jobs
+ *  until there are none left, then sleeps until more are
+ *  queued.
+ ***********************************************************/
+void JobSystem::WorkerLoop(int queueIndex)
+{
+	t_pJobSystem = this;
+	t_queueIndex = queueIndex;
+
+	std::string threadName = "Job worker " + std::to_string(queueIndex);
+	Profiler::SetThreadName(threadName.c_str());
+
+	while (true)
+	{
+		JOB* job = FindJob();
+		if (NULL != job)
+		{
+			RunJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeCondition.wait(lock, [this]() {
+			return((m_bQuit == true) || (m_queuedJobs.load() > 0));
+		});
+		if (m_bQuit == true)
+		{
+			break;
+		}
+	}
+}
+
+/***********************************************************
+ *  QueueJob()
+ *
+ *  This method is used to add a job that is ready to run to
+ *  the calling thread's queue and wake a sleeping worker.
+ ***********************************************************/
+void JobSystem::QueueJob(JOB* job)
+{
+	PushJob(m_queues[GetQueueIndex()], job);
+	m_queuedJobs++;
+
+	// taking the lock makes sure a worker that is about to
+	// sleep either sees the job or gets the notification
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wakeCondition.notify_one();
+}
+
+/***********************************************************
+ *  PushJob()
+ *
+ *  This method is used to add a job to the newest end of a
+ *  queue's ring, moving the jobs into a larger ring first
+ *  when it is full.
+ ***********************************************************/
+void JobSystem::PushJob(JOB_QUEUE* queue, JOB* job)
+{
+	std::lock_guard<std::mutex> lock(queue->mutex);
+
+	size_t size = queue->jobs.size();
+	if (queue->count == size)
+	{
+		std::vector<JOB*> jobs(std::max(g_InitialQueueSize, size * 2));
+		for (size_t i = 0; i < queue->count; i++)
+		{
+			jobs[i] = queue->jobs[(queue->first + i) % size];
+		}
+		queue->jobs.swap(jobs);
+		queue->first = 0;
+		size = queue->jobs.size();
+	}
+
+	queue->jobs[(queue->first + queue->count) % size] = job;
+	queue->count++;
+}
+
+/***********************************************************
+ *  FindJob()
+ *
+ *  This method is used to take the newest job from the
+ *  calling thread's queue, or the oldest job of another
+ *  thread's queue when its own is empty.
+ ***********************************************************/
+JobSystem::JOB* JobSystem::FindJob()
+{
+	if (m_queuedJobs.load() == 0)
+	{
+		return(NULL);
+	}
+
+	int queueCount = (int)m_queues.size();
+	int ownIndex = GetQueueIndex();
+	for (int i = 0; i < queueCount; i++)
+	{
+		int index = (ownIndex + i) % queueCount;
+		JOB_QUEUE* queue = m_queues[index];
+
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (queue->count == 0)
+		{
+			continue;
+		}
+
+		size_t size = queue->jobs.size();
+		JOB* job = NULL;
+		if (index == ownIndex)
+		{
+			job = queue->jobs[(queue->first + queue->count - 1) % size];
+		}
+		else
+		{
+			job = queue->jobs[queue->first];
+			queue->first = (queue->first + 1) % size;
+		}
+		queue->count--;
+		m_queuedJobs--;
+		return(job);
+	}
+
+	return(NULL);
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used to run a job, then queue the jobs
+ *  that were only waiting for it.
+ ***********************************************************/
+void JobSystem::RunJob(JOB* job)
+{
+	{
+		PROFILE_SCOPE(job->name);
+		job->work();
+	}
+
+	// the job can be freed as soon as the last job waiting for it
+	// runs, so nothing of it is touched after releasing that one
+	JOB* const* successors = job->successors.data();
+	size_t successorCount = job->successors.size();
+	job->bFinished.store(true, std::memory_order_release);
+
+	for (size_t i = 0; i < successorCount; i++)
+	{
+		JOB* successor = successors[i];
+		if (successor->dependencies.fetch_sub(1) == 1)
+		{
+			QueueJob(successor);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetQueueIndex()
+ *
+ *  This method is used to get the queue of the calling
+ *  thread - threads outside of the pool use the first one.
+ ***********************************************************/
+int JobSystem::GetQueueIndex() const
+{
+	if (t_pJobSystem == this)
+	{
+		return(t_queueIndex);
+	}
+	return(0);
+}
@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// run the per-frame scene work as a graph of jobs on a pool of worker
+// threads that steal work from each other
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameArena.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class contains a pool of worker threads, each with
+ *  its own queue of jobs.  A thread runs the newest job of
+ *  its own queue and, when that is empty, steals the oldest
+ *  job of another queue.  Jobs can depend on other jobs, so
+ *  the work of a frame is built as a graph and only the jobs
+ *  whose dependencies have finished are queued.  A thread
+ *  that waits for a job runs other jobs in the meantime, so
+ *  jobs can wait for the jobs they create.
+ *
+ *  The jobs and their lists live in a frame arena that is
+ *  reset together with the jobs, and the queues keep their
+ *  storage, so a frame's job graph does not use the heap
+ *  once the first frames have sized everything.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// one node of the job graph
+	struct JOB
+	{
+		// constructor - the successors live in the passed in arena
+		JOB(std::pmr::memory_resource* pResource) : successors(pResource) {}
+
+		// name shown in the profiler trace
+		const char* name;
+		std::function<void()> work;
+		// unfinished dependencies, plus one until submitted
+		std::atomic<int> dependencies;
+		// jobs that wait for this one
+		std::pmr::vector<JOB*> successors;
+		std::atomic<bool> bFinished;
+	};
+
+	// constructor - the thread count includes the calling thread,
+	// and 0 uses one thread for each hardware thread
+	JobSystem(int threadCount = 0);
+	// destructor
+	~JobSystem();
+
+	// create a job that runs the passed in function - it does
+	// not start before it is submitted
+	JOB* CreateJob(const char* name, std::function<void()> work);
+	// make a job wait for another job - both jobs must not be
+	// submitted yet
+	void AddDependency(JOB* job, JOB* dependency);
+	// let a job run as soon as its dependencies have finished
+	void Submit(JOB* job);
+	// run jobs on the calling thread until the passed in job
+	// has finished
+	void Wait(JOB* job);
+
+	// split the range [0, count) into batches of the passed in
+	// size, run them on all threads and wait for them
+	void ParallelFor(
+		int count,
+		int batchSize,
+		const std::function<void(int first, int count)>& work);
+
+	// free the jobs created so far and everything allocated
+	// from the frame arena - no job may be running
+	void Reset();
+	// memory that is released by the next Reset(), for the
+	// scratch data of the jobs
+	FrameArena* GetFrameArena() { return(&m_frameArena); }
+
+	// number of threads that run jobs, including the calling thread
+	int GetThreadCount() const { return((int)m_queues.size()); }
+
+private:
+	// jobs that are ready to run on one thread, in a ring that
+	// grows when it is full and is never shrunk
+	struct JOB_QUEUE
+	{
+		std::mutex mutex;
+		std::vector<JOB*> jobs;
+		// position of the oldest job and the number of jobs
+		size_t first;
+		size_t count;
+	};
+
+	std::vector<std::thread> m_workers;
+	// one queue per thread, the calling thread uses the first
+	std::vector<JOB_QUEUE*> m_queues;
+	// memory of the created jobs and their lists
+	FrameArena m_frameArena;
+	// the created jobs, kept until Reset()
+	std::vector<JOB*> m_jobs;
+	std::mutex m_jobsMutex;
+	// number of jobs in all of the queues
+	std::atomic<int> m_queuedJobs;
+	// idle workers sleep until a job is queued
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+	bool m_bQuit;
+
+	// loop of each worker thread
+	void WorkerLoop(int queueIndex);
+	// queue a job whose dependencies have finished
+	void QueueJob(JOB* job);
+	// add a job to the newest end of a queue
+	void PushJob(JOB_QUEUE* queue, JOB* job);
+	// take a job from the calling thread's queue or another one
+	JOB* FindJob();
+	// run a job and release the jobs that wait for it
+	void RunJob(JOB* job);
+	// index of the calling thread's queue
+	int GetQueueIndex() const;
+};
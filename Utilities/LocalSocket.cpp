@@ -0,0 +1,253 @@
+///////////////////////////////////////////////////////////////////////////////
+// localsocket.cpp
+// ============
+// open, read and write the Unix domain sockets of the render service and
+// its clients
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LocalSocket.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+
+// the render service needs AF_UNIX sockets, which are not set
+// up on Windows
+int LocalSocket::Listen(const char* socketPath)
+{
+	std::cout << "Could not listen on:" << socketPath
+		<< " - Unix domain sockets are not supported on this platform" << std::endl;
+	return(-1);
+}
+int LocalSocket::Accept(int) { return(-1); }
+int LocalSocket::Connect(const char*) { return(-1); }
+int LocalSocket::Receive(int, void*, size_t) { return(-1); }
+bool LocalSocket::ReadAll(int, void*, size_t) { return(false); }
+bool LocalSocket::WriteAll(int, const void*, size_t) { return(false); }
+void LocalSocket::Shutdown(int) {}
+void LocalSocket::Close(int) {}
+void LocalSocket::RemoveFile(const char*) {}
+
+#else
+
+// declaration of the global variables and defines
+namespace
+{
+	// clients that are waiting to be accepted
+	const int g_ListenBacklog = 16;
+
+	// fill the address of a socket file - false when the path
+	// does not fit
+	bool MakeAddress(const char* socketPath, sockaddr_un& address)
+	{
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (strlen(socketPath) >= sizeof(address.sun_path))
+		{
+			return(false);
+		}
+		strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+		return(true);
+	}
+
+	// true when the path is a socket file - anything else at
+	// the path is never removed
+	bool IsSocketFile(const char* socketPath)
+	{
+		struct stat status;
+		return((lstat(socketPath, &status) == 0) && S_ISSOCK(status.st_mode));
+	}
+}
+
+/***********************************************************
+ *  Listen()
+ *
+ *  This method is used to bind a listening socket to a file.
+ *  A socket file that no service answers on any more is
+ *  removed first, but any other file at the path, or a
+ *  socket that is still served, makes it fail.
+ ***********************************************************/
+int LocalSocket::Listen(const char* socketPath)
+{
+	sockaddr_un address;
+	if (MakeAddress(socketPath, address) == false)
+	{
+		std::cout << "Could not listen on:" << socketPath << " - the path is too long" << std::endl;
+		return(-1);
+	}
+
+	struct stat status;
+	if (lstat(socketPath, &status) == 0)
+	{
+		if (S_ISSOCK(status.st_mode) == 0)
+		{
+			std::cout << "Could not listen on:" << socketPath << " - the path is not a socket" << std::endl;
+			return(-1);
+		}
+		int probe = Connect(socketPath);
+		if (probe >= 0)
+		{
+			Close(probe);
+			std::cout << "Could not listen on:" << socketPath << " - another service is using it" << std::endl;
+			return(-1);
+		}
+		unlink(socketPath);
+	}
+
+	int listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenSocket < 0)
+	{
+		std::cout << "Could not listen on:" << socketPath << " - " << strerror(errno) << std::endl;
+		return(-1);
+	}
+	if ((bind(listenSocket, (const sockaddr*)&address, sizeof(address)) != 0) ||
+		(listen(listenSocket, g_ListenBacklog) != 0))
+	{
+		std::cout << "Could not listen on:" << socketPath << " - " << strerror(errno) << std::endl;
+		close(listenSocket);
+		return(-1);
+	}
+	return(listenSocket);
+}
+
+/***********************************************************
+ *  Accept()
+ *
+ *  This method is used to wait for the next client.
+ ***********************************************************/
+int LocalSocket::Accept(int listenSocket)
+{
+	int connection = -1;
+	do
+	{
+		connection = accept(listenSocket, NULL, NULL);
+	} while ((connection < 0) && (errno == EINTR));
+	return(connection);
+}
+
+/***********************************************************
+ *  Connect()
+ *
+ *  This method is used to connect to the service listening
+ *  on a socket file.
+ ***********************************************************/
+int LocalSocket::Connect(const char* socketPath)
+{
+	sockaddr_un address;
+	if (MakeAddress(socketPath, address) == false)
+	{
+		return(-1);
+	}
+
+	int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (connection < 0)
+	{
+		return(-1);
+	}
+	if (connect(connection, (const sockaddr*)&address, sizeof(address)) != 0)
+	{
+		close(connection);
+		return(-1);
+	}
+	return(connection);
+}
+
+/***********************************************************
+ *  Receive()
+ *
+ *  This method is used to read the bytes that have arrived.
+ ***********************************************************/
+int LocalSocket::Receive(int connection, void* pBuffer, size_t size)
+{
+	ssize_t count = -1;
+	do
+	{
+		count = recv(connection, pBuffer, size, 0);
+	} while ((count < 0) && (errno == EINTR));
+	return((int)count);
+}
+
+/***********************************************************
+ *  ReadAll()
+ *
+ *  This method is used to read until the passed in number of
+ *  bytes arrived.
+ ***********************************************************/
+bool LocalSocket::ReadAll(int connection, void* pBytes, size_t size)
+{
+	char* pNext = (char*)pBytes;
+	while (size > 0)
+	{
+		int count = Receive(connection, pNext, size);
+		if (count <= 0)
+		{
+			return(false);
+		}
+		pNext += count;
+		size -= (size_t)count;
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  WriteAll()
+ *
+ *  This method is used to write all of the bytes.  They are
+ *  sent with MSG_NOSIGNAL, so a peer that hung up fails the
+ *  write instead of raising SIGPIPE.
+ ***********************************************************/
+bool LocalSocket::WriteAll(int connection, const void* pBytes, size_t size)
+{
+	const char* pNext = (const char*)pBytes;
+	while (size > 0)
+	{
+		ssize_t count = send(connection, pNext, size, MSG_NOSIGNAL);
+		if ((count < 0) && (errno == EINTR))
+		{
+			continue;
+		}
+		if (count <= 0)
+		{
+			return(false);
+		}
+		pNext += count;
+		size -= (size_t)count;
+	}
+	return(true);
+}
+
+void LocalSocket::Shutdown(int connection)
+{
+	shutdown(connection, SHUT_RDWR);
+}
+
+void LocalSocket::Close(int connection)
+{
+	close(connection);
+}
+
+/***********************************************************
+ *  RemoveFile()
+ *
+ *  This method is used to remove a socket file once its
+ *  service stopped, leaving any other file at the path.
+ ***********************************************************/
+void LocalSocket::RemoveFile(const char* socketPath)
+{
+	if (IsSocketFile(socketPath) == true)
+	{
+		unlink(socketPath);
+	}
+}
+
+#endif
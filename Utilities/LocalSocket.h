@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// localsocket.h
+// ============
+// open, read and write the Unix domain sockets of the render service and
+// its clients
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  LocalSocket
+ *
+ *  This class contains the socket calls shared by the render
+ *  service and the tile coordinator.  The sockets are AF_UNIX
+ *  stream sockets named by a file, and a socket is the file
+ *  descriptor, with -1 for none.  Writes never raise SIGPIPE,
+ *  so a peer that hangs up only fails the write instead of
+ *  ending the process.  Windows has no support, so every
+ *  call there fails.
+ ***********************************************************/
+class LocalSocket
+{
+public:
+	// bind a listening socket to the file, replacing a socket
+	// file left behind by a service that did not stop cleanly -
+	// a path that is not a socket, or is still served, is refused
+	static int Listen(const char* socketPath);
+	// wait for the next client of a listening socket
+	static int Accept(int listenSocket);
+	// connect to the socket file - returns -1 quietly when no
+	// service answers there
+	static int Connect(const char* socketPath);
+
+	// read what has arrived, up to size bytes - returns the
+	// number of bytes, 0 once the peer hung up, or -1
+	static int Receive(int connection, void* pBuffer, size_t size);
+	// read exactly size bytes
+	static bool ReadAll(int connection, void* pBytes, size_t size);
+	// write all of the bytes
+	static bool WriteAll(int connection, const void* pBytes, size_t size);
+
+	// wake the threads blocked on the socket
+	static void Shutdown(int connection);
+	static void Close(int connection);
+	// remove the socket file, if it still is one
+	static void RemoveFile(const char* socketPath);
+};
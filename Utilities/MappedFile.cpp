@@ -0,0 +1,285 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.cpp
+// ============
+// map a whole file into memory for reading, or create a file of a fixed
+// size and map it for writing
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+	m_bWritable = false;
+#ifdef _WIN32
+	m_file = NULL;
+	m_mapping = NULL;
+#else
+	m_file = -1;
+#endif
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+/***********************************************************
+ *  OpenForReading()
+ *
+ *  This method is used to map the whole of an existing file
+ *  for reading.  It returns false when the file does not
+ *  exist, is empty or cannot be mapped.
+ ***********************************************************/
+bool MappedFile::OpenForReading(const char* filename)
+{
+	Close();
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if ((GetFileSizeEx(file, &size) == FALSE) || (size.QuadPart == 0))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void* pData = (mapping != NULL) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (NULL == pData)
+	{
+		std::cout << "Could not map file:" << filename << std::endl;
+		if (mapping != NULL)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_pData = (unsigned char*)pData;
+	m_size = (size_t)size.QuadPart;
+	m_bWritable = false;
+	return true;
+}
+
+/***********************************************************
+ *  CreateForWriting()
+ *
+ *  This method is used to create a file of the passed in
+ *  size, replacing any file with the same name, and map it
+ *  for writing.
+ ***********************************************************/
+bool MappedFile::CreateForWriting(const char* filename, size_t size)
+{
+	Close();
+
+	if (size == 0)
+	{
+		return false;
+	}
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	// creating the mapping also sets the size of the file
+	ULARGE_INTEGER mappingSize;
+	mappingSize.QuadPart = size;
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+		mappingSize.HighPart, mappingSize.LowPart, NULL);
+	void* pData = (mapping != NULL) ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : NULL;
+	if (NULL == pData)
+	{
+		std::cout << "Could not map file:" << filename << std::endl;
+		if (mapping != NULL)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_pData = (unsigned char*)pData;
+	m_size = size;
+	m_bWritable = true;
+	return true;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to unmap the file and close it.
+ ***********************************************************/
+void MappedFile::Close()
+{
+	if (m_pData != NULL)
+	{
+		if (m_bWritable == true)
+		{
+			FlushViewOfFile(m_pData, m_size);
+		}
+		UnmapViewOfFile(m_pData);
+	}
+	if (m_mapping != NULL)
+	{
+		CloseHandle((HANDLE)m_mapping);
+	}
+	if (m_file != NULL)
+	{
+		CloseHandle((HANDLE)m_file);
+	}
+
+	m_pData = NULL;
+	m_size = 0;
+	m_bWritable = false;
+	m_file = NULL;
+	m_mapping = NULL;
+}
+
+#else
+
+/***********************************************************
+ *  OpenForReading()
+ *
+ *  This method is used to map the whole of an existing file
+ *  for reading.  It returns false when the file does not
+ *  exist, is empty or cannot be mapped.
+ ***********************************************************/
+bool MappedFile::OpenForReading(const char* filename)
+{
+	Close();
+
+	int descriptor = open(filename, O_RDONLY);
+	if (descriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if ((fstat(descriptor, &status) != 0) || (status.st_size <= 0))
+	{
+		close(descriptor);
+		return false;
+	}
+
+	void* pData = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (pData == MAP_FAILED)
+	{
+		std::cout << "Could not map file:" << filename << std::endl;
+		close(descriptor);
+		return false;
+	}
+
+	m_file = descriptor;
+	m_pData = (unsigned char*)pData;
+	m_size = (size_t)status.st_size;
+	m_bWritable = false;
+	return true;
+}
+
+/***********************************************************
+ *  CreateForWriting()
+ *
+ *  This method is used to create a file of the passed in
+ *  size, replacing any file with the same name, and map it
+ *  for writing.
+ ***********************************************************/
+bool MappedFile::CreateForWriting(const char* filename, size_t size)
+{
+	Close();
+
+	if (size == 0)
+	{
+		return false;
+	}
+
+	int descriptor = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (descriptor < 0)
+	{
+		return false;
+	}
+
+	void* pData = MAP_FAILED;
+	if (ftruncate(descriptor, (off_t)size) == 0)
+	{
+		pData = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	}
+	if (pData == MAP_FAILED)
+	{
+		std::cout << "Could not map file:" << filename << std::endl;
+		close(descriptor);
+		return false;
+	}
+
+	m_file = descriptor;
+	m_pData = (unsigned char*)pData;
+	m_size = size;
+	m_bWritable = true;
+	return true;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to unmap the file and close it.
+ *  Changes to a file mapped for writing are written back
+ *  by the system.
+ ***********************************************************/
+void MappedFile::Close()
+{
+	if (m_pData != NULL)
+	{
+		munmap(m_pData, m_size);
+	}
+	if (m_file >= 0)
+	{
+		close(m_file);
+	}
+
+	m_pData = NULL;
+	m_size = 0;
+	m_bWritable = false;
+	m_file = -1;
+}
+
+#endif
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// map a whole file into memory for reading, or create a file of a fixed
+// size and map it for writing
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class contains the code for mapping files into the
+ *  address space, so their contents can be used in place
+ *  instead of being read into a copy.  It uses mmap() on
+ *  POSIX systems and file mapping objects on Windows.  The
+ *  memory stays valid until Close() is called.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// not copyable, since it owns the mapping
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// map an existing file for reading
+	bool OpenForReading(const char* filename);
+	// create, or replace, a file of the passed in size and map
+	// it for writing
+	bool CreateForWriting(const char* filename, size_t size);
+	// unmap the file, writing any changes back to it
+	void Close();
+
+	bool IsOpen() const { return(m_pData != NULL); }
+	const unsigned char* GetData() const { return(m_pData); }
+	// NULL unless the file was mapped for writing
+	unsigned char* GetWritableData() const { return(m_bWritable ? m_pData : NULL); }
+	size_t GetSize() const { return(m_size); }
+
+private:
+	unsigned char* m_pData;
+	size_t m_size;
+	bool m_bWritable;
+	// operating system handles of the open file
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+};
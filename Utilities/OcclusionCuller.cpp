@@ -0,0 +1,584 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.cpp
+// ============
+// rasterize large occluders into a low resolution hierarchical depth buffer
+// on the CPU and test object bounding boxes against it before drawing
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <thread>
+
+// SSE2 is always available on x64 targets, so it is used for the
+// depth rasterization inner loop whenever the compiler allows it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define OCCLUSION_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// size of the screen tiles that are rasterized independently
+	const int g_TileWidth = 64;
+	const int g_TileHeight = 32;
+	// size of the hierarchical depth blocks - must divide the tile size
+	const int g_BlockSize = 8;
+	// clip space w values below this are treated as behind the camera
+	const float g_MinClipW = 1e-5f;
+	// triangles with a smaller screen area than this are skipped
+	const float g_MinTriangleArea = 1e-6f;
+
+	// round the passed in value up to a multiple of the passed in step
+	int RoundUp(int value, int step)
+	{
+		return(((value + step - 1) / step) * step);
+	}
+}
+
+/***********************************************************
+ *  OcclusionCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCuller::OcclusionCuller(int width, int height)
+{
+	// the rasterizer works on whole blocks, so round the
+	// requested size up to the block size
+	m_width = RoundUp(std::max(width, g_BlockSize), g_BlockSize);
+	m_height = RoundUp(std::max(height, g_BlockSize), g_BlockSize);
+	m_tilesX = RoundUp(m_width, g_TileWidth) / g_TileWidth;
+	m_tilesY = RoundUp(m_height, g_TileHeight) / g_TileHeight;
+	m_blocksX = m_width / g_BlockSize;
+	m_blocksY = m_height / g_BlockSize;
+
+	m_threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	m_pJobSystem = NULL;
+	m_viewProjection = glm::mat4(1.0f);
+	m_bRendered = false;
+
+	m_depth.assign(m_width * m_height, 1.0f);
+	m_blockMaxDepth.assign(m_blocksX * m_blocksY, 1.0f);
+}
+
+/***********************************************************
+ *  ~OcclusionCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OcclusionCuller::~OcclusionCuller()
+{
+	m_worldVertices.clear();
+	m_screenTriangles.clear();
+}
+
+/***********************************************************
+ *  ClearOccluders()
+ *
+ *  This method is used to remove all registered occluders.
+ ***********************************************************/
+void OcclusionCuller::ClearOccluders()
+{
+	m_worldVertices.clear();
+	m_bRendered = false;
+}
+
+/***********************************************************
+ *  AddOccluderTriangle()
+ *
+ *  This method is used to register a single world space
+ *  triangle as an occluder.  Winding does not matter.
+ ***********************************************************/
+void OcclusionCuller::AddOccluderTriangle(
+	const glm::vec3& p0,
+	const glm::vec3& p1,
+	const glm::vec3& p2)
+{
+	m_worldVertices.push_back(p0);
+	m_worldVertices.push_back(p1);
+	m_worldVertices.push_back(p2);
+}
+
+/***********************************************************
+ *  AddOccluderPlane()
+ *
+ *  This method is used to register the plane mesh from
+ *  ShapeMeshes, transformed by the passed in model matrix,
+ *  as an occluder.
+ ***********************************************************/
+void OcclusionCuller::AddOccluderPlane(const glm::mat4& model)
+{
+	// same corners as the plane mesh vertex data
+	glm::vec3 corners[4];
+	corners[0] = glm::vec3(model * glm::vec4(-1.0f, 0.0f, 1.0f, 1.0f));
+	corners[1] = glm::vec3(model * glm::vec4(1.0f, 0.0f, 1.0f, 1.0f));
+	corners[2] = glm::vec3(model * glm::vec4(1.0f, 0.0f, -1.0f, 1.0f));
+	corners[3] = glm::vec3(model * glm::vec4(-1.0f, 0.0f, -1.0f, 1.0f));
+
+	AddOccluderTriangle(corners[0], corners[1], corners[2]);
+	AddOccluderTriangle(corners[0], corners[3], corners[2]);
+}
+
+/***********************************************************
+ *  AddOccluderBox()
+ *
+ *  This method is used to register an object space box,
+ *  transformed by the passed in model matrix, as an occluder.
+ *  The box should fit inside of the drawn object.
+ ***********************************************************/
+void OcclusionCuller::AddOccluderBox(
+	const glm::mat4& model,
+	const glm::vec3& minCorner,
+	const glm::vec3& maxCorner)
+{
+	glm::vec3 corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec4 corner(
+			(i & 1) ? maxCorner.x : minCorner.x,
+			(i & 2) ? maxCorner.y : minCorner.y,
+			(i & 4) ? maxCorner.z : minCorner.z,
+			1.0f);
+		corners[i] = glm::vec3(model * corner);
+	}
+
+	// two triangles for each of the six faces
+	const int faces[6][4] = {
+		{ 0, 1, 3, 2 },		// bottom
+		{ 4, 5, 7, 6 },		// top
+		{ 0, 1, 5, 4 },		// front
+		{ 2, 3, 7, 6 },		// back
+		{ 0, 2, 6, 4 },		// left
+		{ 1, 3, 7, 5 }		// right
+	};
+	for (int i = 0; i < 6; i++)
+	{
+		AddOccluderTriangle(corners[faces[i][0]], corners[faces[i][1]], corners[faces[i][2]]);
+		AddOccluderTriangle(corners[faces[i][0]], corners[faces[i][2]], corners[faces[i][3]]);
+	}
+}
+
+/***********************************************************
+ *  SetThreadCount()
+ *
+ *  This method is used to set the number of worker threads
+ *  that rasterize the screen tiles.
+ ***********************************************************/
+void OcclusionCuller::SetThreadCount(int threadCount)
+{
+	m_threadCount = std::max(1, threadCount);
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used to set the job system that the
+ *  screen tiles are rasterized on.
+ ***********************************************************/
+void OcclusionCuller::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
+
+/***********************************************************
+ *  RenderOccluders()
+ *
+ *  This method is used to rasterize all of the registered
+ *  occluders into the depth buffer for the passed in view.
+ ***********************************************************/
+void OcclusionCuller::RenderOccluders(const glm::mat4& viewProjection)
+{
+	m_viewProjection = viewProjection;
+
+	// transform, clip and set up all of the occluder triangles
+	m_screenTriangles.clear();
+	for (size_t i = 0; i + 2 < m_worldVertices.size(); i += 3)
+	{
+		SetupTriangle(
+			viewProjection * glm::vec4(m_worldVertices[i], 1.0f),
+			viewProjection * glm::vec4(m_worldVertices[i + 1], 1.0f),
+			viewProjection * glm::vec4(m_worldVertices[i + 2], 1.0f));
+	}
+
+	// each tile only writes its own pixels and blocks, so the
+	// tiles can be spread over the worker threads in any order
+	int tileCount = m_tilesX * m_tilesY;
+	int threadCount = std::min(m_threadCount, tileCount);
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(tileCount, 1, [this](int first, int count) {
+			for (int i = first; i < first + count; i++)
+			{
+				RasterizeTile(i);
+			}
+		});
+	}
+	else if (threadCount <= 1)
+	{
+		for (int i = 0; i < tileCount; i++)
+		{
+			RasterizeTile(i);
+		}
+	}
+	else
+	{
+		std::vector<std::thread> workers;
+		workers.reserve(threadCount);
+		for (int t = 0; t < threadCount; t++)
+		{
+			workers.emplace_back([this, t, threadCount, tileCount]() {
+				PROFILE_SCOPE("RasterizeTiles");
+				for (int i = t; i < tileCount; i += threadCount)
+				{
+					RasterizeTile(i);
+				}
+			});
+		}
+		for (size_t t = 0; t < workers.size(); t++)
+		{
+			workers[t].join();
+		}
+	}
+
+	m_bRendered = true;
+}
+
+/***********************************************************
+ *  SetupTriangle()
+ *
+ *  This method is used to clip a clip space triangle against
+ *  the near plane and pass the remaining pieces on for
+ *  screen space setup.
+ ***********************************************************/
+void OcclusionCuller::SetupTriangle(
+	const glm::vec4& c0,
+	const glm::vec4& c1,
+	const glm::vec4& c2)
+{
+	const glm::vec4 input[3] = { c0, c1, c2 };
+	glm::vec4 output[4];
+	int outputCount = 0;
+
+	// clip against the near plane (z >= -w) - a triangle clipped
+	// by a single plane has at most four vertices
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& current = input[i];
+		const glm::vec4& next = input[(i + 1) % 3];
+		float currentDistance = current.z + current.w;
+		float nextDistance = next.z + next.w;
+
+		if (currentDistance >= 0.0f)
+		{
+			output[outputCount++] = current;
+		}
+		if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+		{
+			float t = currentDistance / (currentDistance - nextDistance);
+			output[outputCount++] = current + (next - current) * t;
+		}
+	}
+
+	// triangulate the clipped polygon as a fan
+	for (int i = 1; i + 1 < outputCount; i++)
+	{
+		AddScreenTriangle(output[0], output[i], output[i + 1]);
+	}
+}
+
+/***********************************************************
+ *  AddScreenTriangle()
+ *
+ *  This method is used to project a clipped triangle to the
+ *  screen and calculate its edge and depth equations.
+ ***********************************************************/
+void OcclusionCuller::AddScreenTriangle(
+	const glm::vec4& c0,
+	const glm::vec4& c1,
+	const glm::vec4& c2)
+{
+	const glm::vec4 clip[3] = { c0, c1, c2 };
+	float x[3];
+	float y[3];
+	float z[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		float w = std::max(clip[i].w, g_MinClipW);
+		x[i] = (clip[i].x / w * 0.5f + 0.5f) * m_width;
+		y[i] = (clip[i].y / w * 0.5f + 0.5f) * m_height;
+		z[i] = clip[i].z / w * 0.5f + 0.5f;
+	}
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (std::fabs(area) < g_MinTriangleArea)
+	{
+		return;
+	}
+	// occluders are double sided, so flip clockwise
+	// triangles to keep the inside positive
+	if (area < 0.0f)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(z[1], z[2]);
+		area = -area;
+	}
+
+	SCREEN_TRIANGLE triangle;
+	for (int i = 0; i < 3; i++)
+	{
+		int j = (i + 1) % 3;
+		triangle.edgeA[i] = y[i] - y[j];
+		triangle.edgeB[i] = x[j] - x[i];
+		triangle.edgeC[i] = x[i] * y[j] - y[i] * x[j];
+	}
+
+	triangle.depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	triangle.depthB = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+	triangle.depthC = z[0] - triangle.depthA * x[0] - triangle.depthB * y[0];
+
+	float minX = std::min(x[0], std::min(x[1], x[2]));
+	float maxX = std::max(x[0], std::max(x[1], x[2]));
+	float minY = std::min(y[0], std::min(y[1], y[2]));
+	float maxY = std::max(y[0], std::max(y[1], y[2]));
+
+	// skip triangles that are completely off of the screen
+	if ((maxX < 0.0f) || (maxY < 0.0f) || (minX >= m_width) || (minY >= m_height))
+	{
+		return;
+	}
+
+	triangle.minX = std::max(0, (int)std::floor(minX));
+	triangle.minY = std::max(0, (int)std::floor(minY));
+	triangle.maxX = std::min(m_width - 1, (int)std::ceil(maxX));
+	triangle.maxY = std::min(m_height - 1, (int)std::ceil(maxY));
+
+	m_screenTriangles.push_back(triangle);
+}
+
+/***********************************************************
+ *  RasterizeTile()
+ *
+ *  This method is used to clear one screen tile, rasterize
+ *  every triangle overlapping it, and refresh the tile's
+ *  hierarchical depth blocks.
+ ***********************************************************/
+void OcclusionCuller::RasterizeTile(int tileIndex)
+{
+	int x0 = (tileIndex % m_tilesX) * g_TileWidth;
+	int y0 = (tileIndex / m_tilesX) * g_TileHeight;
+	int x1 = std::min(x0 + g_TileWidth, m_width);
+	int y1 = std::min(y0 + g_TileHeight, m_height);
+
+	for (int y = y0; y < y1; y++)
+	{
+		std::fill(m_depth.begin() + y * m_width + x0, m_depth.begin() + y * m_width + x1, 1.0f);
+	}
+
+	// triangles are always processed in registration order so the
+	// result does not depend on the thread layout, and the columns
+	// are widened to whole groups of four without leaving the tile
+	for (size_t i = 0; i < m_screenTriangles.size(); i++)
+	{
+		const SCREEN_TRIANGLE& triangle = m_screenTriangles[i];
+		if ((triangle.maxX < x0) || (triangle.minX >= x1) ||
+			(triangle.maxY < y0) || (triangle.minY >= y1))
+		{
+			continue;
+		}
+
+		RasterizeTriangle(
+			triangle,
+			std::max(x0, triangle.minX & ~3),
+			std::max(y0, triangle.minY),
+			std::min(x1, RoundUp(triangle.maxX + 1, 4)),
+			std::min(y1, triangle.maxY + 1));
+	}
+
+	UpdateTileBlocks(tileIndex);
+}
+
+/***********************************************************
+ *  RasterizeTriangle()
+ *
+ *  This method is used to write the nearest depth of one
+ *  triangle into the pixels of the passed in rectangle.
+ *  Pixels are processed four at a time and the starting
+ *  column must be a multiple of four.
+ ***********************************************************/
+void OcclusionCuller::RasterizeTriangle(
+	const SCREEN_TRIANGLE& triangle,
+	int x0, int y0, int x1, int y1)
+{
+#ifdef OCCLUSION_USE_SSE2
+	const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 edgeA0 = _mm_set1_ps(triangle.edgeA[0]);
+	const __m128 edgeA1 = _mm_set1_ps(triangle.edgeA[1]);
+	const __m128 edgeA2 = _mm_set1_ps(triangle.edgeA[2]);
+	const __m128 depthA = _mm_set1_ps(triangle.depthA);
+
+	for (int y = y0; y < y1; y++)
+	{
+		float py = (float)y + 0.5f;
+		const __m128 row0 = _mm_set1_ps(triangle.edgeB[0] * py + triangle.edgeC[0]);
+		const __m128 row1 = _mm_set1_ps(triangle.edgeB[1] * py + triangle.edgeC[1]);
+		const __m128 row2 = _mm_set1_ps(triangle.edgeB[2] * py + triangle.edgeC[2]);
+		const __m128 rowDepth = _mm_set1_ps(triangle.depthB * py + triangle.depthC);
+		float* depthRow = &m_depth[y * m_width];
+
+		for (int x = x0; x < x1; x += 4)
+		{
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA0, px), row0);
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA1, px), row1);
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA2, px), row2);
+			__m128 inside = _mm_and_ps(
+				_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+				_mm_cmpge_ps(e2, zero));
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			__m128 depth = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+			__m128 current = _mm_loadu_ps(depthRow + x);
+			__m128 nearest = _mm_min_ps(current, depth);
+			_mm_storeu_ps(depthRow + x,
+				_mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+		}
+	}
+#else
+	for (int y = y0; y < y1; y++)
+	{
+		float py = (float)y + 0.5f;
+		float row[3];
+		for (int i = 0; i < 3; i++)
+		{
+			row[i] = triangle.edgeB[i] * py + triangle.edgeC[i];
+		}
+		float rowDepth = triangle.depthB * py + triangle.depthC;
+		float* depthRow = &m_depth[y * m_width];
+
+		for (int x = x0; x < x1; x++)
+		{
+			float px = (float)x + 0.5f;
+			if ((triangle.edgeA[0] * px + row[0] >= 0.0f) &&
+				(triangle.edgeA[1] * px + row[1] >= 0.0f) &&
+				(triangle.edgeA[2] * px + row[2] >= 0.0f))
+			{
+				depthRow[x] = std::min(depthRow[x], triangle.depthA * px + rowDepth);
+			}
+		}
+	}
+#endif
+}
+
+/***********************************************************
+ *  UpdateTileBlocks()
+ *
+ *  This method is used to store the farthest depth of each
+ *  block inside of one tile for the hierarchical test.
+ ***********************************************************/
+void OcclusionCuller::UpdateTileBlocks(int tileIndex)
+{
+	int x0 = (tileIndex % m_tilesX) * g_TileWidth;
+	int y0 = (tileIndex / m_tilesX) * g_TileHeight;
+	int x1 = std::min(x0 + g_TileWidth, m_width);
+	int y1 = std::min(y0 + g_TileHeight, m_height);
+
+	for (int by = y0 / g_BlockSize; by < y1 / g_BlockSize; by++)
+	{
+		for (int bx = x0 / g_BlockSize; bx < x1 / g_BlockSize; bx++)
+		{
+			float farthest = 0.0f;
+			for (int y = by * g_BlockSize; y < (by + 1) * g_BlockSize; y++)
+			{
+				const float* depthRow = &m_depth[y * m_width];
+				for (int x = bx * g_BlockSize; x < (bx + 1) * g_BlockSize; x++)
+				{
+					farthest = std::max(farthest, depthRow[x]);
+				}
+			}
+			m_blockMaxDepth[by * m_blocksX + bx] = farthest;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used to test a world space bounding box
+ *  against the last rendered depth buffer.  It only returns
+ *  true when every block under the box's screen rectangle is
+ *  nearer than the nearest point of the box.
+ ***********************************************************/
+bool OcclusionCuller::IsOccluded(
+	const glm::vec3& minCorner,
+	const glm::vec3& maxCorner) const
+{
+	if (m_bRendered == false)
+	{
+		return(false);
+	}
+
+	float minX = FLT_MAX;
+	float minY = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float maxY = -FLT_MAX;
+	float minZ = FLT_MAX;
+
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec4 corner(
+			(i & 1) ? maxCorner.x : minCorner.x,
+			(i & 2) ? maxCorner.y : minCorner.y,
+			(i & 4) ? maxCorner.z : minCorner.z,
+			1.0f);
+		glm::vec4 clip = m_viewProjection * corner;
+
+		// boxes crossing the camera plane are always visible
+		if (clip.w <= g_MinClipW)
+		{
+			return(false);
+		}
+
+		float x = (clip.x / clip.w * 0.5f + 0.5f) * m_width;
+		float y = (clip.y / clip.w * 0.5f + 0.5f) * m_height;
+		minX = std::min(minX, x);
+		minY = std::min(minY, y);
+		maxX = std::max(maxX, x);
+		maxY = std::max(maxY, y);
+		minZ = std::min(minZ, clip.z / clip.w * 0.5f + 0.5f);
+	}
+
+	// boxes outside of the screen are left for frustum culling
+	if ((maxX < 0.0f) || (maxY < 0.0f) || (minX >= m_width) || (minY >= m_height))
+	{
+		return(false);
+	}
+
+	int blockX0 = std::max(0, (int)std::floor(minX) / g_BlockSize);
+	int blockY0 = std::max(0, (int)std::floor(minY) / g_BlockSize);
+	int blockX1 = std::min(m_blocksX - 1, (int)std::ceil(maxX) / g_BlockSize);
+	int blockY1 = std::min(m_blocksY - 1, (int)std::ceil(maxY) / g_BlockSize);
+
+	for (int by = blockY0; by <= blockY1; by++)
+	{
+		for (int bx = blockX0; bx <= blockX1; bx++)
+		{
+			if (m_blockMaxDepth[by * m_blocksX + bx] >= minZ)
+			{
+				return(false);
+			}
+		}
+	}
+
+	return(true);
+}
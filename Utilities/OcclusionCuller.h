@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.h
+// ============
+// rasterize large occluders into a low resolution hierarchical depth buffer
+// on the CPU and test object bounding boxes against it before drawing
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  OcclusionCuller
+ *
+ *  This class contains a small tile based software rasterizer
+ *  that only writes depth.  Occluder triangles are registered
+ *  once in world space, rendered each frame for the current
+ *  view, and then object bounding boxes can be tested against
+ *  the resulting hierarchical depth buffer.  Every screen tile
+ *  is rasterized independently, so the result is identical no
+ *  matter how many threads are used.
+ ***********************************************************/
+class OcclusionCuller
+{
+public:
+	// constructor
+	OcclusionCuller(int width = 320, int height = 256);
+	// destructor
+	~OcclusionCuller();
+
+	// remove all of the registered occluder triangles
+	void ClearOccluders();
+	// register a single world space occluder triangle
+	void AddOccluderTriangle(
+		const glm::vec3& p0,
+		const glm::vec3& p1,
+		const glm::vec3& p2);
+	// register the unit plane mesh, transformed by the model matrix
+	void AddOccluderPlane(const glm::mat4& model);
+	// register an object space box, transformed by the model matrix
+	void AddOccluderBox(
+		const glm::mat4& model,
+		const glm::vec3& minCorner,
+		const glm::vec3& maxCorner);
+
+	// rasterize all registered occluders for the passed in view
+	void RenderOccluders(const glm::mat4& viewProjection);
+	// test whether a world space bounding box is completely hidden
+	bool IsOccluded(
+		const glm::vec3& minCorner,
+		const glm::vec3& maxCorner) const;
+
+	// set the number of worker threads used for rasterizing
+	void SetThreadCount(int threadCount);
+	// rasterize the tiles as jobs of the passed in job system
+	// instead of starting threads each frame, or stop when NULL
+	void SetJobSystem(JobSystem* pJobSystem);
+
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
+	int GetOccluderTriangleCount() const { return((int)m_worldVertices.size() / 3); }
+	// full resolution depth values, 0.0 is near and 1.0 is far
+	const float* GetDepthBuffer() const { return(m_depth.data()); }
+
+private:
+	// occluder triangle after projection into screen space
+	struct SCREEN_TRIANGLE
+	{
+		// edge function coefficients - inside when all >= 0
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		// depth plane equation - depth = A*x + B*y + C
+		float depthA;
+		float depthB;
+		float depthC;
+		// pixel bounds of the triangle
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+	};
+
+	// size of the full resolution depth buffer
+	int m_width;
+	int m_height;
+	// number of tiles in each direction
+	int m_tilesX;
+	int m_tilesY;
+	// number of hierarchical depth blocks in each direction
+	int m_blocksX;
+	int m_blocksY;
+	// number of worker threads used by RenderOccluders()
+	int m_threadCount;
+	// optional job system that the tiles are rasterized on
+	JobSystem* m_pJobSystem;
+
+	// the view that the depth buffer was last rendered with
+	glm::mat4 m_viewProjection;
+	bool m_bRendered;
+
+	// registered occluder geometry, three vertices per triangle
+	std::vector<glm::vec3> m_worldVertices;
+	// triangles set up for the current view
+	std::vector<SCREEN_TRIANGLE> m_screenTriangles;
+	// full resolution depth buffer
+	std::vector<float> m_depth;
+	// farthest depth of each block in the depth buffer
+	std::vector<float> m_blockMaxDepth;
+
+	// clip and project a triangle and add it to the screen list
+	void SetupTriangle(
+		const glm::vec4& c0,
+		const glm::vec4& c1,
+		const glm::vec4& c2);
+	void AddScreenTriangle(
+		const glm::vec4& c0,
+		const glm::vec4& c1,
+		const glm::vec4& c2);
+	// rasterize all of the screen triangles covering one tile
+	void RasterizeTile(int tileIndex);
+	// rasterize a single triangle into the rectangle of one tile
+	void RasterizeTriangle(
+		const SCREEN_TRIANGLE& triangle,
+		int x0, int y0, int x1, int y1);
+	// update the hierarchical depth blocks covered by one tile
+	void UpdateTileBlocks(int tileIndex);
+};
@@ -0,0 +1,240 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreencontext.cpp
+// ============
+// create an OpenGL context without a display window using EGL, so the
+// scene can be rendered on machines without a screen or a GPU
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OffscreenContext.h"
+
+#include <iostream>
+
+#ifdef SCENE_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#endif
+
+/***********************************************************
+ *  OffscreenContext()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OffscreenContext::OffscreenContext()
+{
+	m_display = NULL;
+	m_surface = NULL;
+	m_context = NULL;
+}
+
+/***********************************************************
+ *  ~OffscreenContext()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OffscreenContext::~OffscreenContext()
+{
+	Destroy();
+}
+
+#ifdef SCENE_HEADLESS_EGL
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create the headless OpenGL context.
+ *  A small pbuffer is created when the display supports it,
+ *  otherwise the context is made current without a surface.
+ *  The scene is always rendered into a RenderTarget, so the
+ *  passed in size is only used for the pbuffer.
+ ***********************************************************/
+bool OffscreenContext::Create(int width, int height)
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLint major = 0;
+	EGLint minor = 0;
+
+	// prefer the surfaceless platform - it does not need an X server
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay != NULL)
+	{
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+	if (display == EGL_NO_DISPLAY)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	if ((display == EGL_NO_DISPLAY) || (eglInitialize(display, &major, &minor) == EGL_FALSE))
+	{
+		std::cout << "Failed to initialize the EGL display" << std::endl;
+		return false;
+	}
+	m_display = display;
+
+	if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE)
+	{
+		std::cout << "EGL display does not support desktop OpenGL" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	// try a pbuffer capable configuration first, then any
+	// configuration that can be used without a surface
+	const EGLint pbufferAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+	const EGLint surfacelessAttributes[] = {
+		EGL_SURFACE_TYPE, 0,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config = NULL;
+	EGLint configCount = 0;
+	bool bPbuffer = true;
+	if ((eglChooseConfig(display, pbufferAttributes, &config, 1, &configCount) == EGL_FALSE) ||
+		(configCount == 0))
+	{
+		bPbuffer = false;
+		if ((eglChooseConfig(display, surfacelessAttributes, &config, 1, &configCount) == EGL_FALSE) ||
+			(configCount == 0))
+		{
+			std::cout << "Failed to find a usable EGL configuration" << std::endl;
+			Destroy();
+			return false;
+		}
+	}
+
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (bPbuffer == true)
+	{
+		const EGLint surfaceAttributes[] = {
+			EGL_WIDTH, width,
+			EGL_HEIGHT, height,
+			EGL_NONE
+		};
+		surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+	}
+	m_surface = surface;
+
+	// the shaders are written for GLSL 3.30 core
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cout << "Failed to create the EGL OpenGL context" << std::endl;
+		Destroy();
+		return false;
+	}
+	m_context = context;
+
+	if (MakeCurrent() == false)
+	{
+		std::cout << "Failed to make the EGL context current" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	std::cout << "INFO: EGL " << major << "." << minor << " headless context created" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to release the context, the surface
+ *  and the EGL display.
+ ***********************************************************/
+void OffscreenContext::Destroy()
+{
+	if (m_display == NULL)
+	{
+		return;
+	}
+
+	eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (m_context != NULL)
+	{
+		eglDestroyContext((EGLDisplay)m_display, (EGLContext)m_context);
+		m_context = NULL;
+	}
+	if (m_surface != NULL)
+	{
+		eglDestroySurface((EGLDisplay)m_display, (EGLSurface)m_surface);
+		m_surface = NULL;
+	}
+	eglTerminate((EGLDisplay)m_display);
+	m_display = NULL;
+}
+
+/***********************************************************
+ *  MakeCurrent()
+ *
+ *  This method is used to bind the context to the calling
+ *  thread.
+ ***********************************************************/
+bool OffscreenContext::MakeCurrent()
+{
+	EGLSurface surface = (m_surface != NULL) ? (EGLSurface)m_surface : EGL_NO_SURFACE;
+
+	return(eglMakeCurrent((EGLDisplay)m_display, surface, surface, (EGLContext)m_context) == EGL_TRUE);
+}
+
+/***********************************************************
+ *  ReleaseCurrent()
+ *
+ *  This method is used to unbind the context from the
+ *  calling thread.
+ ***********************************************************/
+void OffscreenContext::ReleaseCurrent()
+{
+	if (m_display != NULL)
+	{
+		eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	}
+}
+
+#else
+
+/***********************************************************
+ *  Create()
+ *
+ *  Headless rendering was not enabled for this build.
+ ***********************************************************/
+bool OffscreenContext::Create(int /*width*/, int /*height*/)
+{
+	std::cout << "Headless rendering is not available - build with SCENE_HEADLESS_EGL" << std::endl;
+	return false;
+}
+
+void OffscreenContext::Destroy()
+{
+}
+
+bool OffscreenContext::MakeCurrent()
+{
+	return false;
+}
+
+void OffscreenContext::ReleaseCurrent()
+{
+}
+
+#endif
@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreencontext.h
+// ============
+// create an OpenGL context without a display window using EGL, so the
+// scene can be rendered on machines without a screen or a GPU
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  OffscreenContext
+ *
+ *  This class contains the code for creating a headless
+ *  OpenGL 3.3 core context through EGL.  The surfaceless Mesa
+ *  platform is tried first so no X server is needed, then
+ *  the default EGL display.  The context is only available
+ *  when the project is built with SCENE_HEADLESS_EGL.
+ ***********************************************************/
+class OffscreenContext
+{
+public:
+	// constructor
+	OffscreenContext();
+	// destructor
+	~OffscreenContext();
+
+	// create the context and make it current on this thread
+	bool Create(int width, int height);
+	// release the context and the EGL display
+	void Destroy();
+
+	// make the context current on the calling thread
+	bool MakeCurrent();
+	// release the context from the calling thread, so another
+	// thread can make it current
+	void ReleaseCurrent();
+
+private:
+	// EGL handles - kept opaque so the EGL headers
+	// are only needed by the source file
+	void* m_display;
+	void* m_surface;
+	void* m_context;
+};
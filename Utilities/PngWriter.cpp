@@ -0,0 +1,239 @@
+///////////////////////////////////////////////////////////////////////////////
+// pngwriter.cpp
+// ============
+// write RGB images into PNG files, compressed with zlib
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PngWriter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <zlib.h>
+
+// declaration of the global variables and defines
+namespace
+{
+	// deflate level of the pixel data - the row filters already do
+	// most of the work on rendered frames, so a fast level keeps
+	// the service and the batch writers quick at nearly the size
+	// the slowest level reaches
+	const int g_CompressionLevel = 3;
+
+	// the PNG filter types, in the order of their numbers
+	enum ROW_FILTER
+	{
+		FILTER_NONE = 0,
+		FILTER_SUB,
+		FILTER_UP,
+		FILTER_AVERAGE,
+		FILTER_PAETH,
+		FILTER_COUNT
+	};
+
+	// the neighbor that is closest to left + up - upLeft
+	unsigned char PaethPredictor(int left, int up, int upLeft)
+	{
+		int estimate = left + up - upLeft;
+		int distanceLeft = std::abs(estimate - left);
+		int distanceUp = std::abs(estimate - up);
+		int distanceUpLeft = std::abs(estimate - upLeft);
+		if ((distanceLeft <= distanceUp) && (distanceLeft <= distanceUpLeft))
+		{
+			return((unsigned char)left);
+		}
+		if (distanceUp <= distanceUpLeft)
+		{
+			return((unsigned char)up);
+		}
+		return((unsigned char)upLeft);
+	}
+
+	// filter one row of RGB bytes against the row above it, which
+	// is NULL for the top row
+	void FilterRow(int filter, const unsigned char* pRow, const unsigned char* pAbove, size_t rowSize, unsigned char* pOut)
+	{
+		for (size_t i = 0; i < rowSize; i++)
+		{
+			int left = (i >= 3) ? pRow[i - 3] : 0;
+			int up = (NULL != pAbove) ? pAbove[i] : 0;
+			int upLeft = ((NULL != pAbove) && (i >= 3)) ? pAbove[i - 3] : 0;
+			int prediction = 0;
+			switch (filter)
+			{
+			case FILTER_SUB:
+				prediction = left;
+				break;
+			case FILTER_UP:
+				prediction = up;
+				break;
+			case FILTER_AVERAGE:
+				prediction = (left + up) / 2;
+				break;
+			case FILTER_PAETH:
+				prediction = PaethPredictor(left, up, upLeft);
+				break;
+			}
+			pOut[i] = (unsigned char)(pRow[i] - prediction);
+		}
+	}
+
+	// how well a filtered row should compress - the sum of the
+	// bytes taken as signed values, which favors rows of small
+	// differences
+	size_t FilteredCost(const unsigned char* pBytes, size_t count)
+	{
+		size_t cost = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			cost += (size_t)std::abs((int)(signed char)pBytes[i]);
+		}
+		return(cost);
+	}
+
+	// add a 32 bit value with the most significant byte first
+	void AppendBigEndian(std::vector<unsigned char>& bytes, uint32_t value)
+	{
+		bytes.push_back((unsigned char)(value >> 24));
+		bytes.push_back((unsigned char)(value >> 16));
+		bytes.push_back((unsigned char)(value >> 8));
+		bytes.push_back((unsigned char)value);
+	}
+
+	// add one chunk - its length, type, data and CRC
+	void AppendChunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& data)
+	{
+		size_t start = png.size();
+		AppendBigEndian(png, (uint32_t)data.size());
+		png.insert(png.end(), type, type + 4);
+		png.insert(png.end(), data.begin(), data.end());
+		uLong crc = crc32(0L, png.data() + start + 4, (uInt)(png.size() - start - 4));
+		AppendBigEndian(png, (uint32_t)crc);
+	}
+}
+
+/***********************************************************
+ *  WriteRGB()
+ *
+ *  This method is used to write an image into a PNG file.
+ ***********************************************************/
+bool PngWriter::WriteRGB(const char* filename, int width, int height, const unsigned char* pPixels)
+{
+	std::vector<unsigned char> png;
+	if (EncodeRGB(width, height, pPixels, png) == false)
+	{
+		return false;
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "Could not write the image:" << filename << std::endl;
+		return false;
+	}
+	file.write((const char*)png.data(), (std::streamsize)png.size());
+	if (!file)
+	{
+		std::cout << "Could not write the image:" << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  EncodeRGB()
+ *
+ *  This method is used to encode an image as the bytes of a
+ *  PNG file.  Each row is filtered the way that leaves the
+ *  smallest differences, as the PNG filters allow, and the
+ *  rows are compressed with zlib into one IDAT chunk.
+ ***********************************************************/
+bool PngWriter::EncodeRGB(int width, int height, const unsigned char* pPixels, std::vector<unsigned char>& png)
+{
+	png.clear();
+	if ((NULL == pPixels) || (width <= 0) || (height <= 0))
+	{
+		return false;
+	}
+
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	png.insert(png.end(), signature, signature + sizeof(signature));
+
+	// 8 bits per channel, RGB, no interlacing
+	std::vector<unsigned char> header;
+	AppendBigEndian(header, (uint32_t)width);
+	AppendBigEndian(header, (uint32_t)height);
+	header.push_back(8);
+	header.push_back(2);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	AppendChunk(png, "IHDR", header);
+
+	size_t rowSize = (size_t)width * 3;
+	std::vector<unsigned char> rows((rowSize + 1) * height);
+	std::vector<unsigned char> filtered(rowSize * FILTER_COUNT);
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* pRow = pPixels + rowSize * y;
+		const unsigned char* pAbove = (y > 0) ? pRow - rowSize : NULL;
+		int bestFilter = FILTER_NONE;
+		size_t bestCost = 0;
+		for (int filter = FILTER_NONE; filter < FILTER_COUNT; filter++)
+		{
+			unsigned char* pOut = filtered.data() + rowSize * filter;
+			FilterRow(filter, pRow, pAbove, rowSize, pOut);
+			size_t cost = FilteredCost(pOut, rowSize);
+			if ((filter == FILTER_NONE) || (cost < bestCost))
+			{
+				bestFilter = filter;
+				bestCost = cost;
+			}
+		}
+
+		unsigned char* pOut = rows.data() + (rowSize + 1) * y;
+		pOut[0] = (unsigned char)bestFilter;
+		std::copy(filtered.begin() + rowSize * bestFilter, filtered.begin() + rowSize * (bestFilter + 1), pOut + 1);
+	}
+
+	uLongf streamSize = compressBound((uLong)rows.size());
+	std::vector<unsigned char> stream(streamSize);
+	if (compress2(stream.data(), &streamSize, rows.data(), (uLong)rows.size(), g_CompressionLevel) != Z_OK)
+	{
+		std::cout << "Could not compress the image:" << width << "x" << height << std::endl;
+		png.clear();
+		return false;
+	}
+	stream.resize(streamSize);
+	AppendChunk(png, "IDAT", stream);
+
+	AppendChunk(png, "IEND", std::vector<unsigned char>());
+	return true;
+}
+
+/***********************************************************
+ *  FlipRGBAToRGB()
+ *
+ *  This method is used to turn read back RGBA pixels into
+ *  the RGB rows, top row first, that the PNG is written from.
+ ***********************************************************/
+void PngWriter::FlipRGBAToRGB(int width, int height, const unsigned char* pRGBA, std::vector<unsigned char>& rgb)
+{
+	rgb.resize((size_t)width * height * 3);
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* pRow = pRGBA + (size_t)(height - 1 - y) * width * 4;
+		unsigned char* pOut = rgb.data() + (size_t)y * width * 3;
+		for (int x = 0; x < width; x++)
+		{
+			pOut[x * 3] = pRow[x * 4];
+			pOut[x * 3 + 1] = pRow[x * 4 + 1];
+			pOut[x * 3 + 2] = pRow[x * 4 + 2];
+		}
+	}
+}
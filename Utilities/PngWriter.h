@@ -0,0 +1,31 @@
+///////////////////////////////////////////////////////////////////////////////
+// pngwriter.h
+// ============
+// write RGB images into PNG files, compressed with zlib
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+/***********************************************************
+ *  PngWriter
+ *
+ *  This class contains the code for writing an image into a
+ *  PNG file.  Every row gets the PNG filter that suits it
+ *  best, and the filtered rows are compressed with zlib.
+ ***********************************************************/
+class PngWriter
+{
+public:
+	// write width * height RGB pixels, top row first, into a PNG
+	// file - returns false when the file cannot be written
+	static bool WriteRGB(const char* filename, int width, int height, const unsigned char* pPixels);
+	// encode width * height RGB pixels, top row first, into the
+	// bytes of a PNG file - returns false for an empty image
+	static bool EncodeRGB(int width, int height, const unsigned char* pPixels, std::vector<unsigned char>& png);
+	// convert width * height RGBA pixels, bottom row first as
+	// OpenGL reads them, into RGB pixels with the top row first
+	static void FlipRGBAToRGB(int width, int height, const unsigned char* pRGBA, std::vector<unsigned char>& rgb);
+};
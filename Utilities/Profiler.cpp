@@ -0,0 +1,367 @@
+///////////////////////////////////////////////////////////////////////////////
+// profiler.cpp
+// ============
+// time named code scopes on every thread and export them as a Chrome trace
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Profiler.h"
+
+#include <iostream>
+
+#ifdef SCENE_ENABLE_PROFILER
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+	// number of events kept for each thread
+	const uint64_t g_EventsPerThread = 1 << 16;
+
+	// one timed scope
+	struct PROFILE_EVENT
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	// slot of a thread's ring buffer - the values are relaxed
+	// atomics so the trace can be copied while the owning
+	// thread keeps writing, which costs nothing extra on x86
+	struct EVENT_SLOT
+	{
+		std::atomic<const char*> name;
+		std::atomic<uint64_t> start;
+		std::atomic<uint64_t> end;
+	};
+
+	// events written by one thread - only the owning thread
+	// writes, the write count is published after each event
+	// so the buffer can be read while it is being written
+	struct THREAD_BUFFER
+	{
+		std::unique_ptr<EVENT_SLOT[]> events;
+		std::atomic<uint64_t> writeCount;
+		std::string name;
+		int threadID;
+		bool bInUse;
+	};
+
+	// every buffer ever created - buffers of finished threads
+	// are handed to new threads, so the short lived worker
+	// threads do not grow the list every frame
+	std::mutex g_BufferMutex;
+	std::vector<std::unique_ptr<THREAD_BUFFER>> g_ThreadBuffers;
+
+	// time that all event times are relative to
+	const std::chrono::steady_clock::time_point g_StartTime = std::chrono::steady_clock::now();
+
+	/***********************************************************
+	 *  AcquireBuffer()
+	 *
+	 *  Find a buffer that no running thread owns, or create a
+	 *  new one.
+	 ***********************************************************/
+	THREAD_BUFFER* AcquireBuffer()
+	{
+		std::lock_guard<std::mutex> lock(g_BufferMutex);
+
+		for (size_t i = 0; i < g_ThreadBuffers.size(); i++)
+		{
+			if (g_ThreadBuffers[i]->bInUse == false)
+			{
+				g_ThreadBuffers[i]->bInUse = true;
+				return(g_ThreadBuffers[i].get());
+			}
+		}
+
+		std::unique_ptr<THREAD_BUFFER> buffer(new THREAD_BUFFER());
+		buffer->events.reset(new EVENT_SLOT[g_EventsPerThread]);
+		buffer->writeCount.store(0);
+		buffer->threadID = (int)g_ThreadBuffers.size() + 1;
+		buffer->name = "thread " + std::to_string(buffer->threadID);
+		buffer->bInUse = true;
+		g_ThreadBuffers.push_back(std::move(buffer));
+
+		return(g_ThreadBuffers.back().get());
+	}
+
+	// owns the calling thread's buffer and gives it back
+	// when the thread exits
+	struct THREAD_BUFFER_HANDLE
+	{
+		THREAD_BUFFER* pBuffer = nullptr;
+
+		THREAD_BUFFER* Get()
+		{
+			if (pBuffer == nullptr)
+			{
+				pBuffer = AcquireBuffer();
+			}
+			return(pBuffer);
+		}
+		~THREAD_BUFFER_HANDLE()
+		{
+			if (pBuffer != nullptr)
+			{
+				std::lock_guard<std::mutex> lock(g_BufferMutex);
+				pBuffer->bInUse = false;
+			}
+		}
+	};
+	thread_local THREAD_BUFFER_HANDLE g_ThreadBuffer;
+	// track for the GPU passes - it is never given back
+	THREAD_BUFFER* g_pGpuBuffer = nullptr;
+
+	/***********************************************************
+	 *  WriteEvent()
+	 *
+	 *  Add an event to a buffer, replacing the oldest event
+	 *  once the buffer is full.
+	 ***********************************************************/
+	void WriteEvent(THREAD_BUFFER* pBuffer, const char* name, uint64_t start, uint64_t end)
+	{
+		uint64_t index = pBuffer->writeCount.load(std::memory_order_relaxed);
+		EVENT_SLOT& slot = pBuffer->events[index % g_EventsPerThread];
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.start.store(start, std::memory_order_relaxed);
+		slot.end.store(end, std::memory_order_relaxed);
+		pBuffer->writeCount.store(index + 1, std::memory_order_release);
+	}
+
+	/***********************************************************
+	 *  WriteJSONString()
+	 *
+	 *  Write a quoted JSON string, escaping the characters that
+	 *  JSON does not allow inside of strings.
+	 ***********************************************************/
+	void WriteJSONString(std::ostream& output, const char* text)
+	{
+		output << '"';
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if ((*c == '"') || (*c == '\\'))
+			{
+				output << '\\' << *c;
+			}
+			else if ((unsigned char)*c < 0x20)
+			{
+				output << ' ';
+			}
+			else
+			{
+				output << *c;
+			}
+		}
+		output << '"';
+	}
+}
+
+/***********************************************************
+ *  IsEnabled()
+ *
+ *  The profiler is compiled into this build.
+ ***********************************************************/
+bool Profiler::IsEnabled()
+{
+	return true;
+}
+
+/***********************************************************
+ *  GetTimeNanoseconds()
+ *
+ *  This method is used to get the current time in
+ *  nanoseconds since the profiler start time.
+ ***********************************************************/
+uint64_t Profiler::GetTimeNanoseconds()
+{
+	return((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - g_StartTime).count());
+}
+
+/***********************************************************
+ *  RecordEvent()
+ *
+ *  This method is used to add a finished scope to the ring
+ *  buffer of the calling thread, replacing the oldest event
+ *  once the buffer is full.
+ ***********************************************************/
+void Profiler::RecordEvent(const char* name, uint64_t startNanoseconds, uint64_t endNanoseconds)
+{
+	WriteEvent(g_ThreadBuffer.Get(), name, startNanoseconds, endNanoseconds);
+}
+
+/***********************************************************
+ *  RecordGpuEvent()
+ *
+ *  This method is used to add a GPU pass to the GPU track.
+ ***********************************************************/
+void Profiler::RecordGpuEvent(const char* name, uint64_t startNanoseconds, uint64_t endNanoseconds)
+{
+	if (g_pGpuBuffer == nullptr)
+	{
+		g_pGpuBuffer = AcquireBuffer();
+
+		std::lock_guard<std::mutex> lock(g_BufferMutex);
+		g_pGpuBuffer->name = "GPU";
+	}
+
+	WriteEvent(g_pGpuBuffer, name, startNanoseconds, endNanoseconds);
+}
+
+/***********************************************************
+ *  SetThreadName()
+ *
+ *  This method is used to name the calling thread in the
+ *  exported trace.
+ ***********************************************************/
+void Profiler::SetThreadName(const char* name)
+{
+	THREAD_BUFFER* pBuffer = g_ThreadBuffer.Get();
+
+	std::lock_guard<std::mutex> lock(g_BufferMutex);
+	pBuffer->name = name;
+}
+
+/***********************************************************
+ *  WriteChromeTrace()
+ *
+ *  This method is used to write the collected events of all
+ *  threads as complete ("X") trace events.  Threads keep
+ *  recording while the trace is written; events that were
+ *  overwritten during the copy are left out.
+ ***********************************************************/
+bool Profiler::WriteChromeTrace(const char* filename)
+{
+	std::ofstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not write profiler trace:" << filename << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(g_BufferMutex);
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool bFirst = true;
+	size_t eventCount = 0;
+	char timeText[64];
+	std::vector<PROFILE_EVENT> events;
+	for (size_t i = 0; i < g_ThreadBuffers.size(); i++)
+	{
+		THREAD_BUFFER* pBuffer = g_ThreadBuffers[i].get();
+
+		// copy the newest events, then drop the ones the
+		// owning thread may have replaced while copying
+		uint64_t endIndex = pBuffer->writeCount.load(std::memory_order_acquire);
+		uint64_t startIndex = (endIndex > g_EventsPerThread) ? endIndex - g_EventsPerThread : 0;
+		events.clear();
+		for (uint64_t index = startIndex; index < endIndex; index++)
+		{
+			const EVENT_SLOT& slot = pBuffer->events[index % g_EventsPerThread];
+			PROFILE_EVENT event;
+			event.name = slot.name.load(std::memory_order_relaxed);
+			event.start = slot.start.load(std::memory_order_relaxed);
+			event.end = slot.end.load(std::memory_order_relaxed);
+			events.push_back(event);
+		}
+		uint64_t overwritten = pBuffer->writeCount.load(std::memory_order_acquire);
+		uint64_t firstValid = (overwritten > g_EventsPerThread) ? overwritten - g_EventsPerThread : 0;
+		size_t skip = (firstValid > startIndex) ? (size_t)(firstValid - startIndex) : 0;
+
+		// thread name metadata
+		file << (bFirst ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+			<< pBuffer->threadID << ",\"args\":{\"name\":";
+		WriteJSONString(file, pBuffer->name.c_str());
+		file << "}}";
+		bFirst = false;
+
+		for (size_t e = skip; e < events.size(); e++)
+		{
+			// trace times are in microseconds
+			snprintf(timeText, sizeof(timeText), "\"ts\":%.3f,\"dur\":%.3f",
+				events[e].start / 1000.0, (events[e].end - events[e].start) / 1000.0);
+			file << ",\n{\"name\":";
+			WriteJSONString(file, events[e].name);
+			file << ",\"cat\":\"" << ((pBuffer == g_pGpuBuffer) ? "gpu" : "cpu")
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << pBuffer->threadID
+				<< "," << timeText << "}";
+			eventCount++;
+		}
+	}
+	file << "\n]}\n";
+
+	std::cout << "Wrote " << eventCount << " profiler events to:" << filename << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to drop every collected event.  It
+ *  should only be called while no other thread is recording.
+ ***********************************************************/
+void Profiler::Clear()
+{
+	std::lock_guard<std::mutex> lock(g_BufferMutex);
+
+	for (size_t i = 0; i < g_ThreadBuffers.size(); i++)
+	{
+		g_ThreadBuffers[i]->writeCount.store(0, std::memory_order_release);
+	}
+}
+
+#else
+
+/***********************************************************
+ *  IsEnabled()
+ *
+ *  The profiler was not compiled into this build.
+ ***********************************************************/
+bool Profiler::IsEnabled()
+{
+	return false;
+}
+
+uint64_t Profiler::GetTimeNanoseconds()
+{
+	return 0;
+}
+
+void Profiler::RecordEvent(const char* /*name*/, uint64_t /*startNanoseconds*/, uint64_t /*endNanoseconds*/)
+{
+}
+
+void Profiler::SetThreadName(const char* /*name*/)
+{
+}
+
+void Profiler::RecordGpuEvent(const char* /*name*/, uint64_t /*startNanoseconds*/, uint64_t /*endNanoseconds*/)
+{
+}
+
+/***********************************************************
+ *  WriteChromeTrace()
+ *
+ *  Without the profiler there is nothing to write.
+ ***********************************************************/
+bool Profiler::WriteChromeTrace(const char* /*filename*/)
+{
+	std::cout << "The profiler is not available - build with SCENE_ENABLE_PROFILER" << std::endl;
+	return false;
+}
+
+void Profiler::Clear()
+{
+}
+
+#endif
@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// profiler.h
+// ============
+// time named code scopes on every thread and export them as a Chrome trace
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+// the scope macros only generate code when the profiler is enabled
+// for the build, otherwise they compile to nothing
+#ifdef SCENE_ENABLE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// time the enclosing scope - the name must be a string literal
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+// time the enclosing function
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#endif
+
+/***********************************************************
+ *  Profiler
+ *
+ *  This class contains the code for collecting timed scopes.
+ *  Every thread writes into its own ring buffer, so timing
+ *  a scope never takes a lock - only the newest events of
+ *  each thread are kept.  The collected events can be
+ *  written at any time as Chrome trace-event JSON, which
+ *  chrome://tracing and Perfetto can open.
+ ***********************************************************/
+class Profiler
+{
+public:
+	// true when the build has the profiler compiled in
+	static bool IsEnabled();
+
+	// nanoseconds since the profiler was first used
+	static uint64_t GetTimeNanoseconds();
+	// add a finished scope to the calling thread's ring buffer
+	static void RecordEvent(const char* name, uint64_t startNanoseconds, uint64_t endNanoseconds);
+	// name the calling thread in the exported trace
+	static void SetThreadName(const char* name);
+	// add a GPU pass, already converted to profiler time, to
+	// the separate GPU track - only the thread that owns the
+	// OpenGL context may call this
+	static void RecordGpuEvent(const char* name, uint64_t startNanoseconds, uint64_t endNanoseconds);
+
+	// write every collected event as Chrome trace-event JSON
+	static bool WriteChromeTrace(const char* filename);
+	// drop every collected event
+	static void Clear();
+};
+
+#ifdef SCENE_ENABLE_PROFILER
+/***********************************************************
+ *  ProfileScope
+ *
+ *  This class records the time between its construction and
+ *  destruction as one profiler event.
+ ***********************************************************/
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name)
+	{
+		m_name = name;
+		m_start = Profiler::GetTimeNanoseconds();
+	}
+	~ProfileScope()
+	{
+		Profiler::RecordEvent(m_name, m_start, Profiler::GetTimeNanoseconds());
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* m_name;
+	uint64_t m_start;
+};
+#endif
@@ -0,0 +1,599 @@
+///////////////////////////////////////////////////////////////////////////////
+// raytracer.cpp
+// ============
+// trace the triangles of a scene on the CPU with the same lighting as the
+// fragment shader, for a reference image that needs no GPU
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RayTracer.h"
+#include "Profiler.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	// nodes a packet can have waiting at the same time, as for
+	// the queries of the tree
+	const int g_StackSize = 128;
+	// most surfaces a ray passes through before the rest of the
+	// pixel is taken from the background
+	const int g_MaxLayers = 8;
+	// light left behind the blended hits below which a ray stops
+	const float g_MinTransmittance = 1.0f / 512.0f;
+	// how far behind a blended hit its ray continues, relative
+	// to the distance of the hit
+	const float g_ContinueOffset = 1.0e-5f;
+
+	// the rays of a packet split into their components
+	struct PACKET_RAYS
+	{
+		FLOAT4 origin[3];
+		FLOAT4 direction[3];
+		FLOAT4 inverseDirection[3];
+		FLOAT4 start;
+	};
+
+	// distances where the rays enter a box, and the lanes whose
+	// rays cross it between their start and their hit so far
+	int IntersectPacketBox(
+		const PACKET_RAYS& rays,
+		const FLOAT4& distance,
+		const glm::vec3& minCorner,
+		const glm::vec3& maxCorner,
+		FLOAT4& enter)
+	{
+		FLOAT4 exit = distance;
+		enter = rays.start;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			FLOAT4 lower = (FLOAT4(minCorner[axis]) - rays.origin[axis]) * rays.inverseDirection[axis];
+			FLOAT4 upper = (FLOAT4(maxCorner[axis]) - rays.origin[axis]) * rays.inverseDirection[axis];
+			enter = Max(enter, Min(lower, upper));
+			exit = Min(exit, Max(lower, upper));
+		}
+		return(GetLanes(enter <= exit));
+	}
+}
+
+/***********************************************************
+ *  RayTracer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RayTracer::RayTracer()
+{
+	m_statistics = STATISTICS();
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove the triangles, surfaces
+ *  and textures, so a new scene can be added.
+ ***********************************************************/
+void RayTracer::Clear()
+{
+	m_addedTriangles.clear();
+	m_addedShading.clear();
+	m_triangles.clear();
+	m_shading.clear();
+	m_surfaces.clear();
+	m_textures.clear();
+	m_hierarchy.Clear();
+	m_statistics = STATISTICS();
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used to add a texture that surfaces can
+ *  be drawn with.  It returns the index of the texture.
+ ***********************************************************/
+int RayTracer::AddTexture(const TEXTURE& texture)
+{
+	m_textures.push_back(texture);
+	return((int)m_textures.size() - 1);
+}
+
+/***********************************************************
+ *  AddSurface()
+ *
+ *  This method is used to add the shading values of a part.
+ *  It returns the index of the surface.
+ ***********************************************************/
+int RayTracer::AddSurface(const SURFACE& surface)
+{
+	m_surfaces.push_back(surface);
+	if ((surface.texture < -1) || (surface.texture >= (int)m_textures.size()))
+	{
+		m_surfaces.back().texture = -1;
+	}
+	return((int)m_surfaces.size() - 1);
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used to add the triangles of a mesh, three
+ *  corners each, placed in the world by the model matrix.
+ *  The vertex shader passes the normals on without turning
+ *  them with the model, so they are kept as they are.
+ ***********************************************************/
+void RayTracer::AddMesh(
+	const glm::mat4& model,
+	const glm::vec3* corners,
+	const glm::vec3* normals,
+	const glm::vec2* textureCoordinates,
+	int cornerCount,
+	int surface)
+{
+	for (int i = 0; i + 2 < cornerCount; i += 3)
+	{
+		glm::vec3 points[3];
+		TRIANGLE_SHADING shading;
+		for (int c = 0; c < 3; c++)
+		{
+			points[c] = glm::vec3(model * glm::vec4(corners[i + c], 1.0f));
+			shading.normals[c] = normals[i + c];
+			shading.textureCoordinates[c] = textureCoordinates[i + c];
+		}
+		shading.surface = surface;
+
+		TRIANGLE triangle;
+		triangle.corner = points[0];
+		triangle.edge1 = points[1] - points[0];
+		triangle.edge2 = points[2] - points[0];
+		m_addedTriangles.push_back(triangle);
+		m_addedShading.push_back(shading);
+	}
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used to build the tree over the bounds of
+ *  the added triangles, and to store the triangles in the
+ *  order of its leaves so a leaf reads them one after the
+ *  other.
+ ***********************************************************/
+void RayTracer::Build(JobSystem* pJobSystem)
+{
+	PROFILE_FUNCTION();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	int count = (int)m_addedTriangles.size();
+	std::vector<glm::vec3> minCorners(count);
+	std::vector<glm::vec3> maxCorners(count);
+	for (int i = 0; i < count; i++)
+	{
+		const TRIANGLE& triangle = m_addedTriangles[i];
+		glm::vec3 second = triangle.corner + triangle.edge1;
+		glm::vec3 third = triangle.corner + triangle.edge2;
+		minCorners[i] = glm::min(triangle.corner, glm::min(second, third));
+		maxCorners[i] = glm::max(triangle.corner, glm::max(second, third));
+	}
+	m_hierarchy.Build(minCorners.data(), maxCorners.data(), count, pJobSystem);
+
+	const int* pOrder = m_hierarchy.GetInstances();
+	m_triangles.resize(count);
+	m_shading.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		m_triangles[i] = m_addedTriangles[pOrder[i]];
+		m_shading[i] = m_addedShading[pOrder[i]];
+	}
+
+	m_statistics.triangles = count;
+	m_statistics.nodes = m_hierarchy.GetNodeCount();
+	m_statistics.buildMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used to trace an image from the passed in
+ *  camera.  Each tile of the image is a job, and the rays
+ *  traced by all of them are counted for the statistics.
+ ***********************************************************/
+void RayTracer::Render(
+	const CAMERA& camera,
+	const LIGHTS& lights,
+	const glm::vec3& background,
+	int width,
+	int height,
+	unsigned char* pPixels,
+	JobSystem* pJobSystem)
+{
+	PROFILE_FUNCTION();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	std::atomic<long long> rays(0);
+	auto renderTiles = [this, &camera, &lights, &background, width, height, pPixels, &rays](int first, int count) {
+		long long tileRays = 0;
+		for (int tile = first; tile < first + count; tile++)
+		{
+			tileRays += RenderTile(tile, camera, lights, background, width, height, pPixels);
+		}
+		rays += tileRays;
+	};
+
+	if (NULL != pJobSystem)
+	{
+		pJobSystem->ParallelFor(tilesX * tilesY, 1, renderTiles);
+	}
+	else
+	{
+		renderTiles(0, tilesX * tilesY);
+	}
+
+	m_statistics.rays = rays;
+	m_statistics.tiles = tilesX * tilesY;
+	m_statistics.threads = (NULL != pJobSystem) ? pJobSystem->GetThreadCount() : 1;
+	m_statistics.traceMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************
+ *  RenderTile()
+ *
+ *  This method is used to trace the pixels of one tile, a
+ *  2x2 block at a time.  A ray that hits a surface that is
+ *  not opaque continues behind it, and the colors are added
+ *  front to back until the rays are blocked or leave the
+ *  scene.  It returns the number of rays traced.
+ ***********************************************************/
+long long RayTracer::RenderTile(
+	int tile,
+	const CAMERA& camera,
+	const LIGHTS& lights,
+	const glm::vec3& background,
+	int width,
+	int height,
+	unsigned char* pPixels) const
+{
+	PROFILE_SCOPE("RenderTile");
+
+	int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	int left = (tile % tilesX) * TILE_SIZE;
+	int top = (tile / tilesX) * TILE_SIZE;
+	int right = std::min(left + TILE_SIZE, width);
+	int bottom = std::min(top + TILE_SIZE, height);
+	glm::mat4 toWorld = glm::inverse(camera.projection * camera.view);
+	long long rays = 0;
+
+	for (int y = top; y < bottom; y += 2)
+	{
+		for (int x = left; x < right; x += 2)
+		{
+			// each ray runs from the near plane to the far plane
+			// through the center of its pixel
+			RAY_PACKET packet;
+			float farDistances[4];
+			glm::vec3 colors[4];
+			float transmittances[4];
+			packet.activeLanes = 0;
+			for (int lane = 0; lane < 4; lane++)
+			{
+				int pixelX = x + (lane & 1);
+				int pixelY = y + (lane >> 1);
+				colors[lane] = glm::vec3(0.0f);
+				transmittances[lane] = 1.0f;
+				if ((pixelX >= right) || (pixelY >= bottom))
+				{
+					// a ray that starts past its end hits nothing
+					for (int axis = 0; axis < 3; axis++)
+					{
+						packet.origin[axis][lane] = 0.0f;
+						packet.direction[axis][lane] = 1.0f;
+					}
+					packet.start[lane] = FLT_MAX;
+					packet.distance[lane] = 0.0f;
+					farDistances[lane] = 0.0f;
+					continue;
+				}
+
+				float ndcX = ((float)pixelX + 0.5f) / (float)width * 2.0f - 1.0f;
+				float ndcY = 1.0f - ((float)pixelY + 0.5f) / (float)height * 2.0f;
+				glm::vec4 nearPoint = toWorld * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+				glm::vec4 farPoint = toWorld * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+				glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+				glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+				float length = std::sqrt(glm::dot(direction, direction));
+				direction = direction / length;
+				for (int axis = 0; axis < 3; axis++)
+				{
+					packet.origin[axis][lane] = origin[axis];
+					packet.direction[axis][lane] = direction[axis];
+				}
+				packet.start[lane] = 0.0f;
+				packet.distance[lane] = length;
+				farDistances[lane] = length;
+				packet.activeLanes |= 1 << lane;
+			}
+
+			for (int layer = 0; (layer < g_MaxLayers) && (packet.activeLanes != 0); layer++)
+			{
+				TracePacket(packet);
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if ((packet.activeLanes & (1 << lane)) == 0)
+					{
+						continue;
+					}
+					rays++;
+
+					if (packet.triangle[lane] < 0)
+					{
+						colors[lane] += background * transmittances[lane];
+						transmittances[lane] = 0.0f;
+						packet.activeLanes &= ~(1 << lane);
+						continue;
+					}
+
+					// the framebuffer clamps the shaded color before
+					// it is blended
+					glm::vec4 shaded = ShadeHit(packet, lane, camera, lights);
+					float alpha = std::min(std::max(shaded.a, 0.0f), 1.0f);
+					glm::vec3 color = glm::min(glm::max(glm::vec3(shaded), glm::vec3(0.0f)), glm::vec3(1.0f));
+					colors[lane] += color * (alpha * transmittances[lane]);
+					transmittances[lane] *= 1.0f - alpha;
+
+					if (transmittances[lane] < g_MinTransmittance)
+					{
+						packet.activeLanes &= ~(1 << lane);
+						continue;
+					}
+
+					// trace on behind the blended hit
+					float hit = packet.distance[lane];
+					packet.start[lane] = hit + std::max(hit * g_ContinueOffset, g_ContinueOffset);
+					packet.distance[lane] = farDistances[lane];
+				}
+			}
+
+			for (int lane = 0; lane < 4; lane++)
+			{
+				int pixelX = x + (lane & 1);
+				int pixelY = y + (lane >> 1);
+				if ((pixelX >= right) || (pixelY >= bottom))
+				{
+					continue;
+				}
+
+				// rays still going after the last layer see the background
+				glm::vec3 color = colors[lane] + background * transmittances[lane];
+				unsigned char* pPixel = pPixels + ((size_t)pixelY * width + pixelX) * 3;
+				for (int channel = 0; channel < 3; channel++)
+				{
+					float value = std::min(std::max(color[channel], 0.0f), 1.0f);
+					pPixel[channel] = (unsigned char)(value * 255.0f + 0.5f);
+				}
+			}
+		}
+	}
+
+	return(rays);
+}
+
+/***********************************************************
+ *  TracePacket()
+ *
+ *  This method is used to find the nearest triangle that
+ *  each active ray of a packet hits.  The four rays visit
+ *  the tree together, so a node is read once for all of
+ *  them and its box is tested in the four lanes at once.
+ *  A node is entered when any of the rays crosses its box
+ *  nearer than their hits so far, and the nearer child is
+ *  visited first.  The triangles of a leaf are tested
+ *  against the four rays with the Moller-Trumbore test.
+ ***********************************************************/
+void RayTracer::TracePacket(RAY_PACKET& packet) const
+{
+	PACKET_RAYS rays;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		rays.origin[axis] = FLOAT4::Load(packet.origin[axis]);
+		rays.direction[axis] = FLOAT4::Load(packet.direction[axis]);
+		rays.inverseDirection[axis] = FLOAT4(1.0f) / rays.direction[axis];
+	}
+
+	// the finished rays are made to start past their end, so
+	// they cannot hit anything
+	float starts[4];
+	float distances[4];
+	for (int lane = 0; lane < 4; lane++)
+	{
+		bool bActive = (packet.activeLanes & (1 << lane)) != 0;
+		starts[lane] = bActive ? packet.start[lane] : FLT_MAX;
+		distances[lane] = bActive ? packet.distance[lane] : 0.0f;
+		packet.triangle[lane] = -1;
+	}
+	rays.start = FLOAT4::Load(starts);
+	FLOAT4 distance = FLOAT4::Load(distances);
+	FLOAT4 hitU(0.0f);
+	FLOAT4 hitV(0.0f);
+
+	const BoundingVolumeHierarchy::NODE* pNodes = m_hierarchy.GetNodes();
+	FLOAT4 enter;
+	if ((m_hierarchy.GetNodeCount() == 0) ||
+		(IntersectPacketBox(rays, distance, pNodes[0].minCorner, pNodes[0].maxCorner, enter) == 0))
+	{
+		return;
+	}
+
+	// the farthest hit so far, beyond which no node is entered
+	float farthest = 0.0f;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		farthest = std::max(farthest, distances[lane]);
+	}
+
+	int stack[g_StackSize];
+	float enters[g_StackSize];
+	int size = 0;
+	stack[size] = 0;
+	enters[size++] = 0.0f;
+
+	while (size > 0)
+	{
+		size--;
+		if (enters[size] > farthest)
+		{
+			continue;
+		}
+		const BoundingVolumeHierarchy::NODE& node = pNodes[stack[size]];
+
+		if (node.count == 0)
+		{
+			FLOAT4 leftEnter;
+			FLOAT4 rightEnter;
+			int leftLanes = IntersectPacketBox(rays, distance,
+				pNodes[node.first].minCorner, pNodes[node.first].maxCorner, leftEnter);
+			int rightLanes = IntersectPacketBox(rays, distance,
+				pNodes[node.first + 1].minCorner, pNodes[node.first + 1].maxCorner, rightEnter);
+			float leftNearest = (leftLanes != 0) ? GetMinimum(leftEnter, leftLanes) : FLT_MAX;
+			float rightNearest = (rightLanes != 0) ? GetMinimum(rightEnter, rightLanes) : FLT_MAX;
+
+			// the farther child goes on the stack first
+			int nearChild = node.first;
+			int farChild = node.first + 1;
+			if (rightNearest < leftNearest)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(leftNearest, rightNearest);
+			}
+			if (rightNearest != FLT_MAX)
+			{
+				stack[size] = farChild;
+				enters[size++] = rightNearest;
+			}
+			if (leftNearest != FLT_MAX)
+			{
+				stack[size] = nearChild;
+				enters[size++] = leftNearest;
+			}
+			continue;
+		}
+
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			const TRIANGLE& triangle = m_triangles[i];
+			FLOAT4 edge1[3] = { FLOAT4(triangle.edge1.x), FLOAT4(triangle.edge1.y), FLOAT4(triangle.edge1.z) };
+			FLOAT4 edge2[3] = { FLOAT4(triangle.edge2.x), FLOAT4(triangle.edge2.y), FLOAT4(triangle.edge2.z) };
+
+			const FLOAT4* d = rays.direction;
+			FLOAT4 p[3] = {
+				d[1] * edge2[2] - d[2] * edge2[1],
+				d[2] * edge2[0] - d[0] * edge2[2],
+				d[0] * edge2[1] - d[1] * edge2[0] };
+			FLOAT4 inverseDeterminant = FLOAT4(1.0f) / (edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2]);
+
+			FLOAT4 s[3] = {
+				rays.origin[0] - FLOAT4(triangle.corner.x),
+				rays.origin[1] - FLOAT4(triangle.corner.y),
+				rays.origin[2] - FLOAT4(triangle.corner.z) };
+			FLOAT4 u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverseDeterminant;
+			FLOAT4 q[3] = {
+				s[1] * edge1[2] - s[2] * edge1[1],
+				s[2] * edge1[0] - s[0] * edge1[2],
+				s[0] * edge1[1] - s[1] * edge1[0] };
+			FLOAT4 v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inverseDeterminant;
+			FLOAT4 t = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) * inverseDeterminant;
+
+			// a ray in the plane of the triangle divides by zero,
+			// which fails every comparison
+			MASK4 hit = (u >= FLOAT4(0.0f)) & (v >= FLOAT4(0.0f)) & ((u + v) <= FLOAT4(1.0f))
+				& (t > rays.start) & (t < distance);
+			int lanes = GetLanes(hit);
+			if (lanes == 0)
+			{
+				continue;
+			}
+
+			distance = Select(hit, t, distance);
+			hitU = Select(hit, u, hitU);
+			hitV = Select(hit, v, hitV);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if ((lanes & (1 << lane)) != 0)
+				{
+					packet.triangle[lane] = i;
+				}
+			}
+
+			distance.Store(distances);
+			farthest = 0.0f;
+			for (int lane = 0; lane < 4; lane++)
+			{
+				farthest = std::max(farthest, distances[lane]);
+			}
+		}
+	}
+
+	// only the lanes that hit something are read
+	distance.Store(distances);
+	hitU.Store(packet.u);
+	hitV.Store(packet.v);
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if (packet.triangle[lane] >= 0)
+		{
+			packet.distance[lane] = distances[lane];
+		}
+	}
+}
+
+/***********************************************************
+ *  ShadeHit()
+ *
+ *  This method is used to shade the hit of one ray of a
+ *  packet the way the fragment shader shades a fragment,
+ *  with the normal and texture coordinate blended from the
+ *  corners of the hit triangle.
+ ***********************************************************/
+glm::vec4 RayTracer::ShadeHit(
+	const RAY_PACKET& packet,
+	int lane,
+	const CAMERA& camera,
+	const LIGHTS& lights) const
+{
+	const TRIANGLE_SHADING& shading = m_shading[packet.triangle[lane]];
+	const SURFACE& surface = m_surfaces[shading.surface];
+	float u = packet.u[lane];
+	float v = packet.v[lane];
+	float w = 1.0f - u - v;
+
+	glm::vec3 origin(packet.origin[0][lane], packet.origin[1][lane], packet.origin[2][lane]);
+	glm::vec3 direction(packet.direction[0][lane], packet.direction[1][lane], packet.direction[2][lane]);
+	return(ShadingModel::Shade(
+		surface,
+		(surface.texture >= 0) ? &m_textures[surface.texture] : NULL,
+		lights,
+		camera.viewPosition,
+		origin + direction * packet.distance[lane],
+		shading.normals[0] * w + shading.normals[1] * u + shading.normals[2] * v,
+		shading.textureCoordinates[0] * w + shading.textureCoordinates[1] * u + shading.textureCoordinates[2] * v));
+}
+
+/***********************************************************
+ *  GetInstructionSet()
+ *
+ *  This method is used to get the name of the instructions
+ *  that the packets were compiled with.
+ ***********************************************************/
+const char* RayTracer::GetInstructionSet()
+{
+	return(GetSimdInstructionSet());
+}
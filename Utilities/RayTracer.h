@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////////////
+// raytracer.h
+// ============
+// trace the triangles of a scene on the CPU with the same lighting as the
+// fragment shader, for a reference image that needs no GPU
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolumeHierarchy.h"
+#include "JobSystem.h"
+#include "ShadingModel.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  RayTracer
+ *
+ *  This class contains the code for tracing an image of the
+ *  triangles of a scene.  The triangles are added in world
+ *  space together with the normals, texture coordinates,
+ *  color, texture and material that the shader would draw
+ *  them with, and a bounding volume hierarchy is built over
+ *  them.
+ *
+ *  The image is split into tiles that are traced as jobs on
+ *  all threads.  The rays of each 2x2 block of pixels are
+ *  traced through the tree together, four SIMD lanes wide,
+ *  and every hit is shaded by ShadingModel, with the Phong
+ *  model of the fragment shader.  A hit that is not opaque
+ *  is blended over whatever the ray hits behind it, like
+ *  the blending of the drawn frames, but sorted per pixel.
+ ***********************************************************/
+class RayTracer
+{
+public:
+	// the textures, surfaces, lights and camera are the ones the
+	// software rasterizer shades with too
+	typedef ShadingModel::TEXTURE TEXTURE;
+	typedef ShadingModel::SURFACE SURFACE;
+	typedef ShadingModel::DIRECTIONAL_LIGHT DIRECTIONAL_LIGHT;
+	typedef ShadingModel::SPOT_LIGHT SPOT_LIGHT;
+	typedef ShadingModel::LIGHTS LIGHTS;
+	typedef ShadingModel::CAMERA CAMERA;
+
+	// measurements of the last build and image
+	struct STATISTICS
+	{
+		int triangles;
+		int nodes;
+		double buildMilliseconds;
+		// rays traced for the image, including the rays that
+		// continue behind blended hits
+		long long rays;
+		int tiles;
+		int threads;
+		double traceMilliseconds;
+	};
+
+	// pixels along each side of the tiles the image is split into
+	static const int TILE_SIZE = 16;
+
+	// constructor
+	RayTracer();
+
+	// remove the triangles, surfaces and textures
+	void Clear();
+	// add a texture for the surfaces - the pixels are not copied
+	// and must stay valid while images are traced
+	int AddTexture(const TEXTURE& texture);
+	// add the shading values of a part
+	int AddSurface(const SURFACE& surface);
+	// add triangles in the space of a mesh, moved into the world
+	// by the passed in model matrix - the normals stay in the
+	// space of the mesh, as the shader uses them
+	void AddMesh(
+		const glm::mat4& model,
+		const glm::vec3* corners,
+		const glm::vec3* normals,
+		const glm::vec2* textureCoordinates,
+		int cornerCount,
+		int surface);
+	// build the tree over the added triangles, on the job system
+	// when one is given
+	void Build(JobSystem* pJobSystem = NULL);
+
+	// trace an image into width * height RGB pixels with the
+	// top row first, on the job system when one is given
+	void Render(
+		const CAMERA& camera,
+		const LIGHTS& lights,
+		const glm::vec3& background,
+		int width,
+		int height,
+		unsigned char* pPixels,
+		JobSystem* pJobSystem = NULL);
+
+	const STATISTICS& GetStatistics() const { return(m_statistics); }
+	// name of the instructions the rays are traced with
+	static const char* GetInstructionSet();
+
+private:
+	// a triangle as the rays are tested against it, stored in
+	// the order of the leaves of the tree
+	struct TRIANGLE
+	{
+		glm::vec3 corner;
+		glm::vec3 edge1;
+		glm::vec3 edge2;
+	};
+
+	// the values a hit on a triangle is shaded with
+	struct TRIANGLE_SHADING
+	{
+		glm::vec3 normals[3];
+		glm::vec2 textureCoordinates[3];
+		int surface;
+	};
+
+	// the rays of one 2x2 block of pixels, one in each lane
+	struct RAY_PACKET
+	{
+		float origin[3][4];
+		float direction[3][4];
+		// distance where each ray starts, and of its nearest hit
+		float start[4];
+		float distance[4];
+		// hit triangle and its barycentric coordinates, the
+		// triangle is -1 when nothing was hit
+		int triangle[4];
+		float u[4];
+		float v[4];
+		// lanes whose rays are traced
+		int activeLanes;
+	};
+
+	// triangles in the order they were added, until Build()
+	std::vector<TRIANGLE> m_addedTriangles;
+	std::vector<TRIANGLE_SHADING> m_addedShading;
+	// triangles in the order of the leaves of the tree
+	std::vector<TRIANGLE> m_triangles;
+	std::vector<TRIANGLE_SHADING> m_shading;
+	std::vector<SURFACE> m_surfaces;
+	std::vector<TEXTURE> m_textures;
+	BoundingVolumeHierarchy m_hierarchy;
+	STATISTICS m_statistics;
+
+	// find the nearest hit of each active ray of a packet
+	// between its start and its distance
+	void TracePacket(RAY_PACKET& packet) const;
+	// color and opacity of a hit, with the shader's lighting
+	glm::vec4 ShadeHit(
+		const RAY_PACKET& packet,
+		int lane,
+		const CAMERA& camera,
+		const LIGHTS& lights) const;
+	// trace the pixels of one tile and count the rays
+	long long RenderTile(
+		int tile,
+		const CAMERA& camera,
+		const LIGHTS& lights,
+		const glm::vec3& background,
+		int width,
+		int height,
+		unsigned char* pPixels) const;
+};
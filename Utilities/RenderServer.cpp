@@ -0,0 +1,542 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderserver.cpp
+// ============
+// accept view requests over a Unix domain socket and send the rendered
+// images back, keeping the latency and throughput of the requests
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderServer.h"
+#include "FrameStatistics.h"
+#include "LocalSocket.h"
+#include "PngWriter.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// requests whose times are kept for the metrics
+	const size_t g_LatencySamples = 1024;
+	// longest request line that is read
+	const size_t g_MaxLineLength = 1024;
+
+	double MillisecondsBetween(
+		std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end)
+	{
+		return(std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	// answer with a header line and the bytes it announces
+	bool SendResponse(int connection, const std::string& header, const std::vector<unsigned char>& bytes)
+	{
+		std::string line = header + "\n";
+		return((LocalSocket::WriteAll(connection, line.data(), line.size()) == true) &&
+			((bytes.empty() == true) || (LocalSocket::WriteAll(connection, bytes.data(), bytes.size()) == true)));
+	}
+}
+
+/***********************************************************
+ *  RenderServer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderServer::RenderServer()
+{
+	m_listenSocket = -1;
+	m_bSoftwareDefault = false;
+	m_bQuit = false;
+	m_bShutdownRequested = false;
+	m_startTime = std::chrono::steady_clock::now();
+	m_completedRequests = 0;
+	m_failedRequests = 0;
+	m_batches = 0;
+	m_batchedRequests = 0;
+	m_queueTimes.next = 0;
+	m_renderTimes.next = 0;
+	m_encodeTimes.next = 0;
+	m_totalTimes.next = 0;
+}
+
+/***********************************************************
+ *  ~RenderServer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderServer::~RenderServer()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to open the socket and start the
+ *  thread that accepts the clients.
+ ***********************************************************/
+bool RenderServer::Start(const char* socketPath, bool bSoftwareDefault)
+{
+	Stop();
+
+	m_listenSocket = LocalSocket::Listen(socketPath);
+	if (m_listenSocket < 0)
+	{
+		return false;
+	}
+
+	m_socketPath = socketPath;
+	m_bSoftwareDefault = bSoftwareDefault;
+	m_bQuit = false;
+	m_bShutdownRequested = false;
+	m_startTime = std::chrono::steady_clock::now();
+	m_acceptThread = std::thread(&RenderServer::AcceptLoop, this);
+	return true;
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used to stop accepting clients, fail the
+ *  queued requests and close every connection, then remove
+ *  the socket file.
+ ***********************************************************/
+void RenderServer::Stop()
+{
+	if (m_acceptThread.joinable() == false)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bQuit = true;
+		for (size_t i = 0; i < m_queue.size(); i++)
+		{
+			m_queue[i]->error = "the service is stopping";
+			m_queue[i]->bDone = true;
+		}
+		m_queue.clear();
+		for (size_t i = 0; i < m_connections.size(); i++)
+		{
+			if (m_connections[i]->bFinished == false)
+			{
+				LocalSocket::Shutdown(m_connections[i]->socket);
+			}
+		}
+	}
+	m_doneCondition.notify_all();
+	m_requestCondition.notify_all();
+
+	LocalSocket::Shutdown(m_listenSocket);
+	m_acceptThread.join();
+	LocalSocket::Close(m_listenSocket);
+	m_listenSocket = -1;
+	JoinFinishedConnections(true);
+	LocalSocket::RemoveFile(m_socketPath.c_str());
+}
+
+/***********************************************************
+ *  TakeRequests()
+ *
+ *  This method is used by the renderer to take the oldest
+ *  queued requests, waiting a while for the first one.  The
+ *  time each request waited in the queue is kept.
+ ***********************************************************/
+bool RenderServer::TakeRequests(std::vector<REQUEST*>& requests, int maxCount, int waitMilliseconds)
+{
+	requests.clear();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_requestCondition.wait_for(lock, std::chrono::milliseconds(waitMilliseconds), [this]() {
+		return((m_bQuit == true) || (m_bShutdownRequested == true) || (m_queue.empty() == false));
+	});
+	if ((m_bQuit == true) || (m_bShutdownRequested == true))
+	{
+		return false;
+	}
+	if (m_queue.empty() == true)
+	{
+		return true;
+	}
+
+	size_t count = std::min(m_queue.size(), (size_t)std::max(maxCount, 1));
+	requests.assign(m_queue.begin(), m_queue.begin() + count);
+	m_queue.erase(m_queue.begin(), m_queue.begin() + count);
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		requests[i]->taken = now;
+		AddSample(m_queueTimes, MillisecondsBetween(requests[i]->received, now));
+	}
+	m_batches++;
+	m_batchedRequests += (long long)count;
+	return true;
+}
+
+/***********************************************************
+ *  CompleteRequest()
+ *
+ *  This method is used by the renderer to wake the thread
+ *  of a request once its pixels or error are set.
+ ***********************************************************/
+void RenderServer::CompleteRequest(REQUEST* pRequest)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		AddSample(m_renderTimes, MillisecondsBetween(pRequest->taken, std::chrono::steady_clock::now()));
+		if (pRequest->error.empty() == true)
+		{
+			m_completedRequests++;
+		}
+		else
+		{
+			m_failedRequests++;
+		}
+		pRequest->bDone = true;
+	}
+	m_doneCondition.notify_all();
+}
+
+/***********************************************************
+ *  WriteStatistics()
+ *
+ *  This method is used to write the request counts, the
+ *  requests rendered per second since the start, the batch
+ *  sizes and the times of the recent requests.
+ ***********************************************************/
+void RenderServer::WriteStatistics(std::ostream& output)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	double seconds = MillisecondsBetween(m_startTime, std::chrono::steady_clock::now()) / 1000.0;
+	output << "{\"uptime_seconds\":" << seconds
+		<< ",\"completed_requests\":" << m_completedRequests
+		<< ",\"failed_requests\":" << m_failedRequests
+		<< ",\"queued_requests\":" << m_queue.size()
+		<< ",\"requests_per_second\":" << (double)m_completedRequests / std::max(seconds, 1e-9)
+		<< ",\"batches\":" << m_batches
+		<< ",\"mean_batch_size\":" << (double)m_batchedRequests / std::max(m_batches, 1LL)
+		<< ",\"queue_ms\":";
+	WriteWindow(m_queueTimes, output);
+	output << ",\"render_ms\":";
+	WriteWindow(m_renderTimes, output);
+	output << ",\"encode_ms\":";
+	WriteWindow(m_encodeTimes, output);
+	output << ",\"latency_ms\":";
+	WriteWindow(m_totalTimes, output);
+	output << "}";
+}
+
+/***********************************************************
+ *  AcceptLoop()
+ *
+ *  This method is run by the accepting thread.  It starts a
+ *  thread for each client until the socket is shut down, and
+ *  joins the threads of the clients that left.
+ ***********************************************************/
+void RenderServer::AcceptLoop()
+{
+	Profiler::SetThreadName("Render server");
+
+	while (true)
+	{
+		int connection = LocalSocket::Accept(m_listenSocket);
+		JoinFinishedConnections(false);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if ((connection < 0) || (m_bQuit == true))
+		{
+			if (connection >= 0)
+			{
+				LocalSocket::Close(connection);
+			}
+			break;
+		}
+
+		CONNECTION* pConnection = new CONNECTION();
+		pConnection->socket = connection;
+		pConnection->bFinished = false;
+		m_connections.push_back(pConnection);
+		pConnection->thread = std::thread(&RenderServer::ConnectionLoop, this, pConnection);
+	}
+}
+
+/***********************************************************
+ *  JoinFinishedConnections()
+ *
+ *  This method is used to join and free the connections
+ *  whose threads are done, or all of them when stopping.
+ ***********************************************************/
+void RenderServer::JoinFinishedConnections(bool bAll)
+{
+	std::vector<CONNECTION*> finished;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < m_connections.size(); )
+		{
+			if ((bAll == true) || (m_connections[i]->bFinished == true))
+			{
+				finished.push_back(m_connections[i]);
+				m_connections.erase(m_connections.begin() + i);
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < finished.size(); i++)
+	{
+		finished[i]->thread.join();
+		delete finished[i];
+	}
+}
+
+/***********************************************************
+ *  ConnectionLoop()
+ *
+ *  This method is run by the thread of each client.  It
+ *  answers the request lines in the order they arrive until
+ *  the client hangs up or the server stops.
+ ***********************************************************/
+void RenderServer::ConnectionLoop(CONNECTION* pConnection)
+{
+	Profiler::SetThreadName("Render client");
+
+	int connection = pConnection->socket;
+	std::string received;
+	std::vector<unsigned char> rgb;
+	std::vector<unsigned char> png;
+	std::vector<unsigned char> noBytes;
+	char buffer[4096];
+	bool bOpen = true;
+	while (bOpen == true)
+	{
+		size_t lineEnd = received.find('\n');
+		if (lineEnd == std::string::npos)
+		{
+			int count = LocalSocket::Receive(connection, buffer, sizeof(buffer));
+			if ((count <= 0) || (received.size() > g_MaxLineLength))
+			{
+				break;
+			}
+			received.append(buffer, (size_t)count);
+			continue;
+		}
+
+		std::string line = received.substr(0, lineEnd);
+		received.erase(0, lineEnd + 1);
+		if ((line.empty() == false) && (line.back() == '\r'))
+		{
+			line.pop_back();
+		}
+		std::istringstream words(line);
+		std::string command;
+		words >> command;
+
+		if (command.empty() == true)
+		{
+			continue;
+		}
+		else if (command == "render")
+		{
+			REQUEST request;
+			std::string error;
+			if (ParseRequest(line, request, error) == false)
+			{
+				bOpen = SendResponse(connection, "error " + error, noBytes);
+				continue;
+			}
+
+			RenderRequest(request);
+			if (request.error.empty() == false)
+			{
+				bOpen = SendResponse(connection, "error " + request.error, noBytes);
+				continue;
+			}
+
+			// the pixels come bottom row first, as OpenGL reads them
+			std::chrono::steady_clock::time_point encodeStart = std::chrono::steady_clock::now();
+			PngWriter::FlipRGBAToRGB(request.width, request.height, request.pixels.data(), rgb);
+			if (request.bRaw == true)
+			{
+				rgb.swap(png);
+			}
+			else
+			{
+				PngWriter::EncodeRGB(request.width, request.height, rgb.data(), png);
+			}
+			std::chrono::steady_clock::time_point encodeEnd = std::chrono::steady_clock::now();
+			bOpen = SendResponse(connection,
+				(request.bRaw ? "ok rgb " : "ok png ") + std::to_string(png.size()), png);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			AddSample(m_encodeTimes, MillisecondsBetween(encodeStart, encodeEnd));
+			AddSample(m_totalTimes, MillisecondsBetween(request.received, std::chrono::steady_clock::now()));
+		}
+		else if (command == "stats")
+		{
+			std::ostringstream statistics;
+			WriteStatistics(statistics);
+			std::string json = statistics.str();
+			bOpen = SendResponse(connection, "ok json " + std::to_string(json.size()),
+				std::vector<unsigned char>(json.begin(), json.end()));
+		}
+		else if (command == "shutdown")
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_bShutdownRequested = true;
+			}
+			m_requestCondition.notify_all();
+			bOpen = SendResponse(connection, "ok", noBytes);
+		}
+		else
+		{
+			bOpen = SendResponse(connection, "error unknown command " + command, noBytes);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	LocalSocket::Close(connection);
+	pConnection->bFinished = true;
+}
+
+/***********************************************************
+ *  ParseRequest()
+ *
+ *  This method is used to read the pose, size and flags of
+ *  a render request line.
+ ***********************************************************/
+bool RenderServer::ParseRequest(const std::string& line, REQUEST& request, std::string& error) const
+{
+	std::istringstream words(line);
+	std::string command;
+	words >> command
+		>> request.position.x >> request.position.y >> request.position.z
+		>> request.yaw >> request.pitch
+		>> request.width >> request.height;
+	if (!words)
+	{
+		error = "expected render <x y z> <yaw> <pitch> <width> <height> [flags]";
+		return false;
+	}
+	if ((request.width <= 0) || (request.height <= 0) || (request.width > MAX_SIZE) || (request.height > MAX_SIZE))
+	{
+		error = "the size must be from 1 to " + std::to_string(MAX_SIZE);
+		return false;
+	}
+
+	request.bSoftware = m_bSoftwareDefault;
+	request.bOcclusionCulling = true;
+	request.regionX = 0;
+	request.regionY = 0;
+	request.frameWidth = 0;
+	request.frameHeight = 0;
+	request.bRaw = false;
+	std::string flag;
+	while (words >> flag)
+	{
+		if (flag == "gl")
+		{
+			request.bSoftware = false;
+		}
+		else if (flag == "software")
+		{
+			request.bSoftware = true;
+		}
+		else if (flag == "no-occlusion")
+		{
+			request.bOcclusionCulling = false;
+		}
+		else if (flag == "raw")
+		{
+			request.bRaw = true;
+		}
+		else if (flag == "region")
+		{
+			// the image has to fit in the frame before the room
+			// left beside it is taken, so nothing can overflow
+			words >> request.regionX >> request.regionY >> request.frameWidth >> request.frameHeight;
+			if ((!words) || (request.regionX < 0) || (request.regionY < 0) ||
+				(request.frameWidth > MAX_FRAME_SIZE) || (request.frameHeight > MAX_FRAME_SIZE) ||
+				(request.frameWidth < request.width) || (request.frameHeight < request.height) ||
+				(request.regionX > request.frameWidth - request.width) ||
+				(request.regionY > request.frameHeight - request.height))
+			{
+				error = "expected region <x> <y> <frame width> <frame height> around the image, up to "
+					+ std::to_string(MAX_FRAME_SIZE);
+				return false;
+			}
+		}
+		else
+		{
+			error = "unknown flag " + flag;
+			return false;
+		}
+	}
+	return true;
+}
+
+/***********************************************************
+ *  RenderRequest()
+ *
+ *  This method is used to queue a request for the renderer
+ *  and wait until it is completed or the server stops.
+ ***********************************************************/
+void RenderServer::RenderRequest(REQUEST& request)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	request.received = std::chrono::steady_clock::now();
+	request.taken = request.received;
+	request.bDone = false;
+	if ((m_bQuit == true) || (m_bShutdownRequested == true))
+	{
+		request.error = "the service is stopping";
+		return;
+	}
+
+	m_queue.push_back(&request);
+	m_requestCondition.notify_all();
+	m_doneCondition.wait(lock, [&request]() { return(request.bDone == true); });
+}
+
+/***********************************************************
+ *  AddSample()
+ *
+ *  This method is used to keep the time of a request, in
+ *  place of the oldest one once the window is full.
+ ***********************************************************/
+void RenderServer::AddSample(LATENCY_WINDOW& window, double milliseconds)
+{
+	if (window.samples.size() < g_LatencySamples)
+	{
+		window.samples.push_back(milliseconds);
+		return;
+	}
+	window.samples[window.next] = milliseconds;
+	window.next = (window.next + 1) % g_LatencySamples;
+}
+
+/***********************************************************
+ *  WriteWindow()
+ *
+ *  This method is used to write the mean and percentiles of
+ *  the times in a window.
+ ***********************************************************/
+void RenderServer::WriteWindow(const LATENCY_WINDOW& window, std::ostream& output) const
+{
+	FrameStatistics statistics;
+	statistics.Reserve((int)window.samples.size());
+	for (size_t i = 0; i < window.samples.size(); i++)
+	{
+		statistics.AddSample(window.samples[i]);
+	}
+	statistics.WriteJSON(output);
+}
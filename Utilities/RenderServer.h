@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderserver.h
+// ============
+// accept view requests over a Unix domain socket and send the rendered
+// images back, keeping the latency and throughput of the requests
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  RenderServer
+ *
+ *  This class contains the socket side of the render
+ *  service.  Each client connection gets a thread that reads
+ *  one request line at a time:
+ *
+ *    render <x y z> <yaw> <pitch> <width> <height> [flags]
+ *    stats
+ *    shutdown
+ *
+ *  where the flags are "gl", "software", "no-occlusion",
+ *  "raw" and "region <x> <y> <frame width> <frame height>".
+ *  A region request renders only the width * height
+ *  rectangle at x, y of a larger frame, for splitting a
+ *  frame into tiles.  A render request is queued and the
+ *  thread sleeps until the renderer completes it, then
+ *  encodes the pixels as a PNG and answers "ok png <bytes>"
+ *  followed by the bytes.  A raw request is answered with
+ *  "ok rgb <bytes>" and the RGB pixels, top row first.
+ *  "stats" answers "ok json <bytes>" with the metrics, and
+ *  errors are answered with "error <message>".
+ *
+ *  The renderer takes the queued requests in batches with
+ *  TakeRequests(), so the views that arrive while a batch is
+ *  drawn are drawn together.  The time each request waited
+ *  in the queue, was rendered, encoded and took in all is
+ *  kept for the most recent requests.
+ ***********************************************************/
+class RenderServer
+{
+public:
+	// most pixels along each side of a requested image
+	static const int MAX_SIZE = 4096;
+	// most pixels along each side of a frame split into regions
+	static const int MAX_FRAME_SIZE = 32768;
+
+	// one view to render
+	struct REQUEST
+	{
+		glm::vec3 position;
+		float yaw;
+		float pitch;
+		int width;
+		int height;
+		// draw with the software rasterizer, or with OpenGL,
+		// instead of the service's default
+		bool bSoftware;
+		bool bOcclusionCulling;
+		// rectangle of a larger frame that the image shows, from
+		// the top left - the frame size is 0 for the whole view
+		int regionX;
+		int regionY;
+		int frameWidth;
+		int frameHeight;
+		// answer with the pixels instead of a PNG file
+		bool bRaw;
+		// set by the renderer - width * height RGBA pixels with
+		// the bottom row first, or the reason it failed
+		std::vector<unsigned char> pixels;
+		std::string error;
+
+		// kept by the server
+		std::chrono::steady_clock::time_point received;
+		std::chrono::steady_clock::time_point taken;
+		bool bDone;
+	};
+
+	// constructor
+	RenderServer();
+	// destructor
+	~RenderServer();
+
+	// listen on a socket file, replacing a stale one - the
+	// default renderer is used for requests without a flag
+	bool Start(const char* socketPath, bool bSoftwareDefault);
+	// close the socket and the connections, failing the
+	// requests that were not completed
+	void Stop();
+
+	// wait up to the passed in time for requests and take up to
+	// maxCount of them, oldest first - returns false once a
+	// client asked the service to shut down
+	bool TakeRequests(std::vector<REQUEST*>& requests, int maxCount, int waitMilliseconds);
+	// hand a rendered or failed request back to its connection
+	void CompleteRequest(REQUEST* pRequest);
+
+	// write the metrics as a JSON object
+	void WriteStatistics(std::ostream& output);
+
+private:
+	// the times of the most recent requests, in milliseconds
+	struct LATENCY_WINDOW
+	{
+		std::vector<double> samples;
+		size_t next;
+	};
+
+	// one client and the thread that answers it
+	struct CONNECTION
+	{
+		std::thread thread;
+		int socket;
+		// set by the thread once it closed the socket
+		bool bFinished;
+	};
+
+	int m_listenSocket;
+	std::string m_socketPath;
+	bool m_bSoftwareDefault;
+	std::thread m_acceptThread;
+	// shared with the connection threads under m_mutex
+	std::mutex m_mutex;
+	std::condition_variable m_requestCondition;
+	std::condition_variable m_doneCondition;
+	std::vector<CONNECTION*> m_connections;
+	std::vector<REQUEST*> m_queue;
+	bool m_bQuit;
+	bool m_bShutdownRequested;
+	// metrics, under m_mutex
+	std::chrono::steady_clock::time_point m_startTime;
+	long long m_completedRequests;
+	long long m_failedRequests;
+	long long m_batches;
+	long long m_batchedRequests;
+	LATENCY_WINDOW m_queueTimes;
+	LATENCY_WINDOW m_renderTimes;
+	LATENCY_WINDOW m_encodeTimes;
+	LATENCY_WINDOW m_totalTimes;
+
+	// run by the accepting thread and each connection's thread
+	void AcceptLoop();
+	void ConnectionLoop(CONNECTION* pConnection);
+	// join the threads of the connections that were closed
+	void JoinFinishedConnections(bool bAll);
+	// parse a render request line - returns false with the
+	// reason when it is not valid
+	bool ParseRequest(const std::string& line, REQUEST& request, std::string& error) const;
+	// queue a request and wait until it is completed
+	void RenderRequest(REQUEST& request);
+	// add a time to a window, replacing the oldest one when full
+	void AddSample(LATENCY_WINDOW& window, double milliseconds);
+	void WriteWindow(const LATENCY_WINDOW& window, std::ostream& output) const;
+};
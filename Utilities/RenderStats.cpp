@@ -0,0 +1,314 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.cpp
+// ============
+// count the work submitted to OpenGL every frame and export the history
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderStats.h"
+#include "ShapeMeshes.h"
+#include "AllocationCounter.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+RenderStats::FRAME_STATS RenderStats::m_current = RenderStats::FRAME_STATS();
+
+// declaration of the global variables and defines
+namespace
+{
+	// finished frames, oldest first once the ring has wrapped
+	std::vector<RenderStats::FRAME_STATS> g_History(300);
+	// number of frames that were ever finished
+	int g_FinishedFrames = 0;
+	// allocation count when the last frame was finished
+	long long g_LastAllocationCount = 0;
+	// returned before the first frame is finished
+	const RenderStats::FRAME_STATS g_EmptyFrame = RenderStats::FRAME_STATS();
+
+	// the columns that are written for every frame
+	const char* const g_ColumnNames[] = {
+		"frame", "frame_ms", "draw_calls", "triangles", "vertices",
+		"uniform_uploads", "buffer_binds", "texture_binds", "vao_binds", "program_switches",
+		"culled_objects", "heap_allocations"
+	};
+
+	/***********************************************************
+	 *  GetHistoryFrame()
+	 *
+	 *  Get a finished frame, where zero is the oldest one that
+	 *  is still in the history.
+	 ***********************************************************/
+	const RenderStats::FRAME_STATS& GetHistoryFrame(int index)
+	{
+		int count = std::min(g_FinishedFrames, (int)g_History.size());
+		int first = g_FinishedFrames - count;
+
+		return(g_History[(first + index) % g_History.size()]);
+	}
+
+	/***********************************************************
+	 *  GetHistoryCount()
+	 *
+	 *  Get the number of finished frames in the history.
+	 ***********************************************************/
+	int GetHistoryCount()
+	{
+		return(std::min(g_FinishedFrames, (int)g_History.size()));
+	}
+
+	/***********************************************************
+	 *  WriteValues()
+	 *
+	 *  Write the values of one frame in the column order with
+	 *  the passed in separator, followed by the draw calls of
+	 *  each primitive.
+	 ***********************************************************/
+	void WriteValues(std::ostream& output, const RenderStats::FRAME_STATS& stats, const char* separator)
+	{
+		output << stats.frame << separator
+			<< stats.frameMilliseconds << separator
+			<< stats.drawCalls << separator
+			<< stats.triangles << separator
+			<< stats.vertices << separator
+			<< stats.uniformUploads << separator
+			<< stats.bufferBinds << separator
+			<< stats.textureBinds << separator
+			<< stats.vertexArrayBinds << separator
+			<< stats.programSwitches << separator
+			<< stats.culledObjects << separator
+			<< stats.heapAllocations;
+		for (int type = 0; type < ShapeMeshes::meshTypeCount; type++)
+		{
+			output << separator << stats.meshDrawCalls[type];
+		}
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to clear the counters for the next
+ *  frame.
+ ***********************************************************/
+void RenderStats::BeginFrame()
+{
+	m_current = FRAME_STATS();
+	m_current.frame = g_FinishedFrames;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to store the counters of the frame
+ *  in the history, replacing the oldest frame when it is
+ *  full.
+ ***********************************************************/
+void RenderStats::EndFrame(double frameMilliseconds)
+{
+	m_current.frameMilliseconds = frameMilliseconds;
+	long long allocationCount = AllocationCounter::GetAllocationCount();
+	m_current.heapAllocations = (int)(allocationCount - g_LastAllocationCount);
+	g_LastAllocationCount = allocationCount;
+	g_History[g_FinishedFrames % g_History.size()] = m_current;
+	g_FinishedFrames++;
+}
+
+/***********************************************************
+ *  CountDraw()
+ *
+ *  This method is used to count a draw call along with the
+ *  vertices it submits and the triangles they assemble into.
+ *  Line modes do not produce any triangles.
+ ***********************************************************/
+void RenderStats::CountDraw(int meshType, unsigned int mode, int vertexCount)
+{
+	m_current.drawCalls++;
+	if ((meshType >= 0) && (meshType < MAX_MESH_TYPES))
+	{
+		m_current.meshDrawCalls[meshType]++;
+	}
+	m_current.vertices += vertexCount;
+
+	switch (mode)
+	{
+	case GL_TRIANGLES:
+		m_current.triangles += vertexCount / 3;
+		break;
+	case GL_TRIANGLE_STRIP:
+	case GL_TRIANGLE_FAN:
+		if (vertexCount > 2)
+		{
+			m_current.triangles += vertexCount - 2;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  GetLastFrame()
+ *
+ *  This method is used to get the counters of the most
+ *  recently finished frame.
+ ***********************************************************/
+const RenderStats::FRAME_STATS& RenderStats::GetLastFrame()
+{
+	if (g_FinishedFrames == 0)
+	{
+		return(g_EmptyFrame);
+	}
+
+	return(g_History[(g_FinishedFrames - 1) % g_History.size()]);
+}
+
+/***********************************************************
+ *  GetOverlayText()
+ *
+ *  This method is used to get a one line summary of the
+ *  last frame, with the frame time averaged over the last
+ *  second of history so the text is readable.
+ ***********************************************************/
+std::string RenderStats::GetOverlayText()
+{
+	const FRAME_STATS& last = GetLastFrame();
+
+	// average the frame time over the newest frames
+	double totalMilliseconds = 0.0;
+	int averaged = 0;
+	for (int i = GetHistoryCount() - 1; i >= 0; i--)
+	{
+		totalMilliseconds += GetHistoryFrame(i).frameMilliseconds;
+		averaged++;
+		if (totalMilliseconds >= 1000.0)
+		{
+			break;
+		}
+	}
+	double averageMilliseconds = (averaged > 0) ? totalMilliseconds / averaged : 0.0;
+
+	std::ostringstream text;
+	text.setf(std::ios::fixed);
+	text.precision(2);
+	text << averageMilliseconds << " ms | "
+		<< last.drawCalls << " draws | "
+		<< last.triangles << " tris | "
+		<< last.uniformUploads << " uniforms | "
+		<< last.bufferBinds << " UBO binds | "
+		<< last.vertexArrayBinds << " VAO binds | "
+		<< last.culledObjects << " culled";
+
+	return(text.str());
+}
+
+/***********************************************************
+ *  SetHistorySize()
+ *
+ *  This method is used to change the number of finished
+ *  frames that are kept.  The current history is dropped.
+ ***********************************************************/
+void RenderStats::SetHistorySize(int frames)
+{
+	g_History.assign(std::max(frames, 1), FRAME_STATS());
+	g_FinishedFrames = 0;
+}
+
+/***********************************************************
+ *  Export()
+ *
+ *  This method is used to write the history in the format
+ *  that matches the file extension.
+ ***********************************************************/
+bool RenderStats::Export(const char* filename)
+{
+	size_t length = strlen(filename);
+	if ((length >= 5) && (strcmp(filename + length - 5, ".json") == 0))
+	{
+		return(WriteJSON(filename));
+	}
+
+	return(WriteCSV(filename));
+}
+
+/***********************************************************
+ *  WriteCSV()
+ *
+ *  This method is used to write one row per frame in the
+ *  history, oldest first.
+ ***********************************************************/
+bool RenderStats::WriteCSV(const char* filename)
+{
+	std::ofstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not write render statistics:" << filename << std::endl;
+		return false;
+	}
+
+	for (size_t column = 0; column < sizeof(g_ColumnNames) / sizeof(g_ColumnNames[0]); column++)
+	{
+		file << ((column > 0) ? "," : "") << g_ColumnNames[column];
+	}
+	for (int type = 0; type < ShapeMeshes::meshTypeCount; type++)
+	{
+		file << ",draws_" << ShapeMeshes::GetMeshTypeName((ShapeMeshes::MeshType)type);
+	}
+	file << "\n";
+
+	for (int i = 0; i < GetHistoryCount(); i++)
+	{
+		WriteValues(file, GetHistoryFrame(i), ",");
+		file << "\n";
+	}
+
+	std::cout << "Wrote " << GetHistoryCount() << " frames of render statistics to:" << filename << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  WriteJSON()
+ *
+ *  This method is used to write the history as a JSON
+ *  object with the column names and one array per frame,
+ *  which keeps long histories compact.
+ ***********************************************************/
+bool RenderStats::WriteJSON(const char* filename)
+{
+	std::ofstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not write render statistics:" << filename << std::endl;
+		return false;
+	}
+
+	file << "{\"columns\":[";
+	for (size_t column = 0; column < sizeof(g_ColumnNames) / sizeof(g_ColumnNames[0]); column++)
+	{
+		file << ((column > 0) ? "," : "") << "\"" << g_ColumnNames[column] << "\"";
+	}
+	for (int type = 0; type < ShapeMeshes::meshTypeCount; type++)
+	{
+		file << ",\"draws_" << ShapeMeshes::GetMeshTypeName((ShapeMeshes::MeshType)type) << "\"";
+	}
+	file << "],\"frames\":[";
+
+	for (int i = 0; i < GetHistoryCount(); i++)
+	{
+		file << ((i > 0) ? ",\n[" : "\n[");
+		WriteValues(file, GetHistoryFrame(i), ",");
+		file << "]";
+	}
+	file << "\n]}\n";
+
+	std::cout << "Wrote " << GetHistoryCount() << " frames of render statistics to:" << filename << std::endl;
+
+	return true;
+}
@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.h
+// ============
+// count the work submitted to OpenGL every frame and export the history
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+
+/***********************************************************
+ *  RenderStats
+ *
+ *  This class contains the counters for the draw calls,
+ *  triangles, vertices and state changes of each frame.
+ *  The counting happens where ShapeMeshes draws and where
+ *  ShaderManager uploads uniforms or binds uniform buffers,
+ *  so every object drawn by the scene is covered.  The last
+ *  frames are kept in a rolling history that can be written
+ *  as CSV or JSON.  The heap allocations of all threads are
+ *  counted from the end of one frame to the end of the next.
+ *  The counters must only be used from the thread that
+ *  issues the OpenGL commands.
+ ***********************************************************/
+class RenderStats
+{
+public:
+	// the most primitive types that can be counted separately
+	static const int MAX_MESH_TYPES = 16;
+
+	// counters for one frame
+	struct FRAME_STATS
+	{
+		int frame;
+		double frameMilliseconds;
+		int drawCalls;
+		// draw calls for each ShapeMeshes::MeshType
+		int meshDrawCalls[MAX_MESH_TYPES];
+		long long triangles;
+		long long vertices;
+		int uniformUploads;
+		// uniform buffer ranges bound for the shader's blocks
+		int bufferBinds;
+		// texture switches between draws and textures bound for
+		// uploads
+		int textureBinds;
+		int vertexArrayBinds;
+		int programSwitches;
+		int culledObjects;
+		// heap allocations made on any thread since the last frame
+		int heapAllocations;
+	};
+
+	// start counting a new frame
+	static void BeginFrame();
+	// finish the frame and add it to the history
+	static void EndFrame(double frameMilliseconds);
+
+	// count a draw call of the passed in primitive with the
+	// OpenGL primitive mode and number of vertices
+	static void CountDraw(int meshType, unsigned int mode, int vertexCount);
+	static void CountUniformUpload() { m_current.uniformUploads++; }
+	static void CountBufferBind() { m_current.bufferBinds++; }
+	static void CountTextureBind() { m_current.textureBinds++; }
+	static void CountVertexArrayBind() { m_current.vertexArrayBinds++; }
+	static void CountProgramSwitch() { m_current.programSwitches++; }
+	static void CountCulledObject() { m_current.culledObjects++; }
+
+	// counters of the frame being rendered
+	static const FRAME_STATS& GetCurrentFrame() { return(m_current); }
+	// counters of the last finished frame
+	static const FRAME_STATS& GetLastFrame();
+
+	// short summary of the last frames for the window title
+	static std::string GetOverlayText();
+
+	// number of finished frames kept for exporting
+	static void SetHistorySize(int frames);
+	// write the history - a filename ending in .json is
+	// written as JSON, anything else as CSV
+	static bool Export(const char* filename);
+	static bool WriteCSV(const char* filename);
+	static bool WriteJSON(const char* filename);
+
+private:
+	// counters of the frame being rendered
+	static FRAME_STATS m_current;
+};
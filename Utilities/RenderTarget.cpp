@@ -0,0 +1,165 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.cpp
+// ============
+// manage an offscreen framebuffer with a color texture and a depth texture
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderTarget.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  RenderTarget()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderTarget::RenderTarget()
+{
+	m_framebufferID = 0;
+	m_colorTextureID = 0;
+	m_depthTextureID = 0;
+	m_velocityTextureID = 0;
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  ~RenderTarget()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderTarget::~RenderTarget()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create the framebuffer object with
+ *  an RGBA color texture of the passed in format and a 24
+ *  bit depth texture.  With a velocity format the fragment
+ *  shader's second output is kept in another texture.
+ ***********************************************************/
+bool RenderTarget::Create(int width, int height, GLenum colorFormat, GLenum velocityFormat)
+{
+	// free any previously created attachments
+	Destroy();
+
+	m_width = width;
+	m_height = height;
+
+	// color attachment - a texture so it can be sampled later
+	glGenTextures(1, &m_colorTextureID);
+	glBindTexture(GL_TEXTURE_2D, m_colorTextureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, colorFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// depth attachment - also a texture, so the temporal
+	// upscaling can reproject the pixels by their depth
+	glGenTextures(1, &m_depthTextureID);
+	glBindTexture(GL_TEXTURE_2D, m_depthTextureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// velocity attachment - read texel by texel, so it is
+	// never filtered
+	if (velocityFormat != GL_NONE)
+	{
+		glGenTextures(1, &m_velocityTextureID);
+		glBindTexture(GL_TEXTURE_2D, m_velocityTextureID);
+		glTexImage2D(GL_TEXTURE_2D, 0, velocityFormat, width, height, 0, GL_RG, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTextureID, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTextureID, 0);
+	if (m_velocityTextureID != 0)
+	{
+		static const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_velocityTextureID, 0);
+		glDrawBuffers(2, drawBuffers);
+	}
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Framebuffer is not complete, status:" << status << std::endl;
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to free the framebuffer object and
+ *  its attachments.
+ ***********************************************************/
+void RenderTarget::Destroy()
+{
+	if (m_framebufferID != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (m_colorTextureID != 0)
+	{
+		glDeleteTextures(1, &m_colorTextureID);
+		m_colorTextureID = 0;
+	}
+	if (m_depthTextureID != 0)
+	{
+		glDeleteTextures(1, &m_depthTextureID);
+		m_depthTextureID = 0;
+	}
+	if (m_velocityTextureID != 0)
+	{
+		glDeleteTextures(1, &m_velocityTextureID);
+		m_velocityTextureID = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used to render into the framebuffer and
+ *  size the viewport to match it.
+ ***********************************************************/
+void RenderTarget::Bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glViewport(0, 0, m_width, m_height);
+}
+
+/***********************************************************
+ *  Unbind()
+ *
+ *  This method is used to go back to rendering into the
+ *  default framebuffer of the display window.
+ ***********************************************************/
+void RenderTarget::Unbind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
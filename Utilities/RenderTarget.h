@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.h
+// ============
+// manage an offscreen framebuffer with a color texture and a depth texture
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+/***********************************************************
+ *  RenderTarget
+ *
+ *  This class contains the code for creating, binding and
+ *  freeing an OpenGL framebuffer object that the 3D scene
+ *  can be rendered into instead of the display window.
+ ***********************************************************/
+class RenderTarget
+{
+public:
+	// constructor
+	RenderTarget();
+	// destructor
+	~RenderTarget();
+
+	// create the framebuffer with the passed in size and format
+	// of the color texture, and a second color texture of the
+	// velocity format unless it is GL_NONE
+	bool Create(int width, int height, GLenum colorFormat = GL_RGBA8, GLenum velocityFormat = GL_NONE);
+	// free the framebuffer and its attachments
+	void Destroy();
+
+	// direct all following draw commands into the framebuffer
+	void Bind();
+	// direct all following draw commands into the display window
+	void Unbind();
+
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
+	GLuint GetFramebuffer() const { return(m_framebufferID); }
+	GLuint GetColorTexture() const { return(m_colorTextureID); }
+	GLuint GetDepthTexture() const { return(m_depthTextureID); }
+	// 0 when the target was created without a velocity texture
+	GLuint GetVelocityTexture() const { return(m_velocityTextureID); }
+
+private:
+	// OpenGL object handles
+	GLuint m_framebufferID;
+	GLuint m_colorTextureID;
+	GLuint m_depthTextureID;
+	GLuint m_velocityTextureID;
+	// size of the attachments in pixels
+	int m_width;
+	int m_height;
+};
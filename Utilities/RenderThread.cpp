@@ -0,0 +1,174 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderthread.cpp
+// ============
+// own the OpenGL context on a dedicated thread that draws the frame packets
+// prepared by the main thread
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderThread.h"
+#include "Profiler.h"
+
+#include <chrono>
+
+// declaration of the global variables and defines
+namespace
+{
+	// times a waiting thread yields before it starts sleeping
+	const int g_SpinAttempts = 64;
+
+	// give up the processor while waiting for the other thread,
+	// sleeping briefly once it has taken a while
+	void WaitForOtherThread(int& attempts)
+	{
+		if (attempts < g_SpinAttempts)
+		{
+			attempts++;
+			std::this_thread::yield();
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+}
+
+/***********************************************************
+ *  RenderThread()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderThread::RenderThread()
+{
+	m_bQuit = false;
+	for (int i = 0; i < PACKET_COUNT; i++)
+	{
+		m_freePackets.TryPush(&m_packets[i]);
+	}
+}
+
+/***********************************************************
+ *  ~RenderThread()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderThread::~RenderThread()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to start the render thread.  From
+ *  here on only the render thread may make OpenGL calls,
+ *  until Stop() returns.
+ ***********************************************************/
+void RenderThread::Start(
+	const std::function<void()>& attachContext,
+	const DRAW_FUNCTION& draw,
+	const std::function<void()>& detachContext)
+{
+	if (IsRunning() == true)
+	{
+		return;
+	}
+
+	m_attachContext = attachContext;
+	m_draw = draw;
+	m_detachContext = detachContext;
+	m_bQuit = false;
+	m_thread = std::thread(&RenderThread::ThreadLoop, this);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used to wait until every submitted packet
+ *  has been drawn and the render thread has released the
+ *  context, so it can be made current on the calling thread.
+ ***********************************************************/
+void RenderThread::Stop()
+{
+	if (IsRunning() == false)
+	{
+		return;
+	}
+
+	m_bQuit.store(true, std::memory_order_release);
+	m_thread.join();
+}
+
+/***********************************************************
+ *  AcquirePacket()
+ *
+ *  This method is used to get a packet to fill for the next
+ *  frame.  It waits while both packets are still queued or
+ *  being drawn, which keeps the main thread at most one
+ *  frame ahead of the render thread.
+ ***********************************************************/
+FRAME_PACKET* RenderThread::AcquirePacket()
+{
+	PROFILE_FUNCTION();
+
+	FRAME_PACKET* packet = NULL;
+	int attempts = 0;
+	while (m_freePackets.TryPop(packet) == false)
+	{
+		WaitForOtherThread(attempts);
+	}
+
+	return(packet);
+}
+
+/***********************************************************
+ *  SubmitPacket()
+ *
+ *  This method is used to queue a filled packet for drawing.
+ *  The packet must not be touched again until it is returned
+ *  by AcquirePacket().
+ ***********************************************************/
+void RenderThread::SubmitPacket(FRAME_PACKET* packet)
+{
+	// there is always room, since only PACKET_COUNT packets exist
+	m_readyPackets.TryPush(packet);
+}
+
+/***********************************************************
+ *  ThreadLoop()
+ *
+ *  This method is run by the render thread.  It draws the
+ *  packets in the order they were submitted and returns each
+ *  one to the main thread once it is drawn.
+ ***********************************************************/
+void RenderThread::ThreadLoop()
+{
+	Profiler::SetThreadName("Render thread");
+	m_attachContext();
+
+	int attempts = 0;
+	while (true)
+	{
+		// read the flag before looking at the queue, so every
+		// packet submitted before Stop() is drawn
+		bool bQuit = m_bQuit.load(std::memory_order_acquire);
+
+		FRAME_PACKET* packet = NULL;
+		if (m_readyPackets.TryPop(packet) == true)
+		{
+			m_draw(*packet);
+			m_freePackets.TryPush(packet);
+			attempts = 0;
+		}
+		else if (bQuit == true)
+		{
+			break;
+		}
+		else
+		{
+			WaitForOtherThread(attempts);
+		}
+	}
+
+	m_detachContext();
+}
@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderthread.h
+// ============
+// own the OpenGL context on a dedicated thread that draws the frame packets
+// prepared by the main thread
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FramePacket.h"
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+/***********************************************************
+ *  RenderThread
+ *
+ *  This class contains the thread that makes all of the
+ *  OpenGL calls.  Two frame packets go back and forth
+ *  between the main thread and the render thread through
+ *  two lock-free queues - one with the packets ready to be
+ *  drawn and one with the packets that can be filled again -
+ *  so the main thread prepares frame N+1 while frame N is
+ *  drawn, and input is handled even when drawing is slow.
+ ***********************************************************/
+class RenderThread
+{
+public:
+	// function that draws one packet on the render thread
+	typedef std::function<void(FRAME_PACKET& packet)> DRAW_FUNCTION;
+
+	// number of packets in flight, one prepared while one is drawn
+	static const int PACKET_COUNT = 2;
+
+	// constructor
+	RenderThread();
+	// destructor
+	~RenderThread();
+
+	// start the thread - the context must not be current on the
+	// calling thread.  attachContext and detachContext make it
+	// current on the render thread before the first packet and
+	// release it after the last one
+	void Start(
+		const std::function<void()>& attachContext,
+		const DRAW_FUNCTION& draw,
+		const std::function<void()>& detachContext);
+	// draw every submitted packet, then stop the thread
+	void Stop();
+	bool IsRunning() const { return(m_thread.joinable()); }
+
+	// wait for a packet that the render thread has finished with
+	FRAME_PACKET* AcquirePacket();
+	// hand a filled packet to the render thread
+	void SubmitPacket(FRAME_PACKET* packet);
+
+private:
+	FRAME_PACKET m_packets[PACKET_COUNT];
+	// packets that can be filled and packets waiting to be drawn
+	SpscQueue<FRAME_PACKET*, PACKET_COUNT> m_freePackets;
+	SpscQueue<FRAME_PACKET*, PACKET_COUNT> m_readyPackets;
+	std::thread m_thread;
+	std::atomic<bool> m_bQuit;
+	std::function<void()> m_attachContext;
+	std::function<void()> m_detachContext;
+	DRAW_FUNCTION m_draw;
+
+	// loop of the render thread
+	void ThreadLoop();
+};
@@ -0,0 +1,476 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.cpp
+// ============
+// draw the scene at a lower resolution that follows the measured GPU time
+// and scale it up to the output
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResolutionScaler.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the scale is a whole number of these steps
+	const float g_ScaleStep = 0.05f;
+	// GPU times at a new scale that are averaged before the
+	// scale may change again
+	const int g_SettleSamples = 8;
+	// weight of the newest GPU time in the average
+	const double g_AverageWeight = 0.25;
+	// the first frames at a new scale also create the target,
+	// so their GPU times are left out of the average
+	const int g_SkippedFrames = 2;
+	// the jitter repeats after this many frames
+	const int g_JitterPhases = 8;
+
+	/***********************************************************
+	 *  Halton()
+	 *
+	 *  This function is used to get the index-th point of the
+	 *  Halton sequence of the passed in base, which spreads
+	 *  any number of consecutive points evenly over [0, 1).
+	 ***********************************************************/
+	float Halton(int index, int base)
+	{
+		float fraction = 1.0f;
+		float result = 0.0f;
+		while (index > 0)
+		{
+			fraction /= (float)base;
+			result += fraction * (float)(index % base);
+			index /= base;
+		}
+		return(result);
+	}
+}
+
+/***********************************************************
+ *  ResolutionScaler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ResolutionScaler::ResolutionScaler()
+{
+	m_settings = SETTINGS();
+	m_outputWidth = 0;
+	m_outputHeight = 0;
+	m_upscaleShader.m_programID = 0;
+	m_vertexArrayID = 0;
+	m_scale = 1.0f;
+	m_firstScaledFrame = 0;
+	m_currentFrame = 0;
+	m_averageMilliseconds = 0.0;
+	m_sampleCount = 0;
+	m_scaleChanges = 0;
+	m_scaleSum = 0.0;
+	m_scaledFrames = 0;
+	m_lowestScale = 1.0f;
+	m_outputFramebuffer = 0;
+	m_outputViewport[0] = 0;
+	m_outputViewport[1] = 0;
+	m_outputViewport[2] = 0;
+	m_outputViewport[3] = 0;
+	m_bDrawingScaled = false;
+	m_resolveShader.m_programID = 0;
+	m_historyIndex = 0;
+	m_bHistoryValid = false;
+	m_viewProjection = glm::mat4(1.0f);
+	m_previousViewProjection = glm::mat4(1.0f);
+	m_jitter = glm::vec2(0.0f);
+}
+
+/***********************************************************
+ *  ~ResolutionScaler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ResolutionScaler::~ResolutionScaler()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to load the upscaling shader, or the
+ *  resolving shader and the history in temporal mode, and
+ *  start at the largest scale.
+ ***********************************************************/
+bool ResolutionScaler::Create(int outputWidth, int outputHeight, const SETTINGS& settings)
+{
+	Destroy();
+
+	if (m_upscaleShader.LoadShaders(
+		"shaders/upscaleVertexShader.glsl",
+		"shaders/upscaleFragmentShader.glsl") == 0)
+	{
+		return false;
+	}
+	if (settings.bTemporal == true)
+	{
+		if ((m_resolveShader.LoadShaders(
+				"shaders/upscaleVertexShader.glsl",
+				"shaders/temporalResolveFragmentShader.glsl") == 0) ||
+			(m_history[0].Create(outputWidth, outputHeight, GL_RGBA16F) == false) ||
+			(m_history[1].Create(outputWidth, outputHeight, GL_RGBA16F) == false))
+		{
+			Destroy();
+			return false;
+		}
+	}
+	glGenVertexArrays(1, &m_vertexArrayID);
+
+	m_settings = settings;
+	m_outputWidth = outputWidth;
+	m_outputHeight = outputHeight;
+	m_scale = settings.maxScale;
+	m_lowestScale = m_scale;
+	m_firstScaledFrame = 0;
+	m_averageMilliseconds = 0.0;
+	m_sampleCount = 0;
+	m_scaleChanges = 0;
+	m_scaleSum = 0.0;
+	m_scaledFrames = 0;
+	m_historyIndex = 0;
+	m_bHistoryValid = false;
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to free the targets, the vertex array
+ *  and the shaders.
+ ***********************************************************/
+void ResolutionScaler::Destroy()
+{
+	m_renderTarget.Destroy();
+	m_history[0].Destroy();
+	m_history[1].Destroy();
+	if (m_vertexArrayID != 0)
+	{
+		glDeleteVertexArrays(1, &m_vertexArrayID);
+		m_vertexArrayID = 0;
+	}
+	if (m_upscaleShader.m_programID != 0)
+	{
+		glDeleteProgram(m_upscaleShader.m_programID);
+		m_upscaleShader.m_programID = 0;
+	}
+	if (m_resolveShader.m_programID != 0)
+	{
+		glDeleteProgram(m_resolveShader.m_programID);
+		m_resolveShader.m_programID = 0;
+	}
+}
+
+/***********************************************************
+ *  GetRenderWidth()
+ *
+ *  This method is used to get the width the scene is drawn
+ *  at with the current scale.
+ ***********************************************************/
+int ResolutionScaler::GetRenderWidth() const
+{
+	return(std::max(1, (int)(m_outputWidth * m_scale + 0.5f)));
+}
+
+/***********************************************************
+ *  GetRenderHeight()
+ *
+ *  This method is used to get the height the scene is drawn
+ *  at with the current scale.
+ ***********************************************************/
+int ResolutionScaler::GetRenderHeight() const
+{
+	return(std::max(1, (int)(m_outputHeight * m_scale + 0.5f)));
+}
+
+/***********************************************************
+ *  GetMeanScale()
+ *
+ *  This method is used to get the mean scale of the frames
+ *  begun so far.
+ ***********************************************************/
+float ResolutionScaler::GetMeanScale() const
+{
+	if (m_scaledFrames == 0)
+	{
+		return(m_scale);
+	}
+	return((float)(m_scaleSum / m_scaledFrames));
+}
+
+/***********************************************************
+ *  GetJitter()
+ *
+ *  This method is used to get the sub-pixel offset of the
+ *  projection for a frame in temporal mode.  The offsets
+ *  follow the Halton sequence of bases 2 and 3 across one
+ *  pixel of the size the frame is drawn at.
+ ***********************************************************/
+glm::vec2 ResolutionScaler::GetJitter(int frame) const
+{
+	if (m_settings.bTemporal == false)
+	{
+		return(glm::vec2(0.0f));
+	}
+
+	int phase = (frame % g_JitterPhases) + 1;
+	glm::vec2 offset(Halton(phase, 2) - 0.5f, Halton(phase, 3) - 0.5f);
+	return(offset * 2.0f / glm::vec2((float)GetRenderWidth(), (float)GetRenderHeight()));
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to keep the bound framebuffer as the
+ *  output and bind the target in its place, creating it
+ *  again when the scale changed.  The projection keeps the
+ *  aspect of the output, so only the viewport shrinks.  The
+ *  temporal mode always draws into the target, since it
+ *  needs the depth of the frame, and keeps its camera.
+ ***********************************************************/
+void ResolutionScaler::BeginFrame(const FRAME_PACKET& packet)
+{
+	m_currentFrame = packet.frame;
+	m_scaleSum += m_scale;
+	m_scaledFrames++;
+	int width = GetRenderWidth();
+	int height = GetRenderHeight();
+	m_bDrawingScaled = (m_settings.bTemporal == true) || (width != m_outputWidth) || (height != m_outputHeight);
+	if (m_bDrawingScaled == false)
+	{
+		m_renderTarget.Destroy();
+		return;
+	}
+
+	if (m_settings.bTemporal == true)
+	{
+		// the history is reprojected without the jitter, which
+		// the packet's projection was moved by last
+		glm::mat4 unjitter(1.0f);
+		unjitter[3][0] = -packet.jitter.x;
+		unjitter[3][1] = -packet.jitter.y;
+		m_viewProjection = unjitter * packet.projection * packet.view;
+		m_jitter = packet.jitter;
+	}
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_outputFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_outputViewport);
+	// the temporal mode also keeps the velocity the scene's
+	// fragment shader writes
+	GLenum velocityFormat = (m_settings.bTemporal == true) ? GL_RG16F : GL_NONE;
+	if (((m_renderTarget.GetWidth() != width) || (m_renderTarget.GetHeight() != height)) &&
+		(m_renderTarget.Create(width, height, GL_RGBA8, velocityFormat) == false))
+	{
+		m_bDrawingScaled = false;
+		return;
+	}
+	m_renderTarget.Bind();
+}
+
+/***********************************************************
+ *  Present()
+ *
+ *  This method is used to draw the target over the whole
+ *  output with the upscaling shader.  The program, the
+ *  texture of unit 0 and the depth test and blending that
+ *  the scene relies on are put back afterwards.
+ ***********************************************************/
+void ResolutionScaler::Present()
+{
+	if (m_bDrawingScaled == false)
+	{
+		return;
+	}
+	PROFILE_FUNCTION();
+
+	if (m_settings.bTemporal == true)
+	{
+		Resolve();
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_outputFramebuffer);
+	glViewport(m_outputViewport[0], m_outputViewport[1], m_outputViewport[2], m_outputViewport[3]);
+
+	GLint sceneProgram = 0;
+	GLint activeTexture = 0;
+	GLint sceneTexture = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &sceneProgram);
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	glActiveTexture(GL_TEXTURE0);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &sceneTexture);
+	GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean bBlend = glIsEnabled(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	m_upscaleShader.use();
+	glBindTexture(GL_TEXTURE_2D, m_renderTarget.GetColorTexture());
+	m_upscaleShader.setIntValue("sourceTexture", 0);
+	m_upscaleShader.setVec2Value("sourceSize", (float)m_renderTarget.GetWidth(), (float)m_renderTarget.GetHeight());
+	glBindVertexArray(m_vertexArrayID);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	glBindTexture(GL_TEXTURE_2D, (GLuint)sceneTexture);
+	glActiveTexture((GLenum)activeTexture);
+	glUseProgram((GLuint)sceneProgram);
+	if (bDepthTest == GL_TRUE)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (bBlend == GL_TRUE)
+	{
+		glEnable(GL_BLEND);
+	}
+}
+
+/***********************************************************
+ *  Resolve()
+ *
+ *  This method is used to blend the drawn frame into the
+ *  history at the output size, with the current frame's
+ *  color and depth on units 0 and 1, the last resolved frame
+ *  on unit 2 and the velocity on unit 3, and to copy the
+ *  result to the output.
+ *  The next frame reads the result as its history.
+ ***********************************************************/
+void ResolutionScaler::Resolve()
+{
+	RenderTarget& history = m_history[m_historyIndex];
+	RenderTarget& lastHistory = m_history[1 - m_historyIndex];
+	history.Bind();
+
+	GLint sceneProgram = 0;
+	GLint activeTexture = 0;
+	GLint sceneTextures[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_CURRENT_PROGRAM, &sceneProgram);
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	for (int unit = 0; unit < 4; unit++)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &sceneTextures[unit]);
+	}
+	GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean bBlend = glIsEnabled(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	// maps a position of the background, without the jitter,
+	// to where it was seen in the last frame
+	glm::mat4 reprojection = m_previousViewProjection * glm::inverse(m_viewProjection);
+
+	m_resolveShader.use();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_renderTarget.GetColorTexture());
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, m_renderTarget.GetDepthTexture());
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, lastHistory.GetColorTexture());
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_2D, m_renderTarget.GetVelocityTexture());
+	m_resolveShader.setIntValue("currentTexture", 0);
+	m_resolveShader.setIntValue("depthTexture", 1);
+	m_resolveShader.setIntValue("historyTexture", 2);
+	m_resolveShader.setIntValue("velocityTexture", 3);
+	m_resolveShader.setVec2Value("sourceSize", (float)m_renderTarget.GetWidth(), (float)m_renderTarget.GetHeight());
+	m_resolveShader.setVec2Value("outputSize", (float)m_outputWidth, (float)m_outputHeight);
+	m_resolveShader.setVec2Value("jitter", m_jitter);
+	m_resolveShader.setMat4Value("reprojection", reprojection);
+	m_resolveShader.setBoolValue("bHistoryValid", m_bHistoryValid);
+	glBindVertexArray(m_vertexArrayID);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	// the output may be the window, which cannot be sampled
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, history.GetFramebuffer());
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)m_outputFramebuffer);
+	glBlitFramebuffer(
+		0, 0, m_outputWidth, m_outputHeight,
+		m_outputViewport[0], m_outputViewport[1],
+		m_outputViewport[0] + m_outputViewport[2], m_outputViewport[1] + m_outputViewport[3],
+		GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_outputFramebuffer);
+	glViewport(m_outputViewport[0], m_outputViewport[1], m_outputViewport[2], m_outputViewport[3]);
+
+	for (int unit = 3; unit >= 0; unit--)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, (GLuint)sceneTextures[unit]);
+	}
+	glActiveTexture((GLenum)activeTexture);
+	glUseProgram((GLuint)sceneProgram);
+	if (bDepthTest == GL_TRUE)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (bBlend == GL_TRUE)
+	{
+		glEnable(GL_BLEND);
+	}
+
+	m_previousViewProjection = m_viewProjection;
+	m_historyIndex = 1 - m_historyIndex;
+	m_bHistoryValid = true;
+}
+
+/***********************************************************
+ *  AddGpuTime()
+ *
+ *  This method is used to average the GPU times of the
+ *  frames drawn at the current scale, and to change the
+ *  scale once enough of them are further from the target
+ *  than the hysteresis allows.
+ ***********************************************************/
+void ResolutionScaler::AddGpuTime(int frame, double milliseconds)
+{
+	// without a target the scale is fixed
+	if (m_settings.targetMilliseconds <= 0.0)
+	{
+		return;
+	}
+
+	// the times arrive a few frames late, so frames drawn at
+	// the last scale may still come in
+	if (frame < m_firstScaledFrame)
+	{
+		return;
+	}
+
+	m_averageMilliseconds = (m_sampleCount == 0) ? milliseconds :
+		m_averageMilliseconds + (milliseconds - m_averageMilliseconds) * g_AverageWeight;
+	m_sampleCount++;
+	if (m_sampleCount < g_SettleSamples)
+	{
+		return;
+	}
+
+	double target = m_settings.targetMilliseconds;
+	if ((m_averageMilliseconds <= target * (1.0 + m_settings.hysteresis)) &&
+		(m_averageMilliseconds >= target * (1.0 - m_settings.hysteresis)))
+	{
+		return;
+	}
+
+	float scale = m_scale * (float)std::sqrt(target / std::max(m_averageMilliseconds, 1e-3));
+	scale = std::round(scale / g_ScaleStep) * g_ScaleStep;
+	scale = std::min(std::max(scale, m_settings.minScale), m_settings.maxScale);
+	if (std::fabs(scale - m_scale) < g_ScaleStep * 0.5f)
+	{
+		return;
+	}
+
+	m_scale = scale;
+	m_lowestScale = std::min(m_lowestScale, scale);
+	m_scaleChanges++;
+	m_firstScaledFrame = m_currentFrame + 1 + g_SkippedFrames;
+	m_sampleCount = 0;
+}
@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.h
+// ============
+// draw the scene at a lower resolution that follows the measured GPU time
+// and scale it up to the output
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FramePacket.h"
+#include "RenderTarget.h"
+#include "ShaderManager.h"
+
+#include <atomic>
+
+/***********************************************************
+ *  ResolutionScaler
+ *
+ *  This class contains dynamic resolution scaling.  Between
+ *  BeginFrame() and Present() the scene is drawn into an
+ *  offscreen target whose size is the output size times the
+ *  current scale, and Present() scales it up into the
+ *  framebuffer that was bound before, with a Catmull-Rom
+ *  filter so the edges stay sharp.  At full scale the scene
+ *  is drawn straight into the output instead.
+ *
+ *  The GPU times of the frames are averaged, and once the
+ *  average is further than the hysteresis from the target
+ *  frame time, the scale is changed by the square root of
+ *  the ratio, as the time mostly follows the pixel count.
+ *  The scale moves in fixed steps and waits for a few frames
+ *  drawn at the new size before it changes again, so the
+ *  target is not created anew every frame.  Without a target
+ *  frame time the scale stays at the largest one.
+ *
+ *  In temporal mode the projection of each frame is moved by
+ *  a different fraction of a pixel, and Present() resolves
+ *  the frame into a history at the output size instead.
+ *  Every output pixel is found in the last frame by the
+ *  velocity the scene wrote into the target's second
+ *  attachment, from the last and current world matrices and
+ *  view-projection, so moving objects are followed as well as
+ *  the camera.  The background has no velocity and is found
+ *  by the camera alone.  The history there is clamped to the
+ *  colors around the pixel in the new frame before the new
+ *  sample is blended in, so the history gathers the detail of
+ *  many frames without ghosting.
+ ***********************************************************/
+class ResolutionScaler
+{
+public:
+	// how the scale follows the GPU time
+	struct SETTINGS
+	{
+		double targetMilliseconds;
+		float minScale;
+		float maxScale;
+		// fraction of the target frame time that the average may
+		// be off by without changing the scale
+		float hysteresis;
+		// gather the jittered frames into a history instead of
+		// scaling each one up on its own
+		bool bTemporal;
+	};
+
+	// constructor
+	ResolutionScaler();
+	// destructor
+	~ResolutionScaler();
+
+	// load the upscaling shaders for output of the passed in size
+	bool Create(int outputWidth, int outputHeight, const SETTINGS& settings);
+	// free the targets and the shaders
+	void Destroy();
+
+	// offset of the projection for the passed in frame, in
+	// normalized device coordinates - zero unless temporal,
+	// and safe to call while another thread draws
+	glm::vec2 GetJitter(int frame) const;
+	// bind the target for drawing the passed in frame, sized
+	// for the current scale
+	void BeginFrame(const FRAME_PACKET& packet);
+	// scale the drawn frame up into the framebuffer that was
+	// bound when the frame began
+	void Present();
+	// add the measured GPU time of a frame, which may change
+	// the scale of the following frames
+	void AddGpuTime(int frame, double milliseconds);
+
+	const SETTINGS& GetSettings() const { return(m_settings); }
+	float GetScale() const { return(m_scale); }
+	bool IsTemporal() const { return(m_settings.bTemporal); }
+	int GetRenderWidth() const;
+	int GetRenderHeight() const;
+	// number of times the scale changed
+	int GetScaleChanges() const { return(m_scaleChanges); }
+	// mean scale and lowest scale of the frames begun so far
+	float GetMeanScale() const;
+	float GetLowestScale() const { return(m_lowestScale); }
+
+private:
+	SETTINGS m_settings;
+	int m_outputWidth;
+	int m_outputHeight;
+	RenderTarget m_renderTarget;
+	ShaderManager m_upscaleShader;
+	// the fullscreen triangle takes its corners from the vertex
+	// index, but a vertex array must still be bound
+	GLuint m_vertexArrayID;
+	// changed by the thread that draws, and read by the thread
+	// that prepares the jitter of the next frames
+	std::atomic<float> m_scale;
+	// first frame drawn at the current scale - the GPU times of
+	// earlier frames are not counted
+	int m_firstScaledFrame;
+	int m_currentFrame;
+	double m_averageMilliseconds;
+	int m_sampleCount;
+	int m_scaleChanges;
+	double m_scaleSum;
+	int m_scaledFrames;
+	float m_lowestScale;
+	// output framebuffer and viewport saved by BeginFrame()
+	GLint m_outputFramebuffer;
+	GLint m_outputViewport[4];
+	bool m_bDrawingScaled;
+	// temporal mode - the resolved frames at the output size,
+	// one read as the history while the other is written - the
+	// small blend weights need more than 8 bits per channel
+	ShaderManager m_resolveShader;
+	RenderTarget m_history[2];
+	int m_historyIndex;
+	bool m_bHistoryValid;
+	// view-projection of the frame being drawn without its
+	// jitter, and of the frame resolved before it
+	glm::mat4 m_viewProjection;
+	glm::mat4 m_previousViewProjection;
+	glm::vec2 m_jitter;
+
+	// blend the drawn frame into the history and copy the
+	// result to the output
+	void Resolve();
+};
@@ -0,0 +1,858 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// read scene descriptions in chunks from their text or binary form, and
+// convert the text form into the binary form or split it into tiles
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <unordered_set>
+
+// declaration of the global variables and defines
+namespace
+{
+	const char g_Magic[4] = { 'S', 'C', 'N', 'B' };
+	// version of the binary form
+	const uint32_t g_Version = 1;
+	// records handed from the reader to the writer at a time
+	const int g_RecordsPerChunk = 1024;
+	// most tokens on a line - a keyword, the strings, the
+	// values and a flag word
+	const int g_MaxTokens = 1 + 2 + SCENE_RECORD::MAX_VALUES + 1;
+
+	// world file written next to the tiles of a split scene, and
+	// the scene file with the occluders that stay with the scene
+	const char* g_WorldFilename = "world.txt";
+	const char* g_OccluderFilename = "occluders.sceneb";
+
+	// the start of every binary scene file, followed by the
+	// records and then by the strings, each ending with a 0
+	struct FILE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t recordSize;
+		uint32_t recordCount;
+		uint32_t typeCounts[SCENE_RECORD::typeCount];
+		uint32_t stringCount;
+		uint32_t stringBytes;
+		uint64_t stringOffset;
+	};
+
+	// how a record is written in the text form
+	struct KEYWORD
+	{
+		const char* name;
+		int stringCount;
+		int valueCount;
+		// values that may follow the required ones
+		int optionalValueCount;
+		// word that sets the record's flag, or NULL
+		const char* flagWord;
+	};
+
+	// in the order of the record types
+	const KEYWORD g_Keywords[] = {
+		{ "texture", 2, 0, 0, NULL },
+		{ "material", 1, 7, 0, NULL },
+		{ "object", 1, 3, 6, NULL },
+		{ "use_texture", 1, 0, 0, NULL },
+		{ "use_color", 0, 4, 0, NULL },
+		{ "use_material", 1, 0, 0, NULL },
+		{ "part", 1, 9, 0, "lines" },
+		{ "lamp_post", 0, 3, 0, "lines" },
+		{ "bench", 0, 3, 0, "right" },
+		{ "fence", 0, 3, 0, NULL },
+		{ "tree", 0, 4, 0, NULL },
+		{ "occluder_plane", 0, 9, 0, NULL },
+		{ "occluder_box", 0, 15, 0, NULL }
+	};
+	static_assert(sizeof(g_Keywords) / sizeof(g_Keywords[0]) == SCENE_RECORD::typeCount,
+		"every record type needs a keyword");
+
+	bool IsSpace(char c)
+	{
+		return((c == ' ') || (c == '\t') || (c == '\r'));
+	}
+
+	// the texture, color and material that the next parts are
+	// given while a scene is split, by the source file or by
+	// the records of one tile so far - the texture is the tag
+	// of the texture, or -1 while the parts use the color, and
+	// the material is -1 for the first material
+	struct SPLIT_STATE
+	{
+		int32_t texture = -1;
+		float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		int32_t material = -1;
+	};
+
+	// records of one tile of a split scene
+	struct SPLIT_TILE
+	{
+		std::vector<SCENE_RECORD> records;
+		SPLIT_STATE state;
+		// texture and material tags the tile has the records of
+		std::unordered_set<int32_t> textures;
+		std::unordered_set<int32_t> materials;
+		// heights of the tile's objects
+		float minY = 0.0f;
+		float maxY = 0.0f;
+	};
+
+	// a record that only names a tag
+	SCENE_RECORD MakeTagRecord(SCENE_RECORD::Type type, int32_t tag)
+	{
+		SCENE_RECORD record = {};
+		record.type = (uint16_t)type;
+		record.strings[0] = tag;
+		record.strings[1] = -1;
+		return(record);
+	}
+
+	// add the record that defines a tag to the tile, the first
+	// time the tile uses it
+	void DefineSplitTag(
+		SPLIT_TILE& tile,
+		std::unordered_set<int32_t>& definedTags,
+		const std::unordered_map<int32_t, SCENE_RECORD>& definitions,
+		int32_t tag)
+	{
+		if (definedTags.insert(tag).second == true)
+		{
+			std::unordered_map<int32_t, SCENE_RECORD>::const_iterator definition = definitions.find(tag);
+			if (definition != definitions.end())
+			{
+				tile.records.push_back(definition->second);
+			}
+		}
+	}
+
+	// add the records to the tile that give its next parts the
+	// texture, color and material of the source file
+	void MatchSplitState(
+		SPLIT_TILE& tile,
+		const SPLIT_STATE& state,
+		const std::unordered_map<int32_t, SCENE_RECORD>& textures,
+		const std::unordered_map<int32_t, SCENE_RECORD>& materials)
+	{
+		// setting the color also stops using the texture
+		if ((memcmp(tile.state.color, state.color, sizeof(state.color)) != 0) ||
+			((state.texture < 0) && (tile.state.texture >= 0)))
+		{
+			SCENE_RECORD record = MakeTagRecord(SCENE_RECORD::useColor, -1);
+			memcpy(record.values, state.color, sizeof(state.color));
+			tile.records.push_back(record);
+			memcpy(tile.state.color, state.color, sizeof(state.color));
+			tile.state.texture = -1;
+		}
+		if ((state.texture >= 0) && (tile.state.texture != state.texture))
+		{
+			DefineSplitTag(tile, tile.textures, textures, state.texture);
+			tile.records.push_back(MakeTagRecord(SCENE_RECORD::useTexture, state.texture));
+			tile.state.texture = state.texture;
+		}
+		if (tile.state.material != state.material)
+		{
+			DefineSplitTag(tile, tile.materials, materials, state.material);
+			tile.records.push_back(MakeTagRecord(SCENE_RECORD::useMaterial, state.material));
+			tile.state.material = state.material;
+		}
+	}
+}
+
+/***********************************************************
+ *  SceneReader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneReader::SceneReader()
+{
+	m_bBinary = false;
+	m_bFailed = false;
+	memset(m_typeCounts, 0, sizeof(m_typeCounts));
+	m_remainingRecords = 0;
+	m_bufferStart = 0;
+	m_bufferEnd = 0;
+	m_bEndOfFile = false;
+	m_lineNumber = 0;
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used to open a scene file.  A file that
+ *  starts with the magic of the binary form is read as
+ *  binary, any other file as text.
+ ***********************************************************/
+bool SceneReader::Open(const char* filename)
+{
+	Close();
+
+	m_filename = filename;
+	m_file.open(filename, std::ios::in | std::ios::binary);
+	if (m_file.is_open() == false)
+	{
+		std::cout << "Could not open the scene file:" << filename << std::endl;
+		return false;
+	}
+
+	char magic[sizeof(g_Magic)] = {};
+	m_file.read(magic, sizeof(magic));
+	m_bBinary = (m_file.gcount() == sizeof(magic)) && (memcmp(magic, g_Magic, sizeof(g_Magic)) == 0);
+	m_file.clear();
+	m_file.seekg(0);
+
+	if (m_bBinary == true)
+	{
+		if (OpenBinary() == false)
+		{
+			std::cout << "Could not read the binary scene file:" << filename << std::endl;
+			Close();
+			return false;
+		}
+	}
+	else
+	{
+		// one extra byte, so the last line can always be ended
+		m_buffer.resize(CHUNK_SIZE + 1);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  OpenBinary()
+ *
+ *  This method is used to check the header of a binary file
+ *  and read its strings, leaving the file at the first
+ *  record.
+ ***********************************************************/
+bool SceneReader::OpenBinary()
+{
+	FILE_HEADER header;
+	m_file.read((char*)&header, sizeof(header));
+	if ((m_file.good() == false) ||
+		(header.version != g_Version) ||
+		(header.recordSize != sizeof(SCENE_RECORD)) ||
+		(header.stringOffset != sizeof(header) + (uint64_t)header.recordCount * sizeof(SCENE_RECORD)))
+	{
+		return false;
+	}
+
+	std::vector<char> strings(header.stringBytes);
+	m_file.seekg(header.stringOffset);
+	m_file.read(strings.data(), strings.size());
+	if ((m_file.good() == false) || (strings.empty() == false && strings.back() != '\0'))
+	{
+		return false;
+	}
+
+	size_t start = 0;
+	while (start < strings.size())
+	{
+		m_strings.push_back(strings.data() + start);
+		start += m_strings.back().size() + 1;
+	}
+	if (m_strings.size() != header.stringCount)
+	{
+		return false;
+	}
+
+	memcpy(m_typeCounts, header.typeCounts, sizeof(m_typeCounts));
+	m_remainingRecords = header.recordCount;
+	m_file.seekg(sizeof(header));
+	return(m_file.good());
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to close the file and forget its
+ *  strings.
+ ***********************************************************/
+void SceneReader::Close()
+{
+	if (m_file.is_open() == true)
+	{
+		m_file.close();
+	}
+	m_file.clear();
+	m_bBinary = false;
+	m_bFailed = false;
+	m_strings.clear();
+	m_stringIndices.clear();
+	memset(m_typeCounts, 0, sizeof(m_typeCounts));
+	m_remainingRecords = 0;
+	m_buffer.clear();
+	m_bufferStart = 0;
+	m_bufferEnd = 0;
+	m_bEndOfFile = false;
+	m_lineNumber = 0;
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used to get a string of a record.  Indices
+ *  that do not belong to a string give an empty string.
+ ***********************************************************/
+const std::string& SceneReader::GetString(int32_t index) const
+{
+	static const std::string empty;
+
+	if ((index < 0) || (index >= (int32_t)m_strings.size()))
+	{
+		return(empty);
+	}
+	return(m_strings[index]);
+}
+
+/***********************************************************
+ *  ReadRecords()
+ *
+ *  This method is used to read the next records of the file.
+ ***********************************************************/
+int SceneReader::ReadRecords(SCENE_RECORD* pRecords, int maxCount)
+{
+	if ((m_file.is_open() == false) || (m_bFailed == true))
+	{
+		return(0);
+	}
+
+	if (m_bBinary == true)
+	{
+		return(ReadBinaryRecords(pRecords, maxCount));
+	}
+	return(ReadTextRecords(pRecords, maxCount));
+}
+
+/***********************************************************
+ *  ReadBinaryRecords()
+ *
+ *  This method is used to read records of a binary file,
+ *  which are stored exactly as they are used.
+ ***********************************************************/
+int SceneReader::ReadBinaryRecords(SCENE_RECORD* pRecords, int maxCount)
+{
+	int count = (int)std::min<uint32_t>(m_remainingRecords, (uint32_t)maxCount);
+	if (count == 0)
+	{
+		return(0);
+	}
+
+	m_file.read((char*)pRecords, (std::streamsize)count * sizeof(SCENE_RECORD));
+	if (m_file.good() == false)
+	{
+		std::cout << "Could not read the records of the scene file:" << m_filename << std::endl;
+		m_bFailed = true;
+		return(0);
+	}
+
+	m_remainingRecords -= count;
+	return(count);
+}
+
+/***********************************************************
+ *  ReadTextRecords()
+ *
+ *  This method is used to parse records of a text file.  The
+ *  file is read a chunk at a time, and a line cut off at the
+ *  end of a chunk is moved to the front before reading the
+ *  next one.
+ ***********************************************************/
+int SceneReader::ReadTextRecords(SCENE_RECORD* pRecords, int maxCount)
+{
+	int count = 0;
+	while ((count < maxCount) && (m_bFailed == false))
+	{
+		char* start = m_buffer.data() + m_bufferStart;
+		char* end = (char*)memchr(start, '\n', m_bufferEnd - m_bufferStart);
+		if (NULL == end)
+		{
+			if (m_bEndOfFile == true)
+			{
+				if (m_bufferStart == m_bufferEnd)
+				{
+					break;
+				}
+				// the last line does not end with a line break
+				end = m_buffer.data() + m_bufferEnd;
+			}
+			else
+			{
+				int remaining = m_bufferEnd - m_bufferStart;
+				if (remaining == CHUNK_SIZE)
+				{
+					std::cout << "Line " << m_lineNumber + 1 << " is too long in the scene file:" << m_filename << std::endl;
+					m_bFailed = true;
+					break;
+				}
+
+				memmove(m_buffer.data(), start, remaining);
+				m_file.read(m_buffer.data() + remaining, CHUNK_SIZE - remaining);
+				m_bufferStart = 0;
+				m_bufferEnd = remaining + (int)m_file.gcount();
+				m_bEndOfFile = (m_bufferEnd < CHUNK_SIZE);
+				if (m_file.bad() == true)
+				{
+					std::cout << "Could not read the scene file:" << m_filename << std::endl;
+					m_bFailed = true;
+				}
+				continue;
+			}
+		}
+
+		*end = '\0';
+		m_bufferStart = std::min((int)(end - m_buffer.data()) + 1, m_bufferEnd);
+		m_lineNumber++;
+
+		bool bRecord = false;
+		if (ParseLine(start, pRecords[count], bRecord) == false)
+		{
+			std::cout << "Could not parse line " << m_lineNumber << " of the scene file:" << m_filename << std::endl;
+			m_bFailed = true;
+			break;
+		}
+		if (bRecord == true)
+		{
+			count++;
+		}
+	}
+
+	return(m_bFailed ? 0 : count);
+}
+
+/***********************************************************
+ *  ParseLine()
+ *
+ *  This method is used to turn one line of text into a
+ *  record.  Blank lines and comments give no record.
+ ***********************************************************/
+bool SceneReader::ParseLine(char* line, SCENE_RECORD& record, bool& bRecord)
+{
+	char* comment = strchr(line, '#');
+	if (NULL != comment)
+	{
+		*comment = '\0';
+	}
+
+	// split the line into tokens in place
+	char* tokens[g_MaxTokens];
+	int tokenCount = 0;
+	char* cursor = line;
+	while (*cursor != '\0')
+	{
+		while (IsSpace(*cursor))
+		{
+			cursor++;
+		}
+		if (*cursor == '\0')
+		{
+			break;
+		}
+		if (tokenCount == g_MaxTokens)
+		{
+			return false;
+		}
+		tokens[tokenCount++] = cursor;
+		while ((*cursor != '\0') && (IsSpace(*cursor) == false))
+		{
+			cursor++;
+		}
+		if (*cursor != '\0')
+		{
+			*cursor++ = '\0';
+		}
+	}
+
+	bRecord = false;
+	if (tokenCount == 0)
+	{
+		return true;
+	}
+
+	int type = 0;
+	while ((type < SCENE_RECORD::typeCount) && (strcmp(tokens[0], g_Keywords[type].name) != 0))
+	{
+		type++;
+	}
+	if (type == SCENE_RECORD::typeCount)
+	{
+		return false;
+	}
+
+	const KEYWORD& keyword = g_Keywords[type];
+	memset(&record, 0, sizeof(record));
+	record.type = (uint16_t)type;
+	record.strings[0] = -1;
+	record.strings[1] = -1;
+
+	int requiredCount = 1 + keyword.stringCount + keyword.valueCount;
+	if ((NULL != keyword.flagWord) && (tokenCount == requiredCount + 1) &&
+		(strcmp(tokens[tokenCount - 1], keyword.flagWord) == 0))
+	{
+		record.bFlag = 1;
+		tokenCount--;
+	}
+	else if ((keyword.optionalValueCount > 0) && (tokenCount == requiredCount + keyword.optionalValueCount))
+	{
+		record.bFlag = 1;
+	}
+	else if (tokenCount != requiredCount)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < keyword.stringCount; i++)
+	{
+		record.strings[i] = AddString(tokens[1 + i]);
+	}
+	for (int i = 1 + keyword.stringCount; i < tokenCount; i++)
+	{
+		char* valueEnd = NULL;
+		record.values[i - 1 - keyword.stringCount] = strtof(tokens[i], &valueEnd);
+		if (*valueEnd != '\0')
+		{
+			return false;
+		}
+	}
+
+	bRecord = true;
+	return true;
+}
+
+/***********************************************************
+ *  AddString()
+ *
+ *  This method is used to get the index of a string of a
+ *  text file, storing each different string once.
+ ***********************************************************/
+int32_t SceneReader::AddString(const char* text)
+{
+	std::unordered_map<std::string, int32_t>::iterator found = m_stringIndices.find(text);
+	if (found != m_stringIndices.end())
+	{
+		return(found->second);
+	}
+
+	int32_t index = (int32_t)m_strings.size();
+	m_strings.push_back(text);
+	m_stringIndices[m_strings.back()] = index;
+	return(index);
+}
+
+/***********************************************************
+ *  SceneWriter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneWriter::SceneWriter()
+{
+	m_recordCount = 0;
+	memset(m_typeCounts, 0, sizeof(m_typeCounts));
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create the file and leave room
+ *  for its header.
+ ***********************************************************/
+bool SceneWriter::Create(const char* filename)
+{
+	m_filename = filename;
+	m_recordCount = 0;
+	memset(m_typeCounts, 0, sizeof(m_typeCounts));
+
+	m_file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	FILE_HEADER header = {};
+	m_file.write((const char*)&header, sizeof(header));
+	if (m_file.good() == false)
+	{
+		std::cout << "Could not create the scene file:" << filename << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  WriteRecords()
+ *
+ *  This method is used to append records to the file.
+ ***********************************************************/
+bool SceneWriter::WriteRecords(const SCENE_RECORD* pRecords, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (pRecords[i].type < SCENE_RECORD::typeCount)
+		{
+			m_typeCounts[pRecords[i].type]++;
+		}
+	}
+	m_recordCount += count;
+
+	m_file.write((const char*)pRecords, (std::streamsize)count * sizeof(SCENE_RECORD));
+	return(m_file.good());
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used to write the strings after the last
+ *  record, then fill in the header at the start.
+ ***********************************************************/
+bool SceneWriter::Finish(const std::vector<std::string>& strings)
+{
+	FILE_HEADER header = {};
+	memcpy(header.magic, g_Magic, sizeof(g_Magic));
+	header.version = g_Version;
+	header.recordSize = sizeof(SCENE_RECORD);
+	header.recordCount = m_recordCount;
+	memcpy(header.typeCounts, m_typeCounts, sizeof(m_typeCounts));
+	header.stringCount = (uint32_t)strings.size();
+	header.stringOffset = sizeof(header) + (uint64_t)m_recordCount * sizeof(SCENE_RECORD);
+
+	for (size_t i = 0; i < strings.size(); i++)
+	{
+		m_file.write(strings[i].c_str(), strings[i].size() + 1);
+		header.stringBytes += (uint32_t)strings[i].size() + 1;
+	}
+
+	m_file.seekp(0);
+	m_file.write((const char*)&header, sizeof(header));
+	m_file.close();
+	if (m_file.fail() == true)
+	{
+		std::cout << "Could not write the scene file:" << m_filename << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  ConvertSceneFile()
+ *
+ *  This function is used to convert a scene file into the
+ *  binary form.  The records are passed on a chunk at a
+ *  time, so the whole scene is never held in memory.  A
+ *  broken source leaves no destination file behind.
+ ***********************************************************/
+bool ConvertSceneFile(const char* sourceFilename, const char* destinationFilename)
+{
+	SceneReader reader;
+	if (reader.Open(sourceFilename) == false)
+	{
+		return false;
+	}
+
+	SceneWriter writer;
+	if (writer.Create(destinationFilename) == false)
+	{
+		return false;
+	}
+
+	std::vector<SCENE_RECORD> records(g_RecordsPerChunk);
+	bool bWritten = true;
+	int count = 0;
+	while ((bWritten == true) && ((count = reader.ReadRecords(records.data(), g_RecordsPerChunk)) > 0))
+	{
+		bWritten = writer.WriteRecords(records.data(), count);
+	}
+
+	// the file is closed even when the conversion failed
+	bool bConverted = (reader.HasFailed() == false) && (bWritten == true);
+	bConverted = (writer.Finish(reader.GetStrings()) == true) && (bConverted == true);
+	if (bConverted == false)
+	{
+		std::remove(destinationFilename);
+		std::cout << "Could not convert the scene file:" << sourceFilename << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  SplitSceneFile()
+ *
+ *  This function is used to split a scene file into square
+ *  tiles of the passed in size for streaming.  Each object
+ *  goes into the tile under its position, along with its
+ *  parts and the records that define and set their textures,
+ *  colors and materials, so every tile loads on its own.  The
+ *  tiles are written as binary scene files with a world file
+ *  that lists them, and the occluders are written into a
+ *  scene file of their own that is loaded as the scene, since
+ *  one occluder can hide the objects of many tiles.  All of
+ *  the records are held until the tiles are written.
+ ***********************************************************/
+bool SplitSceneFile(const char* sourceFilename, const char* directory, float tileSize)
+{
+	if (tileSize <= 0.0f)
+	{
+		std::cout << "The tile size must be positive" << std::endl;
+		return false;
+	}
+
+	SceneReader reader;
+	if (reader.Open(sourceFilename) == false)
+	{
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::path path(directory);
+	std::filesystem::create_directories(path, error);
+	if (error)
+	{
+		std::cout << "Could not create the directory:" << directory << std::endl;
+		return false;
+	}
+
+	std::map<std::pair<int, int>, SPLIT_TILE> tiles;
+	std::vector<SCENE_RECORD> occluders;
+	std::unordered_map<int32_t, SCENE_RECORD> textures;
+	std::unordered_map<int32_t, SCENE_RECORD> materials;
+	SPLIT_STATE state;
+	SPLIT_TILE* pObjectTile = NULL;
+
+	std::vector<SCENE_RECORD> records(g_RecordsPerChunk);
+	bool bSplit = true;
+	int count = 0;
+	while ((bSplit == true) && ((count = reader.ReadRecords(records.data(), g_RecordsPerChunk)) > 0))
+	{
+		for (int i = 0; (i < count) && (bSplit == true); i++)
+		{
+			const SCENE_RECORD& record = records[i];
+			switch (record.type)
+			{
+			case SCENE_RECORD::texture:
+				textures[record.strings[0]] = record;
+				break;
+			case SCENE_RECORD::material:
+				// a material defined again changes the parts that
+				// already use it, in every tile that has it
+				materials[record.strings[0]] = record;
+				for (std::map<std::pair<int, int>, SPLIT_TILE>::iterator tile = tiles.begin(); tile != tiles.end(); ++tile)
+				{
+					if (tile->second.materials.count(record.strings[0]) > 0)
+					{
+						tile->second.records.push_back(record);
+					}
+				}
+				break;
+			case SCENE_RECORD::useTexture:
+				state.texture = record.strings[0];
+				break;
+			case SCENE_RECORD::useColor:
+				state.texture = -1;
+				memcpy(state.color, record.values, sizeof(state.color));
+				break;
+			case SCENE_RECORD::useMaterial:
+				state.material = record.strings[0];
+				break;
+			case SCENE_RECORD::part:
+				if (NULL == pObjectTile)
+				{
+					std::cout << "A part comes before the first object in the scene file" << std::endl;
+					bSplit = false;
+					break;
+				}
+				MatchSplitState(*pObjectTile, state, textures, materials);
+				pObjectTile->records.push_back(record);
+				break;
+			case SCENE_RECORD::occluderPlane:
+			case SCENE_RECORD::occluderBox:
+				occluders.push_back(record);
+				break;
+			default:
+			{
+				// the objects and the object functions
+				std::pair<int, int> cell(
+					(int)std::floor(record.values[0] / tileSize),
+					(int)std::floor(record.values[2] / tileSize));
+				bool bNewTile = (tiles.count(cell) == 0);
+				SPLIT_TILE& tile = tiles[cell];
+				float minY = record.values[1];
+				float maxY = record.values[1];
+				if ((record.type == SCENE_RECORD::object) && (record.bFlag != 0))
+				{
+					minY += record.values[4];
+					maxY += record.values[7];
+				}
+				tile.minY = bNewTile ? minY : std::min(tile.minY, minY);
+				tile.maxY = bNewTile ? maxY : std::max(tile.maxY, maxY);
+
+				// the object functions set their own textures and
+				// colors but use the material
+				if (record.type != SCENE_RECORD::object)
+				{
+					MatchSplitState(tile, state, textures, materials);
+				}
+				tile.records.push_back(record);
+				pObjectTile = &tile;
+				break;
+			}
+			}
+		}
+	}
+	if ((bSplit == false) || (reader.HasFailed() == true))
+	{
+		std::cout << "Could not split the scene file:" << sourceFilename << std::endl;
+		return false;
+	}
+
+	// every tile indexes the strings of the whole source file
+	std::ofstream worldFile((path / g_WorldFilename).string());
+	worldFile << "# tiles of " << sourceFilename << "\n";
+	worldFile << "tile_size " << tileSize << "\n";
+	for (std::map<std::pair<int, int>, SPLIT_TILE>::iterator tile = tiles.begin(); tile != tiles.end(); ++tile)
+	{
+		std::string tileFilename = "tile_" + std::to_string(tile->first.first) + "_" + std::to_string(tile->first.second) + ".sceneb";
+		SceneWriter writer;
+		if ((writer.Create((path / tileFilename).string().c_str()) == false) ||
+			(writer.WriteRecords(tile->second.records.data(), (int)tile->second.records.size()) == false) ||
+			(writer.Finish(reader.GetStrings()) == false))
+		{
+			return false;
+		}
+
+		worldFile << "tile " << tileFilename
+			<< " " << tile->first.first * tileSize << " " << tile->second.minY << " " << tile->first.second * tileSize
+			<< " " << (tile->first.first + 1) * tileSize << " " << tile->second.maxY << " " << (tile->first.second + 1) * tileSize
+			<< "\n";
+	}
+
+	SceneWriter occluderWriter;
+	if ((occluderWriter.Create((path / g_OccluderFilename).string().c_str()) == false) ||
+		(occluderWriter.WriteRecords(occluders.data(), (int)occluders.size()) == false) ||
+		(occluderWriter.Finish(reader.GetStrings()) == false))
+	{
+		return false;
+	}
+
+	worldFile.close();
+	if (worldFile.fail() == true)
+	{
+		std::cout << "Could not write the world file:" << (path / g_WorldFilename).string() << std::endl;
+		return false;
+	}
+
+	std::cout << "Split scene file:" << sourceFilename << " into " << tiles.size()
+		<< " tiles, occluders:" << occluders.size() << std::endl;
+	return true;
+}
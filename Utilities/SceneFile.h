@@ -0,0 +1,171 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// read scene descriptions in chunks from their text or binary form, and
+// convert the text form into the binary form or split it into tiles
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  SCENE_RECORD
+ *
+ *  One line of a scene file.  The text form has one record
+ *  per line, a keyword followed by the strings and values of
+ *  the record and an optional flag word:
+ *
+ *    texture <tag> <path>
+ *    material <tag> <diffuse r g b> <specular r g b> <shininess>
+ *    object <pass> <x y z> [<min x y z> <max x y z>]
+ *    use_texture <tag>
+ *    use_color <r g b a>
+ *    use_material <tag>
+ *    part <mesh> <scale xyz> <rotation xyz> <position xyz> [lines]
+ *    lamp_post <x y z> [lines]
+ *    bench <x y z> [right]
+ *    fence <x y z>
+ *    tree <x y z> <angle>
+ *    occluder_plane <scale xyz> <rotation xyz> <position xyz>
+ *    occluder_box <scale xyz> <rotation xyz> <position xyz> <min xyz> <max xyz>
+ *
+ *  Everything after a '#' is a comment.  The binary form
+ *  stores the same records, so it is read without parsing.
+ ***********************************************************/
+struct SCENE_RECORD
+{
+	enum Type
+	{
+		texture,
+		material,
+		object,
+		useTexture,
+		useColor,
+		useMaterial,
+		part,
+		lampPost,
+		bench,
+		fence,
+		tree,
+		occluderPlane,
+		occluderBox,
+		typeCount
+	};
+
+	// most values of any record type
+	static const int MAX_VALUES = 15;
+
+	uint16_t type;
+	// set when the flag word was given - an object record sets
+	// it when its bounds were given
+	uint16_t bFlag;
+	// indices of the record's strings, or -1
+	int32_t strings[2];
+	float values[MAX_VALUES];
+};
+
+/***********************************************************
+ *  SceneReader
+ *
+ *  This class contains the code for reading the records of
+ *  a scene file in chunks, so a scene of any size is read
+ *  with a fixed amount of memory besides its strings.  The
+ *  form is told apart by the start of the file.  The strings
+ *  of the records are kept by the reader, since tags and
+ *  paths repeat across many records.
+ ***********************************************************/
+class SceneReader
+{
+public:
+	// bytes of a text file read at a time - no line may be longer
+	static const int CHUNK_SIZE = 64 * 1024;
+
+	// constructor
+	SceneReader();
+
+	// open a scene file in either form
+	bool Open(const char* filename);
+	void Close();
+
+	// read up to maxCount records into the passed in array and
+	// return how many were read - 0 at the end of the file or
+	// when the file is broken, which HasFailed() tells apart
+	int ReadRecords(SCENE_RECORD* pRecords, int maxCount);
+	bool HasFailed() const { return(m_bFailed); }
+
+	// string of a record, empty for an index of -1
+	const std::string& GetString(int32_t index) const;
+	const std::vector<std::string>& GetStrings() const { return(m_strings); }
+	// records of each type in a binary file, known before they
+	// are read - all 0 for a text file
+	uint32_t GetTypeCount(int type) const { return(m_typeCounts[type]); }
+
+private:
+	std::ifstream m_file;
+	std::string m_filename;
+	bool m_bBinary;
+	bool m_bFailed;
+	std::vector<std::string> m_strings;
+	uint32_t m_typeCounts[SCENE_RECORD::typeCount];
+	// records of a binary file that are not read yet
+	uint32_t m_remainingRecords;
+	// text of the current chunk and the part not parsed yet
+	std::vector<char> m_buffer;
+	int m_bufferStart;
+	int m_bufferEnd;
+	bool m_bEndOfFile;
+	int m_lineNumber;
+	// index of each string of a text file
+	std::unordered_map<std::string, int32_t> m_stringIndices;
+
+	// read the header and the strings of a binary file
+	bool OpenBinary();
+	// read the records of each form
+	int ReadBinaryRecords(SCENE_RECORD* pRecords, int maxCount);
+	int ReadTextRecords(SCENE_RECORD* pRecords, int maxCount);
+	// parse one line of text, returning false when it is broken
+	// and setting bRecord when it holds a record
+	bool ParseLine(char* line, SCENE_RECORD& record, bool& bRecord);
+	// index of the passed in string, added when it is new
+	int32_t AddString(const char* text);
+};
+
+/***********************************************************
+ *  SceneWriter
+ *
+ *  This class contains the code for writing records into the
+ *  binary form.  The strings and the count of each record
+ *  type are written once the last record is known.
+ ***********************************************************/
+class SceneWriter
+{
+public:
+	// constructor
+	SceneWriter();
+
+	// create, or replace, a binary scene file
+	bool Create(const char* filename);
+	// write records whose strings index the passed in strings
+	bool WriteRecords(const SCENE_RECORD* pRecords, int count);
+	// write the strings and the header and close the file
+	bool Finish(const std::vector<std::string>& strings);
+
+private:
+	std::ofstream m_file;
+	std::string m_filename;
+	uint32_t m_recordCount;
+	uint32_t m_typeCounts[SCENE_RECORD::typeCount];
+};
+
+// convert a scene file into the binary form, a chunk at a time
+bool ConvertSceneFile(const char* sourceFilename, const char* destinationFilename);
+// split a scene file into binary tiles of the passed in size,
+// along with the world file that lists them and a scene file
+// with the occluders
+bool SplitSceneFile(const char* sourceFilename, const char* directory, float tileSize);
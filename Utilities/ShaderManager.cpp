@@ -30,6 +30,7 @@ using namespace std;
  *  external GLSL compatible files.
  ***********************************************************/
 GLuint ShaderManager::LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+	PROFILE_FUNCTION();
 
 	// Create the shaders
 	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
@@ -11,6 +11,9 @@
 
 #include <GL/glew.h>        // GLEW library
 
+#include "Profiler.h"
+#include "RenderStats.h"
+
 #include <glm/glm.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/transform.hpp>
@@ -35,6 +38,7 @@ public:
 	inline void use()
 	{
 		glUseProgram(m_programID);
+		RenderStats::CountProgramSwitch();
 	}
 
 	// utility uniform functions
@@ -42,72 +46,106 @@ public:
 	inline void setBoolValue(const std::string &name, bool value) const
 	{
 		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), (int)value);
+		RenderStats::CountUniformUpload();
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setIntValue(const std::string &name, int value) const
 	{
 		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
+		RenderStats::CountUniformUpload();
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setFloatValue(const std::string &name, float value) const
 	{
 		glUniform1f(glGetUniformLocation(m_programID, name.c_str()), value);
+		RenderStats::CountUniformUpload();
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setVec2Value(const std::string &name, const glm::vec2 &value) const
 	{
 		glUniform2fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		RenderStats::CountUniformUpload();
 	}
 
 	inline void setVec2Value(const std::string &name, float x, float y) const
 	{
 		glUniform2f(glGetUniformLocation(m_programID, name.c_str()), x, y);
+		RenderStats::CountUniformUpload();
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setVec3Value(const std::string &name, const glm::vec3 &value) const
 	{
 		glUniform3fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		RenderStats::CountUniformUpload();
 	}
 	inline void setVec3Value(const std::string &name, float x, float y, float z) const
 	{
 		glUniform3f(glGetUniformLocation(m_programID, name.c_str()), x, y, z);
+		RenderStats::CountUniformUpload();
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setVec4Value(const std::string &name, const glm::vec4 &value) const
 	{
 		glUniform4fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+		RenderStats::CountUniformUpload();
 	}
 	inline void setVec4Value(const std::string &name, float x, float y, float z, float w)
 	{
 		glUniform4f(glGetUniformLocation(m_programID, name.c_str()), x, y, z, w);
+		RenderStats::CountUniformUpload();
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setMat2Value(const std::string &name, const glm::mat2 &mat) const
 	{
 		glUniformMatrix2fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		RenderStats::CountUniformUpload();
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setMat3Value(const std::string &name, const glm::mat3 &mat) const
 	{
 		glUniformMatrix3fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		RenderStats::CountUniformUpload();
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setMat4Value(const std::string &name, const glm::mat4 &mat) const
 	{
+		PROFILE_FUNCTION();
 		glUniformMatrix4fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+		RenderStats::CountUniformUpload();
 	}
 
 	// ------------------------------------------------------------------------
 	inline void setSampler2DValue(const std::string& name, const int &value) const
 	{
 		glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
+		RenderStats::CountUniformUpload();
+	}
+
+	// connect a uniform block to the binding point its buffer
+	// ranges are bound to
+	// ------------------------------------------------------------------------
+	inline void setUniformBlockBinding(const std::string& name, GLuint binding) const
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(m_programID, name.c_str());
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(m_programID, blockIndex, binding);
+		}
+	}
+
+	// bind part of a buffer as the data of a uniform block
+	// ------------------------------------------------------------------------
+	inline void bindUniformBlockRange(GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size) const
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+		RenderStats::CountBufferBind();
 	}
 };
\ No newline at end of file
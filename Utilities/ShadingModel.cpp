@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadingmodel.cpp
+// ============
+// the lighting of the fragment shader in C++, shared by the CPU renderers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadingModel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the incoming direction mirrored about a normal, as GLSL's reflect()
+	glm::vec3 Reflect(const glm::vec3& incoming, const glm::vec3& normal)
+	{
+		return(incoming - normal * (2.0f * glm::dot(normal, incoming)));
+	}
+}
+
+/***********************************************************
+ *  SampleTexture()
+ *
+ *  This method is used to read the color of a texture at a
+ *  texture coordinate, blending the four nearest texels and
+ *  repeating the texture outside of [0, 1] like the scene's
+ *  textures are set up to.
+ ***********************************************************/
+glm::vec4 ShadingModel::SampleTexture(const TEXTURE& texture, const glm::vec2& coordinate)
+{
+	float x = coordinate.x * (float)texture.width - 0.5f;
+	float y = coordinate.y * (float)texture.height - 0.5f;
+	float left = std::floor(x);
+	float bottom = std::floor(y);
+	float fractionX = x - left;
+	float fractionY = y - bottom;
+
+	glm::vec4 texels[4];
+	for (int corner = 0; corner < 4; corner++)
+	{
+		int column = ((int)left + (corner & 1)) % texture.width;
+		int row = ((int)bottom + (corner >> 1)) % texture.height;
+		column = (column < 0) ? column + texture.width : column;
+		row = (row < 0) ? row + texture.height : row;
+
+		const unsigned char* pTexel = texture.pixels + ((size_t)row * texture.width + column) * texture.channels;
+		texels[corner] = glm::vec4(
+			pTexel[0] / 255.0f,
+			pTexel[1] / 255.0f,
+			pTexel[2] / 255.0f,
+			(texture.channels == 4) ? pTexel[3] / 255.0f : 1.0f);
+	}
+
+	glm::vec4 lower = texels[0] + (texels[1] - texels[0]) * fractionX;
+	glm::vec4 upper = texels[2] + (texels[3] - texels[2]) * fractionX;
+	return(lower + (upper - lower) * fractionY);
+}
+
+/***********************************************************
+ *  Shade()
+ *
+ *  This method is used to shade a point the way the fragment
+ *  shader shades a fragment - the directional light and the
+ *  spot light with the Phong model, with the texture or the
+ *  color in the ambient, diffuse and specular terms, and the
+ *  alpha of the texture or the color.
+ ***********************************************************/
+glm::vec4 ShadingModel::Shade(
+	const SURFACE& surface,
+	const TEXTURE* pTexture,
+	const LIGHTS& lights,
+	const glm::vec3& viewPosition,
+	const glm::vec3& position,
+	const glm::vec3& normal,
+	const glm::vec2& textureCoordinate)
+{
+	glm::vec3 unitNormal = glm::normalize(normal);
+	glm::vec3 viewDirection = glm::normalize(viewPosition - position);
+
+	glm::vec4 baseColor = surface.color;
+	if (NULL != pTexture)
+	{
+		baseColor = SampleTexture(*pTexture, textureCoordinate);
+	}
+	glm::vec3 albedo = glm::vec3(baseColor);
+
+	glm::vec3 result(0.0f);
+	const DIRECTIONAL_LIGHT& directional = lights.directionalLight;
+	if (directional.bActive == true)
+	{
+		glm::vec3 lightDirection = glm::normalize(-directional.direction);
+		float diffuse = std::max(glm::dot(unitNormal, lightDirection), 0.0f);
+		float specular = std::pow(std::max(glm::dot(viewDirection, Reflect(-lightDirection, unitNormal)), 0.0f),
+			surface.shininess);
+		result += directional.ambient * albedo
+			+ directional.diffuse * diffuse * surface.diffuseColor * albedo
+			+ directional.specular * specular * surface.specularColor * albedo;
+	}
+
+	const SPOT_LIGHT& spot = lights.spotLight;
+	if (spot.bActive == true)
+	{
+		glm::vec3 toLight = spot.position - position;
+		float lightDistance = std::sqrt(glm::dot(toLight, toLight));
+		glm::vec3 lightDirection = toLight / lightDistance;
+		float diffuse = std::max(glm::dot(unitNormal, lightDirection), 0.0f);
+		float specular = std::pow(std::max(glm::dot(viewDirection, Reflect(-lightDirection, unitNormal)), 0.0f),
+			surface.shininess);
+		float attenuation = 1.0f / (spot.constant + spot.linear * lightDistance
+			+ spot.quadratic * (lightDistance * lightDistance));
+		float theta = glm::dot(lightDirection, glm::normalize(-spot.direction));
+		float intensity = std::min(std::max((theta - spot.outerCutOff) / (spot.cutOff - spot.outerCutOff), 0.0f), 1.0f);
+		result += (spot.ambient * albedo
+			+ spot.diffuse * diffuse * surface.diffuseColor * albedo
+			+ spot.specular * specular * surface.specularColor * albedo) * (attenuation * intensity);
+	}
+
+	return(glm::vec4(result, baseColor.a));
+}
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadingmodel.h
+// ============
+// the lighting of the fragment shader in C++, shared by the CPU renderers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ShadingModel
+ *
+ *  This class contains the values that the fragment shader
+ *  reads from its uniform blocks and textures, and the same
+ *  math for shading one point.  The ray tracer and the
+ *  software rasterizer both shade with it, so their images
+ *  can be compared with the drawn frames and each other.
+ ***********************************************************/
+class ShadingModel
+{
+public:
+	// image of a texture, with the first row at the bottom the
+	// way OpenGL reads it - only 3 and 4 channels are sampled
+	struct TEXTURE
+	{
+		const unsigned char* pixels;
+		int width;
+		int height;
+		int channels;
+	};
+
+	// values of the object block and the texture that the
+	// triangles of one part are drawn with
+	struct SURFACE
+	{
+		// texture of the renderer, or -1 for the color
+		int texture;
+		glm::vec4 color;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+	};
+
+	// the lights of the shader's light block
+	struct DIRECTIONAL_LIGHT
+	{
+		glm::vec3 direction;
+		glm::vec3 ambient;
+		glm::vec3 diffuse;
+		glm::vec3 specular;
+		bool bActive;
+	};
+
+	struct SPOT_LIGHT
+	{
+		glm::vec3 position;
+		glm::vec3 direction;
+		float cutOff;
+		float outerCutOff;
+		float constant;
+		float linear;
+		float quadratic;
+		glm::vec3 ambient;
+		glm::vec3 diffuse;
+		glm::vec3 specular;
+		bool bActive;
+	};
+
+	struct LIGHTS
+	{
+		DIRECTIONAL_LIGHT directionalLight;
+		SPOT_LIGHT spotLight;
+	};
+
+	// view that the image is rendered from
+	struct CAMERA
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec3 viewPosition;
+	};
+
+	// filtered color of a texture, with the linear filtering and
+	// repeating of the scene's textures
+	static glm::vec4 SampleTexture(const TEXTURE& texture, const glm::vec2& coordinate);
+
+	// color and opacity of a point of a surface, lit like the
+	// fragment shader lights it - the normal does not need to be
+	// normalized, and the texture is NULL for the color
+	static glm::vec4 Shade(
+		const SURFACE& surface,
+		const TEXTURE* pTexture,
+		const LIGHTS& lights,
+		const glm::vec3& viewPosition,
+		const glm::vec3& position,
+		const glm::vec3& normal,
+		const glm::vec2& textureCoordinate);
+};
@@ -0,0 +1,210 @@
+///////////////////////////////////////////////////////////////////////////////
+// simd.h
+// ============
+// four lane float and integer values for the CPU renderers, on SSE2, NEON
+// or plain arrays
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+
+// SSE2 is always available on x64 targets and NEON on 64-bit ARM,
+// so the lanes use whichever the compiler allows and four plain
+// values otherwise
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SIMD_USE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_USE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// whether each of four lanes passed a comparison
+struct MASK4
+{
+#if defined(SIMD_USE_SSE2)
+	__m128 m;
+#elif defined(SIMD_USE_NEON)
+	uint32x4_t m;
+#else
+	bool m[4];
+#endif
+};
+
+// four float lanes with the operations the renderers use, so
+// the same code works on four rays or pixels at once
+struct FLOAT4
+{
+#if defined(SIMD_USE_SSE2)
+	__m128 v;
+	FLOAT4() {}
+	FLOAT4(__m128 value) : v(value) {}
+	explicit FLOAT4(float value) : v(_mm_set1_ps(value)) {}
+	FLOAT4(float a, float b, float c, float d) : v(_mm_setr_ps(a, b, c, d)) {}
+	static FLOAT4 Load(const float* p) { return(FLOAT4(_mm_loadu_ps(p))); }
+	void Store(float* p) const { _mm_storeu_ps(p, v); }
+	friend FLOAT4 operator+(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(_mm_add_ps(a.v, b.v))); }
+	friend FLOAT4 operator-(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(_mm_sub_ps(a.v, b.v))); }
+	friend FLOAT4 operator*(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(_mm_mul_ps(a.v, b.v))); }
+	friend FLOAT4 operator/(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(_mm_div_ps(a.v, b.v))); }
+	friend FLOAT4 Min(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(_mm_min_ps(a.v, b.v))); }
+	friend FLOAT4 Max(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(_mm_max_ps(a.v, b.v))); }
+	friend MASK4 operator<(const FLOAT4& a, const FLOAT4& b) { return(MASK4{ _mm_cmplt_ps(a.v, b.v) }); }
+	friend MASK4 operator<=(const FLOAT4& a, const FLOAT4& b) { return(MASK4{ _mm_cmple_ps(a.v, b.v) }); }
+	friend MASK4 operator>(const FLOAT4& a, const FLOAT4& b) { return(MASK4{ _mm_cmpgt_ps(a.v, b.v) }); }
+	friend MASK4 operator>=(const FLOAT4& a, const FLOAT4& b) { return(MASK4{ _mm_cmpge_ps(a.v, b.v) }); }
+#elif defined(SIMD_USE_NEON)
+	float32x4_t v;
+	FLOAT4() {}
+	FLOAT4(float32x4_t value) : v(value) {}
+	explicit FLOAT4(float value) : v(vdupq_n_f32(value)) {}
+	FLOAT4(float a, float b, float c, float d) { const float values[4] = { a, b, c, d }; v = vld1q_f32(values); }
+	static FLOAT4 Load(const float* p) { return(FLOAT4(vld1q_f32(p))); }
+	void Store(float* p) const { vst1q_f32(p, v); }
+	friend FLOAT4 operator+(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(vaddq_f32(a.v, b.v))); }
+	friend FLOAT4 operator-(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(vsubq_f32(a.v, b.v))); }
+	friend FLOAT4 operator*(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(vmulq_f32(a.v, b.v))); }
+	friend FLOAT4 operator/(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(vdivq_f32(a.v, b.v))); }
+	friend FLOAT4 Min(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(vminq_f32(a.v, b.v))); }
+	friend FLOAT4 Max(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(vmaxq_f32(a.v, b.v))); }
+	friend MASK4 operator<(const FLOAT4& a, const FLOAT4& b) { return(MASK4{ vcltq_f32(a.v, b.v) }); }
+	friend MASK4 operator<=(const FLOAT4& a, const FLOAT4& b) { return(MASK4{ vcleq_f32(a.v, b.v) }); }
+	friend MASK4 operator>(const FLOAT4& a, const FLOAT4& b) { return(MASK4{ vcgtq_f32(a.v, b.v) }); }
+	friend MASK4 operator>=(const FLOAT4& a, const FLOAT4& b) { return(MASK4{ vcgeq_f32(a.v, b.v) }); }
+#else
+	float v[4];
+	FLOAT4() {}
+	explicit FLOAT4(float value) { v[0] = v[1] = v[2] = v[3] = value; }
+	FLOAT4(float a, float b, float c, float d) { v[0] = a; v[1] = b; v[2] = c; v[3] = d; }
+	static FLOAT4 Load(const float* p) { FLOAT4 r; for (int i = 0; i < 4; i++) r.v[i] = p[i]; return(r); }
+	void Store(float* p) const { for (int i = 0; i < 4; i++) p[i] = v[i]; }
+	friend FLOAT4 operator+(const FLOAT4& a, const FLOAT4& b) { FLOAT4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] + b.v[i]; return(r); }
+	friend FLOAT4 operator-(const FLOAT4& a, const FLOAT4& b) { FLOAT4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] - b.v[i]; return(r); }
+	friend FLOAT4 operator*(const FLOAT4& a, const FLOAT4& b) { FLOAT4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] * b.v[i]; return(r); }
+	friend FLOAT4 operator/(const FLOAT4& a, const FLOAT4& b) { FLOAT4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] / b.v[i]; return(r); }
+	friend FLOAT4 Min(const FLOAT4& a, const FLOAT4& b) { FLOAT4 r; for (int i = 0; i < 4; i++) r.v[i] = (a.v[i] < b.v[i]) ? a.v[i] : b.v[i]; return(r); }
+	friend FLOAT4 Max(const FLOAT4& a, const FLOAT4& b) { FLOAT4 r; for (int i = 0; i < 4; i++) r.v[i] = (a.v[i] > b.v[i]) ? a.v[i] : b.v[i]; return(r); }
+	friend MASK4 operator<(const FLOAT4& a, const FLOAT4& b) { MASK4 r; for (int i = 0; i < 4; i++) r.m[i] = a.v[i] < b.v[i]; return(r); }
+	friend MASK4 operator<=(const FLOAT4& a, const FLOAT4& b) { MASK4 r; for (int i = 0; i < 4; i++) r.m[i] = a.v[i] <= b.v[i]; return(r); }
+	friend MASK4 operator>(const FLOAT4& a, const FLOAT4& b) { MASK4 r; for (int i = 0; i < 4; i++) r.m[i] = a.v[i] > b.v[i]; return(r); }
+	friend MASK4 operator>=(const FLOAT4& a, const FLOAT4& b) { MASK4 r; for (int i = 0; i < 4; i++) r.m[i] = a.v[i] >= b.v[i]; return(r); }
+#endif
+};
+
+// four 32 bit integer lanes, for the edge functions of the
+// software rasterizer, which only add and test signs
+struct INT4
+{
+#if defined(SIMD_USE_SSE2)
+	__m128i v;
+	INT4() {}
+	INT4(__m128i value) : v(value) {}
+	explicit INT4(int32_t value) : v(_mm_set1_epi32(value)) {}
+	INT4(int32_t a, int32_t b, int32_t c, int32_t d) : v(_mm_setr_epi32(a, b, c, d)) {}
+	friend INT4 operator+(const INT4& a, const INT4& b) { return(INT4(_mm_add_epi32(a.v, b.v))); }
+	friend INT4 operator|(const INT4& a, const INT4& b) { return(INT4(_mm_or_si128(a.v, b.v))); }
+#elif defined(SIMD_USE_NEON)
+	int32x4_t v;
+	INT4() {}
+	INT4(int32x4_t value) : v(value) {}
+	explicit INT4(int32_t value) : v(vdupq_n_s32(value)) {}
+	INT4(int32_t a, int32_t b, int32_t c, int32_t d) { const int32_t values[4] = { a, b, c, d }; v = vld1q_s32(values); }
+	friend INT4 operator+(const INT4& a, const INT4& b) { return(INT4(vaddq_s32(a.v, b.v))); }
+	friend INT4 operator|(const INT4& a, const INT4& b) { return(INT4(vorrq_s32(a.v, b.v))); }
+#else
+	int32_t v[4];
+	INT4() {}
+	explicit INT4(int32_t value) { v[0] = v[1] = v[2] = v[3] = value; }
+	INT4(int32_t a, int32_t b, int32_t c, int32_t d) { v[0] = a; v[1] = b; v[2] = c; v[3] = d; }
+	friend INT4 operator+(const INT4& a, const INT4& b) { INT4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] + b.v[i]; return(r); }
+	friend INT4 operator|(const INT4& a, const INT4& b) { INT4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] | b.v[i]; return(r); }
+#endif
+};
+
+// lanes that passed both comparisons
+inline MASK4 operator&(const MASK4& a, const MASK4& b)
+{
+#if defined(SIMD_USE_SSE2)
+	return(MASK4{ _mm_and_ps(a.m, b.m) });
+#elif defined(SIMD_USE_NEON)
+	return(MASK4{ vandq_u32(a.m, b.m) });
+#else
+	MASK4 r;
+	for (int i = 0; i < 4; i++) r.m[i] = a.m[i] && b.m[i];
+	return(r);
+#endif
+}
+
+// the lanes of the first value that passed, and of the second
+// value that did not
+inline FLOAT4 Select(const MASK4& mask, const FLOAT4& a, const FLOAT4& b)
+{
+#if defined(SIMD_USE_SSE2)
+	return(FLOAT4(_mm_or_ps(_mm_and_ps(mask.m, a.v), _mm_andnot_ps(mask.m, b.v))));
+#elif defined(SIMD_USE_NEON)
+	return(FLOAT4(vbslq_f32(mask.m, a.v, b.v)));
+#else
+	FLOAT4 r;
+	for (int i = 0; i < 4; i++) r.v[i] = mask.m[i] ? a.v[i] : b.v[i];
+	return(r);
+#endif
+}
+
+// one bit for each lane that passed, lane 0 in the lowest bit
+inline int GetLanes(const MASK4& mask)
+{
+#if defined(SIMD_USE_SSE2)
+	return(_mm_movemask_ps(mask.m));
+#elif defined(SIMD_USE_NEON)
+	static const uint32_t bits[4] = { 1, 2, 4, 8 };
+	return((int)vaddvq_u32(vandq_u32(mask.m, vld1q_u32(bits))));
+#else
+	return((mask.m[0] ? 1 : 0) | (mask.m[1] ? 2 : 0) | (mask.m[2] ? 4 : 0) | (mask.m[3] ? 8 : 0));
+#endif
+}
+
+// one bit for each lane that is below zero, lane 0 in the
+// lowest bit
+inline int GetNegativeLanes(const INT4& value)
+{
+#if defined(SIMD_USE_SSE2)
+	return(_mm_movemask_ps(_mm_castsi128_ps(value.v)));
+#elif defined(SIMD_USE_NEON)
+	static const uint32_t bits[4] = { 1, 2, 4, 8 };
+	uint32x4_t negative = vcltq_s32(value.v, vdupq_n_s32(0));
+	return((int)vaddvq_u32(vandq_u32(negative, vld1q_u32(bits))));
+#else
+	return(((value.v[0] < 0) ? 1 : 0) | ((value.v[1] < 0) ? 2 : 0) | ((value.v[2] < 0) ? 4 : 0) | ((value.v[3] < 0) ? 8 : 0));
+#endif
+}
+
+// smallest of the lanes that are set in the passed in bits
+inline float GetMinimum(const FLOAT4& value, int lanes)
+{
+	float values[4];
+	value.Store(values);
+	float minimum = FLT_MAX;
+	for (int lane = 0; lane < 4; lane++)
+	{
+		if (((lanes & (1 << lane)) != 0) && (values[lane] < minimum))
+		{
+			minimum = values[lane];
+		}
+	}
+	return(minimum);
+}
+
+// name of the instructions the lanes were compiled with
+inline const char* GetSimdInstructionSet()
+{
+#if defined(SIMD_USE_SSE2)
+	return("SSE2");
+#elif defined(SIMD_USE_NEON)
+	return("NEON");
+#else
+	return("scalar");
+#endif
+}
@@ -0,0 +1,835 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.cpp
+// ============
+// draw the triangles of the scene on the CPU, tile by tile on all threads,
+// with the math of the vertex and fragment shaders
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.h"
+#include "Profiler.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// steps of a pixel that the corners are snapped to
+	const int g_SubpixelBits = 4;
+	const int g_SubpixelSteps = 1 << g_SubpixelBits;
+	// runs of draws that are binned for each thread, so the
+	// threads stay busy when the runs take different times
+	const int g_BinSetsPerThread = 4;
+	// corners of a triangle clipped against all six planes
+	const int g_MaxClippedCorners = 9;
+
+	// round towards negative and positive infinity when dividing
+	// by a positive number
+	int FloorDivide(int value, int divisor)
+	{
+		return((value >= 0) ? value / divisor : -((-value + divisor - 1) / divisor));
+	}
+
+	int CeilDivide(int value, int divisor)
+	{
+		return(-FloorDivide(-value, divisor));
+	}
+
+	// distance of a point in clip space inside one of the planes
+	// of the view, -w <= x, y, z <= w, negative outside
+	float GetPlaneDistance(const glm::vec4& clip, int plane)
+	{
+		switch (plane)
+		{
+		case 0: return(clip.w + clip.x);
+		case 1: return(clip.w - clip.x);
+		case 2: return(clip.w + clip.y);
+		case 3: return(clip.w - clip.y);
+		case 4: return(clip.w + clip.z);
+		default: return(clip.w - clip.z);
+		}
+	}
+
+	// one bit for each plane of the view that a point is outside of
+	int GetOutcode(const glm::vec4& clip)
+	{
+		int outcode = 0;
+		for (int plane = 0; plane < 6; plane++)
+		{
+			if (GetPlaneDistance(clip, plane) < 0.0f)
+			{
+				outcode |= 1 << plane;
+			}
+		}
+		return(outcode);
+	}
+
+	// a channel of a color clamped and stored in 8 bits, as the
+	// framebuffer stores it
+	uint32_t PackChannel(float value)
+	{
+		value = std::min(std::max(value, 0.0f), 1.0f);
+		return((uint32_t)(value * 255.0f + 0.5f));
+	}
+
+	uint32_t PackColor(const glm::vec3& color)
+	{
+		return(PackChannel(color.r) | (PackChannel(color.g) << 8) | (PackChannel(color.b) << 16) | (255u << 24));
+	}
+}
+
+/***********************************************************
+ *  SoftwareRasterizer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SoftwareRasterizer::SoftwareRasterizer()
+{
+	m_width = 0;
+	m_height = 0;
+	m_tilesX = 0;
+	m_tilesY = 0;
+	m_camera.view = glm::mat4(1.0f);
+	m_camera.projection = glm::mat4(1.0f);
+	m_camera.viewPosition = glm::vec3(0.0f);
+	m_lights = LIGHTS();
+	m_bClear = false;
+	m_clearColor = glm::vec3(0.0f);
+	m_activeBinSets = 0;
+	m_statistics = STATISTICS();
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used to size the color and depth buffers
+ *  and the screen tiles for an image.  The content of the
+ *  buffers is lost.
+ ***********************************************************/
+bool SoftwareRasterizer::Resize(int width, int height)
+{
+	if ((width <= 0) || (height <= 0) || (width > MAX_SIZE) || (height > MAX_SIZE))
+	{
+		std::cout << "Could not size the software rasterizer:" << width << "x" << height << std::endl;
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	m_colors.assign((size_t)width * height, PackColor(glm::vec3(0.0f)));
+	m_depths.assign((size_t)width * height, 1.0f);
+	for (size_t i = 0; i < m_binSets.size(); i++)
+	{
+		m_binSets[i].tiles.clear();
+		m_binSets[i].tiles.resize((size_t)m_tilesX * m_tilesY);
+	}
+	return true;
+}
+
+/***********************************************************
+ *  SetTexture()
+ *
+ *  This method is used to set the texture that the surfaces
+ *  naming a unit are drawn with.
+ ***********************************************************/
+void SoftwareRasterizer::SetTexture(int unit, const TEXTURE* pTexture)
+{
+	if (unit < 0)
+	{
+		return;
+	}
+	if (unit >= (int)m_textures.size())
+	{
+		m_textures.resize(unit + 1, NULL);
+	}
+
+	// only textures of 3 and 4 channels can be sampled
+	if ((NULL != pTexture) && (pTexture->channels != 3) && (pTexture->channels != 4))
+	{
+		pTexture = NULL;
+	}
+	m_textures[unit] = pTexture;
+}
+
+/***********************************************************
+ *  SetCamera()
+ *
+ *  This method is used to set the view that the queued
+ *  draws are drawn from.
+ ***********************************************************/
+void SoftwareRasterizer::SetCamera(const CAMERA& camera)
+{
+	m_camera = camera;
+}
+
+/***********************************************************
+ *  SetLights()
+ *
+ *  This method is used to set the lights that the queued
+ *  draws are shaded with.
+ ***********************************************************/
+void SoftwareRasterizer::SetLights(const LIGHTS& lights)
+{
+	m_lights = lights;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to start a frame.  The buffers are
+ *  cleared by the tile jobs of the next Finish(), before
+ *  each tile's triangles are drawn.
+ ***********************************************************/
+void SoftwareRasterizer::Clear(const glm::vec3& color)
+{
+	m_bClear = true;
+	m_clearColor = color;
+	m_draws.clear();
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used to queue the triangles of a mesh to
+ *  be drawn by the next Finish().
+ ***********************************************************/
+void SoftwareRasterizer::Draw(
+	const glm::mat4& model,
+	const glm::vec3* corners,
+	const glm::vec3* normals,
+	const glm::vec2* textureCoordinates,
+	int cornerCount,
+	const SURFACE& surface)
+{
+	if ((NULL == corners) || (NULL == normals) || (NULL == textureCoordinates) || (cornerCount < 3))
+	{
+		return;
+	}
+
+	DRAW_COMMAND draw;
+	draw.model = model;
+	draw.corners = corners;
+	draw.normals = normals;
+	draw.textureCoordinates = textureCoordinates;
+	draw.cornerCount = cornerCount;
+	draw.surface = surface;
+	m_draws.push_back(draw);
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used to draw the queued draws.  The draws
+ *  are split into runs of about the same number of corners,
+ *  which are binned into the tiles as jobs, and then every
+ *  tile is cleared and drawn as a job.
+ ***********************************************************/
+void SoftwareRasterizer::Finish(JobSystem* pJobSystem)
+{
+	PROFILE_FUNCTION();
+
+	m_statistics = STATISTICS();
+	if (m_width == 0)
+	{
+		m_draws.clear();
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// the runs take whole draws, about the same number of
+	// corners each
+	int threadCount = (NULL != pJobSystem) ? pJobSystem->GetThreadCount() : 1;
+	int drawCount = (int)m_draws.size();
+	int setCount = std::min(drawCount, threadCount * g_BinSetsPerThread);
+	if ((int)m_binSets.size() < setCount)
+	{
+		m_binSets.resize(setCount);
+	}
+	long long totalCorners = 0;
+	for (int i = 0; i < drawCount; i++)
+	{
+		totalCorners += m_draws[i].cornerCount;
+	}
+	int draw = 0;
+	long long corners = 0;
+	for (int set = 0; set < setCount; set++)
+	{
+		BIN_SET& binSet = m_binSets[set];
+		binSet.tiles.resize((size_t)m_tilesX * m_tilesY);
+		binSet.firstDraw = draw;
+		long long endCorners = totalCorners * (set + 1) / setCount;
+		while ((draw < drawCount) && ((corners < endCorners) || (set == setCount - 1)))
+		{
+			corners += m_draws[draw].cornerCount;
+			draw++;
+		}
+		binSet.drawCount = draw - binSet.firstDraw;
+	}
+	m_activeBinSets = setCount;
+
+	glm::mat4 viewProjection = m_camera.projection * m_camera.view;
+	auto binDraws = [this, &viewProjection](int first, int count) {
+		for (int set = first; set < first + count; set++)
+		{
+			BinDraws(m_binSets[set], viewProjection);
+		}
+	};
+	if (NULL != pJobSystem)
+	{
+		pJobSystem->ParallelFor(setCount, 1, binDraws);
+	}
+	else
+	{
+		binDraws(0, setCount);
+	}
+
+	std::chrono::steady_clock::time_point binEnd = std::chrono::steady_clock::now();
+
+	int tileCount = m_tilesX * m_tilesY;
+	std::atomic<long long> shadedPixels(0);
+	auto rasterizeTiles = [this, &shadedPixels](int first, int count) {
+		long long pixels = 0;
+		for (int tile = first; tile < first + count; tile++)
+		{
+			pixels += RasterizeTile(tile);
+		}
+		shadedPixels += pixels;
+	};
+	if (NULL != pJobSystem)
+	{
+		pJobSystem->ParallelFor(tileCount, 1, rasterizeTiles);
+	}
+	else
+	{
+		rasterizeTiles(0, tileCount);
+	}
+
+	m_statistics.draws = drawCount;
+	for (int set = 0; set < setCount; set++)
+	{
+		const BIN_SET& binSet = m_binSets[set];
+		m_statistics.triangles += binSet.triangleCount;
+		m_statistics.setupTriangles += (long long)binSet.triangles.size();
+		for (size_t tile = 0; tile < binSet.tiles.size(); tile++)
+		{
+			m_statistics.binnedTriangles += (long long)binSet.tiles[tile].size();
+		}
+	}
+	m_statistics.shadedPixels = shadedPixels;
+	m_statistics.tiles = tileCount;
+	m_statistics.threads = threadCount;
+	m_statistics.binMilliseconds = std::chrono::duration<double, std::milli>(binEnd - start).count();
+	m_statistics.rasterMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - binEnd).count();
+
+	m_draws.clear();
+	m_bClear = false;
+}
+
+/***********************************************************
+ *  ReadPixels()
+ *
+ *  This method is used to copy the color buffer out as RGB,
+ *  turning it so the top row comes first.
+ ***********************************************************/
+void SoftwareRasterizer::ReadPixels(unsigned char* pPixels) const
+{
+	if (NULL == pPixels)
+	{
+		return;
+	}
+
+	for (int y = 0; y < m_height; y++)
+	{
+		const uint32_t* pRow = m_colors.data() + (size_t)(m_height - 1 - y) * m_width;
+		unsigned char* pOut = pPixels + (size_t)y * m_width * 3;
+		for (int x = 0; x < m_width; x++)
+		{
+			pOut[x * 3] = (unsigned char)(pRow[x] & 0xFF);
+			pOut[x * 3 + 1] = (unsigned char)((pRow[x] >> 8) & 0xFF);
+			pOut[x * 3 + 2] = (unsigned char)((pRow[x] >> 16) & 0xFF);
+		}
+	}
+}
+
+/***********************************************************
+ *  ReadColors()
+ *
+ *  This method is used to copy the color buffer out in the
+ *  layout it is kept in.
+ ***********************************************************/
+void SoftwareRasterizer::ReadColors(unsigned char* pPixels) const
+{
+	if (NULL == pPixels)
+	{
+		return;
+	}
+
+	std::memcpy(pPixels, m_colors.data(), m_colors.size() * sizeof(uint32_t));
+}
+
+/***********************************************************
+ *  GetInstructionSet()
+ *
+ *  This method is used to get the name of the instructions
+ *  that the edge functions were compiled with.
+ ***********************************************************/
+const char* SoftwareRasterizer::GetInstructionSet()
+{
+	return(GetSimdInstructionSet());
+}
+
+/***********************************************************
+ *  BinDraws()
+ *
+ *  This method is used to run the vertex shader math over
+ *  the draws of a bin set and to clip, set up and bin their
+ *  triangles.  Nothing outside of the set is written, so the
+ *  sets are binned at the same time.
+ ***********************************************************/
+void SoftwareRasterizer::BinDraws(BIN_SET& set, const glm::mat4& viewProjection)
+{
+	PROFILE_SCOPE("BinDraws");
+
+	set.triangles.clear();
+	for (size_t tile = 0; tile < set.tiles.size(); tile++)
+	{
+		set.tiles[tile].clear();
+	}
+	set.triangleCount = 0;
+
+	for (int draw = set.firstDraw; draw < set.firstDraw + set.drawCount; draw++)
+	{
+		const DRAW_COMMAND& command = m_draws[draw];
+		glm::mat4 modelViewProjection = viewProjection * command.model;
+		for (int i = 0; i + 2 < command.cornerCount; i += 3)
+		{
+			// the normals and texture coordinates are passed on as
+			// they are, like the vertex shader does
+			CLIP_VERTEX corners[3];
+			for (int c = 0; c < 3; c++)
+			{
+				glm::vec4 corner(command.corners[i + c], 1.0f);
+				corners[c].clip = modelViewProjection * corner;
+				corners[c].position = glm::vec3(command.model * corner);
+				corners[c].normal = command.normals[i + c];
+				corners[c].textureCoordinate = command.textureCoordinates[i + c];
+			}
+			set.triangleCount++;
+			ClipTriangle(set, corners, draw);
+		}
+	}
+}
+
+/***********************************************************
+ *  ClipTriangle()
+ *
+ *  This method is used to clip a triangle against the six
+ *  planes of the view in clip space.  A triangle inside all
+ *  of them is set up as it is, one outside any of them is
+ *  dropped, and the rest are cut into a polygon that is set
+ *  up as a fan of triangles.
+ ***********************************************************/
+void SoftwareRasterizer::ClipTriangle(BIN_SET& set, const CLIP_VERTEX* corners, int draw)
+{
+	int outcodes[3] = {
+		GetOutcode(corners[0].clip),
+		GetOutcode(corners[1].clip),
+		GetOutcode(corners[2].clip) };
+	if ((outcodes[0] & outcodes[1] & outcodes[2]) != 0)
+	{
+		return;
+	}
+	int crossed = outcodes[0] | outcodes[1] | outcodes[2];
+	if (crossed == 0)
+	{
+		SetupTriangle(set, corners[0], corners[1], corners[2], draw);
+		return;
+	}
+
+	CLIP_VERTEX polygons[2][g_MaxClippedCorners];
+	int counts[2] = { 3, 0 };
+	int current = 0;
+	for (int c = 0; c < 3; c++)
+	{
+		polygons[0][c] = corners[c];
+	}
+
+	for (int plane = 0; plane < 6; plane++)
+	{
+		if ((crossed & (1 << plane)) == 0)
+		{
+			continue;
+		}
+
+		const CLIP_VERTEX* pIn = polygons[current];
+		CLIP_VERTEX* pOut = polygons[1 - current];
+		int inCount = counts[current];
+		int outCount = 0;
+		for (int i = 0; i < inCount; i++)
+		{
+			const CLIP_VERTEX& from = pIn[i];
+			const CLIP_VERTEX& to = pIn[(i + 1) % inCount];
+			float fromDistance = GetPlaneDistance(from.clip, plane);
+			float toDistance = GetPlaneDistance(to.clip, plane);
+			if (fromDistance >= 0.0f)
+			{
+				pOut[outCount++] = from;
+			}
+			if ((fromDistance >= 0.0f) != (toDistance >= 0.0f))
+			{
+				// every value the vertex shader passes on is linear
+				// in clip space
+				float t = fromDistance / (fromDistance - toDistance);
+				CLIP_VERTEX& cut = pOut[outCount++];
+				cut.clip = from.clip + (to.clip - from.clip) * t;
+				cut.position = from.position + (to.position - from.position) * t;
+				cut.normal = from.normal + (to.normal - from.normal) * t;
+				cut.textureCoordinate = from.textureCoordinate + (to.textureCoordinate - from.textureCoordinate) * t;
+			}
+		}
+		counts[1 - current] = outCount;
+		current = 1 - current;
+		if (outCount < 3)
+		{
+			return;
+		}
+	}
+
+	const CLIP_VERTEX* pPolygon = polygons[current];
+	for (int i = 1; i + 1 < counts[current]; i++)
+	{
+		SetupTriangle(set, pPolygon[0], pPolygon[i], pPolygon[i + 1], draw);
+	}
+}
+
+/***********************************************************
+ *  SetupTriangle()
+ *
+ *  This method is used to snap the corners of a clipped
+ *  triangle to the subpixel grid, find its edge functions,
+ *  barycentric and depth planes and the pixels it may
+ *  cover, and to add it to the lists of the tiles under
+ *  those pixels.  Triangles facing either way are drawn, as
+ *  the scene does not cull faces, and a triangle that covers
+ *  no pixel center is dropped.
+ ***********************************************************/
+void SoftwareRasterizer::SetupTriangle(
+	BIN_SET& set,
+	const CLIP_VERTEX& a,
+	const CLIP_VERTEX& b,
+	const CLIP_VERTEX& c,
+	int draw)
+{
+	const CLIP_VERTEX* corners[3] = { &a, &b, &c };
+	int x[3];
+	int y[3];
+	float z[3];
+	float inverseW[3];
+	int maxX = m_width * g_SubpixelSteps;
+	int maxY = m_height * g_SubpixelSteps;
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& clip = corners[i]->clip;
+		inverseW[i] = 1.0f / clip.w;
+		float windowX = (clip.x * inverseW[i] * 0.5f + 0.5f) * (float)maxX;
+		float windowY = (clip.y * inverseW[i] * 0.5f + 0.5f) * (float)maxY;
+		// the clipped corners are inside the view, up to rounding
+		x[i] = std::min(std::max((int)std::floor(windowX + 0.5f), 0), maxX);
+		y[i] = std::min(std::max((int)std::floor(windowY + 0.5f), 0), maxY);
+		z[i] = std::min(std::max(clip.z * inverseW[i] * 0.5f + 0.5f, 0.0f), 1.0f);
+	}
+
+	// twice the area, positive when the corners go counter
+	// clockwise - the other way round they are swapped
+	int64_t area = (int64_t)(x[1] - x[0]) * (y[2] - y[0]) - (int64_t)(x[2] - x[0]) * (y[1] - y[0]);
+	if (area == 0)
+	{
+		return;
+	}
+	if (area < 0)
+	{
+		std::swap(corners[1], corners[2]);
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(z[1], z[2]);
+		std::swap(inverseW[1], inverseW[2]);
+		area = -area;
+	}
+
+	// the pixels whose centers lie within the bounds
+	const int half = g_SubpixelSteps / 2;
+	SETUP_TRIANGLE triangle;
+	triangle.minX = std::max(CeilDivide(std::min(x[0], std::min(x[1], x[2])) - half, g_SubpixelSteps), 0);
+	triangle.minY = std::max(CeilDivide(std::min(y[0], std::min(y[1], y[2])) - half, g_SubpixelSteps), 0);
+	triangle.maxX = std::min(FloorDivide(std::max(x[0], std::max(x[1], x[2])) - half, g_SubpixelSteps), m_width - 1);
+	triangle.maxY = std::min(FloorDivide(std::max(y[0], std::max(y[1], y[2])) - half, g_SubpixelSteps), m_height - 1);
+	if ((triangle.minX > triangle.maxX) || (triangle.minY > triangle.maxY))
+	{
+		return;
+	}
+
+	int64_t centerX = (int64_t)triangle.minX * g_SubpixelSteps + half;
+	int64_t centerY = (int64_t)triangle.minY * g_SubpixelSteps + half;
+	for (int i = 0; i < 3; i++)
+	{
+		// the edge from the next corner to the one after it
+		int from = (i + 1) % 3;
+		int to = (i + 2) % 3;
+		int32_t edgeA = y[from] - y[to];
+		int32_t edgeB = x[to] - x[from];
+		int64_t edgeC = -(int64_t)edgeA * x[from] - (int64_t)edgeB * y[from];
+
+		// a pixel center on an edge belongs to the triangle when
+		// the edge is a left edge or a flat top edge
+		bool bTopLeft = (edgeA > 0) || ((edgeA == 0) && (edgeB < 0));
+		triangle.edgeA[i] = edgeA;
+		triangle.edgeB[i] = edgeB;
+		triangle.edgeC[i] = edgeC + (bTopLeft ? 0 : -1);
+
+		if (i > 0)
+		{
+			double value = (double)(edgeA * centerX + edgeB * centerY + edgeC);
+			triangle.bary[i - 1] = (float)(value / (double)area);
+			triangle.baryStepX[i - 1] = (float)((double)edgeA * g_SubpixelSteps / (double)area);
+			triangle.baryStepY[i - 1] = (float)((double)edgeB * g_SubpixelSteps / (double)area);
+		}
+	}
+
+	// the depth is linear on the screen
+	triangle.depth = z[0] + (z[1] - z[0]) * triangle.bary[0] + (z[2] - z[0]) * triangle.bary[1];
+	triangle.depthStepX = (z[1] - z[0]) * triangle.baryStepX[0] + (z[2] - z[0]) * triangle.baryStepX[1];
+	triangle.depthStepY = (z[1] - z[0]) * triangle.baryStepY[0] + (z[2] - z[0]) * triangle.baryStepY[1];
+	for (int i = 0; i < 3; i++)
+	{
+		triangle.inverseW[i] = inverseW[i];
+		triangle.position[i] = corners[i]->position * inverseW[i];
+		triangle.normal[i] = corners[i]->normal * inverseW[i];
+		triangle.textureCoordinate[i] = corners[i]->textureCoordinate * inverseW[i];
+	}
+	triangle.draw = draw;
+
+	int index = (int)set.triangles.size();
+	set.triangles.push_back(triangle);
+	for (int tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; tileY++)
+	{
+		for (int tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; tileX++)
+		{
+			set.tiles[(size_t)tileY * m_tilesX + tileX].push_back(index);
+		}
+	}
+}
+
+/***********************************************************
+ *  RasterizeTile()
+ *
+ *  This method is used to clear one tile when the frame
+ *  clears, and to draw its triangles from every bin set in
+ *  the order of the draws.  Each tile only writes its own
+ *  pixels, so the tiles are drawn at the same time.
+ ***********************************************************/
+long long SoftwareRasterizer::RasterizeTile(int tile)
+{
+	PROFILE_SCOPE("RasterizeTile");
+
+	int left = (tile % m_tilesX) * TILE_SIZE;
+	int bottom = (tile / m_tilesX) * TILE_SIZE;
+	int right = std::min(left + TILE_SIZE, m_width) - 1;
+	int top = std::min(bottom + TILE_SIZE, m_height) - 1;
+
+	if (m_bClear == true)
+	{
+		uint32_t color = PackColor(m_clearColor);
+		for (int y = bottom; y <= top; y++)
+		{
+			size_t row = (size_t)y * m_width;
+			std::fill(m_colors.begin() + row + left, m_colors.begin() + row + right + 1, color);
+			std::fill(m_depths.begin() + row + left, m_depths.begin() + row + right + 1, 1.0f);
+		}
+	}
+
+	long long pixels = 0;
+	for (int set = 0; set < m_activeBinSets; set++)
+	{
+		const BIN_SET& binSet = m_binSets[set];
+		const std::vector<int>& triangles = binSet.tiles[tile];
+		for (size_t i = 0; i < triangles.size(); i++)
+		{
+			pixels += RasterizeTriangle(binSet.triangles[triangles[i]], left, bottom, right, top);
+		}
+	}
+	return(pixels);
+}
+
+/***********************************************************
+ *  RasterizeTriangle()
+ *
+ *  This method is used to draw the pixels of a triangle
+ *  within a rectangle of pixels, a 2x2 block at a time.
+ *  The edge functions are found at the corner of the
+ *  rectangle - an edge that leaves the whole rectangle
+ *  outside drops the triangle, and an edge that leaves it
+ *  inside is not tested further.  The other edges stay
+ *  within 32 bits across the rectangle and are stepped in
+ *  four lanes, and the covered pixels are tested against
+ *  the depth buffer in four lanes too.
+ ***********************************************************/
+long long SoftwareRasterizer::RasterizeTriangle(
+	const SETUP_TRIANGLE& triangle,
+	int left,
+	int bottom,
+	int right,
+	int top)
+{
+	left = std::max(left, triangle.minX);
+	bottom = std::max(bottom, triangle.minY);
+	right = std::min(right, triangle.maxX);
+	top = std::min(top, triangle.maxY);
+	if ((left > right) || (bottom > top))
+	{
+		return(0);
+	}
+
+	const int half = g_SubpixelSteps / 2;
+	int64_t spanX = (int64_t)(right - left) * g_SubpixelSteps;
+	int64_t spanY = (int64_t)(top - bottom) * g_SubpixelSteps;
+	INT4 edgeRows[3];
+	INT4 edgeStepX[3];
+	INT4 edgeStepY[3];
+	for (int i = 0; i < 3; i++)
+	{
+		int64_t edgeA = triangle.edgeA[i];
+		int64_t edgeB = triangle.edgeB[i];
+		int64_t value = edgeA * ((int64_t)left * g_SubpixelSteps + half)
+			+ edgeB * ((int64_t)bottom * g_SubpixelSteps + half)
+			+ triangle.edgeC[i];
+		int64_t highest = value + std::max(edgeA, (int64_t)0) * spanX + std::max(edgeB, (int64_t)0) * spanY;
+		int64_t lowest = value + std::min(edgeA, (int64_t)0) * spanX + std::min(edgeB, (int64_t)0) * spanY;
+		if (highest < 0)
+		{
+			return(0);
+		}
+		if (lowest >= 0)
+		{
+			edgeRows[i] = INT4(0);
+			edgeStepX[i] = INT4(0);
+			edgeStepY[i] = INT4(0);
+			continue;
+		}
+
+		int32_t stepX = (int32_t)(edgeA * g_SubpixelSteps);
+		int32_t stepY = (int32_t)(edgeB * g_SubpixelSteps);
+		edgeRows[i] = INT4((int32_t)value) + INT4(0, stepX, stepY, stepX + stepY);
+		edgeStepX[i] = INT4(stepX * 2);
+		edgeStepY[i] = INT4(stepY * 2);
+	}
+
+	FLOAT4 depthLanes(0.0f, triangle.depthStepX, triangle.depthStepY, triangle.depthStepX + triangle.depthStepY);
+	long long pixels = 0;
+	for (int y = bottom; y <= top; y += 2)
+	{
+		INT4 edges[3] = { edgeRows[0], edgeRows[1], edgeRows[2] };
+		int rowLanes = (y + 1 <= top) ? 0xF : 0x3;
+		float* pDepthRow = m_depths.data() + (size_t)y * m_width;
+		for (int x = left; x <= right; x += 2)
+		{
+			int lanes = rowLanes & ((x + 1 <= right) ? 0xF : 0x5);
+			lanes &= ~GetNegativeLanes(edges[0] | edges[1] | edges[2]);
+			edges[0] = edges[0] + edgeStepX[0];
+			edges[1] = edges[1] + edgeStepX[1];
+			edges[2] = edges[2] + edgeStepX[2];
+			if (lanes == 0)
+			{
+				continue;
+			}
+
+			// the depth test passes for a nearer pixel, as with
+			// the default depth function
+			float stored[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if ((lanes & (1 << lane)) != 0)
+				{
+					stored[lane] = pDepthRow[(size_t)(lane >> 1) * m_width + x + (lane & 1)];
+				}
+			}
+			float depth = triangle.depth
+				+ triangle.depthStepX * (float)(x - triangle.minX)
+				+ triangle.depthStepY * (float)(y - triangle.minY);
+			FLOAT4 depths = FLOAT4(depth) + depthLanes;
+			lanes &= GetLanes(depths < FLOAT4::Load(stored));
+			if (lanes == 0)
+			{
+				continue;
+			}
+
+			float laneDepths[4];
+			depths.Store(laneDepths);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if ((lanes & (1 << lane)) != 0)
+				{
+					ShadePixel(triangle, x + (lane & 1), y + (lane >> 1), laneDepths[lane]);
+					pixels++;
+				}
+			}
+		}
+
+		edgeRows[0] = edgeRows[0] + edgeStepY[0];
+		edgeRows[1] = edgeRows[1] + edgeStepY[1];
+		edgeRows[2] = edgeRows[2] + edgeStepY[2];
+	}
+	return(pixels);
+}
+
+/***********************************************************
+ *  ShadePixel()
+ *
+ *  This method is used to shade one covered pixel with the
+ *  values of the corners interpolated for its perspective,
+ *  and to blend the clamped color over the color buffer
+ *  with its alpha.  The depth is written whatever the alpha,
+ *  as the drawn frames write it.
+ ***********************************************************/
+void SoftwareRasterizer::ShadePixel(const SETUP_TRIANGLE& triangle, int x, int y, float depth)
+{
+	float dx = (float)(x - triangle.minX);
+	float dy = (float)(y - triangle.minY);
+	float second = triangle.bary[0] + triangle.baryStepX[0] * dx + triangle.baryStepY[0] * dy;
+	float third = triangle.bary[1] + triangle.baryStepX[1] * dx + triangle.baryStepY[1] * dy;
+	float first = 1.0f - second - third;
+	float w = 1.0f / (triangle.inverseW[0] * first + triangle.inverseW[1] * second + triangle.inverseW[2] * third);
+
+	const DRAW_COMMAND& draw = m_draws[triangle.draw];
+	int unit = draw.surface.texture;
+	const TEXTURE* pTexture = ((unit >= 0) && (unit < (int)m_textures.size())) ? m_textures[unit] : NULL;
+	glm::vec4 shaded = ShadingModel::Shade(
+		draw.surface,
+		pTexture,
+		m_lights,
+		m_camera.viewPosition,
+		(triangle.position[0] * first + triangle.position[1] * second + triangle.position[2] * third) * w,
+		(triangle.normal[0] * first + triangle.normal[1] * second + triangle.normal[2] * third) * w,
+		(triangle.textureCoordinate[0] * first + triangle.textureCoordinate[1] * second
+			+ triangle.textureCoordinate[2] * third) * w);
+
+	size_t index = (size_t)y * m_width + x;
+	uint32_t stored = m_colors[index];
+	float alpha = std::min(std::max(shaded.a, 0.0f), 1.0f);
+	glm::vec3 color = glm::min(glm::max(glm::vec3(shaded), glm::vec3(0.0f)), glm::vec3(1.0f));
+	glm::vec3 destination(
+		(float)(stored & 0xFF) / 255.0f,
+		(float)((stored >> 8) & 0xFF) / 255.0f,
+		(float)((stored >> 16) & 0xFF) / 255.0f);
+	m_colors[index] = PackColor(color * alpha + destination * (1.0f - alpha));
+	m_depths[index] = depth;
+}
@@ -0,0 +1,217 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.h
+// ============
+// draw the triangles of the scene on the CPU, tile by tile on all threads,
+// with the math of the vertex and fragment shaders
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+#include "ShadingModel.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  SoftwareRasterizer
+ *
+ *  This class contains the code for drawing triangles into
+ *  a color and depth buffer without a GPU.  The draws are
+ *  queued with the model matrix, the mesh corners and the
+ *  surface they are shaded with, and Finish() draws them all
+ *  in two steps of jobs.
+ *
+ *  First the draws are split into runs, and each run's
+ *  triangles are moved into clip space like the vertex
+ *  shader moves them, clipped against the view, set up and
+ *  sorted into lists for the screen tiles they cover.  Then
+ *  each tile is drawn on its own - the lists of the runs are
+ *  walked in order, so the triangles of a tile are drawn in
+ *  the order of the draws.  The edge functions are exact
+ *  integers at 1/16 of a pixel with the top left rule, and
+ *  each 2x2 block of pixels is tested four SIMD lanes wide.
+ *  The pixels that pass the depth test are shaded by
+ *  ShadingModel and blended like the drawn frames blend.
+ ***********************************************************/
+class SoftwareRasterizer
+{
+public:
+	typedef ShadingModel::TEXTURE TEXTURE;
+	typedef ShadingModel::SURFACE SURFACE;
+	typedef ShadingModel::LIGHTS LIGHTS;
+	typedef ShadingModel::CAMERA CAMERA;
+
+	// measurements of the last finished frame
+	struct STATISTICS
+	{
+		int draws;
+		// triangles of the draws, and the triangles that were
+		// left to draw after clipping
+		long long triangles;
+		long long setupTriangles;
+		// triangles added to the lists of the tiles
+		long long binnedTriangles;
+		// pixels that passed the depth test and were shaded
+		long long shadedPixels;
+		int tiles;
+		int threads;
+		// time spent on the vertices and the binning, and on
+		// drawing the tiles
+		double binMilliseconds;
+		double rasterMilliseconds;
+	};
+
+	// pixels along each side of the screen tiles
+	static const int TILE_SIZE = 64;
+	// most pixels along each side of the buffers, so the edge
+	// functions of a tile fit into 32 bits
+	static const int MAX_SIZE = 8192;
+
+	// constructor
+	SoftwareRasterizer();
+
+	// size the color and depth buffers - returns false for a
+	// size that cannot be drawn
+	bool Resize(int width, int height);
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
+
+	// set the texture of a unit, which surfaces name by their
+	// texture - the pixels are not copied and must stay valid
+	// until the frames drawing with them are finished, NULL
+	// empties the unit
+	void SetTexture(int unit, const TEXTURE* pTexture);
+	// the camera and lights of the next Finish()
+	void SetCamera(const CAMERA& camera);
+	void SetLights(const LIGHTS& lights);
+
+	// start a frame that clears the buffers to a color and the
+	// farthest depth - queued draws are dropped
+	void Clear(const glm::vec3& color);
+	// queue the triangles of a mesh, three corners each, placed
+	// in the world by the model matrix - the corners, normals
+	// and texture coordinates must stay valid until Finish()
+	void Draw(
+		const glm::mat4& model,
+		const glm::vec3* corners,
+		const glm::vec3* normals,
+		const glm::vec2* textureCoordinates,
+		int cornerCount,
+		const SURFACE& surface);
+	// draw the queued triangles, on the job system when one is
+	// given
+	void Finish(JobSystem* pJobSystem = NULL);
+
+	// copy the color buffer into width * height RGB pixels with
+	// the top row first
+	void ReadPixels(unsigned char* pPixels) const;
+	// copy the color buffer as it is, width * height RGBA pixels
+	// with the bottom row first like glReadPixels() reads them
+	void ReadColors(unsigned char* pPixels) const;
+
+	const STATISTICS& GetStatistics() const { return(m_statistics); }
+	// name of the instructions the pixels are tested with
+	static const char* GetInstructionSet();
+
+private:
+	// one queued draw
+	struct DRAW_COMMAND
+	{
+		glm::mat4 model;
+		const glm::vec3* corners;
+		const glm::vec3* normals;
+		const glm::vec2* textureCoordinates;
+		int cornerCount;
+		SURFACE surface;
+	};
+
+	// a corner in clip space with the values the vertex shader
+	// passes to the fragment shader
+	struct CLIP_VERTEX
+	{
+		glm::vec4 clip;
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	// a clipped triangle ready to be drawn into the tiles
+	struct SETUP_TRIANGLE
+	{
+		// edge functions A * x + B * y + C in 1/16 pixels, each
+		// zero on the edge across from a corner and positive
+		// inside, with the top left rule folded into C
+		int32_t edgeA[3];
+		int32_t edgeB[3];
+		int64_t edgeC[3];
+		// pixels whose centers may be covered
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+		// barycentric coordinates of the second and third corner,
+		// and the depth, at the center of pixel (minX, minY) and
+		// their change per pixel
+		float bary[2];
+		float baryStepX[2];
+		float baryStepY[2];
+		float depth;
+		float depthStepX;
+		float depthStepY;
+		// 1 / w of the corners, and the values to interpolate
+		// divided by w so they interpolate correctly
+		float inverseW[3];
+		glm::vec3 position[3];
+		glm::vec3 normal[3];
+		glm::vec2 textureCoordinate[3];
+		int draw;
+	};
+
+	// the triangles of one run of draws and the lists of them
+	// that each tile draws
+	struct BIN_SET
+	{
+		std::vector<SETUP_TRIANGLE> triangles;
+		std::vector<std::vector<int>> tiles;
+		int firstDraw;
+		int drawCount;
+		long long triangleCount;
+	};
+
+	int m_width;
+	int m_height;
+	int m_tilesX;
+	int m_tilesY;
+	// RGBA colors and depths, bottom row first like OpenGL
+	std::vector<uint32_t> m_colors;
+	std::vector<float> m_depths;
+	std::vector<const TEXTURE*> m_textures;
+	CAMERA m_camera;
+	LIGHTS m_lights;
+	bool m_bClear;
+	glm::vec3 m_clearColor;
+	std::vector<DRAW_COMMAND> m_draws;
+	// the bin sets are kept between frames for their memory,
+	// and the first ones are used by the frame
+	std::vector<BIN_SET> m_binSets;
+	int m_activeBinSets;
+	STATISTICS m_statistics;
+
+	// move the triangles of the draws of a bin set into the
+	// lists of the tiles
+	void BinDraws(BIN_SET& set, const glm::mat4& viewProjection);
+	// clip a triangle against the view and set up what is left
+	void ClipTriangle(BIN_SET& set, const CLIP_VERTEX* corners, int draw);
+	// set up a triangle inside the view and add it to its tiles
+	void SetupTriangle(BIN_SET& set, const CLIP_VERTEX& a, const CLIP_VERTEX& b, const CLIP_VERTEX& c, int draw);
+	// clear and draw one tile, returning the pixels shaded
+	long long RasterizeTile(int tile);
+	// draw the part of a triangle inside a rectangle of pixels
+	long long RasterizeTriangle(const SETUP_TRIANGLE& triangle, int left, int bottom, int right, int top);
+	// shade a covered pixel and blend it into the color buffer
+	void ShadePixel(const SETUP_TRIANGLE& triangle, int x, int y, float depth);
+};
@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+// spscqueue.h
+// ============
+// pass items from one thread to another through a fixed size ring without
+// taking a lock
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/***********************************************************
+ *  SpscQueue
+ *
+ *  This class contains a ring of CAPACITY items that one
+ *  producer thread pushes into and one consumer thread pops
+ *  from.  Each side only writes its own index, and the
+ *  release store of that index publishes the item to the
+ *  other side, so neither side ever waits on a lock.  The
+ *  indices count up forever and are wrapped when used.
+ ***********************************************************/
+template <typename T, size_t CAPACITY>
+class SpscQueue
+{
+public:
+	// constructor
+	SpscQueue()
+	{
+		m_head.store(0, std::memory_order_relaxed);
+		m_tail.store(0, std::memory_order_relaxed);
+	}
+
+	// add an item, or return false when the ring is full -
+	// only the producer thread may call this
+	bool TryPush(const T& item)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) >= CAPACITY)
+		{
+			return(false);
+		}
+
+		m_items[tail % CAPACITY] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return(true);
+	}
+
+	// take the oldest item, or return false when the ring is
+	// empty - only the consumer thread may call this
+	bool TryPop(T& item)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return(false);
+		}
+
+		item = m_items[head % CAPACITY];
+		m_head.store(head + 1, std::memory_order_release);
+		return(true);
+	}
+
+private:
+	T m_items[CAPACITY];
+	// the indices are on their own cache lines so the two
+	// threads do not slow each other down
+	alignas(64) std::atomic<size_t> m_head;
+	alignas(64) std::atomic<size_t> m_tail;
+};
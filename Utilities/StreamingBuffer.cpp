@@ -0,0 +1,300 @@
+///////////////////////////////////////////////////////////////////////////////
+// streamingbuffer.cpp
+// ============
+// hand out per-frame GPU memory from a mapped ring of buffer regions that
+// are guarded by fences
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StreamingBuffer.h"
+#include "GpuFence.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+/***********************************************************
+ *  StreamingBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StreamingBuffer::StreamingBuffer()
+{
+	m_target = GL_UNIFORM_BUFFER;
+	m_buffer = 0;
+	m_regionSize = 0;
+	m_alignment = 16;
+	m_bPersistent = false;
+	m_pMapped = NULL;
+	m_region = 0;
+	m_used = 0;
+	m_bInFrame = false;
+	m_bWriting = false;
+	for (int i = 0; i < REGION_COUNT; i++)
+	{
+		m_fences[i] = NULL;
+	}
+	m_stalls = 0;
+}
+
+/***********************************************************
+ *  ~StreamingBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StreamingBuffer::~StreamingBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to set up the buffer for the passed
+ *  in target.  The offsets handed out are aligned so they
+ *  can be bound as uniform buffer ranges when the target is
+ *  GL_UNIFORM_BUFFER.  The storage is created by the first
+ *  BeginFrame(), once the size of a frame is known.
+ ***********************************************************/
+void StreamingBuffer::Create(GLenum target)
+{
+	Destroy();
+
+	m_target = target;
+	m_alignment = 16;
+	if (m_target == GL_UNIFORM_BUFFER)
+	{
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_alignment);
+		m_alignment = std::max(m_alignment, 16);
+	}
+	m_regionSize = 0;
+	m_bPersistent = (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+}
+
+/***********************************************************
+ *  CreateStorage()
+ *
+ *  This method is used to create the buffer with room for
+ *  all of the regions.
+ ***********************************************************/
+bool StreamingBuffer::CreateStorage()
+{
+	GLsizeiptr totalSize = m_regionSize * REGION_COUNT;
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(m_target, m_buffer);
+	if (m_bPersistent == true)
+	{
+		// the buffer can be written while the GPU reads other
+		// regions of it, and the writes need no flushing
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(m_target, totalSize, NULL, flags);
+		m_pMapped = (unsigned char*)glMapBufferRange(m_target, 0, totalSize, flags);
+	}
+	else
+	{
+		glBufferData(m_target, totalSize, NULL, GL_STREAM_DRAW);
+	}
+	glBindBuffer(m_target, 0);
+
+	if ((m_bPersistent == true) && (NULL == m_pMapped))
+	{
+		std::cout << "Could not map the streaming buffer" << std::endl;
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+		return false;
+	}
+
+	m_region = 0;
+	m_used = 0;
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to free the buffer once the GPU has
+ *  finished reading all of its regions.
+ ***********************************************************/
+void StreamingBuffer::Destroy()
+{
+	if (m_buffer == 0)
+	{
+		return;
+	}
+
+	if (m_bInFrame == true)
+	{
+		EndFrame();
+	}
+	for (int i = 0; i < REGION_COUNT; i++)
+	{
+		WaitForRegion(i);
+	}
+
+	if (m_bPersistent == true)
+	{
+		glBindBuffer(m_target, m_buffer);
+		glUnmapBuffer(m_target);
+		glBindBuffer(m_target, 0);
+	}
+	glDeleteBuffers(1, &m_buffer);
+	m_buffer = 0;
+	m_pMapped = NULL;
+}
+
+/***********************************************************
+ *  WaitForRegion()
+ *
+ *  This method is used to block until the GPU has passed the
+ *  fence of a region, so the region can be written again.
+ ***********************************************************/
+void StreamingBuffer::WaitForRegion(int region)
+{
+	if (NULL == m_fences[region])
+	{
+		return;
+	}
+
+	GpuFence::RESULT result = GpuFence::Check(m_fences[region]);
+	if (result == GpuFence::PENDING)
+	{
+		PROFILE_SCOPE("StreamingBuffer stall");
+		m_stalls++;
+		result = GpuFence::Wait(m_fences[region]);
+	}
+	if (result == GpuFence::FAILED)
+	{
+		std::cout << "Waiting for a streaming buffer fence failed" << std::endl;
+	}
+
+	glDeleteSync(m_fences[region]);
+	m_fences[region] = NULL;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to move on to the next region.  It
+ *  returns false when there is no buffer to write into.
+ ***********************************************************/
+bool StreamingBuffer::BeginFrame(GLsizeiptr requiredSize)
+{
+	// create the storage for the first frame, or grow it when
+	// a frame needs more room, for example after objects were
+	// added to the scene - every region starts aligned
+	if ((m_buffer == 0) || (requiredSize > m_regionSize))
+	{
+		GLsizeiptr regionSize = GetAlignedSize(std::max(requiredSize, m_regionSize * 2));
+		Destroy();
+		m_regionSize = std::max<GLsizeiptr>(regionSize, m_alignment);
+		if (CreateStorage() == false)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		m_region = (m_region + 1) % REGION_COUNT;
+	}
+
+	WaitForRegion(m_region);
+	m_used = 0;
+
+	if (m_bPersistent == false)
+	{
+		// the fence already guarantees that the GPU is done
+		// with the region, so the driver does not need to sync
+		glBindBuffer(m_target, m_buffer);
+		m_pMapped = (unsigned char*)glMapBufferRange(
+			m_target,
+			m_region * m_regionSize,
+			m_regionSize,
+			GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+		glBindBuffer(m_target, 0);
+		if (NULL == m_pMapped)
+		{
+			return false;
+		}
+	}
+
+	m_bInFrame = true;
+	m_bWriting = true;
+	return true;
+}
+
+/***********************************************************
+ *  FinishWriting()
+ *
+ *  This method is used to end the writes of this frame, so
+ *  the region can be read by draw calls.  A buffer that is
+ *  not mapped persistently must be unmapped before drawing.
+ ***********************************************************/
+void StreamingBuffer::FinishWriting()
+{
+	if (m_bWriting == false)
+	{
+		return;
+	}
+	m_bWriting = false;
+
+	if (m_bPersistent == false)
+	{
+		glBindBuffer(m_target, m_buffer);
+		glUnmapBuffer(m_target);
+		glBindBuffer(m_target, 0);
+		m_pMapped = NULL;
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to place the fence after the draws
+ *  that read this frame's region.
+ ***********************************************************/
+void StreamingBuffer::EndFrame()
+{
+	if (m_bInFrame == false)
+	{
+		return;
+	}
+	m_bInFrame = false;
+	FinishWriting();
+
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used to bump allocate bytes from the
+ *  region of the current frame.  The returned memory is
+ *  only written, never read, since it may be uncached.
+ ***********************************************************/
+void* StreamingBuffer::Allocate(GLsizeiptr size, GLintptr& offset)
+{
+	GLsizeiptr alignedSize = GetAlignedSize(size);
+	if ((m_bWriting == false) || (m_used + alignedSize > m_regionSize))
+	{
+		return(NULL);
+	}
+
+	GLintptr regionStart = m_region * m_regionSize;
+	offset = regionStart + m_used;
+	unsigned char* pointer = m_bPersistent ? m_pMapped + offset : m_pMapped + m_used;
+	m_used += alignedSize;
+
+	return(pointer);
+}
+
+/***********************************************************
+ *  GetAlignedSize()
+ *
+ *  This method is used to get the number of bytes that an
+ *  allocation of the passed in size takes up in a region.
+ ***********************************************************/
+GLsizeiptr StreamingBuffer::GetAlignedSize(GLsizeiptr size) const
+{
+	return(((size + m_alignment - 1) / m_alignment) * m_alignment);
+}
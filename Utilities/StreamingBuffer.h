@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// streamingbuffer.h
+// ============
+// hand out per-frame GPU memory from a mapped ring of buffer regions that
+// are guarded by fences
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  StreamingBuffer
+ *
+ *  This class contains one OpenGL buffer split into
+ *  REGION_COUNT regions, one for each frame in flight.  The
+ *  data of a frame is bump allocated from its region and
+ *  written straight into the mapped memory, so the driver
+ *  never copies it.  A fence is placed after the last draw
+ *  of each frame, and a region is only written again once
+ *  the GPU has passed its fence.
+ *
+ *  A frame writes all of its data first and then draws
+ *  from it.  With OpenGL 4.4 or ARB_buffer_storage the buffer
+ *  is mapped once, persistently and coherently.  Otherwise
+ *  each region is mapped unsynchronized at the start of its
+ *  frame and unmapped before drawing, which the fences make
+ *  just as safe.
+ ***********************************************************/
+class StreamingBuffer
+{
+public:
+	// frames that can be written and drawn at the same time
+	static const int REGION_COUNT = 3;
+
+	// constructor
+	StreamingBuffer();
+	// destructor
+	~StreamingBuffer();
+
+	// set up the buffer for the passed in target - the storage
+	// is sized by the first frame
+	void Create(GLenum target);
+	// wait for the GPU to finish with the buffer, then free it
+	void Destroy();
+
+	// start writing the next region, waiting for its fence if
+	// the GPU still reads from it - the storage is created or
+	// grown first when a frame needs more than the region size
+	bool BeginFrame(GLsizeiptr requiredSize);
+	// end the writes of this frame before drawing from it
+	void FinishWriting();
+	// fence the region after the last draw that reads it
+	void EndFrame();
+
+	// reserve the passed in number of bytes in this frame's
+	// region and return where to write them, or NULL when the
+	// region is full or the writes are finished - offset is
+	// set to the start of the bytes in the buffer, aligned for
+	// binding them
+	void* Allocate(GLsizeiptr size, GLintptr& offset);
+	// the passed in size rounded up to the binding alignment
+	GLsizeiptr GetAlignedSize(GLsizeiptr size) const;
+
+	GLuint GetBuffer() const { return(m_buffer); }
+	// true when the buffer stays mapped for its whole life
+	bool IsPersistent() const { return(m_bPersistent); }
+	// number of frames that had to wait for the GPU
+	int GetStallCount() const { return(m_stalls); }
+
+private:
+	GLenum m_target;
+	GLuint m_buffer;
+	GLsizeiptr m_regionSize;
+	// alignment of the offsets returned by Allocate()
+	GLint m_alignment;
+	bool m_bPersistent;
+	// start of the whole mapped buffer when persistent,
+	// otherwise of the current region while it is mapped
+	unsigned char* m_pMapped;
+	// region being written and the bytes used in it so far
+	int m_region;
+	GLsizeiptr m_used;
+	bool m_bInFrame;
+	bool m_bWriting;
+	// fence placed after the last frame written to each region
+	GLsync m_fences[REGION_COUNT];
+	int m_stalls;
+
+	// create the buffer storage and map it when persistent
+	bool CreateStorage();
+	// wait until the GPU has passed a region's fence
+	void WaitForRegion(int region);
+};
@@ -0,0 +1,429 @@
+///////////////////////////////////////////////////////////////////////////////
+// tilecoordinator.cpp
+// ============
+// split a large frame into tiles, have render service processes draw them
+// and stitch the tiles back into one image
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TileCoordinator.h"
+#include "LocalSocket.h"
+#include "Profiler.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+// declaration of the global variables and defines
+namespace
+{
+	// time between the tries to reach a starting worker
+	const int g_ConnectRetryMilliseconds = 50;
+
+#ifdef _WIN32
+	// the workers are reached over AF_UNIX sockets and started
+	// with posix_spawn(), which are not set up on Windows
+	int StartProcess(const std::string& program, const std::vector<std::string>&)
+	{
+		std::cout << "Could not start:" << program
+			<< " - distributed rendering is not supported on this platform" << std::endl;
+		return(-1);
+	}
+	bool IsProcessRunning(int) { return(false); }
+	void WaitForProcess(int, bool) {}
+	int GetProcessId() { return(0); }
+#else
+	int StartProcess(const std::string& program, const std::vector<std::string>& arguments)
+	{
+		std::vector<char*> argv;
+		argv.push_back(const_cast<char*>(program.c_str()));
+		for (size_t i = 0; i < arguments.size(); i++)
+		{
+			argv.push_back(const_cast<char*>(arguments[i].c_str()));
+		}
+		argv.push_back(NULL);
+
+		// the workers print their results too, so their output goes
+		// to stderr and stdout is left to the coordinator
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+		posix_spawn_file_actions_adddup2(&actions, STDERR_FILENO, STDOUT_FILENO);
+		pid_t process = -1;
+		int result = posix_spawn(&process, program.c_str(), &actions, NULL, argv.data(), environ);
+		posix_spawn_file_actions_destroy(&actions);
+		if (result != 0)
+		{
+			std::cout << "Could not start:" << program << " - " << strerror(result) << std::endl;
+			return(-1);
+		}
+		return((int)process);
+	}
+
+	bool IsProcessRunning(int process)
+	{
+		int status = 0;
+		return(waitpid((pid_t)process, &status, WNOHANG) == 0);
+	}
+
+	// wait for a process to exit, ending it first when asked
+	void WaitForProcess(int process, bool bTerminate)
+	{
+		if (bTerminate == true)
+		{
+			kill((pid_t)process, SIGTERM);
+		}
+		int status = 0;
+		while ((waitpid((pid_t)process, &status, 0) < 0) && (errno == EINTR))
+		{
+		}
+	}
+
+	int GetProcessId()
+	{
+		return((int)getpid());
+	}
+#endif
+
+	// read the header line of an answer, a byte at a time so
+	// none of the bytes after it are taken
+	bool ReadLine(int connection, std::string& line)
+	{
+		line.clear();
+		char character = 0;
+		while (LocalSocket::ReadAll(connection, &character, 1) == true)
+		{
+			if (character == '\n')
+			{
+				return(true);
+			}
+			line.push_back(character);
+		}
+		return(false);
+	}
+
+	// send a request line and read the header of the answer
+	bool Ask(int connection, const std::string& request, std::string& header)
+	{
+		std::string line = request + "\n";
+		return((LocalSocket::WriteAll(connection, line.data(), line.size()) == true) &&
+			(ReadLine(connection, header) == true));
+	}
+}
+
+/***********************************************************
+ *  TileCoordinator()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TileCoordinator::TileCoordinator()
+{
+	m_tilesInFlight = 0;
+	m_activeWorkers = 0;
+	m_retriedTiles = 0;
+	m_bFailed = false;
+	m_view = VIEW();
+	m_frameWidth = 0;
+	m_frameHeight = 0;
+	m_pImage = NULL;
+}
+
+/***********************************************************
+ *  ~TileCoordinator()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TileCoordinator::~TileCoordinator()
+{
+	StopWorkers();
+}
+
+/***********************************************************
+ *  StartWorkers()
+ *
+ *  This method is used to start the render services and
+ *  wait until each of them accepts a connection, so the
+ *  time they take to load the scene is not part of a frame.
+ ***********************************************************/
+bool TileCoordinator::StartWorkers(
+	const std::string& program,
+	const std::vector<std::string>& arguments,
+	int count,
+	const std::string& directory,
+	int timeoutMilliseconds)
+{
+	StopWorkers();
+
+	for (int i = 0; i < count; i++)
+	{
+		WORKER worker;
+		worker.socketPath = directory + "/scene_tiles_" + std::to_string(GetProcessId()) +
+			"_" + std::to_string(i) + ".sock";
+		worker.statistics = WORKER_STATISTICS();
+
+		std::vector<std::string> workerArguments = arguments;
+		workerArguments.push_back("--service");
+		workerArguments.push_back(worker.socketPath);
+		worker.process = StartProcess(program, workerArguments);
+		if (worker.process < 0)
+		{
+			StopWorkers();
+			return false;
+		}
+		m_workers.push_back(worker);
+	}
+
+	std::chrono::steady_clock::time_point deadline =
+		std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMilliseconds);
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		while (true)
+		{
+			int connection = LocalSocket::Connect(m_workers[i].socketPath.c_str());
+			if (connection >= 0)
+			{
+				LocalSocket::Close(connection);
+				break;
+			}
+			if ((IsProcessRunning(m_workers[i].process) == false) ||
+				(std::chrono::steady_clock::now() > deadline))
+			{
+				std::cout << "Could not reach the render worker:" << m_workers[i].socketPath << std::endl;
+				StopWorkers();
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(g_ConnectRetryMilliseconds));
+		}
+	}
+	return true;
+}
+
+/***********************************************************
+ *  StopWorkers()
+ *
+ *  This method is used to ask each render service to shut
+ *  down and wait for it, ending the ones that do not answer.
+ ***********************************************************/
+void TileCoordinator::StopWorkers()
+{
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		bool bStopped = false;
+		int connection = LocalSocket::Connect(m_workers[i].socketPath.c_str());
+		if (connection >= 0)
+		{
+			std::string header;
+			bStopped = (Ask(connection, "shutdown", header) == true) && (header == "ok");
+			LocalSocket::Close(connection);
+		}
+		WaitForProcess(m_workers[i].process, bStopped == false);
+		LocalSocket::RemoveFile(m_workers[i].socketPath.c_str());
+	}
+	m_workers.clear();
+}
+
+/***********************************************************
+ *  RenderFrame()
+ *
+ *  This method is used to split the frame into tiles and
+ *  have the workers draw them, each from its own thread.
+ *  The tiles are copied into the image as they arrive.
+ ***********************************************************/
+bool TileCoordinator::RenderFrame(const VIEW& view, int width, int height, int tileSize, std::vector<unsigned char>& rgb)
+{
+	PROFILE_FUNCTION();
+
+	if ((m_workers.empty() == true) || (width <= 0) || (height <= 0) || (tileSize <= 0))
+	{
+		return false;
+	}
+
+	rgb.assign((size_t)width * height * 3, 0);
+	m_view = view;
+	m_frameWidth = width;
+	m_frameHeight = height;
+	m_pImage = rgb.data();
+	m_tiles.clear();
+	m_pendingTiles.clear();
+	for (int y = 0; y < height; y += tileSize)
+	{
+		for (int x = 0; x < width; x += tileSize)
+		{
+			TILE tile;
+			tile.x = x;
+			tile.y = y;
+			tile.width = std::min(tileSize, width - x);
+			tile.height = std::min(tileSize, height - y);
+			m_tiles.push_back(tile);
+		}
+	}
+	// the workers take the tiles from the back, so the first
+	// tile is drawn first
+	for (int i = (int)m_tiles.size() - 1; i >= 0; i--)
+	{
+		m_pendingTiles.push_back(i);
+	}
+	m_tilesInFlight = 0;
+	m_activeWorkers = (int)m_workers.size();
+	m_retriedTiles = 0;
+	m_bFailed = false;
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].statistics = WORKER_STATISTICS();
+		threads.push_back(std::thread(&TileCoordinator::WorkerLoop, this, &m_workers[i]));
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+
+	m_pImage = NULL;
+	return((m_bFailed == false) && (m_pendingTiles.empty() == true));
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is run by the thread of each worker for a
+ *  frame.  It asks its worker for one tile after the other
+ *  as a region of the frame, with the RGB pixels answered
+ *  directly, until no tile is left or the worker is lost.
+ ***********************************************************/
+void TileCoordinator::WorkerLoop(WORKER* pWorker)
+{
+	Profiler::SetThreadName("Tile worker");
+
+	int connection = LocalSocket::Connect(pWorker->socketPath.c_str());
+	bool bLost = (connection < 0);
+	std::vector<unsigned char> pixels;
+	int tile = 0;
+	while ((connection >= 0) && (TakeTile(tile) == true))
+	{
+		PROFILE_SCOPE("RenderTile");
+
+		const TILE& region = m_tiles[tile];
+		std::ostringstream request;
+		request << "render " << m_view.position.x << " " << m_view.position.y << " " << m_view.position.z
+			<< " " << m_view.yaw << " " << m_view.pitch
+			<< " " << region.width << " " << region.height
+			<< " raw region " << region.x << " " << region.y << " " << m_frameWidth << " " << m_frameHeight;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::string header;
+		if (Ask(connection, request.str(), header) == false)
+		{
+			FinishTile(tile, false);
+			bLost = true;
+			break;
+		}
+
+		std::istringstream words(header);
+		std::string status;
+		std::string format;
+		size_t size = 0;
+		words >> status >> format >> size;
+		if ((status != "ok") || (format != "rgb") || (size != (size_t)region.width * region.height * 3))
+		{
+			// the worker is reachable but will not draw the tile,
+			// so no other worker would either
+			std::cout << "Could not render a tile:" << header << std::endl;
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_bFailed = true;
+			m_tilesInFlight--;
+			m_tileCondition.notify_all();
+			break;
+		}
+		pixels.resize(size);
+		if (LocalSocket::ReadAll(connection, pixels.data(), size) == false)
+		{
+			FinishTile(tile, false);
+			bLost = true;
+			break;
+		}
+
+		// the tiles do not overlap, so no lock is needed
+		size_t rowBytes = (size_t)region.width * 3;
+		for (int y = 0; y < region.height; y++)
+		{
+			memcpy(
+				m_pImage + ((size_t)(region.y + y) * m_frameWidth + region.x) * 3,
+				pixels.data() + (size_t)y * rowBytes,
+				rowBytes);
+		}
+		pWorker->statistics.tiles++;
+		pWorker->statistics.milliseconds += std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+		FinishTile(tile, true);
+	}
+
+	if (connection >= 0)
+	{
+		LocalSocket::Close(connection);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	pWorker->statistics.bFailed = bLost;
+	m_activeWorkers--;
+	if ((m_activeWorkers == 0) && (m_pendingTiles.empty() == false))
+	{
+		m_bFailed = true;
+	}
+	m_tileCondition.notify_all();
+}
+
+/***********************************************************
+ *  TakeTile()
+ *
+ *  This method is used to take the next tile to draw.  When
+ *  none is waiting but others are still being drawn, it
+ *  waits, since a lost worker hands its tile back.
+ ***********************************************************/
+bool TileCoordinator::TakeTile(int& tile)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_tileCondition.wait(lock, [this]() {
+		return((m_bFailed == true) || (m_pendingTiles.empty() == false) || (m_tilesInFlight == 0));
+	});
+	if ((m_bFailed == true) || (m_pendingTiles.empty() == true))
+	{
+		return false;
+	}
+
+	tile = m_pendingTiles.back();
+	m_pendingTiles.pop_back();
+	m_tilesInFlight++;
+	return true;
+}
+
+/***********************************************************
+ *  FinishTile()
+ *
+ *  This method is used to hand back a tile once it was
+ *  drawn, or to queue it again for the other workers when
+ *  its worker was lost.
+ ***********************************************************/
+void TileCoordinator::FinishTile(int tile, bool bDrawn)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_tilesInFlight--;
+	if (bDrawn == false)
+	{
+		m_pendingTiles.push_back(tile);
+		m_retriedTiles++;
+	}
+	m_tileCondition.notify_all();
+}
@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////////
+// tilecoordinator.h
+// ============
+// split a large frame into tiles, have render service processes draw them
+// and stitch the tiles back into one image
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TileCoordinator
+ *
+ *  This class contains the coordinating side of distributed
+ *  rendering.  It starts copies of the program as render
+ *  services, each on its own socket, and splits a frame into
+ *  square tiles.  Every worker gets a thread that connects
+ *  to it and asks for one tile after the other as a region
+ *  of the whole frame, so each worker draws only its part of
+ *  the view, and copies the answered pixels into the image.
+ *
+ *  The tiles are handed out one at a time, so a fast worker
+ *  draws more of them.  When a worker cannot be reached any
+ *  more, the tile it was drawing goes back to the others;
+ *  the frame only fails once no worker is left or a worker
+ *  refused a tile.
+ ***********************************************************/
+class TileCoordinator
+{
+public:
+	// the camera the frame is seen from
+	struct VIEW
+	{
+		glm::vec3 position;
+		float yaw;
+		float pitch;
+	};
+
+	// the tiles one worker drew for the last frame
+	struct WORKER_STATISTICS
+	{
+		int tiles;
+		// time from asking for its tiles to receiving them, summed
+		double milliseconds;
+		bool bFailed;
+	};
+
+	// constructor
+	TileCoordinator();
+	// destructor
+	~TileCoordinator();
+
+	// start count copies of the program as render services in
+	// the passed in directory - the arguments are passed to
+	// each, followed by its --service socket - and wait until
+	// they all answer
+	bool StartWorkers(
+		const std::string& program,
+		const std::vector<std::string>& arguments,
+		int count,
+		const std::string& directory,
+		int timeoutMilliseconds);
+	// ask the workers to shut down and wait for them to exit
+	void StopWorkers();
+
+	// render a width * height frame in tiles of tileSize pixels
+	// into RGB pixels with the top row first
+	bool RenderFrame(const VIEW& view, int width, int height, int tileSize, std::vector<unsigned char>& rgb);
+
+	int GetWorkerCount() const { return((int)m_workers.size()); }
+	int GetTileCount() const { return((int)m_tiles.size()); }
+	// tiles drawn again after their worker was lost
+	int GetRetriedTiles() const { return(m_retriedTiles); }
+	WORKER_STATISTICS GetWorkerStatistics(int worker) const { return(m_workers[worker].statistics); }
+
+private:
+	// one started render service
+	struct WORKER
+	{
+		std::string socketPath;
+		int process;
+		WORKER_STATISTICS statistics;
+	};
+
+	// one rectangle of the frame
+	struct TILE
+	{
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	std::vector<WORKER> m_workers;
+	// the frame being rendered - shared with the worker
+	// threads under m_mutex
+	std::mutex m_mutex;
+	std::condition_variable m_tileCondition;
+	std::vector<TILE> m_tiles;
+	std::vector<int> m_pendingTiles;
+	// tiles being drawn, which may still come back
+	int m_tilesInFlight;
+	int m_activeWorkers;
+	int m_retriedTiles;
+	bool m_bFailed;
+	VIEW m_view;
+	int m_frameWidth;
+	int m_frameHeight;
+	unsigned char* m_pImage;
+
+	// run by the thread of each worker for a frame
+	void WorkerLoop(WORKER* pWorker);
+	// take the next tile to draw, waiting while the tiles being
+	// drawn may still come back - returns false when none is left
+	bool TakeTile(int& tile);
+	// hand back a tile that was drawn, or could not be
+	void FinishTile(int tile, bool bDrawn);
+};
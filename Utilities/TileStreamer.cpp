@@ -0,0 +1,404 @@
+///////////////////////////////////////////////////////////////////////////////
+// tilestreamer.cpp
+// ============
+// keep the tiles of a large world loaded around the camera, loading them
+// on a background thread nearest first within a memory budget
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TileStreamer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+
+// declaration of the global variables and defines
+namespace
+{
+	// load radius and memory budget until they are set
+	const float g_DefaultLoadRadius = 150.0f;
+	const size_t g_DefaultMemoryBudget = 256 * 1024 * 1024;
+}
+
+/***********************************************************
+ *  TileStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TileStreamer::TileStreamer()
+{
+	m_tileSize = 0.0f;
+	m_loadRadius = g_DefaultLoadRadius;
+	m_memoryBudget = g_DefaultMemoryBudget;
+	m_residentBytes = 0;
+	m_residentCount = 0;
+	m_loadingTile = -1;
+	m_bQuit = false;
+}
+
+/***********************************************************
+ *  ~TileStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TileStreamer::~TileStreamer()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  OpenWorld()
+ *
+ *  This method is used to read a world file.  It holds the
+ *  size of the tiles and a line for each tile with its file
+ *  and bounds:
+ *
+ *    tile_size <size>
+ *    tile <file> <min x y z> <max x y z>
+ *
+ *  The files are relative to the world file.
+ ***********************************************************/
+bool TileStreamer::OpenWorld(const char* filename)
+{
+	m_tiles.clear();
+	m_residentBytes = 0;
+	m_residentCount = 0;
+
+	std::ifstream file(filename);
+	if (file.is_open() == false)
+	{
+		std::cout << "Could not open the world file:" << filename << std::endl;
+		return false;
+	}
+
+	std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream stream(line);
+		std::string keyword;
+		if (!(stream >> keyword))
+		{
+			continue;
+		}
+
+		bool bValid = false;
+		if (keyword == "tile_size")
+		{
+			bValid = (stream >> m_tileSize) && (m_tileSize > 0.0f);
+		}
+		else if (keyword == "tile")
+		{
+			TILE tile = {};
+			std::string tileFilename;
+			bValid = (bool)(stream >> tileFilename
+				>> tile.minCorner.x >> tile.minCorner.y >> tile.minCorner.z
+				>> tile.maxCorner.x >> tile.maxCorner.y >> tile.maxCorner.z);
+			if (bValid == true)
+			{
+				tile.filename = (directory / tileFilename).string();
+
+				// the file size stands in for the tile's bytes
+				// until the tile is loaded
+				std::error_code error;
+				uintmax_t fileSize = std::filesystem::file_size(tile.filename, error);
+				tile.bytes = error ? 0 : (size_t)fileSize;
+				m_tiles.push_back(tile);
+			}
+		}
+
+		if (bValid == false)
+		{
+			std::cout << "Could not parse line " << lineNumber << " of the world file:" << filename << std::endl;
+			m_tiles.clear();
+			return false;
+		}
+	}
+
+	if (m_tileSize <= 0.0f)
+	{
+		std::cout << "The world file has no tile size:" << filename << std::endl;
+		m_tiles.clear();
+		return false;
+	}
+
+	m_candidates.reserve(m_tiles.size());
+	m_requests.reserve(m_tiles.size());
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_loadStates.assign(m_tiles.size(), LOAD_IDLE);
+	}
+	std::cout << "Opened world file:" << filename << ", tiles:" << m_tiles.size() << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used to start the loading thread with the
+ *  passed in functions.
+ ***********************************************************/
+void TileStreamer::Start(const LOAD_FUNCTION& load, const RELEASE_FUNCTION& release)
+{
+	if (m_thread.joinable() == true)
+	{
+		return;
+	}
+
+	m_load = load;
+	m_release = release;
+	m_bQuit = false;
+	m_thread = std::thread(&TileStreamer::ThreadLoop, this);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used to stop the loading thread once the
+ *  tile it is loading is done.  Tiles that were loaded but
+ *  not handed back yet are released.
+ ***********************************************************/
+void TileStreamer::Stop()
+{
+	if (m_thread.joinable() == false)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bQuit = true;
+		m_requests.clear();
+	}
+	m_wakeCondition.notify_one();
+	m_thread.join();
+
+	std::fill(m_loadStates.begin(), m_loadStates.end(), LOAD_IDLE);
+
+	for (size_t i = 0; i < m_loaded.size(); i++)
+	{
+		if (NULL != m_loaded[i].pContent)
+		{
+			m_release(m_loaded[i].pContent);
+		}
+	}
+	m_loaded.clear();
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to update the tiles once a frame.
+ *  The tiles that finished loading become resident, then
+ *  the tiles within reach are walked nearest first.  While
+ *  they fit into the budget the ones that are not resident
+ *  are requested, and once one does not fit, the resident
+ *  tiles beyond it are evicted.  Resident tiles out of reach
+ *  are evicted as well.
+ *
+ *  A tile is only requested while the loading thread does
+ *  not hold it, which its load state under the mutex tells,
+ *  so it is never loaded twice.
+ ***********************************************************/
+void TileStreamer::Update(
+	const glm::vec3& cameraPosition,
+	std::vector<void*>& arrivedContents,
+	std::vector<void*>& evictedContents)
+{
+	PROFILE_FUNCTION();
+
+	arrivedContents.clear();
+	evictedContents.clear();
+
+	int loadingTile = -1;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_arrived.swap(m_loaded);
+		loadingTile = m_loadingTile;
+		for (size_t i = 0; i < m_arrived.size(); i++)
+		{
+			m_loadStates[m_arrived[i].tile] = LOAD_IDLE;
+		}
+	}
+
+	for (size_t i = 0; i < m_arrived.size(); i++)
+	{
+		TILE& tile = m_tiles[m_arrived[i].tile];
+		if (NULL == m_arrived[i].pContent)
+		{
+			std::cout << "Could not load the world tile:" << tile.filename << std::endl;
+			tile.bFailed = true;
+			continue;
+		}
+		// a second copy of a resident tile is not used
+		if (NULL != tile.pContent)
+		{
+			m_release(m_arrived[i].pContent);
+			continue;
+		}
+
+		tile.pContent = m_arrived[i].pContent;
+		tile.bytes = m_arrived[i].bytes;
+		m_residentBytes += tile.bytes;
+		m_residentCount++;
+		arrivedContents.push_back(tile.pContent);
+	}
+	m_arrived.clear();
+
+	// resident tiles stay until they are a whole tile farther
+	// than the load radius, so a camera moving back and forth
+	// over a tile's edge does not load it again and again
+	float evictRadius = m_loadRadius + m_tileSize;
+	m_candidates.clear();
+	for (size_t i = 0; i < m_tiles.size(); i++)
+	{
+		TILE& tile = m_tiles[i];
+		float dx = std::max(std::max(tile.minCorner.x - cameraPosition.x, cameraPosition.x - tile.maxCorner.x), 0.0f);
+		float dz = std::max(std::max(tile.minCorner.z - cameraPosition.z, cameraPosition.z - tile.maxCorner.z), 0.0f);
+		tile.distance = std::sqrt(dx * dx + dz * dz);
+
+		if (NULL != tile.pContent)
+		{
+			if (tile.distance > evictRadius)
+			{
+				EvictTile(tile, evictedContents);
+			}
+			else
+			{
+				m_candidates.push_back((int)i);
+			}
+		}
+		else if ((tile.distance <= m_loadRadius) && (tile.bFailed == false) && ((int)i != loadingTile))
+		{
+			m_candidates.push_back((int)i);
+		}
+	}
+
+	std::sort(m_candidates.begin(), m_candidates.end(), [this](int a, int b) {
+		return(m_tiles[a].distance < m_tiles[b].distance);
+	});
+
+	// the tile being loaded is already part of the budget
+	size_t bytes = (loadingTile >= 0) ? m_tiles[loadingTile].bytes : 0;
+	int requestCount = 0;
+	bool bFull = false;
+	for (size_t i = 0; i < m_candidates.size(); i++)
+	{
+		TILE& tile = m_tiles[m_candidates[i]];
+		if ((bFull == false) && (bytes + tile.bytes <= m_memoryBudget))
+		{
+			bytes += tile.bytes;
+			if (NULL == tile.pContent)
+			{
+				m_candidates[requestCount++] = m_candidates[i];
+			}
+		}
+		else
+		{
+			bFull = true;
+			if (NULL != tile.pContent)
+			{
+				EvictTile(tile, evictedContents);
+			}
+		}
+	}
+	m_candidates.resize(requestCount);
+
+	// the thread may have taken a tile since the lists were
+	// swapped, which is then left to it
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < m_requests.size(); i++)
+		{
+			if (m_loadStates[m_requests[i]] == LOAD_REQUESTED)
+			{
+				m_loadStates[m_requests[i]] = LOAD_IDLE;
+			}
+		}
+		m_requests.clear();
+		for (size_t i = 0; i < m_candidates.size(); i++)
+		{
+			if (m_loadStates[m_candidates[i]] == LOAD_IDLE)
+			{
+				m_loadStates[m_candidates[i]] = LOAD_REQUESTED;
+				m_requests.push_back(m_candidates[i]);
+			}
+		}
+		requestCount = (int)m_requests.size();
+	}
+	if (requestCount > 0)
+	{
+		m_wakeCondition.notify_one();
+	}
+}
+
+/***********************************************************
+ *  EvictTile()
+ *
+ *  This method is used to hand the content of a resident
+ *  tile back to the owner and take it out of the budget.
+ ***********************************************************/
+void TileStreamer::EvictTile(TILE& tile, std::vector<void*>& evictedContents)
+{
+	evictedContents.push_back(tile.pContent);
+	tile.pContent = NULL;
+	m_residentBytes -= tile.bytes;
+	m_residentCount--;
+}
+
+/***********************************************************
+ *  ThreadLoop()
+ *
+ *  This method is run by the loading thread.  It loads the
+ *  nearest requested tile, one at a time, until it is told
+ *  to quit.  A request for a tile that is no longer in the
+ *  requested state is dropped.
+ ***********************************************************/
+void TileStreamer::ThreadLoop()
+{
+	Profiler::SetThreadName("Tile streamer");
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wakeCondition.wait(lock, [this]() { return((m_bQuit == true) || (m_requests.empty() == false)); });
+		if (m_bQuit == true)
+		{
+			break;
+		}
+
+		int index = m_requests.front();
+		m_requests.erase(m_requests.begin());
+		if (m_loadStates[index] != LOAD_REQUESTED)
+		{
+			continue;
+		}
+		m_loadStates[index] = LOAD_LOADING;
+		m_loadingTile = index;
+		lock.unlock();
+
+		// only the file name is read, which never changes
+		// once the world is open
+		LOADED_TILE loaded;
+		loaded.tile = index;
+		loaded.bytes = 0;
+		{
+			PROFILE_SCOPE("LoadTile");
+			loaded.pContent = m_load(m_tiles[index].filename, loaded.bytes);
+		}
+
+		lock.lock();
+		m_loaded.push_back(loaded);
+		m_loadStates[index] = LOAD_LOADED;
+		m_loadingTile = -1;
+	}
+}
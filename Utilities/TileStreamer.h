@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+// tilestreamer.h
+// ============
+// keep the tiles of a large world loaded around the camera, loading them
+// on a background thread nearest first within a memory budget
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TileStreamer
+ *
+ *  This class contains the code for streaming the tiles of
+ *  a world.  A world file lists the tiles with their files
+ *  and bounds.  Each frame Update() measures how far the
+ *  camera is from every tile, evicts the tiles that fell out
+ *  of range and hands the tiles in range to a background
+ *  thread, nearest first.  The thread loads one tile at a
+ *  time with the load function, and the loaded tiles are
+ *  handed back by the next Update().
+ *
+ *  The memory budget caps the bytes of the resident tiles
+ *  and of the tile being loaded.  A tile's bytes are only
+ *  known once it is loaded, until then the size of its file
+ *  stands in for them.  When the budget is exceeded the
+ *  farthest tiles are evicted first.
+ *
+ *  The streamer never frees the content it handed back - the
+ *  owner keeps it while it is resident and frees it once an
+ *  evicted tile is no longer drawn.
+ ***********************************************************/
+class TileStreamer
+{
+public:
+	// one tile of the world
+	struct TILE
+	{
+		std::string filename;
+		// bounds of the tile's objects
+		glm::vec3 minCorner;
+		glm::vec3 maxCorner;
+		// bytes the tile takes when it is resident
+		size_t bytes;
+		// content returned by the load function, while resident
+		void* pContent;
+		// the tile failed to load and is not tried again
+		bool bFailed;
+		// distance from the camera to the tile in the XZ plane
+		float distance;
+	};
+
+	// function run on the background thread that loads the file
+	// of a tile and returns its content and size, or NULL when
+	// the tile cannot be loaded
+	typedef std::function<void*(const std::string& filename, size_t& bytes)> LOAD_FUNCTION;
+	// function that frees content that was never handed back
+	typedef std::function<void(void* pContent)> RELEASE_FUNCTION;
+
+	// constructor
+	TileStreamer();
+	// destructor
+	~TileStreamer();
+
+	// read the tiles of a world file
+	bool OpenWorld(const char* filename);
+	// start and stop the loading thread
+	void Start(const LOAD_FUNCTION& load, const RELEASE_FUNCTION& release);
+	void Stop();
+
+	// tiles closer than the radius are loaded, and resident
+	// tiles are evicted once they are a tile size farther
+	void SetLoadRadius(float radius) { m_loadRadius = radius; }
+	// most bytes of the resident tiles
+	void SetMemoryBudget(size_t bytes) { m_memoryBudget = bytes; }
+
+	// update the tiles for the camera position - the content of
+	// the tiles that finished loading and of the evicted tiles
+	// is returned
+	void Update(
+		const glm::vec3& cameraPosition,
+		std::vector<void*>& arrivedContents,
+		std::vector<void*>& evictedContents);
+
+	int GetTileCount() const { return((int)m_tiles.size()); }
+	const TILE& GetTile(int index) const { return(m_tiles[index]); }
+	float GetTileSize() const { return(m_tileSize); }
+	size_t GetResidentBytes() const { return(m_residentBytes); }
+	int GetResidentCount() const { return(m_residentCount); }
+
+private:
+	// where a tile is on its way to the loading thread and back
+	enum LOAD_STATE
+	{
+		// not asked for, or handed back to Update()
+		LOAD_IDLE,
+		// in the request list
+		LOAD_REQUESTED,
+		// being loaded by the thread
+		LOAD_LOADING,
+		// in the loaded list, waiting for Update()
+		LOAD_LOADED
+	};
+
+	// a tile that the loading thread finished
+	struct LOADED_TILE
+	{
+		int tile;
+		void* pContent;
+		size_t bytes;
+	};
+
+	std::vector<TILE> m_tiles;
+	float m_tileSize;
+	float m_loadRadius;
+	size_t m_memoryBudget;
+	size_t m_residentBytes;
+	int m_residentCount;
+	LOAD_FUNCTION m_load;
+	RELEASE_FUNCTION m_release;
+
+	// scratch lists of Update(), kept to reuse their memory
+	std::vector<int> m_candidates;
+	std::vector<LOADED_TILE> m_arrived;
+
+	// shared with the loading thread under m_mutex - the tiles
+	// to load nearest first, the load state of each tile, the
+	// tile being loaded and the tiles that finished loading
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_wakeCondition;
+	std::vector<int> m_requests;
+	std::vector<LOAD_STATE> m_loadStates;
+	int m_loadingTile;
+	std::vector<LOADED_TILE> m_loaded;
+	bool m_bQuit;
+
+	// run by the loading thread
+	void ThreadLoop();
+	// take a resident tile out of the budget
+	void EvictTile(TILE& tile, std::vector<void*>& evictedContents);
+};
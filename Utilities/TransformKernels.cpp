@@ -0,0 +1,288 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformkernels.cpp
+// ============
+// build model matrices from scale, Euler rotation and position values
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformKernels.h"
+
+#include <cmath>
+
+// SSE2 is always available on x64 targets and NEON on 64-bit ARM,
+// so the batch version uses whichever the compiler allows
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define TRANSFORM_USE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TRANSFORM_USE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	const float g_DegreesToRadians = 3.14159265358979f / 180.0f;
+
+	// the upper three rows of a column major model matrix,
+	// stored as m[column][row]
+	template <typename T>
+	struct TRS_COLUMNS
+	{
+		T m[4][3];
+	};
+
+	// combine the sine and cosine of the three angles with the
+	// scale into the matrix columns - the rotation is Rz * Ry * Rx
+	template <typename T>
+	void CombineTRS(
+		const T& sx, const T& cx,
+		const T& sy, const T& cy,
+		const T& sz, const T& cz,
+		const T& scaleX, const T& scaleY, const T& scaleZ,
+		const T& positionX, const T& positionY, const T& positionZ,
+		TRS_COLUMNS<T>& out)
+	{
+		T sysx = sy * sx;
+		T sycx = sy * cx;
+
+		out.m[0][0] = (cz * cy) * scaleX;
+		out.m[0][1] = (sz * cy) * scaleX;
+		out.m[0][2] = (T(0.0f) - sy) * scaleX;
+
+		out.m[1][0] = (cz * sysx - sz * cx) * scaleY;
+		out.m[1][1] = (sz * sysx + cz * cx) * scaleY;
+		out.m[1][2] = (cy * sx) * scaleY;
+
+		out.m[2][0] = (cz * sycx + sz * sx) * scaleZ;
+		out.m[2][1] = (sz * sycx - cz * sx) * scaleZ;
+		out.m[2][2] = (cy * cx) * scaleZ;
+
+		out.m[3][0] = positionX;
+		out.m[3][1] = positionY;
+		out.m[3][2] = positionZ;
+	}
+
+#if defined(TRANSFORM_USE_SSE2) || defined(TRANSFORM_USE_NEON)
+
+	// four float lanes with the operators used by CombineTRS,
+	// so the same code builds four matrices at once
+	struct FLOAT4
+	{
+#if defined(TRANSFORM_USE_SSE2)
+		__m128 v;
+		FLOAT4() {}
+		FLOAT4(__m128 value) : v(value) {}
+		explicit FLOAT4(float value) : v(_mm_set1_ps(value)) {}
+		static FLOAT4 Load(const float* p) { return(FLOAT4(_mm_loadu_ps(p))); }
+		friend FLOAT4 operator+(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(_mm_add_ps(a.v, b.v))); }
+		friend FLOAT4 operator-(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(_mm_sub_ps(a.v, b.v))); }
+		friend FLOAT4 operator*(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(_mm_mul_ps(a.v, b.v))); }
+#else
+		float32x4_t v;
+		FLOAT4() {}
+		FLOAT4(float32x4_t value) : v(value) {}
+		explicit FLOAT4(float value) : v(vdupq_n_f32(value)) {}
+		static FLOAT4 Load(const float* p) { return(FLOAT4(vld1q_f32(p))); }
+		friend FLOAT4 operator+(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(vaddq_f32(a.v, b.v))); }
+		friend FLOAT4 operator-(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(vsubq_f32(a.v, b.v))); }
+		friend FLOAT4 operator*(const FLOAT4& a, const FLOAT4& b) { return(FLOAT4(vmulq_f32(a.v, b.v))); }
+#endif
+	};
+
+	// pi / 2 split into three parts so the angle reduction
+	// keeps its precision for large angles
+	const float g_PiOver2Part1 = 1.5703125f;
+	const float g_PiOver2Part2 = 4.837512969970703125e-4f;
+	const float g_PiOver2Part3 = 7.54978995489188216e-8f;
+	const float g_TwoOverPi = 0.636619772367581343f;
+
+	// sine and cosine of four angles in radians - the angles are
+	// reduced to [-pi/4, pi/4] and the quadrant picks which of the
+	// two polynomials is the sine and which signs are flipped
+	void SinCos(const FLOAT4& angle, FLOAT4& sine, FLOAT4& cosine)
+	{
+#if defined(TRANSFORM_USE_SSE2)
+		__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle.v, _mm_set1_ps(g_TwoOverPi)));
+		FLOAT4 q(_mm_cvtepi32_ps(quadrant));
+#else
+		int32x4_t quadrant = vcvtnq_s32_f32(vmulq_f32(angle.v, vdupq_n_f32(g_TwoOverPi)));
+		FLOAT4 q(vcvtq_f32_s32(quadrant));
+#endif
+		FLOAT4 x = angle - q * FLOAT4(g_PiOver2Part1);
+		x = x - q * FLOAT4(g_PiOver2Part2);
+		x = x - q * FLOAT4(g_PiOver2Part3);
+		FLOAT4 z = x * x;
+
+		FLOAT4 s = ((FLOAT4(-1.9515295891e-4f) * z + FLOAT4(8.3321608736e-3f)) * z
+			- FLOAT4(1.6666654611e-1f)) * z * x + x;
+		FLOAT4 c = ((FLOAT4(2.443315711809948e-5f) * z - FLOAT4(1.388731625493765e-3f)) * z
+			+ FLOAT4(4.166664568298827e-2f)) * z * z - FLOAT4(0.5f) * z + FLOAT4(1.0f);
+
+		// odd quadrants swap the sine and cosine, quadrants 2 and 3
+		// negate the sine and quadrants 1 and 2 negate the cosine
+#if defined(TRANSFORM_USE_SSE2)
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(
+			_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		__m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+		__m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+		__m128 sineValue = _mm_or_ps(_mm_and_ps(swap, c.v), _mm_andnot_ps(swap, s.v));
+		__m128 cosineValue = _mm_or_ps(_mm_and_ps(swap, s.v), _mm_andnot_ps(swap, c.v));
+		sine = FLOAT4(_mm_xor_ps(sineValue, sineSign));
+		cosine = FLOAT4(_mm_xor_ps(cosineValue, cosineSign));
+#else
+		uint32x4_t bits = vreinterpretq_u32_s32(quadrant);
+		uint32x4_t swap = vceqq_u32(vandq_u32(bits, vdupq_n_u32(1)), vdupq_n_u32(1));
+		uint32x4_t sineSign = vshlq_n_u32(vandq_u32(bits, vdupq_n_u32(2)), 30);
+		uint32x4_t cosineSign = vshlq_n_u32(
+			vandq_u32(vaddq_u32(bits, vdupq_n_u32(1)), vdupq_n_u32(2)), 30);
+		float32x4_t sineValue = vbslq_f32(swap, c.v, s.v);
+		float32x4_t cosineValue = vbslq_f32(swap, s.v, c.v);
+		sine = FLOAT4(vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(sineValue), sineSign)));
+		cosine = FLOAT4(vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(cosineValue), cosineSign)));
+#endif
+	}
+
+	// write one column of four matrices - the passed in values
+	// hold the rows of the column with one matrix in each lane
+	void StoreColumn(
+		const FLOAT4& row0, const FLOAT4& row1, const FLOAT4& row2, float row3,
+		int column, glm::mat4* pMatrices)
+	{
+#if defined(TRANSFORM_USE_SSE2)
+		__m128 r0 = row0.v;
+		__m128 r1 = row1.v;
+		__m128 r2 = row2.v;
+		__m128 r3 = _mm_set1_ps(row3);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(&pMatrices[0][column][0], r0);
+		_mm_storeu_ps(&pMatrices[1][column][0], r1);
+		_mm_storeu_ps(&pMatrices[2][column][0], r2);
+		_mm_storeu_ps(&pMatrices[3][column][0], r3);
+#else
+		float32x4x2_t t01 = vtrnq_f32(row0.v, row1.v);
+		float32x4x2_t t23 = vtrnq_f32(row2.v, vdupq_n_f32(row3));
+		vst1q_f32(&pMatrices[0][column][0], vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])));
+		vst1q_f32(&pMatrices[1][column][0], vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1])));
+		vst1q_f32(&pMatrices[2][column][0], vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])));
+		vst1q_f32(&pMatrices[3][column][0], vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])));
+#endif
+	}
+#endif
+}
+
+/***********************************************************
+ *  ComposeTRS()
+ *
+ *  This method is used to build one model matrix from the
+ *  passed in scale, rotation in degrees and position.
+ ***********************************************************/
+glm::mat4 TransformKernels::ComposeTRS(
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees,
+	const glm::vec3& positionXYZ)
+{
+	float angleX = rotationDegrees.x * g_DegreesToRadians;
+	float angleY = rotationDegrees.y * g_DegreesToRadians;
+	float angleZ = rotationDegrees.z * g_DegreesToRadians;
+
+	TRS_COLUMNS<float> columns;
+	CombineTRS<float>(
+		std::sin(angleX), std::cos(angleX),
+		std::sin(angleY), std::cos(angleY),
+		std::sin(angleZ), std::cos(angleZ),
+		scaleXYZ.x, scaleXYZ.y, scaleXYZ.z,
+		positionXYZ.x, positionXYZ.y, positionXYZ.z,
+		columns);
+
+	glm::mat4 matrix;
+	for (int column = 0; column < 4; column++)
+	{
+		matrix[column] = glm::vec4(
+			columns.m[column][0],
+			columns.m[column][1],
+			columns.m[column][2],
+			(column == 3) ? 1.0f : 0.0f);
+	}
+
+	return(matrix);
+}
+
+/***********************************************************
+ *  ComposeTRSBatch()
+ *
+ *  This method is used to build a model matrix for each of
+ *  the passed in transforms.  Groups of four are built with
+ *  the SIMD instructions and the rest one at a time.
+ ***********************************************************/
+void TransformKernels::ComposeTRSBatch(
+	const TRS_ARRAYS& transforms,
+	int count,
+	glm::mat4* pMatrices)
+{
+	int index = 0;
+
+#if defined(TRANSFORM_USE_SSE2) || defined(TRANSFORM_USE_NEON)
+	const FLOAT4 toRadians(g_DegreesToRadians);
+
+	for (; index + 4 <= count; index += 4)
+	{
+		FLOAT4 sine[3];
+		FLOAT4 cosine[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			SinCos(FLOAT4::Load(transforms.rotation[axis] + index) * toRadians,
+				sine[axis], cosine[axis]);
+		}
+
+		TRS_COLUMNS<FLOAT4> columns;
+		CombineTRS<FLOAT4>(
+			sine[0], cosine[0],
+			sine[1], cosine[1],
+			sine[2], cosine[2],
+			FLOAT4::Load(transforms.scale[0] + index),
+			FLOAT4::Load(transforms.scale[1] + index),
+			FLOAT4::Load(transforms.scale[2] + index),
+			FLOAT4::Load(transforms.position[0] + index),
+			FLOAT4::Load(transforms.position[1] + index),
+			FLOAT4::Load(transforms.position[2] + index),
+			columns);
+
+		for (int column = 0; column < 4; column++)
+		{
+			StoreColumn(
+				columns.m[column][0], columns.m[column][1], columns.m[column][2],
+				(column == 3) ? 1.0f : 0.0f,
+				column, pMatrices + index);
+		}
+	}
+#endif
+
+	// the transforms that do not fill a group of four
+	for (; index < count; index++)
+	{
+		pMatrices[index] = ComposeTRS(
+			glm::vec3(transforms.scale[0][index], transforms.scale[1][index], transforms.scale[2][index]),
+			glm::vec3(transforms.rotation[0][index], transforms.rotation[1][index], transforms.rotation[2][index]),
+			glm::vec3(transforms.position[0][index], transforms.position[1][index], transforms.position[2][index]));
+	}
+}
+
+/***********************************************************
+ *  GetInstructionSet()
+ *
+ *  This method is used to get the name of the instructions
+ *  that the batch version was compiled with.
+ ***********************************************************/
+const char* TransformKernels::GetInstructionSet()
+{
+#if defined(TRANSFORM_USE_SSE2)
+	return("SSE2");
+#elif defined(TRANSFORM_USE_NEON)
+	return("NEON");
+#else
+	return("scalar");
+#endif
+}
@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformkernels.h
+// ============
+// build model matrices from scale, Euler rotation and position values
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  TransformKernels
+ *
+ *  This class contains the code for turning scale, rotation
+ *  and position values into model matrices without building
+ *  and multiplying a separate matrix for each part.  The
+ *  result is the same as
+ *      translate * rotateZ * rotateY * rotateX * scale
+ *  with the rotations given in degrees.  The batch version
+ *  computes four matrices at a time with SSE2 or NEON,
+ *  including the sine and cosine of the angles.
+ ***********************************************************/
+class TransformKernels
+{
+public:
+	// scale, rotation in degrees and position of many objects,
+	// each component stored in its own array of count values
+	struct TRS_ARRAYS
+	{
+		const float* scale[3];
+		const float* rotation[3];
+		const float* position[3];
+	};
+
+	// build one model matrix
+	static glm::mat4 ComposeTRS(
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ);
+
+	// build count model matrices into the passed in array
+	static void ComposeTRSBatch(
+		const TRS_ARRAYS& transforms,
+		int count,
+		glm::mat4* pMatrices);
+
+	// name of the instructions used by the batch version
+	static const char* GetInstructionSet();
+};
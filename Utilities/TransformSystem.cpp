@@ -0,0 +1,346 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformsystem.cpp
+// ============
+// store the scale, rotation and position of every scene object and keep
+// their world matrices up to date
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformSystem.h"
+#include "TransformKernels.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// most transforms rebuilt by one job
+	const int g_TransformsPerJob = 256;
+}
+
+/***********************************************************
+ *  TransformSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransformSystem::TransformSystem()
+{
+	m_firstDirty = INT_MAX;
+	m_lastDirty = -1;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to remove all transforms.
+ ***********************************************************/
+void TransformSystem::Clear()
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_scale[axis].clear();
+		m_rotation[axis].clear();
+		m_position[axis].clear();
+	}
+	m_parents.clear();
+	m_subtreeEnds.clear();
+	m_localMatrices.clear();
+	m_worldMatrices.clear();
+	m_dirtyBits.clear();
+	m_firstDirty = INT_MAX;
+	m_lastDirty = -1;
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used to make room for the passed in number
+ *  of transforms, so adding them does not grow the arrays
+ *  again and again.
+ ***********************************************************/
+void TransformSystem::Reserve(int count)
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_scale[axis].reserve(count);
+		m_rotation[axis].reserve(count);
+		m_position[axis].reserve(count);
+	}
+	m_parents.reserve(count);
+	m_subtreeEnds.reserve(count);
+	m_localMatrices.reserve(count);
+	m_worldMatrices.reserve(count);
+	m_dirtyBits.reserve((count + 63) >> 6);
+}
+
+/***********************************************************
+ *  AddTransform()
+ *
+ *  This method is used to add a transform with the passed
+ *  in local values.  The parent must already be added.
+ ***********************************************************/
+int TransformSystem::AddTransform(
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees,
+	const glm::vec3& positionXYZ,
+	int parent)
+{
+	int index = GetCount();
+	if (parent >= index)
+	{
+		std::cout << "Transform parent " << parent << " must be added before its children" << std::endl;
+		parent = -1;
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_scale[axis].push_back(scaleXYZ[axis]);
+		m_rotation[axis].push_back(rotationDegrees[axis]);
+		m_position[axis].push_back(positionXYZ[axis]);
+	}
+	m_parents.push_back(parent);
+	m_subtreeEnds.push_back(index + 1);
+	m_localMatrices.push_back(glm::mat4(1.0f));
+	m_worldMatrices.push_back(glm::mat4(1.0f));
+	if ((index >> 6) >= (int)m_dirtyBits.size())
+	{
+		m_dirtyBits.push_back(0);
+	}
+
+	// the world matrices of the ancestors' children are rebuilt
+	// up to the end of their subtrees
+	for (int ancestor = parent; ancestor >= 0; ancestor = m_parents[ancestor])
+	{
+		m_subtreeEnds[ancestor] = index + 1;
+	}
+
+	MarkDirty(index);
+	return(index);
+}
+
+/***********************************************************
+ *  SetScale()
+ *
+ *  This method is used to change the scale of a transform.
+ ***********************************************************/
+void TransformSystem::SetScale(int index, const glm::vec3& scaleXYZ)
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_scale[axis][index] = scaleXYZ[axis];
+	}
+	MarkDirty(index);
+}
+
+/***********************************************************
+ *  SetRotation()
+ *
+ *  This method is used to change the rotation of a transform.
+ ***********************************************************/
+void TransformSystem::SetRotation(int index, const glm::vec3& rotationDegrees)
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_rotation[axis][index] = rotationDegrees[axis];
+	}
+	MarkDirty(index);
+}
+
+/***********************************************************
+ *  SetPosition()
+ *
+ *  This method is used to change the position of a transform.
+ ***********************************************************/
+void TransformSystem::SetPosition(int index, const glm::vec3& positionXYZ)
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_position[axis][index] = positionXYZ[axis];
+	}
+	MarkDirty(index);
+}
+
+/***********************************************************
+ *  GetScale()
+ *
+ *  This method is used to get the local scale of a transform.
+ ***********************************************************/
+glm::vec3 TransformSystem::GetScale(int index) const
+{
+	return(glm::vec3(m_scale[0][index], m_scale[1][index], m_scale[2][index]));
+}
+
+/***********************************************************
+ *  GetRotation()
+ *
+ *  This method is used to get the local rotation of a
+ *  transform in degrees.
+ ***********************************************************/
+glm::vec3 TransformSystem::GetRotation(int index) const
+{
+	return(glm::vec3(m_rotation[0][index], m_rotation[1][index], m_rotation[2][index]));
+}
+
+/***********************************************************
+ *  GetPosition()
+ *
+ *  This method is used to get the local position of a
+ *  transform.
+ ***********************************************************/
+glm::vec3 TransformSystem::GetPosition(int index) const
+{
+	return(glm::vec3(m_position[0][index], m_position[1][index], m_position[2][index]));
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used to flag a transform for rebuilding
+ *  during the next Update().
+ ***********************************************************/
+void TransformSystem::MarkDirty(int index)
+{
+	m_dirtyBits[index >> 6] |= (uint64_t)1 << (index & 63);
+	m_firstDirty = std::min(m_firstDirty, index);
+	m_lastDirty = std::max(m_lastDirty, index);
+}
+
+/***********************************************************
+ *  IsDirty()
+ *
+ *  This method is used to check the dirty bit of a transform.
+ ***********************************************************/
+bool TransformSystem::IsDirty(int index) const
+{
+	return((m_dirtyBits[index >> 6] & ((uint64_t)1 << (index & 63))) != 0);
+}
+
+/***********************************************************
+ *  UpdateLocalMatrices()
+ *
+ *  This method is used to rebuild the local matrices of the
+ *  passed in range from the stored component arrays.
+ ***********************************************************/
+void TransformSystem::UpdateLocalMatrices(int first, int count)
+{
+	TransformKernels::TRS_ARRAYS arrays;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		arrays.scale[axis] = m_scale[axis].data() + first;
+		arrays.rotation[axis] = m_rotation[axis].data() + first;
+		arrays.position[axis] = m_position[axis].data() + first;
+	}
+
+	TransformKernels::ComposeTRSBatch(arrays, count, m_localMatrices.data() + first);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to rebuild the local matrices of the
+ *  dirty transforms, then the world matrices of those and of
+ *  every transform below them in the hierarchy.
+ ***********************************************************/
+int TransformSystem::Update(JobSystem* pJobSystem)
+{
+	PROFILE_FUNCTION();
+
+	if (m_firstDirty > m_lastDirty)
+	{
+		return(0);
+	}
+
+	// find the runs of dirty transforms, skipping 64 clean
+	// transforms at a time where possible, and split the long
+	// runs so the jobs are about the same size - the list only
+	// lives for this update, so it goes into the frame arena
+	std::pmr::memory_resource* pScratch = (NULL != pJobSystem) ?
+		pJobSystem->GetFrameArena() : std::pmr::get_default_resource();
+	std::pmr::vector<std::pair<int, int>> runs(pScratch);
+	int dirtyCount = 0;
+	int index = m_firstDirty;
+	while (index <= m_lastDirty)
+	{
+		if (IsDirty(index) == false)
+		{
+			if (((index & 63) == 0) && (m_dirtyBits[index >> 6] == 0))
+			{
+				index += 64;
+			}
+			else
+			{
+				index++;
+			}
+			continue;
+		}
+
+		int runStart = index;
+		while ((index <= m_lastDirty) && (IsDirty(index) == true) &&
+			(index - runStart < g_TransformsPerJob))
+		{
+			index++;
+		}
+		runs.push_back(std::make_pair(runStart, index - runStart));
+		dirtyCount += index - runStart;
+	}
+
+	// local matrices of each run, with short runs grouped so each
+	// job builds about the same number of transforms
+	if (NULL != pJobSystem)
+	{
+		int runsPerJob = std::max(1, (int)((long long)runs.size() * g_TransformsPerJob / dirtyCount));
+		pJobSystem->ParallelFor((int)runs.size(), runsPerJob, [this, &runs](int first, int count) {
+			for (int i = first; i < first + count; i++)
+			{
+				UpdateLocalMatrices(runs[i].first, runs[i].second);
+			}
+		});
+	}
+	else
+	{
+		for (size_t i = 0; i < runs.size(); i++)
+		{
+			UpdateLocalMatrices(runs[i].first, runs[i].second);
+		}
+	}
+
+	// world matrices - a transform whose parent was rebuilt is
+	// rebuilt too, and its bit is set so its own children see it
+	int rebuilt = 0;
+	int end = m_lastDirty + 1;
+	for (index = m_firstDirty; index < end; index++)
+	{
+		int parent = m_parents[index];
+		if (IsDirty(index) == false)
+		{
+			if ((parent < m_firstDirty) || (IsDirty(parent) == false))
+			{
+				continue;
+			}
+			m_dirtyBits[index >> 6] |= (uint64_t)1 << (index & 63);
+		}
+
+		if (parent >= 0)
+		{
+			m_worldMatrices[index] = m_worldMatrices[parent] * m_localMatrices[index];
+		}
+		else
+		{
+			m_worldMatrices[index] = m_localMatrices[index];
+		}
+		end = std::max(end, m_subtreeEnds[index]);
+		rebuilt++;
+	}
+
+	std::fill(
+		m_dirtyBits.begin() + (m_firstDirty >> 6),
+		m_dirtyBits.begin() + ((end - 1) >> 6) + 1,
+		0);
+	m_firstDirty = INT_MAX;
+	m_lastDirty = -1;
+
+	return(rebuilt);
+}
@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformsystem.h
+// ============
+// store the scale, rotation and position of every scene object and keep
+// their world matrices up to date
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  TransformSystem
+ *
+ *  This class contains the transforms of all scene objects.
+ *  Each component is kept in its own array so the matrices
+ *  of neighbouring objects are built together by the batch
+ *  kernel in TransformKernels.  Changing a transform sets its
+ *  dirty bit, and Update() rebuilds only the dirty runs and
+ *  the world matrices of their children.  The dirty runs can
+ *  be built on several threads.  A parent must be added
+ *  before its children, so one pass in index order handles
+ *  any depth of hierarchy.
+ ***********************************************************/
+class TransformSystem
+{
+public:
+	// constructor
+	TransformSystem();
+
+	// remove all transforms
+	void Clear();
+	// make room for the passed in number of transforms
+	void Reserve(int count);
+	// add a transform and return its index - the rotation is in
+	// degrees and the parent is -1 for objects without one
+	int AddTransform(
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ,
+		int parent = -1);
+	// number of transforms
+	int GetCount() const { return((int)m_parents.size()); }
+
+	// change the local values of a transform
+	void SetScale(int index, const glm::vec3& scaleXYZ);
+	void SetRotation(int index, const glm::vec3& rotationDegrees);
+	void SetPosition(int index, const glm::vec3& positionXYZ);
+
+	// local values of a transform
+	glm::vec3 GetScale(int index) const;
+	glm::vec3 GetRotation(int index) const;
+	glm::vec3 GetPosition(int index) const;
+	int GetParent(int index) const { return(m_parents[index]); }
+
+	// rebuild the matrices of the changed transforms and their
+	// children, and return the number of world matrices rebuilt -
+	// the local matrices are split over the job system when given
+	int Update(JobSystem* pJobSystem = NULL);
+	// rebuild the local matrices of the passed in range - ranges
+	// that do not overlap can be rebuilt at the same time
+	void UpdateLocalMatrices(int first, int count);
+
+	// matrix that places the object in the world, valid after Update()
+	const glm::mat4& GetWorldMatrix(int index) const { return(m_worldMatrices[index]); }
+	const glm::mat4* GetWorldMatrices() const { return(m_worldMatrices.data()); }
+
+private:
+	// local values, one array per component
+	std::vector<float> m_scale[3];
+	std::vector<float> m_rotation[3];
+	std::vector<float> m_position[3];
+	// index of the parent of each transform, or -1
+	std::vector<int> m_parents;
+	// one past the highest index of any descendant
+	std::vector<int> m_subtreeEnds;
+	// matrices from the local values and with the parents applied
+	std::vector<glm::mat4> m_localMatrices;
+	std::vector<glm::mat4> m_worldMatrices;
+	// one bit for each transform whose local values changed
+	std::vector<uint64_t> m_dirtyBits;
+	// range of indices that contains all dirty bits
+	int m_firstDirty;
+	int m_lastDirty;
+
+	// set the dirty bit of a transform
+	void MarkDirty(int index);
+	bool IsDirty(int index) const;
+};
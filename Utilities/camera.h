@@ -122,6 +122,14 @@ public:
         updateCameraVectors();
     }
 
+    // sets the Euler angles directly, e.g. when following a recorded camera path
+    void SetEulerAngles(float yaw, float pitch)
+    {
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
     // processes input received from a mouse scroll-wheel event. Only requires input on the vertical wheel-axis
     void ProcessMouseScroll(float yoffset)
     {
@@ -1,9 +1,16 @@
 #version 330 core
-out vec4 fragmentColor;
+layout (location = 0) out vec4 fragmentColor;
+// how far the surface moved on the screen since the last frame,
+// in normalized device coordinates, written only when the target
+// has a second attachment - its alpha is the color's, so what is
+// seen through a transparent part keeps its own velocity
+layout (location = 1) out vec4 fragmentVelocity;
 
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+in vec4 currentClipPosition;
+in vec4 previousClipPosition;
 
 struct Material {
     vec3 diffuseColor;
@@ -50,14 +57,34 @@ struct SpotLight {
 
 #define TOTAL_POINT_LIGHTS 5
 
+// the blocks are written into a streaming buffer once per frame
+// and once per draw, and must match the vertex shader
+layout (std140) uniform CameraData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+    mat4 viewProjection;
+    mat4 previousViewProjection;
+};
+
+layout (std140) uniform LightData
+{
+    DirectionalLight directionalLight;
+    SpotLight spotLight;
+};
+
+layout (std140) uniform ObjectData
+{
+    mat4 model;
+    mat4 previousModel;
+    vec4 objectColor;
+    Material material;
+};
+
 uniform bool bUseTexture=false;
 uniform bool bUseLighting=false;
-uniform vec4 objectColor = vec4(1.0f);
-uniform vec3 viewPosition;
-uniform DirectionalLight directionalLight;
 uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
-uniform SpotLight spotLight;
-uniform Material material;
 uniform sampler2D objectTexture;
 uniform vec2 UVscale = vec2(1.0f, 1.0f);
 
@@ -120,6 +147,9 @@ void main()
             fragmentColor = objectColor;
         }
     }
+
+    vec2 velocity = currentClipPosition.xy / currentClipPosition.w - previousClipPosition.xy / previousClipPosition.w;
+    fragmentVelocity = vec4(velocity, 0.0, fragmentColor.a);
 }
 
 // calculates the color when using a directional light.
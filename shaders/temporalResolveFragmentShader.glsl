@@ -0,0 +1,149 @@
+#version 330 core
+
+in vec2 fragmentTextureCoordinate;
+
+out vec4 outFragmentColor;
+
+// the frame drawn at the lower resolution with the jitter, its
+// depth, how far each of its pixels moved since the last frame
+// in normalized device coordinates, and its size in pixels
+uniform sampler2D currentTexture;
+uniform sampler2D depthTexture;
+uniform sampler2D velocityTexture;
+uniform vec2 sourceSize;
+// the frames resolved before, at the size of the output
+uniform sampler2D historyTexture;
+uniform vec2 outputSize;
+// offset the frame was drawn with, in normalized device coordinates
+uniform vec2 jitter;
+// from the normalized device coordinates of this frame, without
+// its jitter, to the clip space of the last frame - only used
+// for the background, where nothing was drawn
+uniform mat4 reprojection;
+uniform bool bHistoryValid;
+
+// share of a new sample drawn right at the center of a pixel
+const float currentWeight = 0.1;
+
+// Catmull-Rom filter over the 4x4 nearest texels, with the
+// middle two texels of each row and column merged into one
+// bilinear fetch and the four corners left out, whose weights
+// are small, so 5 fetches do most of the work of 16
+vec3 SampleCatmullRom(sampler2D source, vec2 size, vec2 textureCoordinate)
+{
+    vec2 samplePosition = textureCoordinate * size;
+    vec2 texelPosition1 = floor(samplePosition - 0.5) + 0.5;
+    vec2 f = samplePosition - texelPosition1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+    vec2 offset12 = w2 / w12;
+
+    vec2 position0 = (texelPosition1 - 1.0) / size;
+    vec2 position3 = (texelPosition1 + 2.0) / size;
+    vec2 position12 = (texelPosition1 + offset12) / size;
+
+    vec4 color = vec4(0.0);
+    color += vec4(texture(source, vec2(position12.x, position0.y)).rgb, 1.0) * w12.x * w0.y;
+    color += vec4(texture(source, vec2(position0.x, position12.y)).rgb, 1.0) * w0.x * w12.y;
+    color += vec4(texture(source, vec2(position12.x, position12.y)).rgb, 1.0) * w12.x * w12.y;
+    color += vec4(texture(source, vec2(position3.x, position12.y)).rgb, 1.0) * w3.x * w12.y;
+    color += vec4(texture(source, vec2(position12.x, position3.y)).rgb, 1.0) * w12.x * w3.y;
+    // the left out weights are made up for by the others
+    return clamp(color.rgb / color.a, 0.0, 1.0);
+}
+
+// the history is clamped in luma and chroma, which keeps its
+// brightness better than clamping red, green and blue apart
+vec3 RGBToYCoCg(vec3 color)
+{
+    return vec3(
+        0.25 * color.r + 0.5 * color.g + 0.25 * color.b,
+        0.5 * color.r - 0.5 * color.b,
+        -0.25 * color.r + 0.5 * color.g - 0.25 * color.b);
+}
+
+vec3 YCoCgToRGB(vec3 color)
+{
+    return vec3(
+        color.x + color.y - color.z,
+        color.x + color.z,
+        color.x - color.y - color.z);
+}
+
+// widen the color bounds by one texel next to the pixel, and
+// keep it when it is the closest so far
+void AddNeighbor(ivec2 texel, ivec2 lastTexel, ivec2 offset, inout vec3 neighborMin, inout vec3 neighborMax, inout float depth, inout ivec2 closestTexel)
+{
+    ivec2 neighbor = clamp(texel + offset, ivec2(0), lastTexel);
+    vec3 color = RGBToYCoCg(texelFetch(currentTexture, neighbor, 0).rgb);
+    neighborMin = min(neighborMin, color);
+    neighborMax = max(neighborMax, color);
+    float neighborDepth = texelFetch(depthTexture, neighbor, 0).r;
+    if (neighborDepth < depth)
+    {
+        depth = neighborDepth;
+        closestTexel = neighbor;
+    }
+}
+
+void main()
+{
+    // the pixel center as it was drawn in the jittered frame
+    vec2 sourceCoordinate = fragmentTextureCoordinate + jitter * 0.5;
+    vec2 sourcePosition = sourceCoordinate * sourceSize;
+    ivec2 lastTexel = ivec2(sourceSize) - 1;
+    ivec2 texel = clamp(ivec2(floor(sourcePosition)), ivec2(0), lastTexel);
+
+    // the colors of the pixel and its four neighbors bound the
+    // history, and the motion of the closest of them keeps the
+    // edges of near objects in place
+    vec3 neighborMin = vec3(1.0e9);
+    vec3 neighborMax = vec3(-1.0e9);
+    float depth = 1.0;
+    ivec2 closestTexel = texel;
+    AddNeighbor(texel, lastTexel, ivec2(0, 0), neighborMin, neighborMax, depth, closestTexel);
+    AddNeighbor(texel, lastTexel, ivec2(-1, 0), neighborMin, neighborMax, depth, closestTexel);
+    AddNeighbor(texel, lastTexel, ivec2(1, 0), neighborMin, neighborMax, depth, closestTexel);
+    AddNeighbor(texel, lastTexel, ivec2(0, -1), neighborMin, neighborMax, depth, closestTexel);
+    AddNeighbor(texel, lastTexel, ivec2(0, 1), neighborMin, neighborMax, depth, closestTexel);
+
+    // the drawn surfaces moved by their velocity, which follows
+    // the camera and the objects, while the background only
+    // moves with the camera
+    vec2 historyCoordinate;
+    bool bInView = true;
+    if (depth < 1.0)
+    {
+        vec2 velocity = texelFetch(velocityTexture, closestTexel, 0).xy;
+        historyCoordinate = fragmentTextureCoordinate - velocity * 0.5;
+    }
+    else
+    {
+        vec4 lastPosition = reprojection * vec4(fragmentTextureCoordinate * 2.0 - 1.0, 1.0, 1.0);
+        historyCoordinate = lastPosition.xy / lastPosition.w * 0.5 + 0.5;
+        bInView = (lastPosition.w > 0.0);
+    }
+
+    // without a history, or where the pixel was not in view,
+    // the frame is only scaled up
+    if (!bHistoryValid || !bInView ||
+        any(lessThan(historyCoordinate, vec2(0.0))) || any(greaterThan(historyCoordinate, vec2(1.0))))
+    {
+        outFragmentColor = vec4(SampleCatmullRom(currentTexture, sourceSize, sourceCoordinate), 1.0);
+        return;
+    }
+
+    vec3 history = RGBToYCoCg(SampleCatmullRom(historyTexture, outputSize, historyCoordinate));
+    history = YCoCgToRGB(clamp(history, neighborMin, neighborMax));
+
+    // the new sample counts for more the closer to the pixel
+    // center it was drawn, measured in output pixels
+    vec2 offset = (sourcePosition - (vec2(texel) + 0.5)) * outputSize / sourceSize;
+    float weight = currentWeight * exp(-2.29 * dot(offset, offset));
+    vec3 current = texelFetch(currentTexture, texel, 0).rgb;
+    outFragmentColor = vec4(mix(history, current, weight), 1.0);
+}
@@ -0,0 +1,48 @@
+#version 330 core
+
+in vec2 fragmentTextureCoordinate;
+
+out vec4 outFragmentColor;
+
+// the frame drawn at the lower resolution, and its size in pixels
+uniform sampler2D sourceTexture;
+uniform vec2 sourceSize;
+
+// Catmull-Rom filter over the 4x4 nearest texels, with the
+// middle two texels of each row and column merged into one
+// bilinear fetch, so 9 fetches do the work of 16
+vec4 SampleCatmullRom(vec2 textureCoordinate)
+{
+    vec2 samplePosition = textureCoordinate * sourceSize;
+    vec2 texelPosition1 = floor(samplePosition - 0.5) + 0.5;
+    vec2 f = samplePosition - texelPosition1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+    vec2 offset12 = w2 / w12;
+
+    vec2 position0 = (texelPosition1 - 1.0) / sourceSize;
+    vec2 position3 = (texelPosition1 + 2.0) / sourceSize;
+    vec2 position12 = (texelPosition1 + offset12) / sourceSize;
+
+    vec4 color = vec4(0.0);
+    color += texture(sourceTexture, vec2(position0.x, position0.y)) * w0.x * w0.y;
+    color += texture(sourceTexture, vec2(position12.x, position0.y)) * w12.x * w0.y;
+    color += texture(sourceTexture, vec2(position3.x, position0.y)) * w3.x * w0.y;
+    color += texture(sourceTexture, vec2(position0.x, position12.y)) * w0.x * w12.y;
+    color += texture(sourceTexture, vec2(position12.x, position12.y)) * w12.x * w12.y;
+    color += texture(sourceTexture, vec2(position3.x, position12.y)) * w3.x * w12.y;
+    color += texture(sourceTexture, vec2(position0.x, position3.y)) * w0.x * w3.y;
+    color += texture(sourceTexture, vec2(position12.x, position3.y)) * w12.x * w3.y;
+    color += texture(sourceTexture, vec2(position3.x, position3.y)) * w3.x * w3.y;
+    return color;
+}
+
+void main()
+{
+    // the negative lobes can ring past the range of the colors
+    outFragmentColor = vec4(clamp(SampleCatmullRom(fragmentTextureCoordinate).rgb, 0.0, 1.0), 1.0);
+}
@@ -6,10 +6,35 @@ layout (location = 2) in vec2 inTextureCoordinate;
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+// where the vertex is in this frame and was in the last one,
+// without the jitter, for the velocity
+out vec4 currentClipPosition;
+out vec4 previousClipPosition;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+struct Material {
+    vec3 diffuseColor;
+    vec3 specularColor;
+    float shininess;
+};
+
+// the blocks are written into a streaming buffer once per frame
+// and once per draw, and must match the fragment shader
+layout (std140) uniform CameraData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+    mat4 viewProjection;
+    mat4 previousViewProjection;
+};
+
+layout (std140) uniform ObjectData
+{
+    mat4 model;
+    mat4 previousModel;
+    vec4 objectColor;
+    Material material;
+};
 
 void main()
 {
@@ -17,4 +42,6 @@ void main()
    gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
    fragmentVertexNormal = inVertexNormal;
    fragmentTextureCoordinate = inTextureCoordinate;
+   currentClipPosition = viewProjection * model * vec4(inVertexPosition, 1.0f);
+   previousClipPosition = previousViewProjection * previousModel * vec4(inVertexPosition, 1.0f);
 }
\ No newline at end of file